@@ -0,0 +1,52 @@
+function [ns_RESULT, Info] = ns_AnalogCache(MaxBytes);
+
+%ns_AnalogCache   Sets, inspects or empties the cache of analog data
+%
+%   Usage:
+%      [ns_RESULT, Info] = ns_AnalogCache
+%      [ns_RESULT, Info] = ns_AnalogCache(MaxBytes)
+%      [ns_RESULT, Info] = ns_AnalogCache('flush')
+%   
+%   Description:
+%       Analog data read by ns_GetAnalogData and the other functions
+%       reading Analog Entities is kept in memory in blocks of BlockSize
+%       indexes, so data that is read again is not decoded by the library
+%       again.  When the blocks take up more than MaxBytes (128 MB by
+%       default), the least recently used blocks are dropped.  Reads of
+%       more than a quarter of MaxBytes bypass the cache.
+%
+%       The blocks of a file are dropped when it is closed with
+%       ns_CloseFile, all blocks when ns_SetLibrary is called.
+%
+%   Parameters:
+%       MaxBytes        Maximum number of bytes of all blocks (0 turns the
+%                       cache off), or 'flush' to drop all blocks and
+%                       reset the counters.  Without MaxBytes only the
+%                       counters are returned.
+%
+%   Return Values:
+%       Info            Structure with the fields:
+%                         MaxBytes     Maximum number of bytes
+%                         Bytes        Bytes of the blocks kept now
+%                         Blocks       Number of blocks kept now
+%                         BlockSize    Number of indexes of a block
+%                         Hits         Blocks found in the cache
+%                         Misses       Blocks read from the library
+%                         HitRate      Hits / (Hits + Misses)
+%                         Evictions    Blocks dropped to stay within
+%                                      MaxBytes
+%       ns_RESULT   This function returns ns_OK if MaxBytes is valid.
+%                   Otherwise the following error code is generated:
+%
+%                       ns_LIBERROR	MaxBytes is not a non-negative number
+%                                   or 'flush'.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 1)
+    MaxBytes = [];
+end;
+
+[ns_RESULT, Info] = mexprog(28, MaxBytes);
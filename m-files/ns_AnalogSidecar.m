@@ -0,0 +1,54 @@
+function [ns_RESULT, Info] = ns_AnalogSidecar(Class);
+
+%ns_AnalogSidecar   Keeps decoded analog data in sidecar files
+%
+%   Usage:
+%      [ns_RESULT, Info] = ns_AnalogSidecar
+%      [ns_RESULT, Info] = ns_AnalogSidecar(Class)
+%   
+%   Description:
+%       Once Class is 'single' or 'int16', every Analog Entity that is
+%       read by ns_GetAnalogData from its first to its last index is also
+%       written to a sidecar file next to the data file
+%       (<file>.<EntityID>.nsdat).  Later reads of the entity that do not
+%       decimate, filter or re-reference the data are served from the
+%       sidecar, which is mapped into memory, instead of being decoded by
+%       the library again.  This also holds in later Matlab sessions.
+%       The sidecar is written from the data that was read, so only such
+%       reads of class 'double' or of the class of the sidecars write it.
+%
+%       'single' sidecars keep the values in single precision, 'int16'
+%       sidecars keep raw counts of the resolution of the entity.  Data
+%       read from a sidecar therefore has the precision of its class.
+%
+%       A sidecar is only used if the data file has the same size and
+%       modification time and the same library (description and version)
+%       is loaded as when it was written.  Otherwise the library is used
+%       and the sidecar is written again on the next full read.
+%
+%   Parameters:
+%       Class           'off' (the default) to neither write nor use
+%                       sidecars, 'single' or 'int16'.  Without Class
+%                       only the counters are returned.
+%
+%   Return Values:
+%       Info            Structure with the fields:
+%                         Class        Class of the sidecars used now
+%                         Sidecars     Number of sidecars mapped now
+%                         Hits         Entity reads served from sidecars
+%                         Written      Number of sidecars written
+%       ns_RESULT   This function returns ns_OK if Class is valid.
+%                   Otherwise the following error code is generated:
+%
+%                       ns_LIBERROR	Class is not 'off', 'single' or
+%                                   'int16'.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 1)
+    Class = '';
+end;
+
+[ns_RESULT, Info] = mexprog(29, Class);
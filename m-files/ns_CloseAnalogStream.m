@@ -0,0 +1,26 @@
+function ns_RESULT = ns_CloseAnalogStream(hStream);
+
+%ns_CloseAnalogStream   Closes an analog stream
+%
+%   Usage:
+%      ns_RESULT = ns_CloseAnalogStream(hStream)
+%
+%   Description:
+%       Closes a stream opened by ns_OpenAnalogStream.  Streams are also
+%       closed when their file is closed with ns_CloseFile.
+%
+%   Parameters:
+%       hStream     Handle to a stream opened by ns_OpenAnalogStream.
+%
+%   Return Values:
+%       ns_RESULT   This function returns ns_OK if the stream is successfully
+%                   closed. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_LIBERROR	Invalid stream handle.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+ns_RESULT = mexprog(21, hStream);
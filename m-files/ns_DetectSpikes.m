@@ -0,0 +1,90 @@
+function [ns_RESULT, Spikes] = ns_DetectSpikes(hFile, EntityID, StartIndex, IndexCount, Options);
+
+%ns_DetectSpikes   Detects spikes in analog data by threshold crossings
+%
+%   Usage:
+%      [ns_RESULT, Spikes] = ns_DetectSpikes(hFile, EntityID)
+%      [ns_RESULT, Spikes] = 
+%               ns_DetectSpikes(hFile, EntityID, StartIndex, IndexCount)
+%      [ns_RESULT, Spikes] = 
+%               ns_DetectSpikes(hFile, EntityID, StartIndex, IndexCount, Options)
+%   
+%   Description:
+%       Detects spikes in the Analog Entities EntityID in the file
+%       referenced by hFile.  The noise level of every entity is
+%       estimated as the median absolute deviation / 0.6745 of its values
+%       (of 16 windows spread evenly over the range if it holds more than
+%       2^20 values).  A spike is detected where the data crosses the
+%       median plus Threshold times the noise level, from one value to
+%       the next within a continuous block.  The data is read in chunks
+%       and only the spikes are returned, so recordings of any length can
+%       be processed.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartIndex	    Starting index number of the analog data (default
+%                       1).
+%       IndexCount	    Number of analog values to use.  Inf (default)
+%                       uses all values of every entity from StartIndex
+%                       on.
+%       Options         Optional structure with the fields:
+%                         Threshold   Threshold in multiples of the noise
+%                                     level; negative values detect
+%                                     crossings downwards (default -4).
+%                         Refractory  Time in s after a spike in which no
+%                                     other spike is detected (default
+%                                     0.001).
+%                         Snippet     [Pre Post]: number of values cut out
+%                                     before the crossing and from the
+%                                     crossing on (default none).
+%                         Filter      Filter applied to the data before
+%                                     detection, see ns_GetAnalogData.  It
+%                                     is only applied forward.
+%                         Threads     Number of worker threads reading
+%                                     entities in parallel (default 1,
+%                                     0 = one per processor).
+%
+%   Return Values:
+%       Spikes          Structure array with an element per entity with
+%                       the fields:
+%                         Index       Index of every spike (the first
+%                                     value beyond the threshold).
+%                         Time        Time of every spike in s.
+%                         Threshold   Value the data crossed.
+%                         Noise       Estimated noise level.
+%                         Snippets    Pre + Post values around every
+%                                     spike, one column per spike.
+%                                     Values outside the range are NaN.
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_BADINDEX	    Invalid entity index or range 
+%                                       specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 3)
+    StartIndex = 1;
+end;
+if (nargin < 4)
+    IndexCount = Inf;
+end;
+if (nargin < 5)
+    Options = [];
+end;
+
+[ns_RESULT, Spikes] = mexprog(30, hFile, EntityID - 1, StartIndex - 1, IndexCount, Options);
+
+if isstruct(Spikes)
+    for i = 1:numel(Spikes)
+        Spikes(i).Index = Spikes(i).Index + 1;
+    end
+end
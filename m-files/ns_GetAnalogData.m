@@ -1,10 +1,16 @@
-function [ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount);
+function [ns_RESULT, ContCount, Data, Scale, Blocks] = ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount, Options);
 
 %ns_GetAnalogData   Retrieves analog data by index
 %
 %   Usage:
 %      [ns_RESULT, ContCount, Data] =  
 %               ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount)
+%      [ns_RESULT, ContCount, Data] =  
+%               ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount, Options)
+%      [ns_RESULT, ContCount, Data, Scale] =  
+%               ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount, Options)
+%      [ns_RESULT, ContCount, Data, Scale, Blocks] =  
+%               ns_GetAnalogData(hFile, EntityID, StartIndex, IndexCount, Options)
 %   
 %   Description:
 %       Returns the data values associated with the Analog Entity indexed
@@ -26,13 +32,67 @@ function [ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, EntityID, StartI
 %                       data file.
 %       StartIndex	    Starting index number of the analog data item.
 %       IndexCount	    Number of analog values to retrieve.
+%       Options         Optional structure with additional read options:
+%                       Threads     Number of threads used to read several
+%                                   entities at once (default 1, 0 uses one
+%                                   thread per processor).  Libraries that
+%                                   are not multithread safe are still
+%                                   called by one thread at a time.
+%                       Class       Class of Data: 'double' (default),
+%                                   'single' or 'int16'.  int16 data holds
+%                                   the raw counts of the Resolution given
+%                                   by ns_GetAnalogInfo, i.e. 
+%                                   double(Data(:, i)) * Scale(i) are the
+%                                   analog values of entity i.
+%                       Decimate    Decimation factor (default 1).  The data
+%                                   is low pass filtered while it is read 
+%                                   and only every Decimate-th value is
+%                                   returned, starting with StartIndex.  
+%                                   The filter passes 80% of the band left
+%                                   after decimation and has no delay;
+%                                   values before StartIndex and after the
+%                                   last index are taken to be equal to
+%                                   the first and last value.  ContCount
+%                                   then counts rows of Data.
+%                       Blocks      Find all continuous blocks of the index
+%                                   range (default false), see Blocks.
+%                       Reference   Re-reference the data while it is read:
+%                                   'average' or 'median' subtracts the mean
+%                                   or median of all requested entities
+%                                   from every entity, a vector with one
+%                                   EntityID per entity subtracts that
+%                                   entity (bipolar pairs, NaN leaves the
+%                                   entity as it is).  Cannot be combined
+%                                   with Decimate.  Entities that cannot be
+%                                   read are left out of the average or
+%                                   median and returned as zeros.
+%                       Filter      IIR filter applied to the data while it
+%                                   is read: one row [b0 b1 b2 a0 a1 a2] per
+%                                   second order section, as returned by
+%                                   tf2sos or zp2sos (multiply the first
+%                                   row's b coefficients by the gain).  The
+%                                   filter starts in the steady state of
+%                                   the first value.  Cannot be combined
+%                                   with Decimate or Reference.
+%                       ZeroPhase   Filter forward and backward like
+%                                   filtfilt (default false): no phase
+%                                   shift, squared magnitude response.
 %
 %   Return Values:
 %       ContCount	    Number of continuous data values starting with
 %                       StartIndex.  This field is ignored if the pointer
 %                       is set to NULL.
 %       Data	        Array of double precision values to receive the
-%                       analog data.
+%                       analog data (or of the class given by Options).
+%       Scale           Value of one count of Data for every entity: the
+%                       Resolution of the entity for int16 data, 1 for
+%                       double and single data.
+%       Blocks          Cell array with the continuous blocks of every
+%                       entity if Options.Blocks is set (otherwise empty).
+%                       Every block is a row [StartIndex, IndexCount,
+%                       StartTime]; a new block starts after every gap in
+%                       time.  Entities that could not be read have no
+%                       blocks.
 %       ns_RESULT   This function returns ns_OK if the file is successfully
 %                   opened. Otherwise one of the following error codes is 
 %                   generated:
@@ -47,4 +107,18 @@ function [ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, EntityID, StartI
 %   Author: Almut Branner
 %   Last modification: 6/20/2003
 
-[ns_RESULT, ContCount, Data] = mexprog(8, hFile, EntityID - 1, StartIndex - 1, IndexCount);
+if (nargin < 5)
+    Options = [];
+end;
+if (isstruct(Options) && isfield(Options, 'Reference') && isnumeric(Options.Reference))
+    Options.Reference = Options.Reference - 1;
+end;
+
+[ns_RESULT, ContCount, Data, Scale, Blocks] = mexprog(8, hFile, EntityID - 1, StartIndex - 1, IndexCount, Options);
+if iscell(Blocks)
+    for i = 1:numel(Blocks)
+        if ~isempty(Blocks{i})
+            Blocks{i}(:, 1) = Blocks{i}(:, 1) + 1;
+        end;
+    end;
+end;
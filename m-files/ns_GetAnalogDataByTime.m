@@ -0,0 +1,67 @@
+function [ns_RESULT, ContCount, Data, Time, StartIndex, IndexCount, Scale] = ns_GetAnalogDataByTime(hFile, EntityID, StartTime, EndTime, Options);
+
+%ns_GetAnalogDataByTime   Retrieves analog data within a time window
+%
+%   Usage:
+%      [ns_RESULT, ContCount, Data, Time] = 
+%               ns_GetAnalogDataByTime(hFile, EntityID, StartTime, EndTime)
+%      [ns_RESULT, ContCount, Data, Time, StartIndex, IndexCount, Scale] = 
+%               ns_GetAnalogDataByTime(hFile, EntityID, StartTime, EndTime, Options)
+%   
+%   Description:
+%       Returns the data values of the Analog Entities EntityID in the 
+%       file referenced by hFile from StartTime to EndTime.  For every
+%       entity the data starts with the first index at or after StartTime
+%       and ends with the last index at or before EndTime, so entities
+%       with different sample rates are read correctly with one call.
+%       Data has one column per entity.  Entities with fewer values in
+%       the window are padded with NaN (0 for int16 data) at the end of
+%       their column; IndexCount gives the number of values of every
+%       entity.
+%       With Options.Decimate every row of Data covers Decimate indexes
+%       and IndexCount still counts the indexes read from the file.
+%       Time holds the time of every row of Data.  If all entities start
+%       at the same time with the same sample rate, Time is a single
+%       column, otherwise it has one column per entity.  Time is computed
+%       from the sample rate, so it does not reflect gaps in the data;
+%       ContCount contains the number of continuous data points of every
+%       entity (starting at StartIndex).
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartTime       Start of the time window in seconds.
+%       EndTime         End of the time window in seconds.
+%       Options         Optional structure with additional read options
+%                       (see ns_GetAnalogData).
+%
+%   Return Values:
+%       ContCount	    Number of continuous data values of every entity
+%                       starting with StartIndex.
+%       Data	        Array of double precision values (or of the class
+%                       given by Options) to receive the analog data.
+%       Time            Time of every row of Data in seconds.
+%       StartIndex      Index of the first value of every entity (NaN if
+%                       the entity has no data in the window).
+%       IndexCount      Number of values of every entity.
+%       Scale           Value of one count of Data for every entity (see
+%                       ns_GetAnalogData).
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 5)
+    Options = [];
+end;
+
+[ns_RESULT, ContCount, Data, Time, StartIndex, IndexCount, Scale] = mexprog(22, hFile, EntityID - 1, StartTime, EndTime, Options);
+StartIndex = StartIndex + 1;
@@ -0,0 +1,72 @@
+function [ns_RESULT, Min, Max, Time] = ns_GetAnalogEnvelope(hFile, EntityID, StartTime, EndTime, Columns, Options);
+
+%ns_GetAnalogEnvelope   Retrieves the minimum and maximum of analog data for display
+%
+%   Usage:
+%      [ns_RESULT, Min, Max, Time] = 
+%               ns_GetAnalogEnvelope(hFile, EntityID, StartTime, EndTime, Columns)
+%      [ns_RESULT, Min, Max, Time] = 
+%               ns_GetAnalogEnvelope(hFile, EntityID, StartTime, EndTime, Columns, Options)
+%   
+%   Description:
+%       Divides the time window from StartTime to EndTime into Columns
+%       columns of equal length, e.g. one per pixel of a plot, and returns
+%       the minimum and maximum of the data of the Analog Entities
+%       EntityID in every column.  Plotting Min and Max of every column
+%       shows the data without loss of peaks at any zoom level.
+%       The values are taken from an envelope of every entity that is
+%       kept between calls and completed as the data is queried, so after
+%       the first query of a part of the file redrawing it does not read
+%       the data again.  The envelope is made of bins of 1024 indexes
+%       (indexes 1-1024, 1025-2048, ...).  Columns of more than 1024
+%       indexes are taken from these bins: both edges of such a column
+%       are moved outward to the edge of the bin they fall into, so the
+%       column may include up to 1023 indexes of each neighbour.  Min and
+%       Max are the exact minimum and maximum of the column widened this
+%       way.  Narrower columns are computed from the data itself.
+%       Data read with ns_GetAnalogData is added
+%       to the envelope of an entity once it has been queried.
+%       The envelopes are released when the file is closed.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartTime       Start of the time window in seconds.
+%       EndTime         End of the time window in seconds.
+%       Columns         Number of columns the time window is divided into.
+%       Options         Optional structure with the fields:
+%                         Threads   Number of worker threads computing
+%                                   entities in parallel (default 1,
+%                                   0 = one per processor).
+%                         Sidecar   If true, the envelopes are stored in
+%                                   files next to the data file (named
+%                                   after the data file and the entity)
+%                                   and read from there when the file is
+%                                   opened again.  A stored envelope is
+%                                   only used if the size and the
+%                                   modification time of the data file
+%                                   did not change (default false).
+%
+%   Return Values:
+%       Min             Minimum of every column, one column per entity.
+%                       Columns without data are NaN.
+%       Max             Maximum of every column, one column per entity.
+%       Time            Time of the center of every column in seconds.
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 6)
+    Options = [];
+end;
+
+[ns_RESULT, Min, Max, Time] = mexprog(23, hFile, EntityID - 1, StartTime, EndTime, Columns, Options);
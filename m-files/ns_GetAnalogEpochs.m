@@ -0,0 +1,68 @@
+function [ns_RESULT, Data, Time, Scale] = ns_GetAnalogEpochs(hFile, EntityID, TriggerTime, PreTime, PostTime, Options);
+
+%ns_GetAnalogEpochs   Retrieves windows of analog data around trigger times
+%
+%   Usage:
+%      [ns_RESULT, Data, Time] = 
+%               ns_GetAnalogEpochs(hFile, EntityID, TriggerTime, PreTime, PostTime)
+%      [ns_RESULT, Data, Time, Scale] = 
+%               ns_GetAnalogEpochs(hFile, EntityID, TriggerTime, PreTime, PostTime, Options)
+%   
+%   Description:
+%       Returns the data of the Analog Entities EntityID in the file
+%       referenced by hFile from PreTime before to PostTime after every
+%       trigger time, e.g. the timestamps of an Event Entity returned by
+%       ns_GetEventData.  The window of every trial starts at the index
+%       closest to the trigger time, so the data of every entity is
+%       aligned to its own samples.  Windows that overlap or lie close
+%       together are read at once.
+%       Samples of a window that lie before the first or after the last
+%       index of an entity and trials whose trigger time does not lie
+%       within the data of an entity are NaN.  The samples are taken by
+%       index; windows that span a gap in the data are not adjusted (see
+%       Options.Blocks of ns_GetAnalogData).
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       TriggerTime     Vector of trigger times in seconds.
+%       PreTime         Time of the window before every trigger in
+%                       seconds.
+%       PostTime        Time of the window after every trigger in
+%                       seconds.
+%       Options         Optional structure with the fields:
+%                         Threads   Number of worker threads reading
+%                                   entities in parallel (default 1,
+%                                   0 = one per processor).
+%                         Class     Class of Data: 'double' (default),
+%                                   'single' or 'int16' (see 
+%                                   ns_GetAnalogData).  int16 data is 0
+%                                   where other classes are NaN.
+%
+%   Return Values:
+%       Data            Array of samples x trials x entities.  Entities
+%                       with a lower sample rate than others have fewer
+%                       samples and are padded with NaN.
+%       Time            Time of every sample relative to the trigger in
+%                       seconds; a single column if all entities have the
+%                       same sample rate, one column per entity otherwise.
+%       Scale           Value of one count of Data for every entity (see
+%                       ns_GetAnalogData).
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 6)
+    Options = [];
+end;
+
+[ns_RESULT, Data, Time, Scale] = mexprog(24, hFile, EntityID - 1, TriggerTime, PreTime, PostTime, Options);
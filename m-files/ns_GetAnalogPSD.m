@@ -0,0 +1,77 @@
+function [ns_RESULT, PSD, Frequency] = ns_GetAnalogPSD(hFile, EntityID, StartIndex, IndexCount, Options);
+
+%ns_GetAnalogPSD   Estimates the power spectral density of analog data
+%
+%   Usage:
+%      [ns_RESULT, PSD, Frequency] = ns_GetAnalogPSD(hFile, EntityID)
+%      [ns_RESULT, PSD, Frequency] = 
+%               ns_GetAnalogPSD(hFile, EntityID, StartIndex, IndexCount)
+%      [ns_RESULT, PSD, Frequency] = 
+%               ns_GetAnalogPSD(hFile, EntityID, StartIndex, IndexCount, Options)
+%   
+%   Description:
+%       Returns the power spectral density of the Analog Entities
+%       EntityID in the file referenced by hFile, estimated with Welch's
+%       method like pwelch: the data is cut into overlapping segments, 
+%       every segment is multiplied by a window and the periodograms of
+%       the segments are averaged.  The data is read in chunks and only
+%       the spectra are returned, so recordings of any length can be
+%       processed.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartIndex	    Starting index number of the analog data (default
+%                       1).
+%       IndexCount	    Number of analog values to use.  Inf (default)
+%                       uses all values of every entity from StartIndex
+%                       on.
+%       Options         Optional structure with the fields:
+%                         Window    Length of the segments, which are
+%                                   multiplied by a Hamming window, or
+%                                   the window itself (default 1024).
+%                         Overlap   Number of values shared by two
+%                                   neighbouring segments (default half
+%                                   the window length).
+%                         NFFT      Length of the Fourier transform; it
+%                                   must be a power of 2 and not less
+%                                   than the window length (default the
+%                                   next power of 2, at least 256).
+%                         Threads   Number of worker threads reading
+%                                   entities in parallel (default 1,
+%                                   0 = one per processor).
+%
+%   Return Values:
+%       PSD             One-sided power spectral density in units^2/Hz,
+%                       one column of NFFT / 2 + 1 values per entity.
+%                       Entities with less values than the window length
+%                       have a column of NaN.
+%       Frequency       Frequency of every row of PSD in Hz.  If the
+%                       entities have different sample rates, there is
+%                       a column for every entity.
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_BADINDEX	    Invalid entity index or range 
+%                                       specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 3)
+    StartIndex = 1;
+end;
+if (nargin < 4)
+    IndexCount = Inf;
+end;
+if (nargin < 5)
+    Options = [];
+end;
+
+[ns_RESULT, PSD, Frequency] = mexprog(26, hFile, EntityID - 1, StartIndex - 1, IndexCount, Options);
@@ -0,0 +1,70 @@
+function [ns_RESULT, Stats] = ns_GetAnalogStats(hFile, EntityID, StartIndex, IndexCount, Options);
+
+%ns_GetAnalogStats   Retrieves statistics of analog data
+%
+%   Usage:
+%      [ns_RESULT, Stats] = ns_GetAnalogStats(hFile, EntityID)
+%      [ns_RESULT, Stats] = 
+%               ns_GetAnalogStats(hFile, EntityID, StartIndex, IndexCount)
+%      [ns_RESULT, Stats] = 
+%               ns_GetAnalogStats(hFile, EntityID, StartIndex, IndexCount, Options)
+%   
+%   Description:
+%       Returns the mean, RMS, minimum, maximum and the percentage of
+%       clipped samples of the Analog Entities EntityID in the file
+%       referenced by hFile, e.g. to check all channels of a recording.
+%       The data is read in chunks and only the statistics are returned,
+%       so recordings of any length can be processed.
+%       A sample is clipped if it is at or below MinVal or at or above
+%       MaxVal given by ns_GetAnalogInfo.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartIndex	    Starting index number of the analog data (default
+%                       1).
+%       IndexCount	    Number of analog values to use.  Inf (default)
+%                       uses all values of every entity from StartIndex
+%                       on.
+%       Options         Optional structure with the fields:
+%                         Threads   Number of worker threads reading
+%                                   entities in parallel (default 1,
+%                                   0 = one per processor).
+%
+%   Return Values:
+%       Stats           Structure per entity with the fields:
+%                         IndexCount      Number of values used
+%                         Mean            Mean of the values
+%                         RMS             Root mean square of the values
+%                         Min             Minimum of the values
+%                         Max             Maximum of the values
+%                         PercentClipped  Percentage of clipped values
+%                                         (NaN if MinVal and MaxVal do
+%                                         not give a range)
+%                       The fields are NaN for entities without values.
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_BADINDEX	    Invalid entity index or range 
+%                                       specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 3)
+    StartIndex = 1;
+end;
+if (nargin < 4)
+    IndexCount = Inf;
+end;
+if (nargin < 5)
+    Options = [];
+end;
+
+[ns_RESULT, Stats] = mexprog(25, hFile, EntityID - 1, StartIndex - 1, IndexCount, Options);
@@ -1,10 +1,14 @@
-function [ns_RESULT, TimeStamp, Data, DataSize] = ns_GetEventData(hFile, EntityID, Index);
+function [ns_RESULT, TimeStamp, Data, DataSize, FieldNames, Dictionary] = ns_GetEventData(hFile, EntityID, Index, Options);
 
 %ns_GetEventData   Retrieves event data by index
 %
 %   Usage:
 %      [ns_RESULT, TimeStamp, Data, DataSize] = 
 %                                   ns_GetEventData(hFile, EntityID, Index)
+%      [ns_RESULT, TimeStamp, Data, DataSize, FieldNames] = 
+%                                   ns_GetEventData(hFile, EntityID, Index)
+%      [ns_RESULT, TimeStamp, Data, DataSize, FieldNames, Dictionary] = 
+%                          ns_GetEventData(hFile, EntityID, Index, Options)
 %
 %   Description:
 %       Returns the data values from the file referenced by hFile and the
@@ -12,12 +16,32 @@ function [ns_RESULT, TimeStamp, Data, DataSize] = ns_GetEventData(hFile, EntityI
 %       is written to Data and the timestamp of the entry is returned to
 %       TimeStamp.  Upon return of the function, the value at DataSize
 %       contains the number of bytes actually written to Data.
+%       The comma separated values of CSV events are converted into
+%       numbers: Data then has one row per index, one column per field
+%       and one page per entity, with NaN for fields that are missing or
+%       not a number.  The fields are given by the member CSVDesc of
+%       ns_EVENTINFO and their names are returned in FieldNames.
+%       With Options.Dictionary text events are returned as uint32 codes
+%       instead of a cell array of strings: Dictionary holds every
+%       distinct string once and Data(i) is the row of Dictionary with
+%       the text of event i (0 for events that were not read), so
+%       Dictionary(Data(i)) is its text.
 %
 %   Parameters:
 %       hFile	        Handle/Indentification number to an open file.
 %       EntityID	    Identification number of the entity in the data
 %                       file.
 %       Index	        The index number of the requested Event data item.
+%       Options         Optional structure with additional read options:
+%                       Dictionary  If true, text events are returned as
+%                                   codes into Dictionary (default false).
+%                       TimeStampsOnly  If true, only TimeStamp is read;
+%                                   the data of the events is not loaded
+%                                   and all other outputs are empty
+%                                   (default false).
+%                       Threads     Number of threads used to read the
+%                                   time stamps of several entities at
+%                                   once (see ns_GetAnalogData).
 %
 %   Return Values:
 %       TimeStamp	    Variable that receives the timestamp of the Event
@@ -27,6 +51,10 @@ function [ns_RESULT, TimeStamp, Data, DataSize] = ns_GetEventData(hFile, EntityI
 %                       EventType in ns_EVENTINFO.
 %       DataSize	    Variable that receives the actual number of bytes
 %                       of data retrieved in the data buffer.
+%       FieldNames      Names of the fields of CSV events (empty for other
+%                       events).
+%       Dictionary      Distinct strings of text events read with
+%                       Options.Dictionary (empty otherwise).
 %       ns_RESULT   This function returns ns_OK if the file is successfully
 %                   opened. Otherwise one of the following error codes is 
 %                   generated:
@@ -42,4 +70,8 @@ function [ns_RESULT, TimeStamp, Data, DataSize] = ns_GetEventData(hFile, EntityI
 %   Author: Almut Branner
 %   Last modification: 8/11/2003
 
-[ns_RESULT, TimeStamp, Data, DataSize] = mexprog(6, hFile, EntityID - 1, Index - 1);
+if (nargin < 4)
+    Options = [];
+end;
+
+[ns_RESULT, TimeStamp, Data, DataSize, FieldNames, Dictionary] = mexprog(6, hFile, EntityID - 1, Index - 1, Options);
@@ -0,0 +1,60 @@
+function [ns_RESULT, Events] = ns_GetEventDataBatch(hFile, EntityID, Index, Options);
+
+%ns_GetEventDataBatch   Retrieves event data of entities of any event type
+%
+%   Usage:
+%      [ns_RESULT, Events] = ns_GetEventDataBatch(hFile, EntityID, Index)
+%      [ns_RESULT, Events] = 
+%                     ns_GetEventDataBatch(hFile, EntityID, Index, Options)
+%
+%   Description:
+%       Returns the Event data entries Index of the Event Entities 
+%       EntityID in the file referenced by hFile.  Unlike ns_GetEventData
+%       the entities may be of different event types; all of them are
+%       read with one call.  Events has one element per entity with the
+%       fields:
+%           TimeStamp   Timestamps of the events.
+%           Data        Data of the events in the type of the entity:
+%                       uint8, uint16 or uint32 values for byte, word and
+%                       dword events, a cell array of strings for text
+%                       events (uint32 codes into Dictionary with
+%                       Options.Dictionary) and one column per field for
+%                       CSV events (see ns_GetEventData).
+%           DataSize    Number of bytes of data of every event.
+%           FieldNames  Names of the fields of CSV events.
+%           Dictionary  Distinct strings of text events read with
+%                       Options.Dictionary.
+%       The fields of entities that do not exist are empty.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Event Entities in
+%                       the data file.
+%       Index	        The index number(s) of the requested Event data
+%                       items (the same for all entities).
+%       Options         Optional structure with additional read options:
+%                       Dictionary  If true, text events are returned as
+%                                   codes into Dictionary (default false).
+%
+%   Return Values:
+%       Events          Structure array with the events of every entity.
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADFILE	    Invalid file handle passed to 
+%                                       function
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_BADINDEX	    Invalid entity index specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 4)
+    Options = [];
+end;
+
+[ns_RESULT, Events] = mexprog(32, hFile, EntityID - 1, Index - 1, Options);
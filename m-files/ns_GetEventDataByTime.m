@@ -0,0 +1,71 @@
+function [ns_RESULT, TimeStamp, Data, DataSize, StartIndex, IndexCount, FieldNames, Dictionary] = ns_GetEventDataByTime(hFile, EntityID, StartTime, EndTime, Options);
+
+%ns_GetEventDataByTime   Retrieves event data within a time window
+%
+%   Usage:
+%      [ns_RESULT, TimeStamp, Data, DataSize, StartIndex, IndexCount] = 
+%               ns_GetEventDataByTime(hFile, EntityID, StartTime, EndTime)
+%      [ns_RESULT, TimeStamp, Data, DataSize, StartIndex, IndexCount, 
+%       FieldNames, Dictionary] = 
+%               ns_GetEventDataByTime(hFile, EntityID, StartTime, EndTime, 
+%                                     Options)
+%
+%   Description:
+%       Returns all events of the Event Entities EntityID in the file
+%       referenced by hFile with a timestamp from StartTime to EndTime.
+%       The events of the window are found by a binary search over the
+%       timestamps, so only these events are read from the file.  The
+%       timestamps that were looked up are kept until the file is closed,
+%       which makes further windows of the same entities faster.
+%       All entities must be of the same event type.  TimeStamp, Data and
+%       DataSize have one column per entity.  Entities with fewer events
+%       in the window are padded at the end of their column with NaN
+%       (empty cells for text events) and a DataSize of 0; IndexCount
+%       gives the number of events of every entity.  CSV events are
+%       converted into numbers and Options.Dictionary returns text events
+%       as codes into one Dictionary for all entities as by
+%       ns_GetEventData; these codes are padded with 0.  With
+%       Options.TimeStampsOnly only TimeStamp is returned, taken from the
+%       timestamps that are kept where possible; the entities may then
+%       be of different event types.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Event Entities in
+%                       the data file.
+%       StartTime       Start of the time window in seconds.
+%       EndTime         End of the time window in seconds.
+%       Options         Optional structure with additional read options
+%                       (see ns_GetEventData).
+%
+%   Return Values:
+%       TimeStamp	    Timestamps of the events.
+%       Data	        Data of the events (see ns_GetEventData).
+%       DataSize	    Number of bytes of data of every event.
+%       StartIndex      Index of the first event of every entity in the
+%                       window (NaN if the entity has no events in it).
+%       IndexCount      Number of events of every entity in the window.
+%       FieldNames      Names of the fields of CSV events (empty for other
+%                       events).
+%       Dictionary      Distinct strings of text events read with
+%                       Options.Dictionary (empty otherwise).
+%       ns_RESULT   This function returns ns_OK if the data is successfully
+%                   retrieved. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADFILE	    Invalid file handle passed to 
+%                                       function
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_FILEERROR	File access or read error
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 5)
+    Options = [];
+end;
+
+[ns_RESULT, TimeStamp, Data, DataSize, StartIndex, IndexCount, FieldNames, Dictionary] = mexprog(31, hFile, EntityID - 1, StartTime, EndTime, Options);
+StartIndex = StartIndex + 1;
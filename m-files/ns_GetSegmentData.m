@@ -1,10 +1,12 @@
-function [ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = ns_GetSegmentData(hFile, EntityID, Index);
+function [ns_RESULT, TimeStamp, Data, SampleCount, UnitID, Scale] = ns_GetSegmentData(hFile, EntityID, Index, Options);
 
 %ns_GetSegmentData   Retrieves segment data by index
 %
 %   Usage:
 %      [ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = 
 %                               ns_GetSegmentData(hFile, EntityID, Index)
+%      [ns_RESULT, TimeStamp, Data, SampleCount, UnitID, Scale] = 
+%                               ns_GetSegmentData(hFile, EntityID, Index, Options)
 %
 %   Description:
 %       Returns the Segment data values in entry Index of the entity
@@ -19,6 +21,17 @@ function [ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = ns_GetSegmentData(h
 %       hFile	    Handle/Indentification number to an open file.
 %       EntityID    Identification number of the entity in the data file.
 %       Index	    Index number of the requested Segment data item.
+%       Options     Optional structure with additional read options:
+%                   Class   Class of Data: 'double' (default), 'single'
+%                           or 'int16'.  int16 data holds the raw counts
+%                           of the Resolution of the first source given
+%                           by ns_GetSegmentSourceInfo.
+%                   TimeStampsOnly  If true, only TimeStamp is read;
+%                           the waveforms are not loaded and all other
+%                           outputs are empty (default false).
+%                   Threads Number of threads used to read the time
+%                           stamps of several entities at once (see
+%                           ns_GetAnalogData).
 %
 %   Remarks:
 %       A zero unit ID is unclassified, then follow unit 1, 2, 3, etc. Unit
@@ -29,6 +42,9 @@ function [ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = ns_GetSegmentData(h
 %       Data	    Variable to receive the requested data.
 %       SampleCount	Number of samples returned in the data variable.
 %       UnitID	    Unit classification code for the Segment Entity.
+%       Scale       Value of one count of Data for every entity: the
+%                   Resolution of the first source for int16 data, 1 for
+%                   double and single data.
 %       ns_RESULT   This function returns ns_OK if the file is successfully
 %                   opened. Otherwise one of the following error codes is 
 %                   generated:
@@ -44,8 +60,11 @@ function [ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = ns_GetSegmentData(h
 %   Author: Almut Branner
 %   Last modification: 10/24/2003
 
+if (nargin < 4)
+    Options = [];
+end;
 
-[ns_RESULT, TimeStamp, Data, SampleCount, UnitID] = mexprog(11, hFile, EntityID - 1, Index - 1);
+[ns_RESULT, TimeStamp, Data, SampleCount, UnitID, Scale] = mexprog(11, hFile, EntityID - 1, Index - 1, Options);
 Data = squeeze(Data);
 if (size(Data, 2) == 1)
     Data = Data';
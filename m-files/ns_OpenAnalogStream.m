@@ -0,0 +1,57 @@
+function [ns_RESULT, hStream] = ns_OpenAnalogStream(hFile, EntityID, StartIndex, IndexCount, ChunkSize, Options);
+
+%ns_OpenAnalogStream   Opens a stream to read analog data in chunks
+%
+%   Usage:
+%      [ns_RESULT, hStream] = ns_OpenAnalogStream(hFile, EntityID, 
+%                               StartIndex, IndexCount, ChunkSize)
+%      [ns_RESULT, hStream] = ns_OpenAnalogStream(hFile, EntityID, 
+%                               StartIndex, IndexCount, ChunkSize, Options)
+%
+%   Description:
+%       Opens a stream over the IndexCount analog values starting at
+%       StartIndex of the Analog Entities EntityID in the file referenced
+%       by hFile.  The data is then read with ns_ReadAnalogStream in
+%       chunks of at most ChunkSize values per entity, so recordings that
+%       do not fit into memory can be processed piece by piece.  The
+%       stream must be closed with ns_CloseAnalogStream.
+%       All entities of a stream should have the same sample rate.
+%       With Options.Class = 'int16' the stream returns raw counts; 
+%       multiply them by the Resolution given by ns_GetAnalogInfo to get
+%       the analog values.
+%       With Options.Filter the state of the filter is kept from chunk to
+%       chunk, so the chunks join as if the whole stream had been filtered
+%       at once.  A ZeroPhase filter reads ahead into the next chunk for
+%       its backward pass.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       StartIndex	    Starting index number of the analog data item.
+%       IndexCount	    Number of analog values of the stream.
+%       ChunkSize       Maximum number of analog values per entity returned
+%                       by one call to ns_ReadAnalogStream.
+%       Options         Optional structure with additional read options
+%                       (see ns_GetAnalogData).
+%
+%   Return Values:
+%       hStream         Handle to the opened stream.
+%       ns_RESULT   This function returns ns_OK if the stream is successfully
+%                   opened. Otherwise one of the following error codes is 
+%                   generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_LIBERROR	    Too many open streams or invalid
+%                                       range
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 6)
+    Options = [];
+end;
+
+[ns_RESULT, hStream] = mexprog(19, hFile, EntityID - 1, StartIndex - 1, IndexCount, ChunkSize, Options);
@@ -0,0 +1,53 @@
+function [ns_RESULT, Info] = ns_ReadAhead(MaxBytes);
+
+%ns_ReadAhead   Sets the memory used to read analog data ahead
+%
+%   Usage:
+%      [ns_RESULT, Info] = ns_ReadAhead
+%      [ns_RESULT, Info] = ns_ReadAhead(MaxBytes)
+%   
+%   Description:
+%       When an Analog Entity is read window after window, e.g. by
+%       ns_GetAnalogData or ns_ReadAnalogStream, the next window is read
+%       in the background while Matlab works on the current one.  The
+%       next call that reads this window gets the data from memory.
+%       Only reads of the same window of all requested entities without
+%       Decimate, Filter or Reference options are served this way.
+%
+%       MaxBytes limits the memory used for these windows (64 MB by
+%       default, 0 turns reading ahead off).  Setting it drops all
+%       windows read so far and resets the counters.  Without MaxBytes
+%       only the counters are returned.
+%
+%       Libraries that are not multithread safe are only called in the
+%       background while no other Neuroshare function runs.
+%
+%   Parameters:
+%       MaxBytes        Maximum number of bytes of all windows read
+%                       ahead (optional).
+%
+%   Return Values:
+%       Info            Structure with the fields:
+%                         MaxBytes     Maximum number of bytes
+%                         Bytes        Bytes of the windows kept now
+%                         Requests     Entities read since the counters
+%                                      were reset
+%                         Hits         Entities served from memory
+%                         HitRate      Hits / Requests
+%                         ReadAhead    Windows read ahead
+%                         Wasted       Windows dropped without being used
+%                         WastedBytes  Bytes of the wasted windows
+%       ns_RESULT   This function returns ns_OK if MaxBytes is valid.
+%                   Otherwise the following error code is generated:
+%
+%                       ns_LIBERROR	MaxBytes is not a non-negative number.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 1)
+    MaxBytes = [];
+end;
+
+[ns_RESULT, Info] = mexprog(27, MaxBytes);
@@ -0,0 +1,41 @@
+function [ns_RESULT, ContCount, Data, Index, Time] = ns_ReadAnalogStream(hStream);
+
+%ns_ReadAnalogStream   Reads the next chunk of an analog stream
+%
+%   Usage:
+%      [ns_RESULT, ContCount, Data, Index, Time] = 
+%                                           ns_ReadAnalogStream(hStream)
+%
+%   Description:
+%       Returns the next chunk of analog data of the stream hStream
+%       opened with ns_OpenAnalogStream.  Data has one column per entity
+%       of the stream and at most ChunkSize rows.  Once all data of the
+%       stream was read, Data is empty.
+%
+%   Parameters:
+%       hStream         Handle to a stream opened by ns_OpenAnalogStream.
+%
+%   Return Values:
+%       ContCount	    Number of continuous data values of every entity
+%                       starting with the first row of Data.
+%       Data	        Array of double precision values with the analog
+%                       data of the chunk.
+%       Index           Index of the first row of Data.
+%       Time            Time of the first row of Data for every entity.
+%       ns_RESULT   This function returns ns_OK if the chunk was read
+%                   successfully. Otherwise one of the following error codes
+%                   is generated:
+%
+%                       ns_BADENTITY	Invalid or inappropriate entity 
+%                                       identifier specified
+%                       ns_BADINDEX	    Invalid entity index or range 
+%                                       specified
+%                       ns_FILEERROR	File access or read error
+%                       ns_LIBERROR	    Invalid stream handle
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+[ns_RESULT, ContCount, Data, Index, Time] = mexprog(20, hStream);
+Index = Index + 1;
@@ -0,0 +1,605 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: dsp.c $
+//
+// Description   : Sample conversion and signal processing routines used by the
+//                 MATLAB wrapper.
+//
+//                 The inner loops are kept free of function calls and branches
+//                 that depend on earlier iterations so that the compiler can
+//                 vectorize them.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "dsp.h"
+
+#include <math.h>
+
+#define DSP_PI 3.14159265358979323846
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Sample conversion
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert double precision samples to single precision
+// Inputs:  pdSrc - samples to convert
+//          nCount - number of samples
+//          pfDst - receives nCount single precision samples
+void dsp_DoubleToSingle(const double *DSP_RESTRICT pdSrc, size_t nCount, float *DSP_RESTRICT pfDst)
+{
+    size_t i;
+
+    for (i = 0; i < nCount; ++i)
+        pfDst[i] = (float) pdSrc[i];
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert samples back to the raw ADC counts they were scaled from
+//          Every sample is divided by the resolution and rounded to the nearest
+//          integer. Values outside the int16 range saturate, NaN becomes 0.
+// Inputs:  pdSrc - samples to convert
+//          nCount - number of samples
+//          dResolution - value of one ADC count
+//          pnDst - receives nCount raw counts
+void dsp_DoubleToInt16(const double *DSP_RESTRICT pdSrc, size_t nCount, double dResolution,
+                       short *DSP_RESTRICT pnDst)
+{
+    const double dScale = 1.0 / dResolution;
+    double dValue;
+    size_t i;
+
+    for (i = 0; i < nCount; ++i)
+    {
+        dValue = pdSrc[i] * dScale;
+        dValue = (dValue == dValue) ? dValue : 0.0;
+        dValue = (dValue < -32768.0) ? -32768.0 : dValue;
+        dValue = (dValue > 32767.0) ? 32767.0 : dValue;
+
+        // Round half away from zero, the conversion itself truncates
+        pnDst[i] = (short) (dValue + ((dValue < 0.0) ? -0.5 : 0.5));
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert single precision samples to double precision
+// Inputs:  pfSrc - samples to convert
+//          nCount - number of samples
+//          pdDst - receives nCount double precision samples
+void dsp_SingleToDouble(const float *DSP_RESTRICT pfSrc, size_t nCount, double *DSP_RESTRICT pdDst)
+{
+    size_t i;
+
+    for (i = 0; i < nCount; ++i)
+        pdDst[i] = (double) pfSrc[i];
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Scale raw ADC counts to samples
+// Inputs:  pnSrc - raw counts to convert
+//          nCount - number of counts
+//          dResolution - value of one ADC count
+//          pdDst - receives nCount samples
+void dsp_Int16ToDouble(const short *DSP_RESTRICT pnSrc, size_t nCount, double dResolution,
+                       double *DSP_RESTRICT pdDst)
+{
+    size_t i;
+
+    for (i = 0; i < nCount; ++i)
+        pdDst[i] = pnSrc[i] * dResolution;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// FIR filters
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Design a linear phase low pass filter (Hamming windowed sinc) with a gain of 1 at DC
+// Inputs:  dCutoff - cutoff frequency as a fraction of the sample rate (0 < dCutoff < 0.5)
+//          nTaps - number of coefficients, should be odd for a delay of whole samples
+//          pdTaps - receives nTaps coefficients (the filter is symmetric)
+void dsp_DesignLowpass(double dCutoff, size_t nTaps, double *pdTaps)
+{
+    double dCenter = (nTaps - 1) / 2.0;
+    double dSum = 0;
+    double dX;
+    size_t k;
+
+    for (k = 0; k < nTaps; ++k)
+    {
+        dX = k - dCenter;
+        if (0 == dX)
+            pdTaps[k] = 2 * dCutoff;
+        else
+            pdTaps[k] = sin(2 * DSP_PI * dCutoff * dX) / (DSP_PI * dX);
+
+        if (1 < nTaps)
+            pdTaps[k] *= 0.54 - 0.46 * cos(2 * DSP_PI * k / (nTaps - 1));
+        dSum += pdTaps[k];
+    }
+
+    for (k = 0; k < nTaps; ++k)
+        pdTaps[k] /= dSum;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Filter and decimate samples, i.e. compute only every nStep-th output of the filter
+//          pdDst[m] = sum(pdTaps[k] * pdSrc[m * nStep + k]) for k = 0 ... nTaps - 1
+//          The sum is split into four independent partial sums, so the products can be
+//          computed with vector instructions.
+// Inputs:  pdSrc - samples; (nOutputs - 1) * nStep + nTaps values are read
+//          nOutputs - number of outputs to compute
+//          nStep - decimation factor
+//          pdTaps - filter coefficients (in reverse order for a filter that is not symmetric)
+//          nTaps - number of coefficients, must be a multiple of 4 (pad with zeros)
+//          pdDst - receives nOutputs values
+void dsp_FirDecimate(const double *DSP_RESTRICT pdSrc, size_t nOutputs, size_t nStep, 
+                     const double *DSP_RESTRICT pdTaps, size_t nTaps, double *DSP_RESTRICT pdDst)
+{
+    const double *pdX;
+    double dSum0;
+    double dSum1;
+    double dSum2;
+    double dSum3;
+    size_t m;
+    size_t k;
+
+    for (m = 0; m < nOutputs; ++m)
+    {
+        pdX = pdSrc + m * nStep;
+        dSum0 = dSum1 = dSum2 = dSum3 = 0;
+
+        for (k = 0; k < nTaps; k += 4)
+        {
+            dSum0 += pdTaps[k] * pdX[k];
+            dSum1 += pdTaps[k + 1] * pdX[k + 1];
+            dSum2 += pdTaps[k + 2] * pdX[k + 2];
+            dSum3 += pdTaps[k + 3] * pdX[k + 3];
+        }
+
+        pdDst[m] = (dSum0 + dSum1) + (dSum2 + dSum3);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Envelopes
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the minimum and maximum of samples
+//          Four independent minima and maxima are kept, so consecutive comparisons
+//          do not depend on each other and can be done with vector instructions.
+// Inputs:  pdSrc - samples
+//          nCount - number of samples, at least 1
+//          pdMin - receives the minimum
+//          pdMax - receives the maximum
+void dsp_MinMax(const double *DSP_RESTRICT pdSrc, size_t nCount, double *pdMin, double *pdMax)
+{
+    double adMin[4];
+    double adMax[4];
+    size_t i;
+    size_t k;
+
+    for (k = 0; k < 4; ++k)
+        adMin[k] = adMax[k] = pdSrc[0];
+
+    for (i = 0; i + 4 <= nCount; i += 4)
+    {
+        for (k = 0; k < 4; ++k)
+        {
+            adMin[k] = (pdSrc[i + k] < adMin[k]) ? pdSrc[i + k] : adMin[k];
+            adMax[k] = (pdSrc[i + k] > adMax[k]) ? pdSrc[i + k] : adMax[k];
+        }
+    }
+    for (; i < nCount; ++i)
+    {
+        adMin[0] = (pdSrc[i] < adMin[0]) ? pdSrc[i] : adMin[0];
+        adMax[0] = (pdSrc[i] > adMax[0]) ? pdSrc[i] : adMax[0];
+    }
+
+    for (k = 1; k < 4; ++k)
+    {
+        adMin[0] = (adMin[k] < adMin[0]) ? adMin[k] : adMin[0];
+        adMax[0] = (adMax[k] > adMax[0]) ? adMax[k] : adMax[0];
+    }
+    *pdMin = adMin[0];
+    *pdMax = adMax[0];
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Statistics
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Reset running statistics
+// Inputs:  pStats - the statistics
+void dsp_InitStats(DSP_STATS *pStats)
+{
+    pStats->dSum = 0;
+    pStats->dSumSquares = 0;
+    pStats->dMin = HUGE_VAL;
+    pStats->dMax = -HUGE_VAL;
+    pStats->dClipped = 0;
+    pStats->dCount = 0;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Add samples to running statistics
+//          Like dsp_MinMax four independent partial results are kept. The sums of every
+//          call are added to the totals at the end, so long recordings added in chunks
+//          lose less precision than a single running sum.
+// Inputs:  pdSrc - samples
+//          nCount - number of samples
+//          dLow - samples at or below this value are clipped
+//          dHigh - samples at or above this value are clipped
+//          pStats - the statistics to add the samples to
+void dsp_Accumulate(const double *DSP_RESTRICT pdSrc, size_t nCount, double dLow, double dHigh,
+                    DSP_STATS *pStats)
+{
+    double adSum[4] = {0, 0, 0, 0};
+    double adSquares[4] = {0, 0, 0, 0};
+    double adClipped[4] = {0, 0, 0, 0};
+    double adMin[4];
+    double adMax[4];
+    double dValue;
+    size_t i;
+    size_t k;
+
+    for (k = 0; k < 4; ++k)
+    {
+        adMin[k] = pStats->dMin;
+        adMax[k] = pStats->dMax;
+    }
+
+    for (i = 0; i + 4 <= nCount; i += 4)
+    {
+        for (k = 0; k < 4; ++k)
+        {
+            dValue = pdSrc[i + k];
+            adSum[k] += dValue;
+            adSquares[k] += dValue * dValue;
+            adClipped[k] += ((dValue <= dLow) | (dValue >= dHigh)) ? 1.0 : 0.0;
+            adMin[k] = (dValue < adMin[k]) ? dValue : adMin[k];
+            adMax[k] = (dValue > adMax[k]) ? dValue : adMax[k];
+        }
+    }
+    for (; i < nCount; ++i)
+    {
+        dValue = pdSrc[i];
+        adSum[0] += dValue;
+        adSquares[0] += dValue * dValue;
+        adClipped[0] += ((dValue <= dLow) | (dValue >= dHigh)) ? 1.0 : 0.0;
+        adMin[0] = (dValue < adMin[0]) ? dValue : adMin[0];
+        adMax[0] = (dValue > adMax[0]) ? dValue : adMax[0];
+    }
+
+    for (k = 1; k < 4; ++k)
+    {
+        adMin[0] = (adMin[k] < adMin[0]) ? adMin[k] : adMin[0];
+        adMax[0] = (adMax[k] > adMax[0]) ? adMax[k] : adMax[0];
+    }
+    pStats->dSum += (adSum[0] + adSum[1]) + (adSum[2] + adSum[3]);
+    pStats->dSumSquares += (adSquares[0] + adSquares[1]) + (adSquares[2] + adSquares[3]);
+    pStats->dClipped += (adClipped[0] + adClipped[1]) + (adClipped[2] + adClipped[3]);
+    pStats->dMin = adMin[0];
+    pStats->dMax = adMax[0];
+    pStats->dCount += (double) nCount;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the median of values by selection (Wirth's algorithm), which takes
+//          linear time on average instead of sorting all values
+// Inputs:  pdValues - values; they are reordered
+//          nCount - number of values, at least 1
+// Outputs: double - the median; the mean of the two middle values for an even count
+double dsp_Median(double *pdValues, size_t nCount)
+{
+    ptrdiff_t nMiddle = (ptrdiff_t) (nCount / 2);
+    ptrdiff_t nLeft = 0;
+    ptrdiff_t nRight = (ptrdiff_t) nCount - 1;
+    ptrdiff_t i;
+    ptrdiff_t j;
+    double dPivot;
+    double dSwap;
+    double dLower;
+
+    // Afterwards no value before nMiddle is larger and none after it is smaller
+    while (nLeft < nRight)
+    {
+        dPivot = pdValues[nMiddle];
+        i = nLeft;
+        j = nRight;
+        do
+        {
+            while (pdValues[i] < dPivot)
+                ++i;
+            while (dPivot < pdValues[j])
+                --j;
+            if (i <= j)
+            {
+                dSwap = pdValues[i];
+                pdValues[i] = pdValues[j];
+                pdValues[j] = dSwap;
+                ++i;
+                --j;
+            }
+        } while (i <= j);
+
+        if (j < nMiddle)
+            nLeft = i;
+        if (nMiddle < i)
+            nRight = j;
+    }
+
+    if (nCount & 1)
+        return(pdValues[nMiddle]);
+
+    // The lower middle value is the largest value before nMiddle
+    dLower = pdValues[0];
+    for (i = 1; i < nMiddle; ++i)
+        dLower = (pdValues[i] > dLower) ? pdValues[i] : dLower;
+    return((dLower + pdValues[nMiddle]) / 2);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// IIR filters
+//
+// A filter is a cascade of second order sections (biquads). Every section
+// is given by DSP_BIQUAD_SIZE coefficients b0, b1, b2, a1, a2 (a0 = 1) and
+// keeps 2 values of state in transposed direct form II.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the largest radius of the poles of a filter; the filter is stable if it is
+//          below 1 and the state of the filter decays by this factor per sample
+// Inputs:  pdSos - coefficients of the sections
+//          nSections - number of sections
+// Outputs: double - the largest pole radius
+double dsp_BiquadRadius(const double *pdSos, size_t nSections)
+{
+    double dRadius = 0;
+    double dRoot;
+    double a1;
+    double a2;
+    size_t i;
+
+    for (i = 0; i < nSections; ++i)
+    {
+        // Poles are the roots of z^2 + a1 z + a2
+        a1 = pdSos[i * DSP_BIQUAD_SIZE + 3];
+        a2 = pdSos[i * DSP_BIQUAD_SIZE + 4];
+        if (a1 * a1 < 4 * a2)
+        {
+            dRoot = sqrt(a2);
+        }
+        else
+        {
+            dRoot = fabs(-a1 / 2 + sqrt(a1 * a1 / 4 - a2));
+            if (fabs(-a1 / 2 - sqrt(a1 * a1 / 4 - a2)) > dRoot)
+                dRoot = fabs(-a1 / 2 - sqrt(a1 * a1 / 4 - a2));
+        }
+        if (dRoot > dRadius)
+            dRadius = dRoot;
+    }
+    return(dRadius);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Set the state of a filter to the one it settles to for a constant input, so
+//          that filtering a signal that starts with this value has no transient
+// Inputs:  pdSos - coefficients of the sections
+//          nSections - number of sections
+//          dValue - the constant input
+//          pdState - receives 2 values per section
+void dsp_BiquadSteadyState(const double *pdSos, size_t nSections, double dValue, double *pdState)
+{
+    const double *pdSection;
+    double dGain;
+    size_t i;
+
+    for (i = 0; i < nSections; ++i)
+    {
+        // The output of a section for a constant input is the input times its gain at
+        // DC, which is the input of the next section
+        pdSection = pdSos + i * DSP_BIQUAD_SIZE;
+        dGain = (pdSection[0] + pdSection[1] + pdSection[2]) / (1 + pdSection[3] + pdSection[4]);
+        pdState[2 * i + 1] = (pdSection[2] - pdSection[4] * dGain) * dValue;
+        pdState[2 * i] = (pdSection[1] - pdSection[3] * dGain) * dValue + pdState[2 * i + 1];
+        dValue *= dGain;
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Filter samples in place with a cascade of biquads
+//          Every section runs over all samples before the next one, so the samples stay
+//          in the cache and the state is held in registers. The recursion of a section
+//          cannot be vectorized.
+// Inputs:  pdSos - coefficients of the sections
+//          nSections - number of sections
+//          pdState - state of the filter (2 values per section), updated
+//          pdData - samples to filter, replaced by the filtered samples
+//          nCount - number of samples
+//          bReverse - filter the samples from the last to the first
+void dsp_Biquads(const double *pdSos, size_t nSections, double *pdState, double *pdData, 
+                 size_t nCount, int bReverse)
+{
+    const double *pdSection;
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+    double x, y;
+    ptrdiff_t nStep = bReverse ? -1 : 1;
+    ptrdiff_t k;
+    size_t i;
+    size_t n;
+
+    for (i = 0; i < nSections; ++i)
+    {
+        pdSection = pdSos + i * DSP_BIQUAD_SIZE;
+        b0 = pdSection[0];
+        b1 = pdSection[1];
+        b2 = pdSection[2];
+        a1 = pdSection[3];
+        a2 = pdSection[4];
+        z1 = pdState[2 * i];
+        z2 = pdState[2 * i + 1];
+
+        k = bReverse ? (ptrdiff_t) nCount - 1 : 0;
+        for (n = 0; n < nCount; ++n, k += nStep)
+        {
+            x = pdData[k];
+            y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            pdData[k] = y;
+        }
+
+        pdState[2 * i] = z1;
+        pdState[2 * i + 1] = z2;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Spectra
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Compute a symmetric Hamming window (like hamming in Matlab)
+// Inputs:  nLength - number of values
+//          pdWindow - receives nLength values
+void dsp_HammingWindow(size_t nLength, double *pdWindow)
+{
+    size_t k;
+
+    for (k = 0; k < nLength; ++k)
+    {
+        pdWindow[k] = 1;
+        if (1 < nLength)
+            pdWindow[k] = 0.54 - 0.46 * cos(2 * DSP_PI * k / (nLength - 1));
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Compute the twiddle factors of a fast Fourier transform
+// Inputs:  nLength - length of the transform (a power of 2)
+//          pdTable - receives nLength values: cos(2 pi k / nLength), then sin(2 pi k / nLength)
+//                    for k = 0 ... nLength / 2 - 1
+void dsp_FftTable(size_t nLength, double *pdTable)
+{
+    size_t k;
+
+    for (k = 0; k < nLength / 2; ++k)
+    {
+        pdTable[k] = cos(2 * DSP_PI * k / nLength);
+        pdTable[nLength / 2 + k] = sin(2 * DSP_PI * k / nLength);
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Compute the discrete Fourier transform of complex values in place
+//          (radix 2, decimation in time): X[k] = sum(x[n] * exp(-2 pi i k n / nLength))
+// Inputs:  pdReal - real parts, replaced by the real parts of the transform
+//          pdImag - imaginary parts, replaced by the imaginary parts of the transform
+//          nLength - number of values (a power of 2)
+//          pdTable - twiddle factors computed by dsp_FftTable for nLength
+void dsp_Fft(double *pdReal, double *pdImag, size_t nLength, const double *pdTable)
+{
+    const double *pdSin = pdTable + nLength / 2;
+    double dReal;
+    double dImag;
+    double dTemp;
+    size_t nHalf;
+    size_t nStride;
+    size_t i;
+    size_t j;
+    size_t k;
+
+    // Bit reversed order
+    for (i = 1, j = 0; i < nLength; ++i)
+    {
+        for (k = nLength >> 1; j & k; k >>= 1)
+            j ^= k;
+        j |= k;
+        if (i < j)
+        {
+            dTemp = pdReal[i];
+            pdReal[i] = pdReal[j];
+            pdReal[j] = dTemp;
+            dTemp = pdImag[i];
+            pdImag[i] = pdImag[j];
+            pdImag[j] = dTemp;
+        }
+    }
+
+    // Butterflies of transforms of length 2 * nHalf
+    for (nHalf = 1; nHalf < nLength; nHalf *= 2)
+    {
+        nStride = nLength / (2 * nHalf);
+        for (i = 0; i < nLength; i += 2 * nHalf)
+        {
+            for (k = 0; k < nHalf; ++k)
+            {
+                j = i + k + nHalf;
+                dReal = pdTable[k * nStride] * pdReal[j] + pdSin[k * nStride] * pdImag[j];
+                dImag = pdTable[k * nStride] * pdImag[j] - pdSin[k * nStride] * pdReal[j];
+                pdReal[j] = pdReal[i + k] - dReal;
+                pdImag[j] = pdImag[i + k] - dImag;
+                pdReal[i + k] += dReal;
+                pdImag[i + k] += dImag;
+            }
+        }
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Add the power spectra of two real signals that were transformed together, the
+//          first one as real, the second one as imaginary part of the input of dsp_Fft
+//          The power of both at frequency k is (|Z[k]|^2 + |Z[nLength - k]|^2) / 2.
+//          A single signal with an imaginary part of zero is added correctly as well.
+// Inputs:  pdReal - real parts of the transform
+//          pdImag - imaginary parts of the transform
+//          nLength - length of the transform
+//          pdPower - nLength / 2 + 1 values the power of both signals is added to
+void dsp_AddPower(const double *pdReal, const double *pdImag, size_t nLength, double *pdPower)
+{
+    size_t k;
+    size_t m;
+
+    for (k = 0; k <= nLength / 2; ++k)
+    {
+        m = (nLength - k) & (nLength - 1);
+        pdPower[k] += (pdReal[k] * pdReal[k] + pdImag[k] * pdImag[k] + 
+                       pdReal[m] * pdReal[m] + pdImag[m] * pdImag[m]) / 2;
+    }
+}
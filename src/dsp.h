@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: dsp.h $
+//
+// Description   : Sample conversion and signal processing routines used by the
+//                 MATLAB wrapper. The routines work on plain C arrays, so they
+//                 may be called from worker threads.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DSP_H_INCLUDED   // Include guards
+#define DSP_H_INCLUDED
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Source and destination arrays of the routines never overlap. Telling the
+// compiler so allows it to vectorize the loops.
+#define DSP_RESTRICT __restrict
+
+void dsp_DoubleToSingle(const double *DSP_RESTRICT pdSrc, size_t nCount, float *DSP_RESTRICT pfDst);
+void dsp_DoubleToInt16(const double *DSP_RESTRICT pdSrc, size_t nCount, double dResolution,
+                       short *DSP_RESTRICT pnDst);
+void dsp_SingleToDouble(const float *DSP_RESTRICT pfSrc, size_t nCount, double *DSP_RESTRICT pdDst);
+void dsp_Int16ToDouble(const short *DSP_RESTRICT pnSrc, size_t nCount, double dResolution,
+                       double *DSP_RESTRICT pdDst);
+
+void dsp_DesignLowpass(double dCutoff, size_t nTaps, double *pdTaps);
+void dsp_FirDecimate(const double *DSP_RESTRICT pdSrc, size_t nOutputs, size_t nStep, 
+                     const double *DSP_RESTRICT pdTaps, size_t nTaps, double *DSP_RESTRICT pdDst);
+
+void dsp_MinMax(const double *DSP_RESTRICT pdSrc, size_t nCount, double *pdMin, double *pdMax);
+
+// Running statistics of samples, see dsp_Accumulate
+typedef struct
+{
+    double dSum;              // sum of the samples
+    double dSumSquares;       // sum of the squares of the samples
+    double dMin;              // minimum (+Inf if no samples were added)
+    double dMax;              // maximum (-Inf if no samples were added)
+    double dClipped;          // number of samples at or beyond the clipping limits
+    double dCount;            // number of samples
+} DSP_STATS;
+
+void dsp_InitStats(DSP_STATS *pStats);
+void dsp_Accumulate(const double *DSP_RESTRICT pdSrc, size_t nCount, double dLow, double dHigh,
+                    DSP_STATS *pStats);
+
+double dsp_Median(double *pdValues, size_t nCount);
+
+// Number of coefficients of a second order section (b0, b1, b2, a1, a2) of an IIR filter
+#define DSP_BIQUAD_SIZE 5
+
+double dsp_BiquadRadius(const double *pdSos, size_t nSections);
+void dsp_BiquadSteadyState(const double *pdSos, size_t nSections, double dValue, double *pdState);
+void dsp_Biquads(const double *pdSos, size_t nSections, double *pdState, double *pdData, 
+                 size_t nCount, int bReverse);
+
+void dsp_HammingWindow(size_t nLength, double *pdWindow);
+void dsp_FftTable(size_t nLength, double *pdTable);
+void dsp_Fft(double *pdReal, double *pdImag, size_t nLength, const double *pdTable);
+void dsp_AddPower(const double *pdReal, const double *pdImag, size_t nLength, double *pdPower);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // include guards
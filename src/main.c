@@ -197,16 +197,34 @@
 
 #include "mex.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
 // Load library for Neuroshare
 #include "ns.h"
+#include "threads.h"
+#include "dsp.h"
+#include "mapfile.h"
 
 ns_DLLHANDLE g_nsDllHandle = 0;
 
+// Whether the loaded library reported itself as multithread safe
+// (-1 = not probed yet, see fLibraryIsThreadSafe)
+int g_nThreadSafe = -1;
+
+// Serializes calls into libraries that are not multithread safe
+TH_MUTEX g_nsLibraryLock = TH_MUTEX_INITIALIZER;
+
+void fReleaseFile(UINT32 hFile);
+void fReleaseAll(void);
+
 typedef int BOOL;
 #define FALSE 0
 #define TRUE  1
@@ -230,7 +248,8 @@ typedef int BOOL;
             // handle library closure 
             // (MEX DLL is unlinked by "clear all", "clear mexprog", or matlab closure)
             case DLL_PROCESS_DETACH: 
-                // Unload Neuroshare DLL here
+                // Release streams etc. and unload Neuroshare DLL here
+                fReleaseAll();
                 if (g_nsDllHandle)
                     ns_CloseLibrary(g_nsDllHandle);
                 break;
@@ -249,6 +268,7 @@ typedef int BOOL;
 
     int __attribute__ ((destructor)) mexprog_fini (void)
     {
+        fReleaseAll();
         if (g_nsDllHandle)
             ns_CloseLibrary(g_nsDllHandle);
 
@@ -265,1619 +285,9436 @@ typedef int BOOL;
 
 ////////////////////////////////////////////////////////////////////////////
 //
-// Specific Neuroshare functions
+// Helper functions
 //
-//      Each specific function calls the appropriate function in the 
-//      Neuroshare DLL with the input arguments it was given. The returned
-//      data are then converted into MATLAB mxArrays and passed back to the
-//      main function.
+//      Functions shared by the specific Neuroshare functions below, e.g. to
+//      read optional arguments or to call the library from worker threads.
 //
 ////////////////////////////////////////////////////////////////////////////
 
-// Author & Date: Almut Branner, 2/4/2003
-// Purpose: Load Neuroshare DLL and open the data file
-// Inputs:  szFile - name of the file to be opened
-//          ppmxFilehandle - double pointer to the handle/ID number of the 
-//                           file that was opened
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxFilehandle is filled
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Check whether an options argument is valid
+// Inputs:  pmxOptions - options argument passed from Matlab
+// Outputs: BOOL - TRUE if pmxOptions is empty or a scalar structure
+BOOL fIsOptions(const mxArray *pmxOptions)
+{
+    if (mxIsEmpty(pmxOptions))
+        return(TRUE);
+    return(mxIsStruct(pmxOptions) && (mxGetNumberOfElements(pmxOptions) == 1));
+}
 
-// TODO: This function will eventually select a DLL based on the file extension
-//       and load that DLL. At this point only NEV files are supported.
-ns_RESULT fOpenFile(char *szFile, mxArray **ppmxFilehandle)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get a numeric option from the options structure
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          szName - name of the option (structure field)
+//          dDefault - value to use if the option is not given
+// Outputs: double - the value of the option
+double fGetOption(const mxArray *pmxOptions, const char *szName, double dDefault)
 {
-    UINT32 hFile;
-    ns_RESULT nsresult;
+    const mxArray *pmxValue;
 
-    nsresult = ns_OpenFile(g_nsDllHandle, szFile, &hFile);
+    if (!pmxOptions || !mxIsStruct(pmxOptions))
+        return(dDefault);
 
-    if (0 != nsresult) 
-    {
-        *ppmxFilehandle = mxCreateString("");
-        mexPrintf("NEV file could not be loaded!\n");
-    }
-    else 
-    {
-        *ppmxFilehandle = mxCreateScalarDouble(hFile);
-    }
+    pmxValue = mxGetField(pmxOptions, 0, szName);
+    if (!pmxValue || mxIsEmpty(pmxValue) || !(mxIsNumeric(pmxValue) || mxIsLogical(pmxValue)))
+        return(dDefault);
 
-    return(nsresult);
+    return(mxGetScalar(pmxValue));
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// Author & Date: Almut Branner, 2/3/2003
-// Purpose: Get library information and convert it into Matlab format
-// Inputs:  ppmxInfo - double pointer to the mex converted ns_LIBRARYINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled
-ns_RESULT fLibInfo(mxArray **ppmxInfo)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Check whether an option is given in the options structure
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          szName - name of the option (structure field)
+// Outputs: BOOL - TRUE if the field exists and is not empty
+BOOL fHasOption(const mxArray *pmxOptions, const char *szName)
 {
-    // Arrays & enumerations with structure element names are created
-    enum
-    {
-        LI_LIB_VERSION_MAJ,
-        LI_LIB_VERSION_MIN,
-        LI_API_VERSION_MAJ, 
-        LI_API_VERSION_MIN, 
-        LI_DESCRIPTION,
-        LI_CREATOR, 
-        LI_TIME_YEAR,
-        LI_TIME_MONTH,
-        LI_TIME_DAY,
-        LI_FLAGS,
-        LI_MAX_FILES, 
-        LI_FILE_DESC_COUNT,
-        LI_FILE_DESC,
-        LI_COUNT
-    };
-    
-    const char *aszLibInfoNames[LI_COUNT] = 
-    {
-        "LibVersionMaj",
-        "LibVersionMin",
-        "APIVersionMaj", 
-        "APIVersionMin", 
-        "Description",
-        "Creator", 
-        "Time_Year",
-        "Time_Month",
-        "Time_Day",
-        "Flags",
-        "MaxFiles", 
-        "FileDescCount",
-        "FileDesc"
-    };
+    const mxArray *pmxValue;
 
-    enum
-    {
-        FD_DESCRIPTION,
-        FD_EXTENSION,
-        FD_MACCODES,
-        FD_MAGICCODE,
-        FD_COUNT
-    };
-    const char *aszFileDescNames[FD_COUNT] = 
-    {
-        "Description",
-        "Extension",
-        "MacCodes",
-        "MagicCode"
-    };
+    if (!pmxOptions || !mxIsStruct(pmxOptions))
+        return(FALSE);
 
+    pmxValue = mxGetField(pmxOptions, 0, szName);
+    return(pmxValue && !mxIsEmpty(pmxValue));
+}
 
-    // Intermediate mxArrays to hold the structures
-    mxArray *mxOutput;
-    mxArray *mxFileDesc;
-    mxArray *mxFieldValue;
-    BOOL bPrev = FALSE;
-    char szTemp[80];
-    ns_LIBRARYINFO nsLibInfo;
-    ns_RESULT nsresult;
-    unsigned int i;
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get a string option from the options structure
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          szName - name of the option (structure field)
+//          szValue - receives the string
+//          cbValue - size of the szValue buffer
+// Outputs: BOOL - TRUE if the option is given as a string that fits into szValue
+BOOL fGetOptionString(const mxArray *pmxOptions, const char *szName, char *szValue, size_t cbValue)
+{
+    const mxArray *pmxValue;
 
-    nsresult = ns_GetLibraryInfo(g_nsDllHandle, &nsLibInfo, (UINT32)sizeof(nsLibInfo));
+    if (!fHasOption(pmxOptions, szName))
+        return(FALSE);
 
-    if (0 == nsresult)
-    {
-        // A structure array to hold the libray information is created
-        mxOutput = mxCreateStructMatrix(1, 1, 13, aszLibInfoNames);
+    pmxValue = mxGetField(pmxOptions, 0, szName);
+    if (!mxIsChar(pmxValue))
+        return(FALSE);
 
-        // The library information is converted into Matlab mxArrays
-        // and the fields of the structure array are filled
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwLibVersionMaj);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_LIB_VERSION_MAJ], mxFieldValue);
+    return(0 == mxGetString(pmxValue, szValue, (mwSize) cbValue));
+}
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwLibVersionMin);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_LIB_VERSION_MIN], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the class of the data output requested in the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          pClassID - receives the class (mxDOUBLE_CLASS if the option is not given)
+// Outputs: BOOL - FALSE if the Class option is not 'double', 'single' or 'int16'
+BOOL fGetClassOption(const mxArray *pmxOptions, mxClassID *pClassID)
+{
+    char szClass[8];
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwAPIVersionMaj);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_API_VERSION_MAJ], mxFieldValue);
+    *pClassID = mxDOUBLE_CLASS;
+    if (!fHasOption(pmxOptions, "Class"))
+        return(TRUE);
+    if (!fGetOptionString(pmxOptions, "Class", szClass, sizeof(szClass)))
+        return(FALSE);
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwAPIVersionMin);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_API_VERSION_MIN], mxFieldValue);
+    if (0 == strcmp(szClass, "double"))
+        *pClassID = mxDOUBLE_CLASS;
+    else if (0 == strcmp(szClass, "single"))
+        *pClassID = mxSINGLE_CLASS;
+    else if (0 == strcmp(szClass, "int16"))
+        *pClassID = mxINT16_CLASS;
+    else
+        return(FALSE);
+    return(TRUE);
+}
 
-        mxFieldValue = mxCreateString(nsLibInfo.szDescription);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_DESCRIPTION], mxFieldValue);
+// Largest factor accepted by the Decimate option
+#define MAX_DECIMATE 10000
 
-        mxFieldValue = mxCreateString(nsLibInfo.szCreator);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_CREATOR], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the decimation factor requested in the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          pdwDecimate - receives the factor (1 if the option is not given)
+// Outputs: BOOL - FALSE if the Decimate option is not a positive integer
+BOOL fGetDecimateOption(const mxArray *pmxOptions, UINT32 *pdwDecimate)
+{
+    double dDecimate = fGetOption(pmxOptions, "Decimate", 1);
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Year);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_YEAR], mxFieldValue);
+    *pdwDecimate = 1;
+    if ((fHasOption(pmxOptions, "Decimate") && !mxIsNumeric(mxGetField(pmxOptions, 0, "Decimate"))) ||
+        !(dDecimate >= 1) || (dDecimate > MAX_DECIMATE) || (dDecimate != floor(dDecimate)))
+        return(FALSE);
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Month);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_MONTH], mxFieldValue);
+    *pdwDecimate = (UINT32) dDecimate;
+    return(TRUE);
+}
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Day);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_DAY], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the options of an analog read and report invalid ones
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          pClassID - receives the class of the data
+//          pdwDecimate - receives the decimation factor
+// Outputs: BOOL - FALSE if an option is not valid (a message is printed)
+BOOL fGetAnalogOptions(const mxArray *pmxOptions, mxClassID *pClassID, UINT32 *pdwDecimate)
+{
+    if (!fGetClassOption(pmxOptions, pClassID))
+    {
+        mexPrintf("Class option must be 'double', 'single' or 'int16'.\n");
+        return(FALSE);
+    }
+    if (!fGetDecimateOption(pmxOptions, pdwDecimate))
+    {
+        mexPrintf("Decimate option must be a positive integer.\n");
+        return(FALSE);
+    }
+    return(TRUE);
+}
 
-        if (nsLibInfo.dwFlags & ns_LIBRARY_DEBUG)
-        {
-            strcpy(szTemp, "DEBUG ");
-            bPrev = TRUE;
-        }
-        if (nsLibInfo.dwFlags & ns_LIBRARY_MODIFIED)
-        {
-            if (bPrev == FALSE) 
-            {
-                strcpy(szTemp, "MODIFIED ");
-                bPrev = TRUE;
-            }
-            else
-                strcat(szTemp, "+ MODIFIED ");
-        }
-        if (nsLibInfo.dwFlags & ns_LIBRARY_PRERELEASE)
-        {
-            if (bPrev == FALSE) 
-            {
-                strcpy(szTemp, "PRERELEASE ");
-                bPrev = TRUE;
-            }
-            else
-                strcat(szTemp, "+ PRERELEASE ");
-        }
-        if (nsLibInfo.dwFlags & ns_LIBRARY_SPECIALBUILD)
-        {
-            if (bPrev == FALSE) 
-            {
-                strcpy(szTemp, "SPECIALBUILD ");
-                bPrev = TRUE;
-            }
-            else
-                strcat(szTemp, "+ SPECIALBUILD ");
-        }
-        if (nsLibInfo.dwFlags & ns_LIBRARY_MULTITHREADED)
-        {
-            if (bPrev == FALSE)
-                strcpy(szTemp, "MULTITHREADED");
-            else
-                strcat(szTemp, "+ MULTITHREADED");
-        }
-        if (bPrev == FALSE)
-            strcpy(szTemp, "NONE");
-            
+// One past the last index the Neuroshare API can address
+#define MAX_INDEX_RANGE 4294967296.0
 
-        mxFieldValue = mxCreateString(szTemp);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FLAGS], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Check an index passed from Matlab before it is converted to the 32 bit indeces
+//          of the Neuroshare API. Converting a double outside of their range is undefined.
+// Inputs:  pmxIndex - the index (double scalar)
+// Outputs: BOOL - TRUE if the index is an integer within 0 ... 2^32 - 1
+BOOL fIsIndex(const mxArray *pmxIndex)
+{
+    double dIndex = mxGetScalar(pmxIndex);
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwMaxFiles);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_MAX_FILES], mxFieldValue);
+    return((dIndex >= 0) && (dIndex < MAX_INDEX_RANGE) && (dIndex == floor(dIndex)));
+}
 
-        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwFileDescCount);
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FILE_DESC_COUNT], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Check an index range passed from Matlab before it is converted to the 32 bit
+//          indeces of the Neuroshare API, where it would silently wrap around
+//          Matlab passes indeces as doubles, which hold integers exactly up to 2^53.
+// Inputs:  pmxIndex - first index of the range (double scalar)
+//          pmxIndexCount - number of indeces in the range (double scalar)
+// Outputs: BOOL - TRUE if both are integers that fit into 32 bits and all indeces of the
+//          range lie within 0 ... 2^32 - 2, so that one past its end fits into 32 bits too
+BOOL fIsIndexRange(const mxArray *pmxIndex, const mxArray *pmxIndexCount)
+{
+    double dIndexCount = mxGetScalar(pmxIndexCount);
 
-        
-        // Build the other structure
+    return(fIsIndex(pmxIndex) && fIsIndex(pmxIndexCount) && 
+           (mxGetScalar(pmxIndex) + dIndexCount < MAX_INDEX_RANGE));
+}
 
-        mxFileDesc = mxCreateStructMatrix(nsLibInfo.dwFileDescCount, 1, 4, aszFileDescNames);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert samples into the memory of an output matrix of the given class
+//          May be called from worker threads.
+// Inputs:  pdSrc - samples to convert
+//          nCount - number of samples
+//          classID - class of the output (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+//          dScale - value of one raw count (only used for mxINT16_CLASS)
+//          pvDst - receives nCount values of the given class
+void fConvertSamples(const double *pdSrc, size_t nCount, mxClassID classID, double dScale, void *pvDst)
+{
+    if (mxSINGLE_CLASS == classID)
+        dsp_DoubleToSingle(pdSrc, nCount, (float *) pvDst);
+    else if (mxINT16_CLASS == classID)
+        dsp_DoubleToInt16(pdSrc, nCount, dScale, (short *) pvDst);
+    else if (pvDst != pdSrc)
+        memcpy(pvDst, pdSrc, nCount * sizeof(double));
+}
 
-        for (i = 0; i < nsLibInfo.dwFileDescCount; ++i)
-        {
-            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szDescription);
-            mxSetField(mxFileDesc, i, aszFileDescNames[FD_DESCRIPTION], mxFieldValue);
-            
-            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szExtension);
-            mxSetField(mxFileDesc, i, aszFileDescNames[FD_EXTENSION], mxFieldValue);
-            
-            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szMacCodes);
-            mxSetField(mxFileDesc, i, aszFileDescNames[FD_MACCODES], mxFieldValue);
-            
-            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szMagicCode);
-            mxSetField(mxFileDesc, i, aszFileDescNames[FD_MAGICCODE], mxFieldValue);
-        }
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the size of one element of an output matrix of the given class
+// Inputs:  classID - class of the output (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+// Outputs: size_t - size of one element in bytes
+size_t fClassSize(mxClassID classID)
+{
+    if (mxSINGLE_CLASS == classID)
+        return(sizeof(float));
+    if (mxINT16_CLASS == classID)
+        return(sizeof(short));
+    return(sizeof(double));
+}
 
-        // Now put the structure into the other structure
-        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FILE_DESC], mxFileDesc);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the number of worker threads requested in the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+// Outputs: int - number of threads; 0 in the options selects one thread per processor
+int fGetThreadOption(const mxArray *pmxOptions)
+{
+    double dThreads = fGetOption(pmxOptions, "Threads", 1);
 
+    if (dThreads < 0.5)
+        return(th_GetProcessorCount());
+    if (dThreads > TH_MAX_THREADS)
+        return(TH_MAX_THREADS);
+    return((int) dThreads);
+}
 
-        // Assign the structure array to the output argument
-        *ppmxInfo = mxOutput;
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Check an options argument and the options shared by all functions (Threads)
+// Inputs:  pmxOptions - options argument passed from Matlab
+// Outputs: BOOL - TRUE if the options are valid; otherwise a message is printed
+BOOL fCheckOptions(const mxArray *pmxOptions)
+{
+    const mxArray *pmxThreads;
+    double dThreads;
+
+    if (!fIsOptions(pmxOptions))
+    {
+        mexPrintf("Options input must be a structure or empty.\n");
+        return(FALSE);
     }
-    else
+
+    // Threads must be a non-negative integer (0 selects one thread per processor)
+    if (fHasOption(pmxOptions, "Threads"))
     {
-        mexPrintf("There was an error running ns_GetLibraryInfo!\n");
-        *ppmxInfo = mxCreateString("");
+        pmxThreads = mxGetField(pmxOptions, 0, "Threads");
+        dThreads = fGetOption(pmxOptions, "Threads", -1);
+        if (!mxIsNumeric(pmxThreads) || (mxGetNumberOfElements(pmxThreads) != 1) ||
+            !mxIsFinite(dThreads) || !(dThreads >= 0) || (dThreads != floor(dThreads)))
+        {
+            mexPrintf("Threads option must be a non-negative integer.\n");
+            return(FALSE);
+        }
     }
-    return(nsresult);
+    return(TRUE);
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Get file information and convert it into Matlab format
-// Inputs:  hFile - handle/ID number of the file
-//          ppmxInfo - double pointer to the mex converted ns_FILEINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fFileInfo(UINT32 hFile, mxArray **ppmxInfo)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find out whether the loaded library may be called from several threads at once.
+//          The library is probed once via the ns_LIBRARY_MULTITHREADED flag of its
+//          ns_LIBRARYINFO. Must be called from the Matlab thread before any worker
+//          thread calls into the library.
+// Outputs: BOOL - TRUE if the library is multithread safe
+BOOL fLibraryIsThreadSafe(void)
+{
+    ns_LIBRARYINFO nsLibInfo;
+
+    if (-1 == g_nThreadSafe)
+    {
+        g_nThreadSafe = 0;
+        if (0 == ns_GetLibraryInfo(g_nsDllHandle, &nsLibInfo, (UINT32) sizeof(nsLibInfo)))
+        {
+            if (nsLibInfo.dwFlags & ns_LIBRARY_MULTITHREADED)
+                g_nThreadSafe = 1;
+        }
+    }
+    return(1 == g_nThreadSafe);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Call ns_GetAnalogData of the library. May be called from worker threads.
+//          Calls are serialized unless the library is known to be multithread safe.
+// Inputs:  see fReadAnalog
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fCallAnalog(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount,
+                      UINT32 *pdwContCount, double *pdData)
 {
-    const char *aszFileInfoNames[] = {"FileType","EntityCount","TimeStampResolution",
-                                "TimeSpan","AppName","Time_Year","Time_Month","Time_Day",
-                                "Time_Hour","Time_Min","Time_Sec","Time_MilliSec",
-                                "FileComment"};
-    mxArray *mxOutput;
-    mxArray *mxFieldValue;
-    ns_FILEINFO nsFileInfo;
     ns_RESULT nsresult;
+    BOOL bSerialize = (1 != g_nThreadSafe);
 
-    nsresult = ns_GetFileInfo(g_nsDllHandle, hFile, &nsFileInfo, (UINT32)sizeof(nsFileInfo));
+    if (bSerialize)
+        th_MutexLock(&g_nsLibraryLock);
 
-    if (0 == nsresult)
-    {
-        mxOutput = mxCreateStructMatrix(1, 1, 13, aszFileInfoNames);
+    nsresult = ns_GetAnalogData(g_nsDllHandle, hFile, dwEntityID, dwIndex, dwIndexCount,
+                                pdwContCount, pdData);
 
-        mxFieldValue = mxCreateString(nsFileInfo.szFileType);
-        mxSetField(mxOutput, 0, aszFileInfoNames[0], mxFieldValue);
+    if (bSerialize)
+        th_MutexUnlock(&g_nsLibraryLock);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwEntityCount);
-        mxSetField(mxOutput, 0, aszFileInfoNames[1], mxFieldValue);
+    return(nsresult);
+}
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dTimeStampResolution);
-        mxSetField(mxOutput, 0, aszFileInfoNames[2], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Call ns_GetTimeByIndex of the library. May be called from worker threads.
+//          Calls are serialized unless the library is known to be multithread safe.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the entity
+//          dwIndex - the index
+//          pdTime - receives the time of the index
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fCallTimeByIndex(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, double *pdTime)
+{
+    ns_RESULT nsresult;
+    BOOL bSerialize = (1 != g_nThreadSafe);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dTimeSpan);
-        mxSetField(mxOutput, 0, aszFileInfoNames[3], mxFieldValue);
+    if (bSerialize)
+        th_MutexLock(&g_nsLibraryLock);
 
-        mxFieldValue = mxCreateString(nsFileInfo.szAppName);
-        mxSetField(mxOutput, 0, aszFileInfoNames[4], mxFieldValue);
+    nsresult = ns_GetTimeByIndex(g_nsDllHandle, hFile, dwEntityID, dwIndex, pdTime);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Year);
-        mxSetField(mxOutput, 0, aszFileInfoNames[5], mxFieldValue);
+    if (bSerialize)
+        th_MutexUnlock(&g_nsLibraryLock);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Month);
-        mxSetField(mxOutput, 0, aszFileInfoNames[6], mxFieldValue);
+    return(nsresult);
+}
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Day);
-        mxSetField(mxOutput, 0, aszFileInfoNames[7], mxFieldValue);
+// Largest number of indeces passed to the library in one call. Some libraries compute
+// the size of the data in bytes with 32 bit arithmetic, which overflows for 2^29 and
+// more indeces; larger reads also block other threads for longer.
+#define ANALOG_READ_WINDOW 0x1000000
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Hour);
-        mxSetField(mxOutput, 0, aszFileInfoNames[8], mxFieldValue);
+// Reads go through the block cache first, see below
+BOOL fCacheRead(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount,
+                UINT32 *pdwContCount, double *pdData);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Min);
-        mxSetField(mxOutput, 0, aszFileInfoNames[9], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read analog data from the library. May be called from worker threads.
+//          Data kept in the block cache is taken from there. Reads of more than 
+//          ANALOG_READ_WINDOW indeces are split into several calls.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - entity to read
+//          dwIndex - first index to read
+//          dwIndexCount - how many indeces are read
+//          pdwContCount - receives the number of continuous indeces
+//          pdData - receives dwIndexCount values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fReadAnalog(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount,
+                      UINT32 *pdwContCount, double *pdData)
+{
+    ns_RESULT nsresult;
+    BOOL bGap = FALSE;
+    UINT32 dwDone = 0;
+    UINT32 dwOverlap = 0;
+    UINT32 dwCount;
+    UINT32 dwContCount;
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Sec);
-        mxSetField(mxOutput, 0, aszFileInfoNames[10], mxFieldValue);
+    if (fCacheRead(hFile, dwEntityID, dwIndex, dwIndexCount, pdwContCount, pdData))
+        return(ns_OK);
 
-        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_MilliSec);
-        mxSetField(mxOutput, 0, aszFileInfoNames[11], mxFieldValue);
+    *pdwContCount = 0;
 
-        mxFieldValue = mxCreateString(nsFileInfo.szFileComment);
-        mxSetField(mxOutput, 0, aszFileInfoNames[12], mxFieldValue);
+    // Large reads are split into windows and stitched together again; the continuous
+    // count ends with the first gap within or between the windows. Libraries only report
+    // gaps within a call, so every window after the first starts with the last index of
+    // the window before: a gap between the windows ends its continuous count after one.
+    do
+    {
+        dwCount = dwIndexCount - dwDone;
+        if (dwCount > ANALOG_READ_WINDOW - dwOverlap)
+            dwCount = ANALOG_READ_WINDOW - dwOverlap;
+
+        dwContCount = 0;
+        nsresult = fCallAnalog(hFile, dwEntityID, dwIndex + dwDone - dwOverlap, dwCount + dwOverlap, 
+                               &dwContCount, pdData + dwDone - dwOverlap);
+        if (0 != nsresult)
+            break;
 
-        *ppmxInfo = mxOutput;
-    }
-    else
+        if (!bGap)
+        {
+            *pdwContCount += (dwContCount > dwOverlap) ? dwContCount - dwOverlap : 0;
+            bGap = (dwContCount < dwCount + dwOverlap);
+        }
+        dwDone += dwCount;
+        dwOverlap = 1;
+    } while (dwDone < dwIndexCount);
+
+    return(nsresult);
+}
+
+// Continuous blocks of an index range, i.e. the parts between the gaps of the data
+typedef struct
+{
+    UINT32 *pdwStart;         // first index of every block
+    size_t nBlocks;           // number of blocks
+    size_t nCapacity;         // capacity of pdwStart
+    BOOL bOutOfMemory;        // not all blocks could be stored
+} ANALOGBLOCKS;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Add a block that starts at an index. May be called from worker threads.
+// Inputs:  pBlocks - the blocks
+//          dwIndex - first index of the new block
+void fAddBlock(ANALOGBLOCKS *pBlocks, UINT32 dwIndex)
+{
+    UINT32 *pdwStart;
+
+    if (pBlocks->nBlocks == pBlocks->nCapacity)
     {
-        mexPrintf("There was an error running ns_GetFileInfo!\n");
-        *ppmxInfo = mxCreateString("");
+        pdwStart = realloc(pBlocks->pdwStart, (2 * pBlocks->nCapacity + 16) * sizeof(UINT32));
+        if (!pdwStart)
+        {
+            pBlocks->bOutOfMemory = TRUE;
+            return;
+        }
+        pBlocks->pdwStart = pdwStart;
+        pBlocks->nCapacity = 2 * pBlocks->nCapacity + 16;
     }
+    pBlocks->pdwStart[pBlocks->nBlocks++] = dwIndex;
+}
 
-    return(nsresult);
+// Reads an index range of one analog entity piece by piece into a buffer of fixed size
+typedef struct
+{
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    UINT32 dwFirstIndex;      // first index of the range
+    UINT32 dwIndex;           // first index of the next chunk
+    UINT32 dwEndIndex;        // one past the last index of the range
+    UINT32 dwChunkSize;       // capacity of pdChunk
+    double *pdChunk;          // values of the current chunk
+    UINT32 dwCount;           // number of values in pdChunk
+    UINT32 dwContCount;       // continuous indeces counted from the start of the range
+    BOOL bGap;                // a gap was found, dwContCount is final
+    BOOL bGapAhead;           // there is a gap before the first index of the next chunk
+    double dSampleRate;       // sample rate, once needed by fBlockLength (0 = not known yet)
+    ANALOGBLOCKS *pBlocks;    // receives every block of the range (0 = only dwContCount)
+} ANALOGCHUNKS;
+
+// Number of indeces read at once when the data has to pass through a buffer
+#define ANALOG_CHUNK_SIZE 65536
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Prepare reading an index range of an analog entity in chunks
+//          May be called from worker threads.
+// Inputs:  pChunks - the reader to prepare
+//          hFile - handle/ID number of the file
+//          dwEntityID - entity to read
+//          dwIndex - first index of the range
+//          dwIndexCount - number of indeces in the range
+//          dwChunkSize - maximum number of indeces per chunk (0 if only fReadChunk is used)
+// Outputs: BOOL - FALSE if the chunk buffer could not be allocated
+BOOL fOpenChunks(ANALOGCHUNKS *pChunks, UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex,
+                 UINT32 dwIndexCount, UINT32 dwChunkSize)
+{
+    if (dwChunkSize > dwIndexCount)
+        dwChunkSize = dwIndexCount;
+
+    memset(pChunks, 0, sizeof(ANALOGCHUNKS));
+    pChunks->hFile = hFile;
+    pChunks->dwEntityID = dwEntityID;
+    pChunks->dwFirstIndex = dwIndex;
+    pChunks->dwIndex = dwIndex;
+    pChunks->dwEndIndex = dwIndex + dwIndexCount;
+    pChunks->dwChunkSize = dwChunkSize;
+    if (0 == dwChunkSize)
+        return(TRUE);
+
+    // See fReadChunk for the value after the chunk
+    pChunks->pdChunk = malloc((dwChunkSize + 1) * sizeof(double));
+    return(0 != pChunks->pdChunk);
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Get entity information and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the number of continuous indeces from an index by the time stamps, e.g.
+//          for libraries that report no continuous indeces. The time of every index after
+//          a gap is later than the sample rate predicts, so the end of the block is found
+//          by binary search. May be called from worker threads; calls into the library
+//          are serialized unless it is known to be multithread safe.
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ppmxInfo - double pointer to the mex converted ns_ENTITYINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fEntityInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+//          dwEntityID - the analog entity
+//          pdSampleRate - sample rate of the entity; 0 if it is not known yet, it is
+//                         filled then
+//          dwIndex - first index of the block
+//          dwMaxCount - number of indeces that may belong to the block
+//          pdwCount - receives the number of indeces in the block (at least 1)
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fBlockLength(UINT32 hFile, UINT32 dwEntityID, double *pdSampleRate, UINT32 dwIndex, 
+                       UINT32 dwMaxCount, UINT32 *pdwCount)
 {
-    const char *aszEntityNames[] = {"EntityLabel","EntityType","ItemCount"};
-    UINT32 i;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_ENTITYINFO nsEntityInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
+    ns_ANALOGINFO nsAnalogInfo;
+    UINT32 dwLow = 1;
+    UINT32 dwHigh = dwMaxCount;
+    UINT32 dwMid;
+    double dFirstTime;
+    double dTime;
+    BOOL bSerialize = (1 != g_nThreadSafe);
+    ns_RESULT nsresult;
 
-    for (i = 0; i < ncols; ++i)
+    *pdwCount = dwMaxCount;
+    if (!(0 < *pdSampleRate))
     {
-        nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo, 
-                                    (UINT32) sizeof(nsEntityInfo));
-        if (0 == i)
-            mxOutput = mxCreateStructMatrix(ncols, 1, 3, aszEntityNames);
+        if (bSerialize)
+            th_MutexLock(&g_nsLibraryLock);
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, dwEntityID, &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if (bSerialize)
+            th_MutexUnlock(&g_nsLibraryLock);
+        if (0 != nsresult)
+            return(nsresult);
+        *pdSampleRate = nsAnalogInfo.dSampleRate;
+    }
+    // Without a sample rate there are no gaps to be found
+    if (!(0 < *pdSampleRate) || (dwMaxCount < 2))
+        return(ns_OK);
 
-        if (0 == nsresult)
-        {
-            mxFieldValue = mxCreateString(nsEntityInfo.szEntityLabel);
-            mxSetField(mxOutput, i, aszEntityNames[0], mxFieldValue);
+    nsresult = fCallTimeByIndex(hFile, dwEntityID, dwIndex, &dFirstTime);
+    if (0 != nsresult)
+        return(nsresult);
 
-            switch (nsEntityInfo.dwEntityType)
-            {
-            case 0:     // ns_ENTITY_UNKNOWN
-                mxFieldValue = mxCreateScalarDouble(0);
-                break;
-            case 1:     // ns_ENTITY_EVENT
-                mxFieldValue = mxCreateScalarDouble(1);
-                break;
-            case 2:     // ns_ENTITY_ANALOG
-                mxFieldValue = mxCreateScalarDouble(2);
-                break;
-            case 3:     // ns_ENTITY_SEGMENT
-                mxFieldValue = mxCreateScalarDouble(3);
-                break;
-            case 4:     // ns_ENTITY_NEURALEVENT
-                mxFieldValue = mxCreateScalarDouble(4);
-                break;
-            }
-            mxSetField(mxOutput, i, aszEntityNames[1], mxFieldValue);
+    // Half a sample of tolerance for the rounding of the time stamps
+    while (dwLow < dwHigh)
+    {
+        dwMid = dwLow + (dwHigh - dwLow) / 2;
+        nsresult = fCallTimeByIndex(hFile, dwEntityID, dwIndex + dwMid, &dTime);
+        if (0 != nsresult)
+            return(nsresult);
 
-            mxFieldValue = mxCreateScalarDouble(nsEntityInfo.dwItemCount);
-            mxSetField(mxOutput, i, aszEntityNames[2], mxFieldValue);
-        }
-        else if (-5 == nsresult)
-        {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetEntityInfo).\n");
-            bEntity = FALSE;
-            nsresult = 0;
-        }
+        if (dTime - dFirstTime > (dwMid + 0.5) / *pdSampleRate)
+            dwHigh = dwMid;
         else
-        {
-            // If any element fails, the function returns an error and an empty structure
-            mexPrintf("There was an error running ns_GetEntityInfo!\n");
-            *ppmxInfo = mxCreateString("");
-            break;
-        }
+            dwLow = dwMid + 1;
     }
-    if (0 == nsresult)
-        *ppmxInfo = mxOutput;
-    return(nsresult);
+
+    *pdwCount = dwLow;
+    return(ns_OK);
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Get event information and convert it into Matlab format
-// Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ppmxInfo - double pointer to the mex converted ns_EVENTINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fEventInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the next chunk of the range into a buffer of the caller
+//          If another chunk follows, its first value is read as well and written after
+//          the chunk: libraries only report gaps within a call, and so the gap between
+//          the chunks is found without another call. May be called from worker threads.
+// Inputs:  pChunks - the reader
+//          pdData - receives the values; must have room for dwMaxCount + 1 values
+//          dwMaxCount - maximum number of values to read
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+//          pdData holds pChunks->dwCount values, 0 at the end of the range
+ns_RESULT fReadChunk(ANALOGCHUNKS *pChunks, double *pdData, UINT32 dwMaxCount)
 {
-    const char *aszEventNames[] = {"EventType","MinDataLength","MaxDataLength",
-                                    "CSVDesc"};
-    UINT32 i;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_EVENTINFO nsEventInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
+    UINT32 dwContCount = 0;
+    UINT32 dwOffset;
+    UINT32 dwRead;
+    ns_RESULT nsresult;
 
-    for (i = 0; i < ncols; ++i)
+    pChunks->dwCount = pChunks->dwEndIndex - pChunks->dwIndex;
+    if (pChunks->dwCount > dwMaxCount)
+        pChunks->dwCount = dwMaxCount;
+    if (0 == pChunks->dwCount)
+        return(ns_OK);
+    dwRead = pChunks->dwCount + ((pChunks->dwIndex + pChunks->dwCount < pChunks->dwEndIndex) ? 1 : 0);
+
+    nsresult = fReadAnalog(pChunks->hFile, pChunks->dwEntityID, pChunks->dwIndex, dwRead,
+                           &dwContCount, pdData);
+    if (0 != nsresult)
     {
-        nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEventInfo, 
-                                   (UINT32) sizeof(nsEventInfo));
-        if (0 == i)
-            mxOutput = mxCreateStructMatrix(ncols, 1, 4, aszEventNames);
+        pChunks->dwCount = 0;
+        return(nsresult);
+    }
 
-        if (0 == nsresult)
+    // The continuous count of the range ends with the first gap within or before a chunk
+    if (pChunks->bGapAhead)
+    {
+        pChunks->bGap = TRUE;
+        if (pChunks->pBlocks)
+            fAddBlock(pChunks->pBlocks, pChunks->dwIndex);
+    }
+    if (!pChunks->bGap)
+    {
+        pChunks->dwContCount += MIN(dwContCount, pChunks->dwCount);
+        if (dwContCount < pChunks->dwCount)
+            pChunks->bGap = TRUE;
+    }
+
+    // Libraries only report the first gap of a read, the rest of the chunk is read
+    // again from every gap to skip the whole block up to the next one. If the library
+    // reports no continuous indeces, the block is found by the time stamps instead.
+    for (dwOffset = dwContCount; pChunks->pBlocks && (dwOffset < pChunks->dwCount); 
+         dwOffset += dwContCount)
+    {
+        // A block at the start of the chunk is already known
+        if (0 < dwOffset)
+            fAddBlock(pChunks->pBlocks, pChunks->dwIndex + dwOffset);
+        nsresult = fReadAnalog(pChunks->hFile, pChunks->dwEntityID, pChunks->dwIndex + dwOffset, 
+                               dwRead - dwOffset, &dwContCount, pdData + dwOffset);
+        if ((0 == nsresult) && (0 == dwContCount))
+            nsresult = fBlockLength(pChunks->hFile, pChunks->dwEntityID, &pChunks->dSampleRate, 
+                                    pChunks->dwIndex + dwOffset, dwRead - dwOffset, &dwContCount);
+        if (0 != nsresult)
         {
-            switch (nsEventInfo.dwEventType)
-            {
-            case 0:
-                mxFieldValue = mxCreateString("ns_EVENT_TEXT");
-                break;
-            case 1:
-                mxFieldValue = mxCreateString("ns_EVENT_CSV");
-                break;
-            case 2:
-                mxFieldValue = mxCreateString("ns_EVENT_BYTE");
-                break;
-            case 3:
-                mxFieldValue = mxCreateString("ns_EVENT_WORD");
-                break;
-            case 4:
-                mxFieldValue = mxCreateString("ns_EVENT_DWORD");
-                break;
-            }
-            mxSetField(mxOutput, i, aszEventNames[0], mxFieldValue);
+            pChunks->dwCount = 0;
+            return(nsresult);
+        }
+    }
 
-            mxFieldValue = mxCreateScalarDouble(nsEventInfo.dwMinDataLength);
-            mxSetField(mxOutput, i, aszEventNames[1], mxFieldValue);
+    // The value after the chunk starts a new block if the read ended just before it
+    pChunks->bGapAhead = (dwRead > pChunks->dwCount) && (dwOffset == pChunks->dwCount);
+    pChunks->dwIndex += pChunks->dwCount;
+    return(ns_OK);
+}
 
-            mxFieldValue = mxCreateScalarDouble(nsEventInfo.dwMaxDataLength);
-            mxSetField(mxOutput, i, aszEventNames[2], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the next chunk of the range
+//          May be called from worker threads.
+// Inputs:  pChunks - the reader
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+//          pChunks->pdChunk holds pChunks->dwCount values, 0 at the end of the range
+ns_RESULT fNextChunk(ANALOGCHUNKS *pChunks)
+{
+    return(fReadChunk(pChunks, pChunks->pdChunk, pChunks->dwChunkSize));
+}
 
-            mxFieldValue = mxCreateString(nsEventInfo.szCSVDesc);
-            mxSetField(mxOutput, i, aszEventNames[3], mxFieldValue);
-        }
-        else if (-5 == nsresult)
-        {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetEventInfo).\n");
-            bEntity = FALSE;
-            nsresult = 0;
-        }
-        else
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Let a chunk reader find every continuous block of its range, not only the
+//          first one. Must be called before the first chunk is read.
+// Inputs:  pChunks - the reader
+//          pBlocks - receives the blocks
+void fTrackBlocks(ANALOGCHUNKS *pChunks, ANALOGBLOCKS *pBlocks)
+{
+    pChunks->pBlocks = pBlocks;
+    if (pChunks->dwIndex < pChunks->dwEndIndex)
+        fAddBlock(pBlocks, pChunks->dwIndex);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free the buffer of a chunk reader
+// Inputs:  pChunks - the reader
+void fCloseChunks(ANALOGCHUNKS *pChunks)
+{
+    free(pChunks->pdChunk);
+    pChunks->pdChunk = 0;
+}
+
+// Name of an open file, needed to keep data next to the file (see fSidecarHeader)
+typedef struct
+{
+    UINT32 hFile;
+    char *szPath;
+} OPENFILE;
+
+OPENFILE *g_pOpenFiles = 0;
+size_t g_nOpenFiles = 0;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Forget the name of a file, e.g. when it is closed
+// Inputs:  hFile - handle/ID number of the file
+void fForgetFile(UINT32 hFile)
+{
+    size_t i;
+
+    for (i = 0; i < g_nOpenFiles; ++i)
+    {
+        if (g_pOpenFiles[i].hFile == hFile)
         {
-            mexPrintf("There was an error running ns_GetEventInfo!\n");
-            *ppmxInfo = mxCreateString("");
+            free(g_pOpenFiles[i].szPath);
+            g_pOpenFiles[i] = g_pOpenFiles[--g_nOpenFiles];
+            return;
         }
     }
-    if (0 == nsresult)
-        *ppmxInfo = mxOutput;
-    return(nsresult);
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Get analog information and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Remember the name of a file that was opened
+//          Nothing is remembered if there is not enough memory.
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ppmxInfo - double pointer to the mex converted ns_ANALOGINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fAnalogInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+//          szPath - name of the file as it was passed to ns_OpenFile
+void fRememberFile(UINT32 hFile, const char *szPath)
 {
-    const char *aszAnalogNames[] = {"SampleRate","MinVal","MaxVal","Units","Resolution",
-                                "LocationX","LocationY","LocationZ","LocationUser",
-                                "HighFreqCorner","HighFreqOrder","HighFilterType",
-                                "LowFreqCorner","LowFreqOrder","LowFilterType","ProbeInfo"};
-    UINT32 i;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_ANALOGINFO nsAnalogInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
+    OPENFILE *pOpenFiles;
+    char *szCopy;
 
-    for (i = 0; i < ncols; ++i)
+    fForgetFile(hFile);
+
+    szCopy = malloc(strlen(szPath) + 1);
+    pOpenFiles = realloc(g_pOpenFiles, (g_nOpenFiles + 1) * sizeof(OPENFILE));
+    if (pOpenFiles)
+        g_pOpenFiles = pOpenFiles;
+    if (!szCopy || !pOpenFiles)
     {
-        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
-                                    (UINT32) sizeof(nsAnalogInfo));
-        if (0 == i)
-            mxOutput = mxCreateStructMatrix(ncols, 1, 16, aszAnalogNames);
-
-        if (nsresult == 0)
-        {
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dSampleRate);
-            mxSetField(mxOutput, i, aszAnalogNames[0], mxFieldValue);
-
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dMinVal);
-            mxSetField(mxOutput, i, aszAnalogNames[1], mxFieldValue);
+        free(szCopy);
+        return;
+    }
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dMaxVal);
-            mxSetField(mxOutput, i, aszAnalogNames[2], mxFieldValue);
+    strcpy(szCopy, szPath);
+    g_pOpenFiles[g_nOpenFiles].hFile = hFile;
+    g_pOpenFiles[g_nOpenFiles].szPath = szCopy;
+    ++g_nOpenFiles;
+}
 
-            mxFieldValue = mxCreateString(nsAnalogInfo.szUnits);
-            mxSetField(mxOutput, i, aszAnalogNames[3], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the name of an open file
+// Inputs:  hFile - handle/ID number of the file
+// Outputs: const char * - name of the file, 0 if it is not known
+const char *fGetFilePath(UINT32 hFile)
+{
+    size_t i;
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dResolution);
-            mxSetField(mxOutput, i, aszAnalogNames[4], mxFieldValue);
+    for (i = 0; i < g_nOpenFiles; ++i)
+    {
+        if (g_pOpenFiles[i].hFile == hFile)
+            return(g_pOpenFiles[i].szPath);
+    }
+    return(0);
+}
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationX);
-            mxSetField(mxOutput, i, aszAnalogNames[5], mxFieldValue);
+////////////////////////////////////////////////////////////////////////////
+//
+// Analog envelopes
+//
+//      The minimum and maximum of an analog entity are kept in a pyramid of
+//      bins, so that a display can show any part of a long recording at any
+//      zoom level without reading all of its data again. A bin of level 0
+//      covers ENV_BASE_BIN indeces, a bin of every level above combines
+//      ENV_FACTOR bins of the level below.
+//
+//      Level 0 is computed in tiles of ENV_TILE_BINS bins when a query first
+//      needs them, or when ns_GetAnalogData reads a whole tile anyway. Bins
+//      above are computed from the level below when they are first needed.
+//      Level 0 can be kept in a sidecar file next to the data file.
+//
+////////////////////////////////////////////////////////////////////////////
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationY);
-            mxSetField(mxOutput, i, aszAnalogNames[6], mxFieldValue);
+#define ENV_BASE_BIN    1024
+#define ENV_FACTOR      4
+#define ENV_TILE_BINS   64
+#define ENV_TILE_SIZE   (ENV_BASE_BIN * ENV_TILE_BINS)
+#define ENV_MAX_LEVELS  16
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationZ);
-            mxSetField(mxOutput, i, aszAnalogNames[7], mxFieldValue);
+typedef struct
+{
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    UINT32 dwItemCount;                       // number of indeces of the entity
+    size_t nLevels;                           // number of levels of the pyramid
+    size_t anBins[ENV_MAX_LEVELS];            // number of bins of every level
+    double *apdMin[ENV_MAX_LEVELS];           // minimum of every bin
+    double *apdMax[ENV_MAX_LEVELS];           // maximum of every bin
+    unsigned char *apbValid[ENV_MAX_LEVELS];  // computed tiles of level 0, computed bins above
+    size_t nTiles;                            // number of tiles of level 0
+    BOOL bChanged;                            // tiles were computed since the sidecar was read
+    TH_MUTEX mutex;                           // held while the bins are used or computed
+} ENVELOPE;
+
+// Envelopes of all entities that were queried. The table is only changed from the
+// Matlab thread while no worker threads run.
+ENVELOPE **g_ppEnvelopes = 0;
+size_t g_nEnvelopes = 0;
+
+// Header of a sidecar file, followed by the tile flags and the minima and maxima of
+// level 0. The magic is written last, so a file that was not completely written is
+// never used.
+typedef struct
+{
+    char szMagic[8];
+    double dFileSize;         // size of the data file
+    double dModified;         // modification time of the data file
+    UINT32 dwEntityID;
+    UINT32 dwItemCount;
+    UINT32 dwBaseBin;
+    UINT32 dwTileBins;
+} ENVSIDECAR;
+
+#define ENV_MAGIC "NSENV02"
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free an envelope and its memory
+// Inputs:  pEnv - the envelope (may be 0)
+void fFreeEnvelope(ENVELOPE *pEnv)
+{
+    size_t i;
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationUser);
-            mxSetField(mxOutput, i, aszAnalogNames[8], mxFieldValue);
+    if (!pEnv)
+        return;
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dHighFreqCorner);
-            mxSetField(mxOutput, i, aszAnalogNames[9], mxFieldValue);
+    for (i = 0; i < pEnv->nLevels; ++i)
+    {
+        free(pEnv->apdMin[i]);
+        free(pEnv->apdMax[i]);
+        free(pEnv->apbValid[i]);
+    }
+    th_MutexDestroy(&pEnv->mutex);
+    free(pEnv);
+}
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dwHighFreqOrder);
-            mxSetField(mxOutput, i, aszAnalogNames[10], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Look up the envelope of an entity. May be called from worker threads.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+// Outputs: ENVELOPE * - the envelope, 0 if none was created yet
+ENVELOPE *fFindEnvelope(UINT32 hFile, UINT32 dwEntityID)
+{
+    size_t i;
 
-            mxFieldValue = mxCreateString(nsAnalogInfo.szHighFilterType);
-            mxSetField(mxOutput, i, aszAnalogNames[11], mxFieldValue);
+    for (i = 0; i < g_nEnvelopes; ++i)
+    {
+        if ((g_ppEnvelopes[i]->hFile == hFile) && (g_ppEnvelopes[i]->dwEntityID == dwEntityID))
+            return(g_ppEnvelopes[i]);
+    }
+    return(0);
+}
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLowFreqCorner);
-            mxSetField(mxOutput, i, aszAnalogNames[12], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Create an empty envelope for an entity and add it to the table
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dwItemCount - number of indeces of the entity
+// Outputs: ENVELOPE * - the envelope, 0 if there is not enough memory
+ENVELOPE *fCreateEnvelope(UINT32 hFile, UINT32 dwEntityID, UINT32 dwItemCount)
+{
+    ENVELOPE *pEnv;
+    ENVELOPE **ppEnvelopes;
+    size_t nBins = dwItemCount / ENV_BASE_BIN + (0 != dwItemCount % ENV_BASE_BIN);
+    size_t nLevel;
+
+    pEnv = calloc(1, sizeof(ENVELOPE));
+    ppEnvelopes = realloc(g_ppEnvelopes, (g_nEnvelopes + 1) * sizeof(ENVELOPE *));
+    if (ppEnvelopes)
+        g_ppEnvelopes = ppEnvelopes;
+    if (!pEnv || !ppEnvelopes)
+    {
+        free(pEnv);
+        return(0);
+    }
 
-            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dwLowFreqOrder);
-            mxSetField(mxOutput, i, aszAnalogNames[13], mxFieldValue);
+    pEnv->hFile = hFile;
+    pEnv->dwEntityID = dwEntityID;
+    pEnv->dwItemCount = dwItemCount;
+    pEnv->nTiles = (nBins + ENV_TILE_BINS - 1) / ENV_TILE_BINS;
+    th_MutexInit(&pEnv->mutex);
 
-            mxFieldValue = mxCreateString(nsAnalogInfo.szLowFilterType);
-            mxSetField(mxOutput, i, aszAnalogNames[14], mxFieldValue);
+    // Every level has ENV_FACTOR times fewer bins than the one below, up to a single bin
+    for (nLevel = 0; nLevel < ENV_MAX_LEVELS; ++nLevel)
+    {
+        pEnv->anBins[nLevel] = nBins;
+        pEnv->apdMin[nLevel] = calloc(nBins + 1, sizeof(double));
+        pEnv->apdMax[nLevel] = calloc(nBins + 1, sizeof(double));
+        pEnv->apbValid[nLevel] = calloc((0 == nLevel ? pEnv->nTiles : nBins) + 1, 1);
+        pEnv->nLevels = nLevel + 1;
 
-            mxFieldValue = mxCreateString(nsAnalogInfo.szProbeInfo);
-            mxSetField(mxOutput, i, aszAnalogNames[15], mxFieldValue);
-        }
-        else if (-5 == nsresult)
-        {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetAnalogInfo).\n");
-            bEntity = FALSE;
-            nsresult = 0;
-        }
-        else
+        if (!pEnv->apdMin[nLevel] || !pEnv->apdMax[nLevel] || !pEnv->apbValid[nLevel])
         {
-            mexPrintf("There was an error running ns_GetAnalogInfo!\n");
-            *ppmxInfo = mxCreateString("");
+            fFreeEnvelope(pEnv);
+            return(0);
         }
+        if (nBins <= 1)
+            break;
+        nBins = (nBins + ENV_FACTOR - 1) / ENV_FACTOR;
     }
-    if (0 == nsresult)
-        *ppmxInfo = mxOutput;
-    return(nsresult);
+
+    g_ppEnvelopes[g_nEnvelopes++] = pEnv;
+    return(pEnv);
 }
 
-// Author & Date: Almut Branner, 2/7/2003
-// Purpose: Get segment information and convert it into Matlab format
-// Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ppmxInfo - double pointer to the mex converted ns_SEGMENTINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fSegmentInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Compute bins of level 0 from the data of an entity
+// Inputs:  pEnv - the envelope
+//          nBin - first bin to compute
+//          pdData - the data, starting with the first index of nBin
+//          nCount - number of values in pdData
+void fEnvelopeBins(ENVELOPE *pEnv, size_t nBin, const double *pdData, size_t nCount)
 {
-    const char *aszSegmentNames[] = {"SourceCount","MinSampleCount","MaxSampleCount",
-                                     "SampleRate"};
-    UINT32 i;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_SEGMENTINFO nsSegmentInfo;
-    ns_RESULT nsresult =0;
-    BOOL bEntity = TRUE;
+    double dMin;
+    double dMax;
+    size_t i;
 
-    for (i = 0; i < ncols; ++i)
+    for (i = 0; i < nCount; i += ENV_BASE_BIN, ++nBin)
     {
-        nsresult = ns_GetSegmentInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsSegmentInfo, 
-                                     (UINT32) sizeof(nsSegmentInfo));
-        if (0 == i)
-            mxOutput = mxCreateStructMatrix(ncols, 1, 4, aszSegmentNames);
+        dsp_MinMax(pdData + i, (nCount - i < ENV_BASE_BIN) ? nCount - i : ENV_BASE_BIN, &dMin, &dMax);
+        pEnv->apdMin[0][nBin] = dMin;
+        pEnv->apdMax[0][nBin] = dMax;
+    }
+}
 
-        if (nsresult == 0)
-        {
-            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwSourceCount);
-            mxSetField(mxOutput, i, aszSegmentNames[0], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read one tile of an entity and compute its bins of level 0
+//          May be called from worker threads that hold the mutex of the envelope.
+// Inputs:  pEnv - the envelope
+//          nTile - the tile to compute
+//          pdBuffer - buffer for ENV_TILE_SIZE values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fEnvelopeTile(ENVELOPE *pEnv, size_t nTile, double *pdBuffer)
+{
+    UINT32 dwIndex = (UINT32) (nTile * ENV_TILE_SIZE);
+    UINT32 dwCount = pEnv->dwItemCount - dwIndex;
+    UINT32 dwContCount;
+    ns_RESULT nsresult;
 
-            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwMinSampleCount);
-            mxSetField(mxOutput, i, aszSegmentNames[1], mxFieldValue);
+    if (dwCount > ENV_TILE_SIZE)
+        dwCount = ENV_TILE_SIZE;
 
-            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwMaxSampleCount);
-            mxSetField(mxOutput, i, aszSegmentNames[2], mxFieldValue);
+    nsresult = fReadAnalog(pEnv->hFile, pEnv->dwEntityID, dwIndex, dwCount, &dwContCount, pdBuffer);
+    if (0 != nsresult)
+        return(nsresult);
 
-            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dSampleRate);
-            mxSetField(mxOutput, i, aszSegmentNames[3], mxFieldValue);
+    fEnvelopeBins(pEnv, nTile * ENV_TILE_BINS, pdBuffer, dwCount);
+    pEnv->apbValid[0][nTile] = 1;
+    pEnv->bChanged = TRUE;
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Make sure a range of bins of one level is computed; computes the bins it
+//          is made of first. May be called from worker threads that hold the mutex
+//          of the envelope.
+// Inputs:  pEnv - the envelope
+//          nLevel - level of the bins
+//          nFirst - first bin of the range
+//          nLast - one past the last bin of the range
+//          pdBuffer - buffer for ENV_TILE_SIZE values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fEnvelopeLevel(ENVELOPE *pEnv, size_t nLevel, size_t nFirst, size_t nLast, double *pdBuffer)
+{
+    const double *pdMin;
+    const double *pdMax;
+    size_t nBelow;
+    size_t nBin;
+    size_t k;
+    ns_RESULT nsresult;
+
+    if (nFirst >= nLast)
+        return(ns_OK);
+
+    if (0 == nLevel)
+    {
+        for (nBin = nFirst / ENV_TILE_BINS; nBin <= (nLast - 1) / ENV_TILE_BINS; ++nBin)
+        {
+            if (!pEnv->apbValid[0][nBin] && (0 != (nsresult = fEnvelopeTile(pEnv, nBin, pdBuffer))))
+                return(nsresult);
         }
-        else if (-5 == nsresult)
+        return(ns_OK);
+    }
+
+    // A bin is only marked as computed together with all bins it is made of
+    while ((nFirst < nLast) && pEnv->apbValid[nLevel][nFirst])
+        ++nFirst;
+    while ((nFirst < nLast) && pEnv->apbValid[nLevel][nLast - 1])
+        --nLast;
+    if (nFirst == nLast)
+        return(ns_OK);
+
+    nBelow = pEnv->anBins[nLevel - 1];
+    nsresult = fEnvelopeLevel(pEnv, nLevel - 1, nFirst * ENV_FACTOR, 
+                              (nLast * ENV_FACTOR < nBelow) ? nLast * ENV_FACTOR : nBelow, pdBuffer);
+    if (0 != nsresult)
+        return(nsresult);
+
+    pdMin = pEnv->apdMin[nLevel - 1];
+    pdMax = pEnv->apdMax[nLevel - 1];
+    for (nBin = nFirst; nBin < nLast; ++nBin)
+    {
+        if (pEnv->apbValid[nLevel][nBin])
+            continue;
+
+        k = nBin * ENV_FACTOR;
+        pEnv->apdMin[nLevel][nBin] = pdMin[k];
+        pEnv->apdMax[nLevel][nBin] = pdMax[k];
+        for (++k; (k < (nBin + 1) * ENV_FACTOR) && (k < nBelow); ++k)
         {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetSegmentInfo).\n");
-            bEntity = FALSE;
-            nsresult = 0;
+            if (pdMin[k] < pEnv->apdMin[nLevel][nBin])
+                pEnv->apdMin[nLevel][nBin] = pdMin[k];
+            if (pdMax[k] > pEnv->apdMax[nLevel][nBin])
+                pEnv->apdMax[nLevel][nBin] = pdMax[k];
         }
-        else
+        pEnv->apbValid[nLevel][nBin] = 1;
+    }
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the minimum and maximum of a range of bins of level 0 from the fewest bins
+//          of the levels up to nTopLevel. The bins of nTopLevel covering the range must
+//          have been computed with fEnvelopeLevel. May be called from worker threads that
+//          hold the mutex of the envelope.
+// Inputs:  pEnv - the envelope
+//          nTopLevel - highest level to use
+//          nFirst - first bin of level 0
+//          nLast - one past the last bin of level 0 (> nFirst)
+//          pdMin - receives the minimum
+//          pdMax - receives the maximum
+void fEnvelopeRange(ENVELOPE *pEnv, size_t nTopLevel, size_t nFirst, size_t nLast, double *pdMin, 
+                    double *pdMax)
+{
+    double dMin = pEnv->apdMin[0][nFirst];
+    double dMax = pEnv->apdMax[0][nFirst];
+    size_t nLevel;
+
+    // Bins that do not fill a whole bin of the next level are taken from this level
+    for (nLevel = 0; nFirst < nLast; ++nLevel)
+    {
+        for (; (nFirst < nLast) && ((nLevel == nTopLevel) || (0 != nFirst % ENV_FACTOR)); ++nFirst)
         {
-            mexPrintf("There was an error running ns_GetSegmentInfo!\n");
-            *ppmxInfo = mxCreateString("");
-            break;
+            dMin = (pEnv->apdMin[nLevel][nFirst] < dMin) ? pEnv->apdMin[nLevel][nFirst] : dMin;
+            dMax = (pEnv->apdMax[nLevel][nFirst] > dMax) ? pEnv->apdMax[nLevel][nFirst] : dMax;
         }
+        for (; (nFirst < nLast) && (0 != nLast % ENV_FACTOR); --nLast)
+        {
+            dMin = (pEnv->apdMin[nLevel][nLast - 1] < dMin) ? pEnv->apdMin[nLevel][nLast - 1] : dMin;
+            dMax = (pEnv->apdMax[nLevel][nLast - 1] > dMax) ? pEnv->apdMax[nLevel][nLast - 1] : dMax;
+        }
+        nFirst /= ENV_FACTOR;
+        nLast /= ENV_FACTOR;
     }
-    if (0 == nsresult)
-        *ppmxInfo = mxOutput;
-    return(nsresult);
+
+    *pdMin = dMin;
+    *pdMax = dMax;
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Get segment source information and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Add data that was read anyway to the envelope of its entity, if there is one
+//          Only tiles that are completely contained in the data are added.
+//          May be called from worker threads.
 // Inputs:  hFile - handle/ID number of the file
-//          ncolsEntity - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ncolsSource - number of elements in the array of sources (pdSourceID)
-//          pdSourceID - pointer to the array of sources to get info for
-//          ppmxInfo - double pointer to the mex converted ns_SEGMENTSOURCEINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fSegmentSourceInfo(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, 
-                             size_t ncolsSource, double *pdSourceID, mxArray **ppmxInfo)
+//          dwEntityID - the analog entity
+//          dwIndex - index of the first value of pdData
+//          dwIndexCount - number of values in pdData
+//          pdData - the data
+void fEnvelopeFeed(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount, 
+                   const double *pdData)
 {
-    const char *aszSegSourceNames[] = {"MinVal","MaxVal","Resolution","SubSampleShift",
-                                "LocationX","LocationY","LocationZ","LocationUser",
-                                "HighFreqCorner","HighFreqOrder","HighFilterType",
-                                "LowFreqCorner","LowFreqOrder","LowFilterType","ProbeInfo"};
-    UINT32 i;
-    UINT32 j;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_SEGSOURCEINFO nsSegmentSourceInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
-    BOOL bSource = TRUE;
+    ENVELOPE *pEnv = fFindEnvelope(hFile, dwEntityID);
+    size_t nTile;
+    UINT32 dwStart;
+    UINT32 dwCount;
 
-    for (i = 0; i < ncolsEntity; ++i)
+    if (!pEnv)
+        return;
+
+    th_MutexLock(&pEnv->mutex);
+    for (nTile = dwIndex / ENV_TILE_SIZE + (0 != dwIndex % ENV_TILE_SIZE); nTile < pEnv->nTiles; ++nTile)
     {
-        for (j = 0; j < ncolsSource; ++j)
+        dwStart = (UINT32) (nTile * ENV_TILE_SIZE);
+        dwCount = pEnv->dwItemCount - dwStart;
+        if (dwCount > ENV_TILE_SIZE)
+            dwCount = ENV_TILE_SIZE;
+        if ((dwCount > dwIndexCount) || (dwStart - dwIndex > dwIndexCount - dwCount))
+            break;
+
+        if (!pEnv->apbValid[0][nTile])
         {
-            nsresult = ns_GetSegmentSourceInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdSourceID[j],
-                                       &nsSegmentSourceInfo, (UINT32) sizeof(nsSegmentSourceInfo));
-            if ((0 == i) && (0 == j))
-                mxOutput = mxCreateStructMatrix(ncolsSource, ncolsEntity, 15, aszSegSourceNames);
+            fEnvelopeBins(pEnv, nTile * ENV_TILE_BINS, pdData + (dwStart - dwIndex), dwCount);
+            pEnv->apbValid[0][nTile] = 1;
+            pEnv->bChanged = TRUE;
+        }
+    }
+    th_MutexUnlock(&pEnv->mutex);
+}
 
-            if (0 == nsresult)
-            {
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dMinVal);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[0], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the name and the expected header of the sidecar file of an envelope
+//          The header identifies the data file by its size and modification time.
+// Inputs:  pEnv - the envelope
+//          pHeader - receives the header
+// Outputs: char * - name of the sidecar file (free it), 0 if the data file is not known
+char *fSidecarHeader(ENVELOPE *pEnv, ENVSIDECAR *pHeader)
+{
+    const char *szPath = fGetFilePath(pEnv->hFile);
+    struct stat fileStat;
+    char *szName;
+
+    if (!szPath || (0 != stat(szPath, &fileStat)))
+        return(0);
+
+    szName = malloc(strlen(szPath) + 32);
+    if (!szName)
+        return(0);
+    sprintf(szName, "%s.%u.nsenv", szPath, (unsigned) pEnv->dwEntityID);
+
+    memset(pHeader, 0, sizeof(ENVSIDECAR));
+    strcpy(pHeader->szMagic, ENV_MAGIC);
+    pHeader->dFileSize = (double) fileStat.st_size;
+    pHeader->dModified = (double) fileStat.st_mtime;
+    pHeader->dwEntityID = pEnv->dwEntityID;
+    pHeader->dwItemCount = pEnv->dwItemCount;
+    pHeader->dwBaseBin = ENV_BASE_BIN;
+    pHeader->dwTileBins = ENV_TILE_BINS;
+    return(szName);
+}
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dMaxVal);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[1], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Fill a new envelope with the tiles stored in its sidecar file
+//          Nothing is read if the sidecar does not exist or belongs to another
+//          version of the data file.
+// Inputs:  pEnv - the envelope
+void fLoadEnvelope(ENVELOPE *pEnv)
+{
+    ENVSIDECAR header;
+    ENVSIDECAR expected;
+    char *szName = fSidecarHeader(pEnv, &expected);
+    size_t nBins = pEnv->anBins[0];
+    FILE *pFile;
+
+    if (!szName)
+        return;
+    pFile = fopen(szName, "rb");
+    free(szName);
+    if (!pFile)
+        return;
+
+    if ((1 != fread(&header, sizeof(header), 1, pFile)) || 
+        (0 != memcmp(&header, &expected, sizeof(header))) ||
+        (pEnv->nTiles != fread(pEnv->apbValid[0], 1, pEnv->nTiles, pFile)) ||
+        (nBins != fread(pEnv->apdMin[0], sizeof(double), nBins, pFile)) ||
+        (nBins != fread(pEnv->apdMax[0], sizeof(double), nBins, pFile)))
+    {
+        memset(pEnv->apbValid[0], 0, pEnv->nTiles);
+    }
+    pEnv->bChanged = FALSE;
+    fclose(pFile);
+}
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dResolution);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[2], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Store the computed tiles of an envelope in its sidecar file, if tiles were
+//          computed since it was read. Errors are ignored, the sidecar is only a cache.
+// Inputs:  pEnv - the envelope
+void fSaveEnvelope(ENVELOPE *pEnv)
+{
+    ENVSIDECAR header;
+    char *szName;
+    char szMagic[8];
+    size_t nBins = pEnv->anBins[0];
+    FILE *pFile;
+    BOOL bWritten;
+
+    if (!pEnv->bChanged || !(szName = fSidecarHeader(pEnv, &header)))
+        return;
+    pFile = fopen(szName, "wb");
+    free(szName);
+    if (!pFile)
+        return;
+
+    memcpy(szMagic, header.szMagic, sizeof(szMagic));
+    memset(header.szMagic, 0, sizeof(header.szMagic));
+
+    bWritten = (1 == fwrite(&header, sizeof(header), 1, pFile)) &&
+               (pEnv->nTiles == fwrite(pEnv->apbValid[0], 1, pEnv->nTiles, pFile)) &&
+               (nBins == fwrite(pEnv->apdMin[0], sizeof(double), nBins, pFile)) &&
+               (nBins == fwrite(pEnv->apdMax[0], sizeof(double), nBins, pFile)) &&
+               (0 == fseek(pFile, 0, SEEK_SET)) &&
+               (1 == fwrite(szMagic, sizeof(szMagic), 1, pFile));
+    if (0 != fclose(pFile))
+        bWritten = FALSE;
+    if (bWritten)
+        pEnv->bChanged = FALSE;
+}
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dSubSampleShift);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[3], mxFieldValue);
+////////////////////////////////////////////////////////////////////////////
+//
+// Analog read-ahead
+//
+//      When an analog entity is read window after window, the window after
+//      the one just read is read by a background job while Matlab works on
+//      the data. The next read of that window is served from memory. There
+//      is a slot per file and entity holding at most one window; all windows
+//      together take up at most g_nReadAheadLimit bytes.
+//
+//      The slots are only used from the Matlab thread while the background
+//      job does not run (see fWaitReadAhead).
+//
+////////////////////////////////////////////////////////////////////////////
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationX);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[4], mxFieldValue);
+#define MAX_READAHEAD 1024
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationY);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[5], mxFieldValue);
+// Memory used for windows read ahead unless ns_ReadAhead sets another limit
+#define READAHEAD_DEFAULT_BYTES 0x4000000
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationZ);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[6], mxFieldValue);
+typedef struct
+{
+    BOOL bValid;
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    UINT32 dwItemCount;       // number of indeces of the entity, windows end there
+    UINT32 dwNextIndex;       // one past the last index of the last read of the entity
+    unsigned long dwLastRead; // when the entity was last read, the oldest slot is reused
+    UINT32 dwIndex;           // first index of the window read ahead
+    UINT32 dwIndexCount;      // number of indeces of the window
+    double *pdData;           // values of the window (0 = no window)
+    UINT32 dwContCount;       // continuous indeces of the window
+    ns_RESULT nsresult;       // result of reading the window
+    BOOL bPending;            // the window still has to be read by the background job
+} READAHEAD;
+
+// Counters reported by ns_ReadAhead
+typedef struct
+{
+    double dRequests;         // entities read by plain reads
+    double dHits;             // reads served from a window
+    double dWindows;          // windows read ahead
+    double dWasted;           // windows dropped without being used
+    double dWastedBytes;      // memory of the windows dropped without being used
+} READAHEADSTATS;
+
+READAHEAD g_aReadAhead[MAX_READAHEAD];
+READAHEADSTATS g_readAheadStats;
+TH_JOB g_jobReadAhead;
+size_t g_nReadAheadLimit = READAHEAD_DEFAULT_BYTES;
+size_t g_nReadAheadBytes = 0;
+unsigned long g_dwReadAheadTick = 0;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Wait until the background job has read all windows
+//          Must be called before the slots are used.
+void fWaitReadAhead(void)
+{
+    th_WaitJob(&g_jobReadAhead);
+}
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationUser);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[7], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free the window of a slot
+// Inputs:  pSlot - the slot
+//          bWasted - TRUE if the window is dropped without being used
+void fDropWindow(READAHEAD *pSlot, BOOL bWasted)
+{
+    if (!pSlot->pdData)
+        return;
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dHighFreqCorner);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[8], mxFieldValue);
+    if (bWasted)
+    {
+        g_readAheadStats.dWasted += 1;
+        g_readAheadStats.dWastedBytes += (double) pSlot->dwIndexCount * sizeof(double);
+    }
+    g_nReadAheadBytes -= (size_t) pSlot->dwIndexCount * sizeof(double);
+    free(pSlot->pdData);
+    pSlot->pdData = 0;
+    pSlot->bPending = FALSE;
+}
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dwHighFreqOrder);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[9], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read all pending windows. Runs as the background job.
+// Inputs:  pvContext - not used
+//          nItem - not used
+void fReadAheadTask(void *pvContext, size_t nItem)
+{
+    READAHEAD *pSlot;
+    int i;
 
-                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szHighFilterType);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[10], mxFieldValue);
+    (void) pvContext;
+    (void) nItem;
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLowFreqCorner);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[11], mxFieldValue);
+    for (i = 0; i < MAX_READAHEAD; ++i)
+    {
+        pSlot = &g_aReadAhead[i];
+        if (!pSlot->bValid || !pSlot->bPending)
+            continue;
 
-                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dwLowFreqOrder);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[12], mxFieldValue);
+        pSlot->nsresult = fReadAnalog(pSlot->hFile, pSlot->dwEntityID, pSlot->dwIndex, 
+                                      pSlot->dwIndexCount, &pSlot->dwContCount, pSlot->pdData);
+        pSlot->bPending = FALSE;
+    }
+}
 
-                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szLowFilterType);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[13], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the slot of an entity
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+// Outputs: READAHEAD * - the slot, 0 if the entity was not read yet
+READAHEAD *fFindReadAhead(UINT32 hFile, UINT32 dwEntityID)
+{
+    int i;
 
-                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szProbeInfo);
-                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[14], mxFieldValue);
-            }
-            else if (-5 == nsresult)
-            {
-                if (TRUE == bEntity)
-                    mexPrintf("Some entities do not exist (ns_GetSegmentSourceInfo).\n");
-                bEntity = FALSE;
-            }
-            else if (-6 == nsresult)
-            {
-                if (TRUE == bSource)
-                    mexPrintf("Some sources do not exist (ns_GetSegmentSourceInfo).\n");
-                bSource = FALSE;
-                break;
-            }
-            else
-            {
-                mexPrintf("There was an error running ns_GetSegmentSourceInfo!\n");
-                *ppmxInfo = mxCreateString("");
-                return(nsresult);
-            }
+    for (i = 0; i < MAX_READAHEAD; ++i)
+    {
+        if (g_aReadAhead[i].bValid && (g_aReadAhead[i].hFile == hFile) &&
+            (g_aReadAhead[i].dwEntityID == dwEntityID))
+        {
+            return(&g_aReadAhead[i]);
         }
     }
-
-    *ppmxInfo = mxOutput;
-    return(nsresult);
+    return(0);
 }
 
-// Author & Date: Almut Branner, 2/7/2003
-// Purpose: Get neural information and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Serve a read of an entity from its window if the window holds the indeces
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ppmxInfo - double pointer to the mex converted ns_NEURALINFO structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxInfo is filled.
-ns_RESULT fNeuralInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+//          dwEntityID - the analog entity
+//          dwIndex - first index to read
+//          dwIndexCount - how many indeces are read
+//          classID - class of the data (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+//          dScale - value of one raw count (only used for mxINT16_CLASS)
+//          pvData - receives the data
+//          pdwContCount - receives the number of continuous indeces
+// Outputs: BOOL - TRUE if the data was taken from the window (the window is freed)
+BOOL fServeReadAhead(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount,
+                     mxClassID classID, double dScale, void *pvData, UINT32 *pdwContCount)
 {
-    const char *aszNeuralNames[] = {"SourceEntityID","SourceUnitID","ProbeInfo"};
-    UINT32 i;
-    mxArray *mxOutput = 0;
-    mxArray *mxFieldValue = 0;
-    ns_NEURALINFO nsNeuralInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
+    READAHEAD *pSlot = fFindReadAhead(hFile, dwEntityID);
 
-    for (i = 0; i < ncols; ++i)
+    g_readAheadStats.dRequests += 1;
+
+    if (!pSlot || !pSlot->pdData || (0 != pSlot->nsresult) || (pSlot->dwIndex != dwIndex) ||
+        (pSlot->dwIndexCount < dwIndexCount) || (0 == dwIndexCount))
     {
-        nsresult = ns_GetNeuralInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsNeuralInfo, 
-                                    (UINT32) sizeof(nsNeuralInfo));
-        if (0 == i)
-            mxOutput = mxCreateStructMatrix(ncols, 1, 3, aszNeuralNames);
+        return(FALSE);
+    }
 
-        if (nsresult == 0)
-        {
-            mxFieldValue = mxCreateScalarDouble(nsNeuralInfo.dwSourceEntityID);
-            mxSetField(mxOutput, i, aszNeuralNames[0], mxFieldValue);
+    fConvertSamples(pSlot->pdData, dwIndexCount, classID, dScale, pvData);
+    *pdwContCount = MIN(pSlot->dwContCount, dwIndexCount);
+    g_readAheadStats.dHits += 1;
+    fDropWindow(pSlot, FALSE);
+    return(TRUE);
+}
 
-            mxFieldValue = mxCreateScalarDouble(nsNeuralInfo.dwSourceUnitID);
-            mxSetField(mxOutput, i, aszNeuralNames[1], mxFieldValue);
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Note a successful read of an entity. If it continues the last read of the
+//          entity, the window after it is scheduled to be read ahead (see fStartReadAhead).
+//          A window that was not used by the read is dropped.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dwIndex - first index that was read
+//          dwIndexCount - how many indeces were read
+void fNoteRead(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount)
+{
+    READAHEAD *pSlot = fFindReadAhead(hFile, dwEntityID);
+    UINT32 dwEndIndex = dwIndex + dwIndexCount;
+    ns_ENTITYINFO nsEntityInfo;
+    size_t cbWindow;
+    BOOL bSequential;
+    int i;
 
-            mxFieldValue = mxCreateString(nsNeuralInfo.szProbeInfo);
-            mxSetField(mxOutput, i, aszNeuralNames[2], mxFieldValue);
-        }
-        else if (-5 == nsresult)
+    // The entity may be read more than once by the same request
+    if (pSlot && pSlot->bPending)
+        return;
+
+    // A new entity takes a free slot or the one that was not read for the longest time
+    if (!pSlot)
+    {
+        pSlot = &g_aReadAhead[0];
+        for (i = 0; (i < MAX_READAHEAD) && pSlot->bValid; ++i)
         {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetNeuralInfo).\n");
-            bEntity = FALSE;
+            if (!g_aReadAhead[i].bValid || (g_aReadAhead[i].dwLastRead < pSlot->dwLastRead))
+                pSlot = &g_aReadAhead[i];
         }
-        else
+        fDropWindow(pSlot, TRUE);
+        memset(pSlot, 0, sizeof(READAHEAD));
+        pSlot->bValid = TRUE;
+        pSlot->hFile = hFile;
+        pSlot->dwEntityID = dwEntityID;
+        pSlot->dwNextIndex = dwIndex - 1;       // the first read is never sequential
+        pSlot->dwItemCount = (UINT32) -1;
+        if (0 == ns_GetEntityInfo(g_nsDllHandle, hFile, dwEntityID, &nsEntityInfo, 
+                                  (UINT32) sizeof(nsEntityInfo)))
         {
-            mexPrintf("There was an error running ns_GetNeuralInfo!\n");
-            *ppmxInfo = mxCreateString("");
+            pSlot->dwItemCount = nsEntityInfo.dwItemCount;
         }
     }
 
-    if (0 == nsresult)
-        *ppmxInfo = mxOutput;
-    return(nsresult);
+    fDropWindow(pSlot, TRUE);
+    bSequential = (pSlot->dwNextIndex == dwIndex);
+    pSlot->dwNextIndex = dwEndIndex;
+    pSlot->dwLastRead = ++g_dwReadAheadTick;
+
+    // The window ends with the entity; the last one may be shorter than the read
+    if (dwEndIndex >= pSlot->dwItemCount)
+        return;
+    dwIndexCount = MIN(dwIndexCount, pSlot->dwItemCount - dwEndIndex);
+    cbWindow = (size_t) dwIndexCount * sizeof(double);
+    if (!bSequential || (0 == dwIndexCount) || (g_nReadAheadBytes + cbWindow > g_nReadAheadLimit))
+        return;
+
+    pSlot->pdData = malloc(cbWindow);
+    if (!pSlot->pdData)
+        return;
+    pSlot->dwIndex = dwEndIndex;
+    pSlot->dwIndexCount = dwIndexCount;
+    pSlot->dwContCount = 0;
+    pSlot->nsresult = ns_OK;
+    pSlot->bPending = TRUE;
+    g_nReadAheadBytes += cbWindow;
+    g_readAheadStats.dWindows += 1;
 }
 
-// Author & Date: Almut Branner, 2/21/2003
-// Purpose: Get event data and convert it into Matlab format
-// Inputs:  hFile - handle/ID number of the file
-//          ncolsEntity - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          ncolsIndex - number of elements in the array of indeces (pdIndex)
-//          pdIndex - pointer to the array of indeces to get info for
-//          ppmxTimeStamp - double pointer to the mex converted timestamp
-//          ppmxData - double pointer to the mex converted data structure
-//          ppmxDataSize - how big is the data structure that was returned
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxTimeStamp is filled.
-//          ppmxData is filled.
-//          ppmxDataSize is filled.
-ns_RESULT fEventData(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex, 
-                     double *pdIndex, mxArray **ppmxTimeStamp, mxArray **ppmxData, 
-                     mxArray **ppmxDataSize)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Start the background job reading the windows scheduled by fNoteRead
+//          Must be called from the Matlab thread after fLibraryIsThreadSafe.
+void fStartReadAhead(void)
 {
-    UINT32 i;
-    UINT32 j;
-    UINT32 dwTempType;
-    double dTimeStamp;
-    void *pvData;
-    double *pdOutputTimeStamp = 0;
-    double *pdOutputData = 0;
-    double *pdOutputDataSize = 0;
-    UINT32 dwDataSize;
-    ns_EVENTINFO nsEventInfo;
-    ns_RESULT nsresult;
-    BOOL bIndex = TRUE;
-    
-    // Compare the types of all requested entities. Error when not the same.
-    // Also checks whether loading the information works for all entities.
-    nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[0], &nsEventInfo, sizeof(nsEventInfo));
-    if (0 == nsresult)
+    int i;
+
+    for (i = 0; i < MAX_READAHEAD; ++i)
     {
-        dwTempType = nsEventInfo.dwEventType;
-        // Allocate mxArray for the data depending on the type
-        if ((ns_EVENT_BYTE == dwTempType) || (ns_EVENT_WORD == dwTempType) ||
-            (ns_EVENT_DWORD == dwTempType))
-        {
-            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            *ppmxData = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
-            pdOutputData = mxGetPr(*ppmxData);
-            pdOutputDataSize = mxGetPr(*ppmxDataSize);
-        }
-        else if (ns_EVENT_TEXT == dwTempType)
+        if (g_aReadAhead[i].bValid && g_aReadAhead[i].bPending)
         {
-            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            *ppmxData = mxCreateCellMatrix(ncolsIndex, ncolsEntity);
-            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
-            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+            th_StartJob(&g_jobReadAhead, fReadAheadTask, 0);
+            return;
         }
-        else if (ns_EVENT_CSV == dwTempType)
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free the slots of a file, e.g. when it is closed, or of all files
+// Inputs:  hFile - handle/ID number of the file
+//          bAll - TRUE to free the slots of all files
+void fReleaseReadAhead(UINT32 hFile, BOOL bAll)
+{
+    int i;
+
+    fWaitReadAhead();
+    for (i = 0; i < MAX_READAHEAD; ++i)
+    {
+        if (g_aReadAhead[i].bValid && (bAll || (g_aReadAhead[i].hFile == hFile)))
         {
-            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            *ppmxData = mxCreateCellMatrix(ncolsIndex, ncolsEntity);
-            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
-            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+            fDropWindow(&g_aReadAhead[i], TRUE);
+            g_aReadAhead[i].bValid = FALSE;
         }
     }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Analog block cache
+//
+//      Analog data read from the library is kept in blocks of CACHE_BLOCK_SIZE
+//      indeces, so data that is read again does not have to be decoded by the
+//      library again. When the blocks take up more than g_nCacheLimit bytes,
+//      the least recently used ones are dropped. Every block also knows where
+//      the data within it is not continuous, so continuous counts can be
+//      reported without calling the library. Blocks with more gaps than that
+//      only serve their data, and blocks that cannot be read are remembered
+//      so they are not read again on every read.
+//
+//      The cache is used by fReadAnalog from the Matlab thread, the worker
+//      threads and the read-ahead job. Blocks are dropped when their file is
+//      closed or the library is changed.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define CACHE_BLOCK_SIZE 65536
+#define CACHE_MAX_GAPS 16
+#define CACHE_HASH_SIZE 4096
+
+// Memory used for blocks unless ns_AnalogCache sets another limit
+#define CACHE_DEFAULT_BYTES 0x8000000
+
+typedef struct CACHEBLOCK
+{
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    UINT32 dwBlock;                   // the block holds the indeces from dwBlock * CACHE_BLOCK_SIZE on
+    UINT32 dwCount;                   // number of values (fewer in the last block of an entity)
+    double *pdData;                   // values of the block
+    BOOL bJoined;                     // the first value is continuous with the one before
+    UINT32 adwGap[CACHE_MAX_GAPS];    // offsets of the values not continuous with the one before
+    size_t nGaps;                     // number of gaps
+    BOOL bGapsUnknown;                // there are more gaps after the last one of adwGap
+    BOOL bUncacheable;                // the block could not be read, it has no values
+    struct CACHEBLOCK *pNext;         // next block in the same bucket of the hash table
+    struct CACHEBLOCK *pNewer;        // block used next more recently
+    struct CACHEBLOCK *pOlder;        // block used next less recently
+} CACHEBLOCK;
+
+// Counters reported by ns_AnalogCache
+typedef struct
+{
+    double dHits;             // blocks found in the cache
+    double dMisses;           // blocks read from the library
+    double dEvictions;        // blocks dropped to stay within the limit
+} CACHESTATS;
+
+// The cache is shared by all threads and only used while g_cacheLock is held
+CACHEBLOCK *g_apCache[CACHE_HASH_SIZE];
+CACHEBLOCK *g_pCacheNewest = 0;
+CACHEBLOCK *g_pCacheOldest = 0;
+CACHESTATS g_cacheStats;
+size_t g_nCacheLimit = CACHE_DEFAULT_BYTES;
+size_t g_nCacheBytes = 0;
+size_t g_nCacheBlocks = 0;
+TH_MUTEX g_cacheLock = TH_MUTEX_INITIALIZER;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the bucket of the hash table a block belongs to
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dwBlock - number of the block
+// Outputs: CACHEBLOCK ** - the bucket
+CACHEBLOCK **fCacheBucket(UINT32 hFile, UINT32 dwEntityID, UINT32 dwBlock)
+{
+    size_t nHash = ((size_t) hFile * 31 + dwEntityID) * 2654435761u + dwBlock;
+
+    return(&g_apCache[nHash % CACHE_HASH_SIZE]);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find a block in the cache and mark it as the most recently used one
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dwBlock - number of the block
+// Outputs: CACHEBLOCK * - the block, 0 if it is not in the cache
+CACHEBLOCK *fCacheFind(UINT32 hFile, UINT32 dwEntityID, UINT32 dwBlock)
+{
+    CACHEBLOCK *pBlock;
+
+    for (pBlock = *fCacheBucket(hFile, dwEntityID, dwBlock); pBlock; pBlock = pBlock->pNext)
+    {
+        if ((pBlock->hFile == hFile) && (pBlock->dwEntityID == dwEntityID) && (pBlock->dwBlock == dwBlock))
+            break;
+    }
+    if (!pBlock || (pBlock == g_pCacheNewest))
+        return(pBlock);
+
+    // Move the block to the front of the list
+    pBlock->pNewer->pOlder = pBlock->pOlder;
+    if (pBlock->pOlder)
+        pBlock->pOlder->pNewer = pBlock->pNewer;
+    else
+        g_pCacheOldest = pBlock->pNewer;
+    pBlock->pNewer = 0;
+    pBlock->pOlder = g_pCacheNewest;
+    g_pCacheNewest->pNewer = pBlock;
+    g_pCacheNewest = pBlock;
+    return(pBlock);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Add a block to the cache as the most recently used one
+// Inputs:  pBlock - the block (not in the cache yet)
+void fCacheInsert(CACHEBLOCK *pBlock)
+{
+    CACHEBLOCK **ppBucket = fCacheBucket(pBlock->hFile, pBlock->dwEntityID, pBlock->dwBlock);
+
+    pBlock->pNext = *ppBucket;
+    *ppBucket = pBlock;
+    pBlock->pNewer = 0;
+    pBlock->pOlder = g_pCacheNewest;
+    if (g_pCacheNewest)
+        g_pCacheNewest->pNewer = pBlock;
+    else
+        g_pCacheOldest = pBlock;
+    g_pCacheNewest = pBlock;
+
+    g_nCacheBytes += sizeof(CACHEBLOCK) + pBlock->dwCount * sizeof(double);
+    ++g_nCacheBlocks;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Remove a block from the cache and free it
+// Inputs:  pBlock - the block
+void fCacheRemove(CACHEBLOCK *pBlock)
+{
+    CACHEBLOCK **ppLink = fCacheBucket(pBlock->hFile, pBlock->dwEntityID, pBlock->dwBlock);
+
+    while (*ppLink != pBlock)
+        ppLink = &(*ppLink)->pNext;
+    *ppLink = pBlock->pNext;
+
+    if (pBlock->pNewer)
+        pBlock->pNewer->pOlder = pBlock->pOlder;
     else
+        g_pCacheNewest = pBlock->pOlder;
+    if (pBlock->pOlder)
+        pBlock->pOlder->pNewer = pBlock->pNewer;
+    else
+        g_pCacheOldest = pBlock->pNewer;
+
+    g_nCacheBytes -= sizeof(CACHEBLOCK) + pBlock->dwCount * sizeof(double);
+    --g_nCacheBlocks;
+    free(pBlock->pdData);
+    free(pBlock);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Drop the least recently used blocks until the cache fits into a limit
+// Inputs:  nLimit - maximum number of bytes of all blocks
+void fCacheTrim(size_t nLimit)
+{
+    while (g_pCacheOldest && (g_nCacheBytes > nLimit))
     {
-        mexPrintf("All requested Entities have to be of the same event type\nor there was an error running ns_GetEventInfo!\n(Was required for ns_GetEventData)\n");
-        *ppmxTimeStamp = mxCreateString("");
-        *ppmxDataSize = mxCreateString("");
-        *ppmxData = mxCreateString("");
-        return(ns_LIBERROR);
+        fCacheRemove(g_pCacheOldest);
+        g_cacheStats.dEvictions += 1;
     }
+}
 
-    for (i = 1; i < ncolsEntity; ++i)
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read a block from the library. May be called from worker threads.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dwBlock - number of the block
+// Outputs: CACHEBLOCK * - the new block (not in the cache yet), flagged bUncacheable if it
+//          does not exist or could not be read, 0 if there is no memory for it
+CACHEBLOCK *fCacheLoad(UINT32 hFile, UINT32 dwEntityID, UINT32 dwBlock)
+{
+    UINT32 dwStart = dwBlock * CACHE_BLOCK_SIZE;
+    BOOL bSerialize = (1 != g_nThreadSafe);
+    ns_ENTITYINFO nsEntityInfo;
+    CACHEBLOCK *pBlock;
+    double dSampleRate = 0;
+    UINT32 dwContCount = 0;
+    UINT32 dwOffset = 0;
+    BOOL bTimes = FALSE;
+    ns_RESULT nsresult;
+
+    if (bSerialize)
+        th_MutexLock(&g_nsLibraryLock);
+    nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, dwEntityID, &nsEntityInfo, 
+                                (UINT32) sizeof(nsEntityInfo));
+    if (bSerialize)
+        th_MutexUnlock(&g_nsLibraryLock);
+
+    pBlock = calloc(1, sizeof(CACHEBLOCK));
+    if (!pBlock)
+        return(0);
+    pBlock->hFile = hFile;
+    pBlock->dwEntityID = dwEntityID;
+    pBlock->dwBlock = dwBlock;
+    if ((0 != nsresult) || (dwStart >= nsEntityInfo.dwItemCount))
     {
-        nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEventInfo, sizeof(nsEventInfo));
-        
-        if ((0 == nsresult) && (dwTempType == nsEventInfo.dwEventType))
-        {
-            dwTempType = nsEventInfo.dwEventType;
-        }
-        else
+        pBlock->bUncacheable = TRUE;
+        return(pBlock);
+    }
+    pBlock->dwCount = MIN(CACHE_BLOCK_SIZE, nsEntityInfo.dwItemCount - dwStart);
+
+    // The value before the block is read as well to find out whether the block is
+    // continuous with it. If the library reports no continuous indeces, the blocks
+    // are found by the time stamps instead.
+    pBlock->pdData = malloc((pBlock->dwCount + 1) * sizeof(double));
+    if (!pBlock->pdData)
+        nsresult = ns_LIBERROR;
+    else if (0 < dwStart)
+    {
+        nsresult = fCallAnalog(hFile, dwEntityID, dwStart - 1, pBlock->dwCount + 1, &dwContCount, 
+                               pBlock->pdData);
+        memmove(pBlock->pdData, pBlock->pdData + 1, pBlock->dwCount * sizeof(double));
+        bTimes = (0 == nsresult) && (0 == dwContCount);
+        if (bTimes)
+            nsresult = fBlockLength(hFile, dwEntityID, &dSampleRate, dwStart - 1, 
+                                    pBlock->dwCount + 1, &dwContCount);
+        pBlock->bJoined = (2 <= dwContCount);
+        dwOffset = pBlock->bJoined ? dwContCount - 1 : 0;
+    }
+    else
+    {
+        nsresult = fCallAnalog(hFile, dwEntityID, dwStart, pBlock->dwCount, &dwContCount, pBlock->pdData);
+        bTimes = (0 == nsresult) && (0 == dwContCount);
+        dwOffset = dwContCount;
+    }
+
+    // Libraries only report the first gap of a read, the rest of the block is read
+    // again from every gap to find the next one. Gaps that do not fit into the
+    // table are found by fCacheRead when they are needed.
+    while ((0 == nsresult) && (dwOffset < pBlock->dwCount))
+    {
+        if (0 < dwOffset)
         {
-            mexPrintf("All requested Entities have to be of the same event type\nor there was an error running ns_GetEventInfo!\n(Was required for ns_GetEventData)\n");
-            *ppmxTimeStamp = mxCreateString("");
-            *ppmxDataSize = mxCreateString("");
-            *ppmxData = mxCreateString("");
-            return(ns_LIBERROR);
+            if (CACHE_MAX_GAPS == pBlock->nGaps)
+            {
+                pBlock->bGapsUnknown = TRUE;
+                break;
+            }
+            pBlock->adwGap[pBlock->nGaps++] = dwOffset;
         }
+
+        dwContCount = 0;
+        if (!bTimes)
+            nsresult = fCallAnalog(hFile, dwEntityID, dwStart + dwOffset, pBlock->dwCount - dwOffset, 
+                                   &dwContCount, pBlock->pdData + dwOffset);
+        if ((0 == nsresult) && (0 == dwContCount))
+            nsresult = fBlockLength(hFile, dwEntityID, &dSampleRate, dwStart + dwOffset, 
+                                    pBlock->dwCount - dwOffset, &dwContCount);
+        dwOffset += MAX(dwContCount, 1);
     }
 
-    // Actually load the data
-    for (i = 0; i < ncolsEntity; ++i)
+    if (0 != nsresult)
     {
-        for (j = 0; j < ncolsIndex; ++j)
+        free(pBlock->pdData);
+        pBlock->pdData = 0;
+        pBlock->dwCount = 0;
+        pBlock->nGaps = 0;
+        pBlock->bUncacheable = TRUE;
+    }
+    return(pBlock);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read analog data through the cache. May be called from worker threads.
+//          Reads of more than a quarter of the cache are not cached.
+// Inputs:  see fReadAnalog
+// Outputs: BOOL - TRUE if the data was read, FALSE if it has to be read from the library
+//          (e.g. the range does not exist); pdData may have been written to then
+BOOL fCacheRead(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, UINT32 dwIndexCount,
+                UINT32 *pdwContCount, double *pdData)
+{
+    CACHEBLOCK *pBlock;
+    CACHEBLOCK *pLoaded;
+    double dSampleRate = 0;
+    BOOL bRead;
+    BOOL bJoined = TRUE;
+    BOOL bGap = FALSE;
+    BOOL bGapsUnknown = FALSE;
+    UINT32 dwDone = 0;
+    UINT32 dwBlock;
+    UINT32 dwOffset;
+    UINT32 dwCount;
+    UINT32 dwContCount = 0;
+    size_t i;
+
+    if ((0 == dwIndexCount) || ((size_t) dwIndexCount * sizeof(double) > g_nCacheLimit / 4))
+        return(FALSE);
+
+    *pdwContCount = 0;
+    while (dwDone < dwIndexCount)
+    {
+        dwBlock = (dwIndex + dwDone) / CACHE_BLOCK_SIZE;
+        dwOffset = (dwIndex + dwDone) % CACHE_BLOCK_SIZE;
+        dwCount = MIN(dwIndexCount - dwDone, CACHE_BLOCK_SIZE - dwOffset);
+        pLoaded = 0;
+
+        th_MutexLock(&g_cacheLock);
+        pBlock = fCacheFind(hFile, dwEntityID, dwBlock);
+        if (pBlock)
+            g_cacheStats.dHits += 1;
+        else
         {
-            // Call GetEventInfo first to get the type of data that is loaded
-            nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEventInfo, 
-                                       sizeof(nsEventInfo));
-            pvData = malloc(nsEventInfo.dwMaxDataLength);
+            // The block is read without holding the lock; another thread may add
+            // it in the meantime
+            g_cacheStats.dMisses += 1;
+            th_MutexUnlock(&g_cacheLock);
+            pLoaded = fCacheLoad(hFile, dwEntityID, dwBlock);
+            if (!pLoaded)
+                return(FALSE);
+
+            th_MutexLock(&g_cacheLock);
+            pBlock = fCacheFind(hFile, dwEntityID, dwBlock);
+            if (!pBlock)
+            {
+                fCacheInsert(pLoaded);
+                pBlock = pLoaded;
+                pLoaded = 0;
+            }
+        }
 
-            nsresult = ns_GetEventData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdIndex[j], 
-                                       &dTimeStamp, pvData, nsEventInfo.dwMaxDataLength, 
-                                       &dwDataSize);
-            if (0 == nsresult)
+        // The values are copied before other blocks are dropped for the new one
+        bRead = !pBlock->bUncacheable && (dwOffset + dwCount <= pBlock->dwCount);
+        if (bRead)
+        {
+            memcpy(pdData + dwDone, pBlock->pdData + dwOffset, dwCount * sizeof(double));
+            bJoined = (0 < dwOffset) || pBlock->bJoined;
+            dwContCount = dwCount;
+            for (i = 0; i < pBlock->nGaps; ++i)
             {
-                switch (nsEventInfo.dwEventType)
+                if (pBlock->adwGap[i] > dwOffset)
                 {
-                case 0: // ns_EVENT_TEXT
-                    mxSetCell(*ppmxData, i * ncolsIndex + j, mxCreateString((char*)pvData));
-                    break;
-                case 1: // ns_EVENT_CSV
-                    mxSetCell(*ppmxData, i * ncolsIndex + j, mxCreateString("Not supported"));
-                    break;
-                case 2: // ns_EVENT_BYTE
-                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT8*)pvData);
-                    break;
-                case 3: // ns_EVENT_WORD
-                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT16*)pvData);
-                    break;
-                case 4: // ns_EVENT_DWORD
-                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT32*)pvData);
+                    dwContCount = MIN(dwCount, pBlock->adwGap[i] - dwOffset);
                     break;
                 }
-                *(pdOutputTimeStamp + (i * ncolsIndex) + j) = dTimeStamp;
-                *(pdOutputDataSize + (i * ncolsIndex) + j) = dwDataSize;
             }
-            else if (-7 == nsresult)
+            bGapsUnknown = (i == pBlock->nGaps) && pBlock->bGapsUnknown;
+        }
+        fCacheTrim(g_nCacheLimit);
+        th_MutexUnlock(&g_cacheLock);
+
+        if (pLoaded)
+        {
+            free(pLoaded->pdData);
+            free(pLoaded);
+        }
+        if (!bRead)
+            return(FALSE);
+
+        // The continuous count ends with the first gap within or between the blocks
+        if (!bGap && (0 < dwDone) && !bJoined)
+            bGap = TRUE;
+        if (!bGap)
+        {
+            // Past the gaps the block knows, the continuous count is found by the time stamps
+            if (bGapsUnknown && (0 != fBlockLength(hFile, dwEntityID, &dSampleRate, dwIndex + dwDone, 
+                                                   dwCount, &dwContCount)))
             {
-                if (TRUE == bIndex)
-                    mexPrintf("Some indeces do not exist (ns_GetEventData).\n");
-                bIndex = FALSE;
-                break;
+                return(FALSE);
             }
-            else
-            {
-                mexPrintf("There was an error running ns_GetEventData!\n");
-                *ppmxTimeStamp = mxCreateString("");
-                *ppmxDataSize = mxCreateString("");
-                *ppmxData = mxCreateString("");
-                free(pvData);
-                return(nsresult);
-            }
-            free(pvData);
+            *pdwContCount += dwContCount;
+            bGap = (dwContCount < dwCount);
         }
+        dwDone += dwCount;
     }
-    return(nsresult);
+    return(TRUE);
 }
 
-// Author & Date: Almut Branner, 2/7/2003
-// Purpose: Get analog data and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Drop the blocks of a file, e.g. when it is closed, or of all files
+//          Must not be called while worker threads run.
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          dwIndex - index in the particular entity
-//          dwIndexCount - How many indeces are loaded
-//          ppmxContCount - double pointer to the mex converted number of how
-//                          many continuous indeces were loaded
-//          ppmxData - double pointer to the mex converted data structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxContCount is filled.
-//          ppmxData is filled.
-ns_RESULT fAnalogData(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
-                      UINT32 dwIndexCount, mxArray **ppmxContCount, mxArray **ppmxData)
+//          bAll - TRUE to drop the blocks of all files
+void fCacheFlush(UINT32 hFile, BOOL bAll)
 {
-    UINT32 i;
-    UINT32 j;
-    double *pdData;
-    double *pdTempData = 0;
-    double *pdTempContCount = 0;
-    UINT32 dwContCount;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
-    BOOL bIndex = TRUE;
-    
-    pdData = calloc(dwIndexCount, 8);
+    CACHEBLOCK *pBlock;
+    CACHEBLOCK *pOlder;
 
-    for (i = 0; i < ncols; ++i)
+    th_MutexLock(&g_cacheLock);
+    for (pBlock = g_pCacheNewest; pBlock; pBlock = pOlder)
     {
-        nsresult = ns_GetAnalogData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, dwIndexCount, 
-                                    &dwContCount, pdData);
-        if (0 == i)
-        {
-            *ppmxContCount = mxCreateDoubleMatrix(ncols, 1, mxREAL);
-            pdTempContCount = mxGetPr(*ppmxContCount);
-            *ppmxData = mxCreateDoubleMatrix(dwIndexCount, ncols, mxREAL);
-            pdTempData = mxGetPr(*ppmxData);
-        }
-        if (0 == nsresult)
-        {
-            *(pdTempContCount + i) = dwContCount;
-            for (j = 0; j < dwIndexCount; ++j)
-            {
-                *(pdTempData + (i * dwIndexCount) + j) = *(pdData + j);
-            }
-        }
-        else if (-5 == nsresult)
-        {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetAnalogData).\n");
-            bEntity = FALSE;
-        }
-        else if (-7 == nsresult)
-        {
-            if (TRUE == bIndex)
-                mexPrintf("Some indeces do not exist (ns_GetAnalogData).\n");
-            bIndex = FALSE;
-        }
-        else
-        {
-            mexPrintf("There was an error running ns_GetAnalogData!\n");
-            *ppmxContCount = mxCreateString("");
-            *ppmxData = mxCreateString("");
-            break;
-        }
+        pOlder = pBlock->pOlder;
+        if (bAll || (pBlock->hFile == hFile))
+            fCacheRemove(pBlock);
+    }
+    th_MutexUnlock(&g_cacheLock);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Analog sidecar files
+//
+//      Once a sidecar class is set with ns_AnalogSidecar, every analog entity
+//      that is read from its first to its last index is also written to a
+//      sidecar file next to the data file, as single precision values or as
+//      int16 raw counts. Later reads of the entity are served from the sidecar,
+//      which is mapped into memory, instead of being decoded by the library.
+//
+//      The header identifies the data file by its size and modification time
+//      and the library that decoded it. A sidecar that does not match is not
+//      used and written again on the next full read of its entity.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define MAX_SIDECARS 1024
+
+// The values of a sidecar start at this offset
+#define SIDECAR_DATA_OFFSET 4096
+
+// Number of values converted at once when a sidecar is read
+#define SIDECAR_BUFFER_SIZE 4096
+
+#define SIDECAR_MAGIC "NSDAT01"
+
+// Header of a sidecar file. The values are followed by the indeces that are not continuous
+// with the index before them, in ascending order. Sidecars are written to a temporary file
+// that replaces the sidecar when it is complete, so a file that was not completely written
+// is never used.
+typedef struct
+{
+    char szMagic[8];
+    double dFileSize;         // size of the data file
+    double dModified;         // modification time of the data file
+    char szLibrary[64];       // description of the library that decoded the data
+    UINT32 dwLibVersionMaj;
+    UINT32 dwLibVersionMin;
+    UINT32 dwEntityID;
+    UINT32 dwItemCount;
+    UINT32 dwClass;           // class of the values (mxSINGLE_CLASS or mxINT16_CLASS)
+    UINT32 dwGaps;            // number of indeces not continuous with the one before
+    double dScale;            // value of one raw count of int16 values
+} DATSIDECAR;
+
+// The sidecar of an entity that was looked for
+typedef struct
+{
+    BOOL bValid;
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    MF_MAP map;               // the sidecar (not mapped if there is no valid sidecar)
+    const DATSIDECAR *pHeader;
+    const void *pvValues;     // dwItemCount values of the class of the sidecar
+    const UINT32 *pdwGaps;    // dwGaps indeces
+} ANALOGSIDECAR;
+
+// The sidecars are only looked for, mapped and unmapped from the Matlab thread while
+// no worker threads run
+ANALOGSIDECAR g_aSidecars[MAX_SIDECARS];
+mxClassID g_sidecarClass = mxUNKNOWN_CLASS;   // class of new sidecars (mxUNKNOWN_CLASS = none)
+double g_dSidecarHits = 0;                    // entity reads served from sidecars
+double g_dSidecarsWritten = 0;                // sidecars written
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the name and the expected header of the sidecar file of an analog entity
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          classID - class of the values (mxSINGLE_CLASS or mxINT16_CLASS)
+//          pHeader - receives the header (dwGaps is 0)
+// Outputs: char * - name of the sidecar file (free it), 0 if the data file is not known,
+//          the entity is not an analog entity or its int16 values cannot be scaled
+char *fDataSidecarHeader(UINT32 hFile, UINT32 dwEntityID, mxClassID classID, DATSIDECAR *pHeader)
+{
+    const char *szPath = fGetFilePath(hFile);
+    struct stat fileStat;
+    ns_LIBRARYINFO nsLibInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    ns_ANALOGINFO nsAnalogInfo;
+    char *szName;
+
+    memset(pHeader, 0, sizeof(DATSIDECAR));
+    if (!szPath || (0 != stat(szPath, &fileStat)) ||
+        (0 != ns_GetLibraryInfo(g_nsDllHandle, &nsLibInfo, (UINT32) sizeof(nsLibInfo))) ||
+        (0 != ns_GetEntityInfo(g_nsDllHandle, hFile, dwEntityID, &nsEntityInfo, 
+                               (UINT32) sizeof(nsEntityInfo))) ||
+        (ns_ENTITY_ANALOG != nsEntityInfo.dwEntityType) ||
+        (0 != ns_GetAnalogInfo(g_nsDllHandle, hFile, dwEntityID, &nsAnalogInfo, 
+                               (UINT32) sizeof(nsAnalogInfo))) ||
+        ((mxINT16_CLASS == classID) && !(0 < nsAnalogInfo.dResolution)))
+    {
+        return(0);
     }
 
-    free(pdData);
-    return(nsresult);
+    szName = malloc(strlen(szPath) + 32);
+    if (!szName)
+        return(0);
+    sprintf(szName, "%s.%u.nsdat", szPath, (unsigned) dwEntityID);
+
+    strcpy(pHeader->szMagic, SIDECAR_MAGIC);
+    pHeader->dFileSize = (double) fileStat.st_size;
+    pHeader->dModified = (double) fileStat.st_mtime;
+    snprintf(pHeader->szLibrary, sizeof(pHeader->szLibrary), "%s", nsLibInfo.szDescription);
+    pHeader->dwLibVersionMaj = nsLibInfo.dwLibVersionMaj;
+    pHeader->dwLibVersionMin = nsLibInfo.dwLibVersionMin;
+    pHeader->dwEntityID = dwEntityID;
+    pHeader->dwItemCount = nsEntityInfo.dwItemCount;
+    pHeader->dwClass = (UINT32) classID;
+    pHeader->dScale = (mxINT16_CLASS == classID) ? nsAnalogInfo.dResolution : 1;
+    return(szName);
 }
 
-// Author & Date: Almut Branner, 2/21/2003
-// Purpose: Get segment data and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the sidecar of an entity, mapping it when the entity is first looked for
 // Inputs:  hFile - handle/ID number of the file
-//          ncolsEntity - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get data for
-//          ncolsIndex - number of elements in the array of entities (pdEntityID)
-//          pdIndex - pointer to the array of indeces to get data for
-//          ppmxTimeStamp - double pointer to the mex converted time stamp
-//          ppmxData - double pointer to the mex converted data structure
-//          ppmxSampleCount - double pointer to the mex converted count of the
-//                            samples loaded
-//          ppmxUnitID - double pointer to the mex converted unit classification
-//                       code
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxTimeStamp is filled.
-//          ppmxData is filled.
-//          ppmxSampleCount is filled.
-//          ppmxUnitID is filled.
-ns_RESULT fSegmentData(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex, 
-                       double *pdIndex, mxArray **ppmxTimeStamp, mxArray **ppmxData, 
-                       mxArray **ppmxSampleCount, mxArray **ppmxUnitID)
+//          dwEntityID - the analog entity
+// Outputs: ANALOGSIDECAR * - the mapped sidecar, 0 if there is no valid one
+ANALOGSIDECAR *fFindSidecar(UINT32 hFile, UINT32 dwEntityID)
 {
-    UINT32 i;
-    UINT32 j;
-    UINT32 k;
-    double dTimeStamp;
-    double *pdData;
-    double *pdTempData;
-    double *pdTempTimeStamp;
-    double *pdTempSampleCount;
-    double *pdTempUnitID;
-    UINT32 dwSampleCount;
-    UINT32 dwUnitID;
-    size_t dwMaxSampleCount = 0;
-    ns_SEGMENTINFO nsSegmentInfo;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
-    BOOL bIndex = TRUE;
+    ANALOGSIDECAR *pSidecar = 0;
+    DATSIDECAR expected;
+    DATSIDECAR header;
+    char *szName;
+    size_t cbValues;
+    int i;
 
-    // Determine the maximum data buffer necessary in case segment have different length
-    for (i = 0; i < ncolsEntity; ++i)
+    for (i = 0; i < MAX_SIDECARS; ++i)
     {
-        nsresult = ns_GetSegmentInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsSegmentInfo, 
-                                     sizeof(nsSegmentInfo));
-        if (0 == nsresult)
-        {
-            if (nsSegmentInfo.dwMaxSampleCount > dwMaxSampleCount)
-                dwMaxSampleCount = nsSegmentInfo.dwMaxSampleCount;
-        }
-        else if (-5 == nsresult)
+        if (g_aSidecars[i].bValid && (g_aSidecars[i].hFile == hFile) && 
+            (g_aSidecars[i].dwEntityID == dwEntityID))
         {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetSegmentInfo).\n");
-            bEntity = FALSE;
+            return(g_aSidecars[i].map.pvData ? &g_aSidecars[i] : 0);
         }
+        if (!pSidecar && !g_aSidecars[i].bValid)
+            pSidecar = &g_aSidecars[i];
+    }
+    if (!pSidecar)
+        return(0);
+
+    // An entity without a valid sidecar is remembered as well
+    memset(pSidecar, 0, sizeof(ANALOGSIDECAR));
+    pSidecar->bValid = TRUE;
+    pSidecar->hFile = hFile;
+    pSidecar->dwEntityID = dwEntityID;
+
+    szName = fDataSidecarHeader(hFile, dwEntityID, g_sidecarClass, &expected);
+    if (!szName)
+        return(0);
+    mf_Open(&pSidecar->map, szName);
+    free(szName);
+    if (pSidecar->map.nSize < SIDECAR_DATA_OFFSET)
+    {
+        mf_Close(&pSidecar->map);
+        return(0);
+    }
+
+    memcpy(&header, pSidecar->map.pvData, sizeof(header));
+    expected.dwGaps = header.dwGaps;
+    cbValues = (size_t) header.dwItemCount * fClassSize(g_sidecarClass);
+    if ((0 != memcmp(&header, &expected, sizeof(header))) || 
+        ((double) SIDECAR_DATA_OFFSET + cbValues + (double) header.dwGaps * sizeof(UINT32) > 
+         (double) pSidecar->map.nSize))
+    {
+        mf_Close(&pSidecar->map);
+        return(0);
+    }
+
+    pSidecar->pHeader = (const DATSIDECAR *) pSidecar->map.pvData;
+    pSidecar->pvValues = (const char *) pSidecar->map.pvData + SIDECAR_DATA_OFFSET;
+    pSidecar->pdwGaps = (const UINT32 *) ((const char *) pSidecar->pvValues + cbValues);
+    return(pSidecar);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the sidecars of several entities
+// Inputs:  hFile - handle/ID number of the file
+//          pdEntityID - pointer to the array of entities
+//          ncols - number of elements in the array of entities
+// Outputs: ANALOGSIDECAR ** - the mapped sidecar of every entity, 0 for entities without
+//          one (free it); 0 if no sidecar class is set
+ANALOGSIDECAR **fFindSidecars(UINT32 hFile, double *pdEntityID, size_t ncols)
+{
+    ANALOGSIDECAR **ppSidecar;
+    size_t i;
+
+    if (mxUNKNOWN_CLASS == g_sidecarClass)
+        return(0);
+
+    ppSidecar = calloc(ncols + 1, sizeof(ANALOGSIDECAR *));
+    for (i = 0; ppSidecar && (i < ncols); ++i)
+        ppSidecar[i] = fFindSidecar(hFile, (UINT32) pdEntityID[i]);
+    return(ppSidecar);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read analog data from a sidecar. May be called from worker threads.
+// Inputs:  pSidecar - the mapped sidecar
+//          dwIndex - first index to read
+//          dwIndexCount - how many indeces are read
+//          classID - class of the data (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+//          dScale - value of one raw count (only used for mxINT16_CLASS)
+//          pvData - receives the data
+//          pdwContCount - receives the number of continuous indeces
+// Outputs: BOOL - FALSE if the range does not lie within the entity
+BOOL fReadSidecar(const ANALOGSIDECAR *pSidecar, UINT32 dwIndex, UINT32 dwIndexCount,
+                  mxClassID classID, double dScale, void *pvData, UINT32 *pdwContCount)
+{
+    const DATSIDECAR *pHeader = pSidecar->pHeader;
+    size_t cbValue = fClassSize(classID);
+    double adBuffer[SIDECAR_BUFFER_SIZE];
+    double *pdBuffer;
+    size_t nLow = 0;
+    size_t nHigh = pHeader->dwGaps;
+    size_t nMid;
+    UINT32 dwDone;
+    UINT32 dwCount;
+
+    if ((double) dwIndex + dwIndexCount > pHeader->dwItemCount)
+        return(FALSE);
+
+    // The continuous count ends with the first gap after the first index
+    while (nLow < nHigh)
+    {
+        nMid = (nLow + nHigh) / 2;
+        if (pSidecar->pdwGaps[nMid] <= dwIndex)
+            nLow = nMid + 1;
         else
-        {
-            mexPrintf("There was an error running ns_GetSegmentInfo!\n(Required for ns_GetSegmentData)\n");
-            *ppmxTimeStamp = mxCreateString("");
-            *ppmxSampleCount = mxCreateString("");
-            *ppmxUnitID = mxCreateString("");
-            *ppmxData = mxCreateString("");
-            return(ns_LIBERROR);
-        }
+            nHigh = nMid;
     }
+    *pdwContCount = dwIndexCount;
+    if (nLow < pHeader->dwGaps)
+        *pdwContCount = MIN(dwIndexCount, pSidecar->pdwGaps[nLow] - dwIndex);
 
-    // Check whether there actually is data or whether the size of it is defined
-    if (0 < dwMaxSampleCount)
-    {
-        const int dims[] = {dwMaxSampleCount, ncolsIndex, ncolsEntity};
-        pdData = calloc(dwMaxSampleCount, 8);
-        *ppmxData = mxCreateNumericArray(3, dims, mxDOUBLE_CLASS, mxREAL);
-        *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-        *ppmxSampleCount = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-        *ppmxUnitID = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
-        pdTempData = mxGetPr(*ppmxData);
-        pdTempTimeStamp = mxGetPr(*ppmxTimeStamp);
-        pdTempSampleCount = mxGetPr(*ppmxSampleCount);
-        pdTempUnitID = mxGetPr(*ppmxUnitID);
+    // Values of the class of the sidecar are copied, the others converted
+    if (((UINT32) classID == pHeader->dwClass) && ((mxSINGLE_CLASS == classID) || (dScale == pHeader->dScale)))
+    {
+        memcpy(pvData, (const char *) pSidecar->pvValues + (size_t) dwIndex * cbValue, 
+               (size_t) dwIndexCount * cbValue);
+        return(TRUE);
     }
-    else
+
+    for (dwDone = 0; dwDone < dwIndexCount; dwDone += dwCount)
     {
-        mexPrintf("ns_GetSegmentInfo returned a ZERO sample count for the data!\n(Required for ns_GetSegmentData)\n");
-        *ppmxTimeStamp = mxCreateString("");
-        *ppmxSampleCount = mxCreateString("");
-        *ppmxUnitID = mxCreateString("");
-        *ppmxData = mxCreateString("");
-        return(ns_LIBERROR);
+        dwCount = MIN(dwIndexCount - dwDone, SIDECAR_BUFFER_SIZE);
+        pdBuffer = (mxDOUBLE_CLASS == classID) ? (double *) pvData + dwDone : adBuffer;
+        if (mxSINGLE_CLASS == pHeader->dwClass)
+            dsp_SingleToDouble((const float *) pSidecar->pvValues + dwIndex + dwDone, dwCount, pdBuffer);
+        else
+            dsp_Int16ToDouble((const short *) pSidecar->pvValues + dwIndex + dwDone, dwCount, 
+                              pHeader->dScale, pdBuffer);
+        fConvertSamples(pdBuffer, dwCount, classID, dScale, (char *) pvData + dwDone * cbValue);
     }
+    return(TRUE);
+}
 
-    // Load the data and fill the matrix
-    for (i = 0; i < ncolsEntity; ++i)
+// Sidecars of several entities written by the worker threads
+typedef struct
+{
+    mxClassID classID;        // class of the values that were read
+    DATSIDECAR *pHeader;      // header of every sidecar
+    char **pszName;           // name of every sidecar
+    const void **ppvValues;   // values of every entity that were read
+    ANALOGBLOCKS *pGaps;      // gaps of every entity, found before the parallel write
+    BOOL *pbWritten;          // the sidecar was written
+} SIDECARWRITE;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Write the values of an entity that were read and its gaps to its sidecar file.
+//          Errors are ignored, the sidecar is only a cache. May be called from worker
+//          threads, the library is not called.
+// Inputs:  pvContext - the SIDECARWRITE describing the sidecars
+//          nItem - which sidecar to write
+// Outputs: pWrite->pbWritten[nItem] is filled
+void fWriteSidecarTask(void *pvContext, size_t nItem)
+{
+    SIDECARWRITE *pWrite = (SIDECARWRITE *) pvContext;
+    DATSIDECAR header = pWrite->pHeader[nItem];
+    mxClassID classID = (mxClassID) header.dwClass;
+    size_t cbValue = fClassSize(classID);
+    const char *pcValues = (const char *) pWrite->ppvValues[nItem];
+    char acBuffer[SIDECAR_BUFFER_SIZE * sizeof(double)];
+    const ANALOGBLOCKS *pGaps = &pWrite->pGaps[nItem];
+    UINT32 dwCount;
+    UINT32 dwDone;
+    char *szTemp = malloc(strlen(pWrite->pszName[nItem]) + 8);
+    FILE *pFile = 0;
+    BOOL bWritten;
+
+    header.dwGaps = (UINT32) pGaps->nBlocks;
+
+    if (szTemp)
     {
-        for (j = 0; j < ncolsIndex; ++j)
-        {
-            nsresult = ns_GetSegmentData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdIndex[j], 
-                                         &dTimeStamp, pdData, 8 * (UINT32) dwMaxSampleCount, &dwSampleCount, 
-                                         &dwUnitID);
-            if (0 == nsresult)
-            {
-                for (k = 0; k < dwSampleCount; ++k)
-                {
-                    // totalrow * totalcol * 3rd + col * totalrow + row
-                    *(pdTempData + dwSampleCount * ncolsIndex * i + dwSampleCount * j + k)
-                         = *(pdData + k);
-                }
+        sprintf(szTemp, "%s.tmp", pWrite->pszName[nItem]);
+        pFile = fopen(szTemp, "wb");
+    }
+    bWritten = pFile && (0 == fseek(pFile, SIDECAR_DATA_OFFSET, SEEK_SET));
 
-                *(pdTempTimeStamp + i * ncolsIndex + j) = dTimeStamp;
-                *(pdTempSampleCount + i * ncolsIndex + j) = dwSampleCount;
-                *(pdTempUnitID + i * ncolsIndex + j) = dwUnitID;
-            }
-            else if (-5 == nsresult)
-            {
-                break;
-            }
-            else if (-7 == nsresult)
-            {
-                if (TRUE == bIndex)
-                    mexPrintf("Some indeces do not exist (ns_GetSegmentData).\n");
-                bIndex = FALSE;
-                break;
-            }
-            else
-            {
-                mexPrintf("There was an error running ns_GetSegmentData!\n");
-                *ppmxTimeStamp = mxCreateString("");
-                *ppmxSampleCount = mxCreateString("");
-                *ppmxUnitID = mxCreateString("");
-                *ppmxData = mxCreateString("");
-                free(pdData);
-                return(nsresult);
-            }
-        }
+    // Values read as double are converted to the class of the sidecar on the way
+    if (bWritten && (pWrite->classID == classID))
+        bWritten = (header.dwItemCount == fwrite(pcValues, cbValue, header.dwItemCount, pFile));
+    for (dwDone = 0; bWritten && (pWrite->classID != classID) && (dwDone < header.dwItemCount); 
+         dwDone += dwCount)
+    {
+        dwCount = MIN(header.dwItemCount - dwDone, SIDECAR_BUFFER_SIZE);
+        fConvertSamples((const double *) pcValues + dwDone, dwCount, classID, header.dScale, acBuffer);
+        bWritten = (dwCount == fwrite(acBuffer, cbValue, dwCount, pFile));
     }
 
-    free(pdData);
-    return(nsresult);
+    bWritten = bWritten &&
+               (header.dwGaps == fwrite(pGaps->pdwStart, sizeof(UINT32), header.dwGaps, pFile)) &&
+               (0 == fseek(pFile, 0, SEEK_SET)) &&
+               (1 == fwrite(&header, sizeof(header), 1, pFile));
+    if (pFile && (0 != fclose(pFile)))
+        bWritten = FALSE;
+    bWritten = bWritten && mf_Replace(szTemp, pWrite->pszName[nItem]);
+    if (pFile && !bWritten)
+        remove(szTemp);
+
+    free(szTemp);
+    pWrite->pbWritten[nItem] = bWritten;
 }
 
-// Author & Date: Almut Branner, 2/7/2003
-// Purpose: Get neural data and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Forget the sidecar of an entity, e.g. when it was written again
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          dwIndex - index in the particular entity
-//          dwIndexCount - how many indeces are loaded
-//          ppmxData - double pointer to the mex converted data structure
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxData is filled.
-ns_RESULT fNeuralData(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
-                      UINT32 dwIndexCount, mxArray **ppmxData)
+//          dwEntityID - the analog entity
+void fForgetSidecar(UINT32 hFile, UINT32 dwEntityID)
 {
-    UINT32 i;
-    UINT32 j;
-    double *pdData = 0;
-    double *pdTempData = 0;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
-    BOOL bIndex = TRUE;
-
-    pdData = calloc(dwIndexCount, 8);
+    int i;
 
-    for (i = 0; i < ncols; ++i)
+    for (i = 0; i < MAX_SIDECARS; ++i)
     {
-        nsresult = ns_GetNeuralData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, dwIndexCount, pdData);
-
-        if (0 == i)
+        if (g_aSidecars[i].bValid && (g_aSidecars[i].hFile == hFile) && 
+            (g_aSidecars[i].dwEntityID == dwEntityID))
         {
-            *ppmxData = mxCreateDoubleMatrix(dwIndexCount, ncols, mxREAL);
-            pdTempData = mxGetPr(*ppmxData);
+            mf_Close(&g_aSidecars[i].map);
+            g_aSidecars[i].bValid = FALSE;
         }
+    }
+}
 
-        if (nsresult == 0)
-        {
-            for (j = 0; j < dwIndexCount; ++j)
-            {
-                *(pdTempData + (i * dwIndexCount) + j) = *(pdData + j);
-            }
-        }
-        else if (-5 == nsresult)
-        {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetNeuralData).\n");
-            bEntity = FALSE;
-        }
-        else if (-7 == nsresult)
-        {
-            ns_ENTITYINFO nsEntityInfo;
-
-            if (TRUE == bIndex)
-                mexPrintf("Some indeces do not exist (ns_GetNeuralData).\n");
-
-            if (ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo, 
-                sizeof(ns_ENTITYINFO)) == 0)
-            {
-                if (ns_GetNeuralData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, 
-                    nsEntityInfo.dwItemCount, pdData) == 0)
-                {
-                    for (j = 0; j < dwIndexCount; ++j)
-                    {
-                        *(pdTempData + (i * dwIndexCount) + j) = *(pdData + j);
-                    }
-                }
-            }
-
-            bIndex = FALSE;
-        }
-        else
-        {
-            mexPrintf("There was an error running ns_GetNeuralData!\n");
-            *ppmxData = mxCreateString("");
-            break;
-        }
-    }
-
-    free(pdData);
-    return(nsresult);
-}
-
-// Author & Date: Almut Branner, 2/7/2003
-// Purpose: Find index and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Write the sidecars of the entities of a read that covered them completely
+//          The values that were read are written, the entities are not decoded again.
+//          The gaps after the first one are found by the time stamps here, on the Matlab
+//          thread, so that the worker threads only write files.
+//          Entities served from their sidecar are not written again, neither are values
+//          read as a class other than double or the class of the sidecars.
 // Inputs:  hFile - handle/ID number of the file
-//          ncols - number of elements in the array of entities (pdEntityID)
-//          pdEntityID - pointer to the array of entities to get info for
-//          dTime - time of the data to search for
-//          nFlag - flag specifying whether index to be retrieved belongs to data item
-//                 occuring before (-1), closest (0) or after (1) specified time
-//          ppmxIndex - double pointer to the mex converted index
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxIndex is filled.
-ns_RESULT fIndexByTime(UINT32 hFile, size_t ncols, double *pdEntityID, double dTime, INT32 nFlag, 
-                       mxArray **ppmxIndex)
+//          pdEntityID - pointer to the array of entities that were read
+//          ncols - number of elements in the array of entities
+//          dwIndex - first index that was read
+//          dwIndexCount - how many indeces were read
+//          classID - class of the values that were read
+//          pvData - the values that were read, a column of dwIndexCount values per entity
+//          pdwContCount - number of continuous indeces of every entity that were read
+//          pnResult - result of reading every entity
+//          ppSidecar - the sidecar every entity was served from (may be 0)
+//          nThreads - number of worker threads writing sidecars in parallel
+void fWriteSidecars(UINT32 hFile, double *pdEntityID, size_t ncols, UINT32 dwIndex, 
+                    UINT32 dwIndexCount, mxClassID classID, const void *pvData, 
+                    const UINT32 *pdwContCount, ns_RESULT *pnResult, ANALOGSIDECAR **ppSidecar, 
+                    int nThreads)
 {
-    UINT32 i;
-    UINT32 dwIndex;
-    double *pdIndex = 0;
-    ns_RESULT nsresult = 0;
-    BOOL bEntity = TRUE;
+    SIDECARWRITE write;
+    size_t cbColumn = (size_t) dwIndexCount * fClassSize(classID);
+    double dSampleRate;
+    UINT32 dwGap;
+    UINT32 dwCount;
+    ns_RESULT nsresult;
+    size_t nCount = 0;
+    size_t i;
+    size_t k;
 
-    for (i = 0; i < ncols; ++i)
+    if ((mxUNKNOWN_CLASS == g_sidecarClass) || (0 != dwIndex) || (0 == dwIndexCount) ||
+        ((mxDOUBLE_CLASS != classID) && (g_sidecarClass != classID)))
     {
-        nsresult = ns_GetIndexByTime(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dTime, nFlag, &dwIndex);
+        return;
+    }
 
-        if (0 == i)
+    write.classID = classID;
+    write.pHeader = calloc(ncols, sizeof(DATSIDECAR));
+    write.pszName = calloc(ncols, sizeof(char *));
+    write.ppvValues = calloc(ncols, sizeof(void *));
+    write.pGaps = calloc(ncols, sizeof(ANALOGBLOCKS));
+    write.pbWritten = calloc(ncols, sizeof(BOOL));
+
+    for (i = 0; write.pHeader && write.pszName && write.ppvValues && write.pGaps && 
+         write.pbWritten && (i < ncols); ++i)
+    {
+        if ((0 != pnResult[i]) || (ppSidecar && ppSidecar[i]))
+            continue;
+        for (k = 0; (k < i) && (pdEntityID[k] != pdEntityID[i]); ++k)
+            ;
+        if (k < i)
+            continue;
+
+        write.pszName[nCount] = fDataSidecarHeader(hFile, (UINT32) pdEntityID[i], g_sidecarClass, 
+                                                   &write.pHeader[nCount]);
+        if (!write.pszName[nCount])
+            continue;
+        if (write.pHeader[nCount].dwItemCount != dwIndexCount)
         {
-            *ppmxIndex = mxCreateDoubleMatrix(ncols, 1, mxREAL);
-            pdIndex = mxGetPr(*ppmxIndex);
+            free(write.pszName[nCount]);
+            write.pszName[nCount] = 0;
+            continue;
         }
-
-        if (0 == nsresult)
+        // The read reported the first gap, the blocks after it are found by the time stamps
+        nsresult = ns_OK;
+        dSampleRate = 0;
+        for (dwGap = pdwContCount[i]; (0 == nsresult) && (dwGap < dwIndexCount); dwGap += dwCount)
         {
-            *(pdIndex + i) = dwIndex;
+            if (0 < dwGap)
+                fAddBlock(&write.pGaps[nCount], dwGap);
+            nsresult = fBlockLength(hFile, (UINT32) pdEntityID[i], &dSampleRate, dwGap, 
+                                    dwIndexCount - dwGap, &dwCount);
         }
-        else if (-5 == nsresult)
+        if ((0 != nsresult) || write.pGaps[nCount].bOutOfMemory)
         {
-            if (TRUE == bEntity)
-                mexPrintf("Some entities do not exist (ns_GetIndexByTime).\n");
-            bEntity = FALSE;
+            free(write.pGaps[nCount].pdwStart);
+            memset(&write.pGaps[nCount], 0, sizeof(ANALOGBLOCKS));
+            free(write.pszName[nCount]);
+            write.pszName[nCount] = 0;
+            continue;
         }
-        else 
+        write.ppvValues[nCount] = (const char *) pvData + i * cbColumn;
+        ++nCount;
+    }
+
+    th_ParallelFor(nCount, nThreads, fWriteSidecarTask, &write);
+
+    // Written sidecars are mapped when their entity is read next
+    for (i = 0; i < nCount; ++i)
+    {
+        if (write.pbWritten[i])
         {
-            mexPrintf("There was an error running ns_GetIndexByTime!\n");
-            *ppmxIndex = mxCreateString("");
-            break;
+            g_dSidecarsWritten += 1;
+            fForgetSidecar(hFile, write.pHeader[i].dwEntityID);
         }
+        free(write.pszName[i]);
+        free(write.pGaps[i].pdwStart);
     }
 
-    return(nsresult);
+    free(write.pHeader);
+    free(write.pszName);
+    free(write.ppvValues);
+    free(write.pGaps);
+    free(write.pbWritten);
 }
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Find time and convert it into Matlab format
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Unmap the sidecars of a file, e.g. when it is closed, or of all files
 // Inputs:  hFile - handle/ID number of the file
-//          dwEntityID - get info for this entity
-//          dwIndexCount - the number of indices we care about
-//          pdIndex - array of indices we want to know about
-//          ppmxTime - double pointer to the mex converted time
-// Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxTime is filled.
-ns_RESULT fTimeByIndex(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndexCount, double * pdIndex, mxArray **ppmxTime)
-{
-    double * adTime = 0;
-    ns_RESULT nsresult = ns_BADINDEX;
-    UINT32 i;
-
-    // Let's get our space
-    *ppmxTime = mxCreateDoubleMatrix(dwIndexCount, 1, mxREAL);
-    adTime = mxGetPr(*ppmxTime);
+//          bAll - TRUE to unmap the sidecars of all files
+void fReleaseSidecars(UINT32 hFile, BOOL bAll)
+{
+    int i;
 
-    // Now do them all
-    for (i = 0; i < dwIndexCount; ++i)
+    for (i = 0; i < MAX_SIDECARS; ++i)
     {
-        UINT32 dwIndex = (UINT32)pdIndex[i];
-        
-        nsresult = ns_GetTimeByIndex(g_nsDllHandle, hFile, dwEntityID, dwIndex, &adTime[i]);
-        if (nsresult != ns_OK)
+        if (g_aSidecars[i].bValid && (bAll || (g_aSidecars[i].hFile == hFile)))
         {
-            mexPrintf("There was an error running ns_GetTimeByIndex!\n");
-            *ppmxTime = mxCreateString("");
-            return nsresult;
+            mf_Close(&g_aSidecars[i].map);
+            g_aSidecars[i].bValid = FALSE;
         }
     }
-    return nsresult;
 }
 
+////////////////////////////////////////////////////////////////////////////
+//
+// Specific Neuroshare functions
+//
+//      Each specific function calls the appropriate function in the 
+//      Neuroshare DLL with the input arguments it was given. The returned
+//      data are then converted into MATLAB mxArrays and passed back to the
+//      main function.
+//
+////////////////////////////////////////////////////////////////////////////
 
-// Author & Date: Almut Branner, 2/21/2003
-// Purpose: Get the extended error message to last error
-// Inputs:  ppmxErrorMsg - double pointer to the mex converted error message
+// Author & Date: Almut Branner, 2/4/2003
+// Purpose: Load Neuroshare DLL and open the data file
+// Inputs:  szFile - name of the file to be opened
+//          ppmxFilehandle - double pointer to the handle/ID number of the 
+//                           file that was opened
 // Outputs: ns_RESULT - what error was returned by the function (should be 0)
-//          ppmxErrorMsg is filled.
-ns_RESULT fLastErrorMsg(mxArray **ppmxErrorMsg)
+//          ppmxFilehandle is filled
+
+// TODO: This function will eventually select a DLL based on the file extension
+//       and load that DLL. At this point only NEV files are supported.
+ns_RESULT fOpenFile(char *szFile, mxArray **ppmxFilehandle)
 {
-    char szMsgBuffer[256];
+    UINT32 hFile;
     ns_RESULT nsresult;
 
-    nsresult = ns_GetLastErrorMsg(g_nsDllHandle, szMsgBuffer, sizeof(szMsgBuffer));
+    nsresult = ns_OpenFile(g_nsDllHandle, szFile, &hFile);
 
-    if (nsresult == 0) 
-        *ppmxErrorMsg = mxCreateString(szMsgBuffer);
+    if (0 != nsresult) 
+    {
+        *ppmxFilehandle = mxCreateString("");
+        mexPrintf("NEV file could not be loaded!\n");
+    }
     else 
     {
-        mexPrintf("There was an error running ns_GetTimeByIndex!\n");
-        *ppmxErrorMsg = mxCreateString("");
+        *ppmxFilehandle = mxCreateScalarDouble(hFile);
+        fRememberFile(hFile, szFile);
     }
 
     return(nsresult);
 }
 
-// Author & Date:       Kirk Korver     17 Dec 2003
-// Purpose: Unload the previous library if it was loaded, then load this DLL
-// Inputs:
-//  szName - the name of the library to load
-// Outputs:
-//  ns_OK if life is good; ns_LIBERROR, if the DLL couldn't be loaded
-ns_RESULT fSetLibrary(const char * szName)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: Almut Branner, 2/3/2003
+// Purpose: Get library information and convert it into Matlab format
+// Inputs:  ppmxInfo - double pointer to the mex converted ns_LIBRARYINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled
+ns_RESULT fLibInfo(mxArray **ppmxInfo)
 {
-    if (g_nsDllHandle)
-        ns_CloseLibrary(g_nsDllHandle);
+    // Arrays & enumerations with structure element names are created
+    enum
+    {
+        LI_LIB_VERSION_MAJ,
+        LI_LIB_VERSION_MIN,
+        LI_API_VERSION_MAJ, 
+        LI_API_VERSION_MIN, 
+        LI_DESCRIPTION,
+        LI_CREATOR, 
+        LI_TIME_YEAR,
+        LI_TIME_MONTH,
+        LI_TIME_DAY,
+        LI_FLAGS,
+        LI_MAX_FILES, 
+        LI_FILE_DESC_COUNT,
+        LI_FILE_DESC,
+        LI_COUNT
+    };
+    
+    const char *aszLibInfoNames[LI_COUNT] = 
+    {
+        "LibVersionMaj",
+        "LibVersionMin",
+        "APIVersionMaj", 
+        "APIVersionMin", 
+        "Description",
+        "Creator", 
+        "Time_Year",
+        "Time_Month",
+        "Time_Day",
+        "Flags",
+        "MaxFiles", 
+        "FileDescCount",
+        "FileDesc"
+    };
 
-    g_nsDllHandle = ns_LoadLibrary(szName);
+    enum
+    {
+        FD_DESCRIPTION,
+        FD_EXTENSION,
+        FD_MACCODES,
+        FD_MAGICCODE,
+        FD_COUNT
+    };
+    const char *aszFileDescNames[FD_COUNT] = 
+    {
+        "Description",
+        "Extension",
+        "MacCodes",
+        "MagicCode"
+    };
 
-    return g_nsDllHandle ? ns_OK : ns_LIBERROR;
-}
 
+    // Intermediate mxArrays to hold the structures
+    mxArray *mxOutput;
+    mxArray *mxFileDesc;
+    mxArray *mxFieldValue;
+    BOOL bPrev = FALSE;
+    char szTemp[80];
+    ns_LIBRARYINFO nsLibInfo;
+    ns_RESULT nsresult;
+    unsigned int i;
 
+    nsresult = ns_GetLibraryInfo(g_nsDllHandle, &nsLibInfo, (UINT32)sizeof(nsLibInfo));
 
+    if (0 == nsresult)
+    {
+        // A structure array to hold the libray information is created
+        mxOutput = mxCreateStructMatrix(1, 1, 13, aszLibInfoNames);
 
-////////////////////////////////////////////////////////////////////////////
-//
-// Error handling functions
-//
-//      If an error occurs, the output arguments are filled with an empty
-//      string, a MATLAB error message is created and the program returns
-//      back to MATLAB with a general library error.
-//
-////////////////////////////////////////////////////////////////////////////
+        // The library information is converted into Matlab mxArrays
+        // and the fields of the structure array are filled
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwLibVersionMaj);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_LIB_VERSION_MAJ], mxFieldValue);
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Check whether the right amount of arguments were given by Matlab
-// Inputs:  pplhs - double pointer to the return arguments of the function
-//          nRight - number of right hand arguments
-//          nLeft - number of left hand arguments
-//          nExpRight - number of expected right hand arguments
-//          nExpLeft - number of expected left hand arguments
-// Outputs: BOOL - is expected number of arguments the same as actual
-//          If there is an error the left hand arguments are filled in with blanks
-BOOL fCheckNumArguments(mxArray **pplhs, int nRight, int nLeft, int nExpRight, int nExpLeft)
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwLibVersionMin);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_LIB_VERSION_MIN], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwAPIVersionMaj);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_API_VERSION_MAJ], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwAPIVersionMin);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_API_VERSION_MIN], mxFieldValue);
+
+        mxFieldValue = mxCreateString(nsLibInfo.szDescription);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_DESCRIPTION], mxFieldValue);
+
+        mxFieldValue = mxCreateString(nsLibInfo.szCreator);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_CREATOR], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Year);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_YEAR], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Month);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_MONTH], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwTime_Day);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_TIME_DAY], mxFieldValue);
+
+        if (nsLibInfo.dwFlags & ns_LIBRARY_DEBUG)
+        {
+            strcpy(szTemp, "DEBUG ");
+            bPrev = TRUE;
+        }
+        if (nsLibInfo.dwFlags & ns_LIBRARY_MODIFIED)
+        {
+            if (bPrev == FALSE) 
+            {
+                strcpy(szTemp, "MODIFIED ");
+                bPrev = TRUE;
+            }
+            else
+                strcat(szTemp, "+ MODIFIED ");
+        }
+        if (nsLibInfo.dwFlags & ns_LIBRARY_PRERELEASE)
+        {
+            if (bPrev == FALSE) 
+            {
+                strcpy(szTemp, "PRERELEASE ");
+                bPrev = TRUE;
+            }
+            else
+                strcat(szTemp, "+ PRERELEASE ");
+        }
+        if (nsLibInfo.dwFlags & ns_LIBRARY_SPECIALBUILD)
+        {
+            if (bPrev == FALSE) 
+            {
+                strcpy(szTemp, "SPECIALBUILD ");
+                bPrev = TRUE;
+            }
+            else
+                strcat(szTemp, "+ SPECIALBUILD ");
+        }
+        if (nsLibInfo.dwFlags & ns_LIBRARY_MULTITHREADED)
+        {
+            if (bPrev == FALSE)
+                strcpy(szTemp, "MULTITHREADED");
+            else
+                strcat(szTemp, "+ MULTITHREADED");
+        }
+        if (bPrev == FALSE)
+            strcpy(szTemp, "NONE");
+            
+
+        mxFieldValue = mxCreateString(szTemp);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FLAGS], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwMaxFiles);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_MAX_FILES], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsLibInfo.dwFileDescCount);
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FILE_DESC_COUNT], mxFieldValue);
+
+        
+        // Build the other structure
+
+        mxFileDesc = mxCreateStructMatrix(nsLibInfo.dwFileDescCount, 1, 4, aszFileDescNames);
+
+        for (i = 0; i < nsLibInfo.dwFileDescCount; ++i)
+        {
+            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szDescription);
+            mxSetField(mxFileDesc, i, aszFileDescNames[FD_DESCRIPTION], mxFieldValue);
+            
+            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szExtension);
+            mxSetField(mxFileDesc, i, aszFileDescNames[FD_EXTENSION], mxFieldValue);
+            
+            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szMacCodes);
+            mxSetField(mxFileDesc, i, aszFileDescNames[FD_MACCODES], mxFieldValue);
+            
+            mxFieldValue = mxCreateString(nsLibInfo.FileDesc[i].szMagicCode);
+            mxSetField(mxFileDesc, i, aszFileDescNames[FD_MAGICCODE], mxFieldValue);
+        }
+
+        // Now put the structure into the other structure
+        mxSetField(mxOutput, 0, aszLibInfoNames[LI_FILE_DESC], mxFileDesc);
+
+
+        // Assign the structure array to the output argument
+        *ppmxInfo = mxOutput;
+    }
+    else
+    {
+        mexPrintf("There was an error running ns_GetLibraryInfo!\n");
+        *ppmxInfo = mxCreateString("");
+    }
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Get file information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ppmxInfo - double pointer to the mex converted ns_FILEINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fFileInfo(UINT32 hFile, mxArray **ppmxInfo)
 {
-    int i;
+    const char *aszFileInfoNames[] = {"FileType","EntityCount","TimeStampResolution",
+                                "TimeSpan","AppName","Time_Year","Time_Month","Time_Day",
+                                "Time_Hour","Time_Min","Time_Sec","Time_MilliSec",
+                                "FileComment"};
+    mxArray *mxOutput;
+    mxArray *mxFieldValue;
+    ns_FILEINFO nsFileInfo;
+    ns_RESULT nsresult;
+
+    nsresult = ns_GetFileInfo(g_nsDllHandle, hFile, &nsFileInfo, (UINT32)sizeof(nsFileInfo));
+
+    if (0 == nsresult)
+    {
+        mxOutput = mxCreateStructMatrix(1, 1, 13, aszFileInfoNames);
+
+        mxFieldValue = mxCreateString(nsFileInfo.szFileType);
+        mxSetField(mxOutput, 0, aszFileInfoNames[0], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwEntityCount);
+        mxSetField(mxOutput, 0, aszFileInfoNames[1], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dTimeStampResolution);
+        mxSetField(mxOutput, 0, aszFileInfoNames[2], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dTimeSpan);
+        mxSetField(mxOutput, 0, aszFileInfoNames[3], mxFieldValue);
+
+        mxFieldValue = mxCreateString(nsFileInfo.szAppName);
+        mxSetField(mxOutput, 0, aszFileInfoNames[4], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Year);
+        mxSetField(mxOutput, 0, aszFileInfoNames[5], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Month);
+        mxSetField(mxOutput, 0, aszFileInfoNames[6], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Day);
+        mxSetField(mxOutput, 0, aszFileInfoNames[7], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Hour);
+        mxSetField(mxOutput, 0, aszFileInfoNames[8], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Min);
+        mxSetField(mxOutput, 0, aszFileInfoNames[9], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_Sec);
+        mxSetField(mxOutput, 0, aszFileInfoNames[10], mxFieldValue);
+
+        mxFieldValue = mxCreateScalarDouble(nsFileInfo.dwTime_MilliSec);
+        mxSetField(mxOutput, 0, aszFileInfoNames[11], mxFieldValue);
+
+        mxFieldValue = mxCreateString(nsFileInfo.szFileComment);
+        mxSetField(mxOutput, 0, aszFileInfoNames[12], mxFieldValue);
+
+        *ppmxInfo = mxOutput;
+    }
+    else
+    {
+        mexPrintf("There was an error running ns_GetFileInfo!\n");
+        *ppmxInfo = mxCreateString("");
+    }
+
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Get entity information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ppmxInfo - double pointer to the mex converted ns_ENTITYINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fEntityInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+{
+    const char *aszEntityNames[] = {"EntityLabel","EntityType","ItemCount"};
+    UINT32 i;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_ENTITYINFO nsEntityInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo, 
+                                    (UINT32) sizeof(nsEntityInfo));
+        if (0 == i)
+            mxOutput = mxCreateStructMatrix(ncols, 1, 3, aszEntityNames);
+
+        if (0 == nsresult)
+        {
+            mxFieldValue = mxCreateString(nsEntityInfo.szEntityLabel);
+            mxSetField(mxOutput, i, aszEntityNames[0], mxFieldValue);
+
+            switch (nsEntityInfo.dwEntityType)
+            {
+            case 0:     // ns_ENTITY_UNKNOWN
+                mxFieldValue = mxCreateScalarDouble(0);
+                break;
+            case 1:     // ns_ENTITY_EVENT
+                mxFieldValue = mxCreateScalarDouble(1);
+                break;
+            case 2:     // ns_ENTITY_ANALOG
+                mxFieldValue = mxCreateScalarDouble(2);
+                break;
+            case 3:     // ns_ENTITY_SEGMENT
+                mxFieldValue = mxCreateScalarDouble(3);
+                break;
+            case 4:     // ns_ENTITY_NEURALEVENT
+                mxFieldValue = mxCreateScalarDouble(4);
+                break;
+            }
+            mxSetField(mxOutput, i, aszEntityNames[1], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsEntityInfo.dwItemCount);
+            mxSetField(mxOutput, i, aszEntityNames[2], mxFieldValue);
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetEntityInfo).\n");
+            bEntity = FALSE;
+            nsresult = 0;
+        }
+        else
+        {
+            // If any element fails, the function returns an error and an empty structure
+            mexPrintf("There was an error running ns_GetEntityInfo!\n");
+            *ppmxInfo = mxCreateString("");
+            break;
+        }
+    }
+    if (0 == nsresult)
+        *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Get event information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ppmxInfo - double pointer to the mex converted ns_EVENTINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fEventInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+{
+    const char *aszEventNames[] = {"EventType","MinDataLength","MaxDataLength",
+                                    "CSVDesc"};
+    UINT32 i;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_EVENTINFO nsEventInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEventInfo, 
+                                   (UINT32) sizeof(nsEventInfo));
+        if (0 == i)
+            mxOutput = mxCreateStructMatrix(ncols, 1, 4, aszEventNames);
+
+        if (0 == nsresult)
+        {
+            switch (nsEventInfo.dwEventType)
+            {
+            case 0:
+                mxFieldValue = mxCreateString("ns_EVENT_TEXT");
+                break;
+            case 1:
+                mxFieldValue = mxCreateString("ns_EVENT_CSV");
+                break;
+            case 2:
+                mxFieldValue = mxCreateString("ns_EVENT_BYTE");
+                break;
+            case 3:
+                mxFieldValue = mxCreateString("ns_EVENT_WORD");
+                break;
+            case 4:
+                mxFieldValue = mxCreateString("ns_EVENT_DWORD");
+                break;
+            }
+            mxSetField(mxOutput, i, aszEventNames[0], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsEventInfo.dwMinDataLength);
+            mxSetField(mxOutput, i, aszEventNames[1], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsEventInfo.dwMaxDataLength);
+            mxSetField(mxOutput, i, aszEventNames[2], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsEventInfo.szCSVDesc);
+            mxSetField(mxOutput, i, aszEventNames[3], mxFieldValue);
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetEventInfo).\n");
+            bEntity = FALSE;
+            nsresult = 0;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetEventInfo!\n");
+            *ppmxInfo = mxCreateString("");
+        }
+    }
+    if (0 == nsresult)
+        *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Get analog information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ppmxInfo - double pointer to the mex converted ns_ANALOGINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fAnalogInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+{
+    const char *aszAnalogNames[] = {"SampleRate","MinVal","MaxVal","Units","Resolution",
+                                "LocationX","LocationY","LocationZ","LocationUser",
+                                "HighFreqCorner","HighFreqOrder","HighFilterType",
+                                "LowFreqCorner","LowFreqOrder","LowFilterType","ProbeInfo"};
+    UINT32 i;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if (0 == i)
+            mxOutput = mxCreateStructMatrix(ncols, 1, 16, aszAnalogNames);
+
+        if (nsresult == 0)
+        {
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dSampleRate);
+            mxSetField(mxOutput, i, aszAnalogNames[0], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dMinVal);
+            mxSetField(mxOutput, i, aszAnalogNames[1], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dMaxVal);
+            mxSetField(mxOutput, i, aszAnalogNames[2], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsAnalogInfo.szUnits);
+            mxSetField(mxOutput, i, aszAnalogNames[3], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dResolution);
+            mxSetField(mxOutput, i, aszAnalogNames[4], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationX);
+            mxSetField(mxOutput, i, aszAnalogNames[5], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationY);
+            mxSetField(mxOutput, i, aszAnalogNames[6], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationZ);
+            mxSetField(mxOutput, i, aszAnalogNames[7], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLocationUser);
+            mxSetField(mxOutput, i, aszAnalogNames[8], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dHighFreqCorner);
+            mxSetField(mxOutput, i, aszAnalogNames[9], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dwHighFreqOrder);
+            mxSetField(mxOutput, i, aszAnalogNames[10], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsAnalogInfo.szHighFilterType);
+            mxSetField(mxOutput, i, aszAnalogNames[11], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dLowFreqCorner);
+            mxSetField(mxOutput, i, aszAnalogNames[12], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsAnalogInfo.dwLowFreqOrder);
+            mxSetField(mxOutput, i, aszAnalogNames[13], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsAnalogInfo.szLowFilterType);
+            mxSetField(mxOutput, i, aszAnalogNames[14], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsAnalogInfo.szProbeInfo);
+            mxSetField(mxOutput, i, aszAnalogNames[15], mxFieldValue);
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogInfo).\n");
+            bEntity = FALSE;
+            nsresult = 0;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n");
+            *ppmxInfo = mxCreateString("");
+        }
+    }
+    if (0 == nsresult)
+        *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/7/2003
+// Purpose: Get segment information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ppmxInfo - double pointer to the mex converted ns_SEGMENTINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fSegmentInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+{
+    const char *aszSegmentNames[] = {"SourceCount","MinSampleCount","MaxSampleCount",
+                                     "SampleRate"};
+    UINT32 i;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_SEGMENTINFO nsSegmentInfo;
+    ns_RESULT nsresult =0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetSegmentInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsSegmentInfo, 
+                                     (UINT32) sizeof(nsSegmentInfo));
+        if (0 == i)
+            mxOutput = mxCreateStructMatrix(ncols, 1, 4, aszSegmentNames);
+
+        if (nsresult == 0)
+        {
+            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwSourceCount);
+            mxSetField(mxOutput, i, aszSegmentNames[0], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwMinSampleCount);
+            mxSetField(mxOutput, i, aszSegmentNames[1], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dwMaxSampleCount);
+            mxSetField(mxOutput, i, aszSegmentNames[2], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsSegmentInfo.dSampleRate);
+            mxSetField(mxOutput, i, aszSegmentNames[3], mxFieldValue);
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetSegmentInfo).\n");
+            bEntity = FALSE;
+            nsresult = 0;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetSegmentInfo!\n");
+            *ppmxInfo = mxCreateString("");
+            break;
+        }
+    }
+    if (0 == nsresult)
+        *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Get segment source information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncolsEntity - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ncolsSource - number of elements in the array of sources (pdSourceID)
+//          pdSourceID - pointer to the array of sources to get info for
+//          ppmxInfo - double pointer to the mex converted ns_SEGMENTSOURCEINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fSegmentSourceInfo(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, 
+                             size_t ncolsSource, double *pdSourceID, mxArray **ppmxInfo)
+{
+    const char *aszSegSourceNames[] = {"MinVal","MaxVal","Resolution","SubSampleShift",
+                                "LocationX","LocationY","LocationZ","LocationUser",
+                                "HighFreqCorner","HighFreqOrder","HighFilterType",
+                                "LowFreqCorner","LowFreqOrder","LowFilterType","ProbeInfo"};
+    UINT32 i;
+    UINT32 j;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_SEGSOURCEINFO nsSegmentSourceInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+    BOOL bSource = TRUE;
+
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        for (j = 0; j < ncolsSource; ++j)
+        {
+            nsresult = ns_GetSegmentSourceInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdSourceID[j],
+                                       &nsSegmentSourceInfo, (UINT32) sizeof(nsSegmentSourceInfo));
+            if ((0 == i) && (0 == j))
+                mxOutput = mxCreateStructMatrix(ncolsSource, ncolsEntity, 15, aszSegSourceNames);
+
+            if (0 == nsresult)
+            {
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dMinVal);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[0], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dMaxVal);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[1], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dResolution);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[2], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dSubSampleShift);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[3], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationX);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[4], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationY);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[5], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationZ);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[6], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLocationUser);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[7], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dHighFreqCorner);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[8], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dwHighFreqOrder);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[9], mxFieldValue);
+
+                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szHighFilterType);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[10], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dLowFreqCorner);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[11], mxFieldValue);
+
+                mxFieldValue = mxCreateScalarDouble(nsSegmentSourceInfo.dwLowFreqOrder);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[12], mxFieldValue);
+
+                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szLowFilterType);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[13], mxFieldValue);
+
+                mxFieldValue = mxCreateString(nsSegmentSourceInfo.szProbeInfo);
+                mxSetField(mxOutput, (i * ncolsSource) + j, aszSegSourceNames[14], mxFieldValue);
+            }
+            else if (-5 == nsresult)
+            {
+                if (TRUE == bEntity)
+                    mexPrintf("Some entities do not exist (ns_GetSegmentSourceInfo).\n");
+                bEntity = FALSE;
+            }
+            else if (-6 == nsresult)
+            {
+                if (TRUE == bSource)
+                    mexPrintf("Some sources do not exist (ns_GetSegmentSourceInfo).\n");
+                bSource = FALSE;
+                break;
+            }
+            else
+            {
+                mexPrintf("There was an error running ns_GetSegmentSourceInfo!\n");
+                *ppmxInfo = mxCreateString("");
+                return(nsresult);
+            }
+        }
+    }
+
+    *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/7/2003
+// Purpose: Get neural information and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ppmxInfo - double pointer to the mex converted ns_NEURALINFO structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fNeuralInfo(UINT32 hFile, size_t ncols, double *pdEntityID, mxArray **ppmxInfo)
+{
+    const char *aszNeuralNames[] = {"SourceEntityID","SourceUnitID","ProbeInfo"};
+    UINT32 i;
+    mxArray *mxOutput = 0;
+    mxArray *mxFieldValue = 0;
+    ns_NEURALINFO nsNeuralInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetNeuralInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsNeuralInfo, 
+                                    (UINT32) sizeof(nsNeuralInfo));
+        if (0 == i)
+            mxOutput = mxCreateStructMatrix(ncols, 1, 3, aszNeuralNames);
+
+        if (nsresult == 0)
+        {
+            mxFieldValue = mxCreateScalarDouble(nsNeuralInfo.dwSourceEntityID);
+            mxSetField(mxOutput, i, aszNeuralNames[0], mxFieldValue);
+
+            mxFieldValue = mxCreateScalarDouble(nsNeuralInfo.dwSourceUnitID);
+            mxSetField(mxOutput, i, aszNeuralNames[1], mxFieldValue);
+
+            mxFieldValue = mxCreateString(nsNeuralInfo.szProbeInfo);
+            mxSetField(mxOutput, i, aszNeuralNames[2], mxFieldValue);
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetNeuralInfo).\n");
+            bEntity = FALSE;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetNeuralInfo!\n");
+            *ppmxInfo = mxCreateString("");
+        }
+    }
+
+    if (0 == nsresult)
+        *ppmxInfo = mxOutput;
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Time stamps only
+//
+//      Event and segment reads that only need the time stamps get them with
+//      ns_GetTimeByIndex instead of loading the data of every item. The
+//      entities are read by worker threads.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// A read of the time stamps of several entities, shared by all worker threads
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    size_t ncolsIndex;
+    double *pdIndex;
+    double *pdTimeStamp;      // one column of ncolsIndex time stamps per entity
+    ns_RESULT *pnResult;      // result of every entity
+} TIMESTAMPREAD;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the time stamps of one entity. Runs on a worker thread.
+//          The time stamps after an index that does not exist are left 0.
+// Inputs:  pvRead - the TIMESTAMPREAD
+//          nItem - number of the entity
+void fTimeStampsTask(void *pvRead, size_t nItem)
+{
+    TIMESTAMPREAD *pRead = (TIMESTAMPREAD *) pvRead;
+    BOOL bSerialize = (1 != g_nThreadSafe);
+    double dTimeStamp;
+    ns_RESULT nsresult = ns_OK;
+    size_t j;
+
+    if (bSerialize)
+        th_MutexLock(&g_nsLibraryLock);
+
+    for (j = 0; (0 == nsresult) && (j < pRead->ncolsIndex); ++j)
+    {
+        nsresult = ns_GetTimeByIndex(g_nsDllHandle, pRead->hFile, (UINT32) pRead->pdEntityID[nItem], 
+                                     (UINT32) pRead->pdIndex[j], &dTimeStamp);
+        if (0 == nsresult)
+            pRead->pdTimeStamp[nItem * pRead->ncolsIndex + j] = dTimeStamp;
+    }
+
+    if (bSerialize)
+        th_MutexUnlock(&g_nsLibraryLock);
+
+    pRead->pnResult[nItem] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get only the time stamps of event or segment entities and convert them into
+//          Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncolsEntity - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get time stamps for
+//          ncolsIndex - number of elements in the array of indeces (pdIndex)
+//          pdIndex - pointer to the array of indeces to get time stamps for
+//          pmxOptions - options structure passed from Matlab (may be empty)
+//                       Threads - number of worker threads reading entities in parallel
+//          szFunction - name of the Neuroshare function for messages
+//          ppmxTimeStamp - double pointer to the mex converted time stamps; one column per
+//                          entity
+// Outputs: ns_RESULT - ns_LIBERROR if the time stamps could not be read (ppmxTimeStamp is
+//          an empty string then), otherwise ns_BADENTITY or ns_BADINDEX if some entities or
+//          indeces do not exist, or ns_OK
+ns_RESULT fTimeStampsOnly(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex,
+                          double *pdIndex, const mxArray *pmxOptions, const char *szFunction, 
+                          mxArray **ppmxTimeStamp)
+{
+    TIMESTAMPREAD read;
+    ns_RESULT nsresult = ns_OK;
+    int nThreads = fGetThreadOption(pmxOptions);
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    size_t i;
+
+    read.pnResult = calloc(ncolsEntity + 1, sizeof(ns_RESULT));
+    if (!read.pnResult)
+    {
+        mexPrintf("Not enough memory to read the time stamps (%s).\n", szFunction);
+        *ppmxTimeStamp = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+    read.hFile = hFile;
+    read.pdEntityID = pdEntityID;
+    read.ncolsIndex = ncolsIndex;
+    read.pdIndex = pdIndex;
+    read.pdTimeStamp = mxGetPr(*ppmxTimeStamp);
+
+    if (1 < nThreads)
+        fLibraryIsThreadSafe();
+    th_ParallelFor(ncolsEntity, nThreads, fTimeStampsTask, &read);
+
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        if (-5 == read.pnResult[i])
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (%s).\n", szFunction);
+            bEntity = FALSE;
+            nsresult = read.pnResult[i];
+        }
+        else if (-7 == read.pnResult[i])
+        {
+            if (TRUE == bIndex)
+                mexPrintf("Some indeces do not exist (%s).\n", szFunction);
+            bIndex = FALSE;
+            nsresult = read.pnResult[i];
+        }
+        else if (0 != read.pnResult[i])
+        {
+            mexPrintf("There was an error running ns_GetTimeByIndex!\n(Required for %s)\n", szFunction);
+            mxDestroyArray(*ppmxTimeStamp);
+            *ppmxTimeStamp = mxCreateString("");
+            nsresult = ns_LIBERROR;
+            break;
+        }
+    }
+
+    free(read.pnResult);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Count the comma separated fields of a CSV description or event
+// Inputs:  szCSV - the text
+// Outputs: UINT32 - number of fields (0 for an empty text)
+UINT32 fCountCSVFields(const char *szCSV)
+{
+    UINT32 dwFields = 1;
+
+    if (0 == *szCSV)
+        return(0);
+
+    for (; *szCSV; ++szCSV)
+    {
+        if (',' == *szCSV)
+            ++dwFields;
+    }
+    return(dwFields);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the number of fields of a CSV event entity
+//          The fields are given by szCSVDesc. If the library leaves it empty, they are
+//          counted in the first requested event.
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the CSV event entity
+//          pEventInfo - the event information of the entity
+//          dwIndex - the first requested event
+// Outputs: UINT32 - number of fields
+UINT32 fCSVFields(UINT32 hFile, UINT32 dwEntityID, ns_EVENTINFO *pEventInfo, UINT32 dwIndex)
+{
+    UINT32 dwFields;
+    UINT32 dwDataSize;
+    double dTimeStamp;
+    char *szData;
+
+    dwFields = fCountCSVFields(pEventInfo->szCSVDesc);
+    if (0 < dwFields)
+        return(dwFields);
+
+    szData = calloc(pEventInfo->dwMaxDataLength + 1, 1);
+    if (szData && (0 == ns_GetEventData(g_nsDllHandle, hFile, dwEntityID, dwIndex, &dTimeStamp, 
+                                        szData, pEventInfo->dwMaxDataLength, &dwDataSize)))
+        dwFields = fCountCSVFields(szData);
+    free(szData);
+    return(dwFields);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Create the names of the fields of CSV event entities from their szCSVDesc
+//          Every field is named by the first entity that describes it.
+// Inputs:  pEventInfo - the event information of the entities
+//          nEntities - number of entities
+//          dwFields - number of fields
+// Outputs: mxArray * - cell array of the names (an empty name for undescribed fields)
+mxArray *fCSVFieldNames(ns_EVENTINFO *pEventInfo, size_t nEntities, UINT32 dwFields)
+{
+    char szName[sizeof(pEventInfo->szCSVDesc)];
+    const char *pcField;
+    const char *pcName;
+    mxArray *pmxNames;
+    size_t nLength;
+    size_t i;
+    UINT32 f;
+
+    pmxNames = mxCreateCellMatrix(1, dwFields);
+    for (i = 0; i < nEntities; ++i)
+    {
+        pcField = pEventInfo[i].szCSVDesc;
+        for (f = 0; (f < dwFields) && *pcField; ++f)
+        {
+            nLength = strcspn(pcField, ",");
+            if (!mxGetCell(pmxNames, f))
+            {
+                // Surrounding blanks are not part of the name
+                pcName = pcField;
+                while ((pcName < pcField + nLength) && (' ' == *pcName))
+                    ++pcName;
+                nLength -= pcName - pcField;
+                while ((0 < nLength) && (' ' == pcName[nLength - 1]))
+                    --nLength;
+                memcpy(szName, pcName, nLength);
+                szName[nLength] = 0;
+                mxSetCell(pmxNames, f, mxCreateString(szName));
+            }
+            pcField += strcspn(pcField, ",");
+            if (',' == *pcField)
+                ++pcField;
+        }
+    }
+
+    for (f = 0; f < dwFields; ++f)
+    {
+        if (!mxGetCell(pmxNames, f))
+            mxSetCell(pmxNames, f, mxCreateString(""));
+    }
+    return(pmxNames);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert the comma separated values of a CSV event into numbers
+//          The text is parsed in place. Fields that are missing or not a number become NaN,
+//          fields beyond dwFields are ignored.
+// Inputs:  szData - the text of the event
+//          pdField - receives the value of the first field
+//          dwFields - number of fields to convert
+//          nStride - distance between the values of two fields in pdField
+void fParseCSVEvent(const char *szData, double *pdField, UINT32 dwFields, size_t nStride)
+{
+    const char *pcField = szData;
+    char *pcEnd;
+    double dValue;
+    double dNaN = mxGetNaN();
+    UINT32 f;
+
+    for (f = 0; f < dwFields; ++f)
+    {
+        pdField[f * nStride] = dNaN;
+        if (!pcField)
+            continue;
+
+        dValue = strtod(pcField, &pcEnd);
+        while ((' ' == *pcEnd) || ('\t' == *pcEnd) || ('\r' == *pcEnd) || ('\n' == *pcEnd))
+            ++pcEnd;
+        if ((pcEnd != pcField) && ((',' == *pcEnd) || (0 == *pcEnd)))
+            pdField[f * nStride] = dValue;
+
+        pcField = strchr(pcField, ',');
+        if (pcField)
+            ++pcField;
+    }
+}
+
+// Strings of text events that are encoded as codes into a dictionary
+typedef struct
+{
+    char *pcText;             // the strings, each with its terminating 0
+    size_t cbText;            // bytes of pcText in use
+    size_t cbTextCapacity;    // bytes allocated for pcText
+    size_t *pnString;         // offset of every string in pcText; its code is its position + 1
+    UINT32 dwStrings;
+    UINT32 dwCapacity;        // number of offsets allocated for pnString
+    UINT32 *pdwSlots;         // hash table of the codes (0 for an empty slot)
+    UINT32 dwSlots;           // size of the hash table, a power of 2 at least twice dwStrings
+} DICTIONARY;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Hash a string (FNV-1a)
+// Inputs:  szText - the string
+// Outputs: UINT32 - the hash value
+UINT32 fHashString(const char *szText)
+{
+    UINT32 dwHash = 2166136261u;
+
+    for (; *szText; ++szText)
+        dwHash = (dwHash ^ (unsigned char) *szText) * 16777619u;
+    return(dwHash);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the code of a string, adding the string to the dictionary if it is new
+// Inputs:  pDictionary - the dictionary
+//          szText - the string
+// Outputs: UINT32 - the code of the string (1 for the first string), 0 if there is not
+//          enough memory
+UINT32 fDictionaryCode(DICTIONARY *pDictionary, const char *szText)
+{
+    UINT32 *pdwSlots;
+    UINT32 dwSlots;
+    UINT32 dwSlot;
+    UINT32 i;
+    size_t cbString = strlen(szText) + 1;
+    size_t cbCapacity;
+    void *pvNew;
+
+    // Look the string up
+    for (dwSlot = fHashString(szText) & (pDictionary->dwSlots - 1); 
+         pDictionary->dwSlots && pDictionary->pdwSlots[dwSlot]; 
+         dwSlot = (dwSlot + 1) & (pDictionary->dwSlots - 1))
+    {
+        if (0 == strcmp(szText, pDictionary->pcText + 
+                                pDictionary->pnString[pDictionary->pdwSlots[dwSlot] - 1]))
+            return(pDictionary->pdwSlots[dwSlot]);
+    }
+
+    // The hash table is kept at most half full
+    if (2 * ((size_t) pDictionary->dwStrings + 1) > pDictionary->dwSlots)
+    {
+        dwSlots = pDictionary->dwSlots ? 2 * pDictionary->dwSlots : 64;
+        pdwSlots = calloc(dwSlots, sizeof(UINT32));
+        if (!pdwSlots)
+            return(0);
+        for (i = 0; i < pDictionary->dwStrings; ++i)
+        {
+            for (dwSlot = fHashString(pDictionary->pcText + pDictionary->pnString[i]) & (dwSlots - 1);
+                 pdwSlots[dwSlot]; dwSlot = (dwSlot + 1) & (dwSlots - 1))
+                ;
+            pdwSlots[dwSlot] = i + 1;
+        }
+        free(pDictionary->pdwSlots);
+        pDictionary->pdwSlots = pdwSlots;
+        pDictionary->dwSlots = dwSlots;
+
+        for (dwSlot = fHashString(szText) & (dwSlots - 1); pdwSlots[dwSlot]; 
+             dwSlot = (dwSlot + 1) & (dwSlots - 1))
+            ;
+    }
+
+    // Add the string
+    if (pDictionary->dwStrings == pDictionary->dwCapacity)
+    {
+        pvNew = realloc(pDictionary->pnString, 2 * ((size_t) pDictionary->dwCapacity + 16) * sizeof(size_t));
+        if (!pvNew)
+            return(0);
+        pDictionary->pnString = pvNew;
+        pDictionary->dwCapacity = 2 * (pDictionary->dwCapacity + 16);
+    }
+    if (pDictionary->cbText + cbString > pDictionary->cbTextCapacity)
+    {
+        cbCapacity = MAX(2 * pDictionary->cbTextCapacity, pDictionary->cbText + cbString + 1024);
+        pvNew = realloc(pDictionary->pcText, cbCapacity);
+        if (!pvNew)
+            return(0);
+        pDictionary->pcText = pvNew;
+        pDictionary->cbTextCapacity = cbCapacity;
+    }
+
+    memcpy(pDictionary->pcText + pDictionary->cbText, szText, cbString);
+    pDictionary->pnString[pDictionary->dwStrings] = pDictionary->cbText;
+    pDictionary->cbText += cbString;
+    pDictionary->pdwSlots[dwSlot] = ++pDictionary->dwStrings;
+    return(pDictionary->dwStrings);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Create the strings of a dictionary in Matlab format
+// Inputs:  pDictionary - the dictionary
+// Outputs: mxArray * - cell array with one string per code
+mxArray *fDictionaryStrings(DICTIONARY *pDictionary)
+{
+    mxArray *pmxStrings;
+    UINT32 i;
+
+    pmxStrings = mxCreateCellMatrix(pDictionary->dwStrings, 1);
+    for (i = 0; i < pDictionary->dwStrings; ++i)
+        mxSetCell(pmxStrings, i, mxCreateString(pDictionary->pcText + pDictionary->pnString[i]));
+    return(pmxStrings);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free the memory of a dictionary
+// Inputs:  pDictionary - the dictionary
+void fFreeDictionary(DICTIONARY *pDictionary)
+{
+    free(pDictionary->pcText);
+    free(pDictionary->pnString);
+    free(pDictionary->pdwSlots);
+    memset(pDictionary, 0, sizeof(DICTIONARY));
+}
+
+// Author & Date: Almut Branner, 2/21/2003
+// Purpose: Get event data and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncolsEntity - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          ncolsIndex - number of elements in the array of indeces (pdIndex)
+//          pdIndex - pointer to the array of indeces to get info for
+//          pmxOptions - options structure passed from Matlab (may be empty); Dictionary
+//                       encodes text events as codes into a dictionary of their strings,
+//                       TimeStampsOnly reads only the time stamps (see fTimeStampsOnly)
+//                       and leaves all other outputs empty
+//          ppmxTimeStamp - double pointer to the mex converted timestamp
+//          ppmxData - double pointer to the mex converted data structure; the values of
+//                     CSV events are an index by field by entity array, dictionary encoded
+//                     text events are uint32 codes (0 for events that were not read)
+//          ppmxDataSize - how big is the data structure that was returned
+//          ppmxFieldNames - double pointer to the names of the fields of CSV events (an
+//                           empty cell array for other events)
+//          ppmxDictionary - double pointer to the strings of the codes of text events (an
+//                           empty cell array if they are not dictionary encoded)
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxTimeStamp is filled.
+//          ppmxData is filled.
+//          ppmxDataSize is filled.
+//          ppmxFieldNames is filled.
+//          ppmxDictionary is filled.
+ns_RESULT fEventData(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex, 
+                     double *pdIndex, const mxArray *pmxOptions, mxArray **ppmxTimeStamp, 
+                     mxArray **ppmxData, mxArray **ppmxDataSize, mxArray **ppmxFieldNames, 
+                     mxArray **ppmxDictionary)
+{
+    UINT32 i;
+    UINT32 j;
+    UINT32 dwTempType;
+    double dTimeStamp;
+    void *pvData;
+    double *pdOutputTimeStamp = 0;
+    double *pdOutputData = 0;
+    double *pdOutputDataSize = 0;
+    UINT32 dwDataSize;
+    UINT32 dwMaxDataLength = 0;
+    UINT32 dwFields = 0;
+    UINT32 *pdwOutputCode = 0;
+    mwSize adwDims[3];
+    DICTIONARY dictionary;
+    ns_EVENTINFO *pEventInfo;
+    ns_RESULT nsresult;
+    BOOL bIndex = TRUE;
+    BOOL bDictionary = (0 != fGetOption(pmxOptions, "Dictionary", 0));
+
+    // The data of the events is not loaded at all if only the time stamps are needed
+    if (0 != fGetOption(pmxOptions, "TimeStampsOnly", 0))
+    {
+        nsresult = fTimeStampsOnly(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, pmxOptions, 
+                                   "ns_GetEventData", ppmxTimeStamp);
+        if (ns_LIBERROR == nsresult)
+        {
+            *ppmxDataSize = mxCreateString("");
+            *ppmxData = mxCreateString("");
+            *ppmxFieldNames = mxCreateString("");
+            *ppmxDictionary = mxCreateString("");
+            return(ns_LIBERROR);
+        }
+        *ppmxDataSize = mxCreateDoubleMatrix(0, 0, mxREAL);
+        *ppmxData = mxCreateDoubleMatrix(0, 0, mxREAL);
+        *ppmxFieldNames = mxCreateCellMatrix(0, 0);
+        *ppmxDictionary = mxCreateCellMatrix(0, 0);
+        return(nsresult);
+    }
+
+    memset(&dictionary, 0, sizeof(dictionary));
+
+    // The information of every entity is only loaded once
+    pEventInfo = calloc(ncolsEntity + 1, sizeof(ns_EVENTINFO));
+    if (!pEventInfo)
+    {
+        mexPrintf("Not enough memory to load the event information (ns_GetEventData).\n");
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxDataSize = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxFieldNames = mxCreateString("");
+        *ppmxDictionary = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    
+    // Compare the types of all requested entities. Error when not the same.
+    // Also checks whether loading the information works for all entities.
+    nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[0], &pEventInfo[0], sizeof(ns_EVENTINFO));
+    if (0 == nsresult)
+    {
+        dwTempType = pEventInfo[0].dwEventType;
+        dwMaxDataLength = pEventInfo[0].dwMaxDataLength;
+        // Allocate mxArray for the data depending on the type
+        if ((ns_EVENT_BYTE == dwTempType) || (ns_EVENT_WORD == dwTempType) ||
+            (ns_EVENT_DWORD == dwTempType))
+        {
+            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            *ppmxData = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
+            pdOutputData = mxGetPr(*ppmxData);
+            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+        }
+        else if ((ns_EVENT_TEXT == dwTempType) && bDictionary)
+        {
+            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            *ppmxData = mxCreateNumericMatrix(ncolsIndex, ncolsEntity, mxUINT32_CLASS, mxREAL);
+            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
+            pdwOutputCode = (UINT32 *) mxGetData(*ppmxData);
+            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+        }
+        else if (ns_EVENT_TEXT == dwTempType)
+        {
+            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            *ppmxData = mxCreateCellMatrix(ncolsIndex, ncolsEntity);
+            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
+            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+        }
+        else if (ns_EVENT_CSV == dwTempType)
+        {
+            // The data is created once the number of fields of all entities is known
+            *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            *ppmxDataSize = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+            pdOutputTimeStamp = mxGetPr(*ppmxTimeStamp);
+            pdOutputDataSize = mxGetPr(*ppmxDataSize);
+        }
+    }
+    else
+    {
+        mexPrintf("All requested Entities have to be of the same event type\nor there was an error running ns_GetEventInfo!\n(Was required for ns_GetEventData)\n");
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxDataSize = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxFieldNames = mxCreateString("");
+        *ppmxDictionary = mxCreateString("");
+        free(pEventInfo);
+        return(ns_LIBERROR);
+    }
+
+    for (i = 1; i < ncolsEntity; ++i)
+    {
+        nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &pEventInfo[i], sizeof(ns_EVENTINFO));
+        
+        if ((0 == nsresult) && (dwTempType == pEventInfo[i].dwEventType))
+        {
+            dwTempType = pEventInfo[i].dwEventType;
+            if (pEventInfo[i].dwMaxDataLength > dwMaxDataLength)
+                dwMaxDataLength = pEventInfo[i].dwMaxDataLength;
+        }
+        else
+        {
+            mexPrintf("All requested Entities have to be of the same event type\nor there was an error running ns_GetEventInfo!\n(Was required for ns_GetEventData)\n");
+            *ppmxTimeStamp = mxCreateString("");
+            *ppmxDataSize = mxCreateString("");
+            *ppmxData = mxCreateString("");
+            *ppmxFieldNames = mxCreateString("");
+            *ppmxDictionary = mxCreateString("");
+            free(pEventInfo);
+            return(ns_LIBERROR);
+        }
+    }
+
+    // CSV events are converted into one column per field
+    if (ns_EVENT_CSV == dwTempType)
+    {
+        for (i = 0; i < ncolsEntity; ++i)
+        {
+            dwFields = MAX(dwFields, fCSVFields(hFile, (UINT32) pdEntityID[i], &pEventInfo[i], 
+                                                (0 < ncolsIndex) ? (UINT32) pdIndex[0] : 0));
+        }
+        adwDims[0] = ncolsIndex;
+        adwDims[1] = dwFields;
+        adwDims[2] = ncolsEntity;
+        *ppmxData = mxCreateNumericArray(3, adwDims, mxDOUBLE_CLASS, mxREAL);
+        pdOutputData = mxGetPr(*ppmxData);
+        *ppmxFieldNames = fCSVFieldNames(pEventInfo, ncolsEntity, dwFields);
+    }
+    else
+        *ppmxFieldNames = mxCreateCellMatrix(0, 0);
+
+    // One buffer large enough for every entity is used for all events. The byte after
+    // the longest event ends text that the library did not end.
+    pvData = calloc(dwMaxDataLength + 1, 1);
+    if (!pvData)
+    {
+        mexPrintf("Not enough memory to load the event data (ns_GetEventData).\n");
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxDataSize = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxFieldNames = mxCreateString("");
+        *ppmxDictionary = mxCreateString("");
+        free(pEventInfo);
+        return(ns_LIBERROR);
+    }
+
+    // Actually load the data
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        for (j = 0; j < ncolsIndex; ++j)
+        {
+            nsresult = ns_GetEventData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdIndex[j], 
+                                       &dTimeStamp, pvData, pEventInfo[i].dwMaxDataLength, 
+                                       &dwDataSize);
+            if (0 == nsresult)
+            {
+                switch (pEventInfo[i].dwEventType)
+                {
+                case 0: // ns_EVENT_TEXT
+                    ((char *) pvData)[pEventInfo[i].dwMaxDataLength] = 0;
+                    if (pdwOutputCode)
+                        pdwOutputCode[i * ncolsIndex + j] = fDictionaryCode(&dictionary, (char *) pvData);
+                    else
+                        mxSetCell(*ppmxData, i * ncolsIndex + j, mxCreateString((char*)pvData));
+                    break;
+                case 1: // ns_EVENT_CSV
+                    ((char *) pvData)[pEventInfo[i].dwMaxDataLength] = 0;
+                    fParseCSVEvent((char *) pvData, pdOutputData + i * dwFields * ncolsIndex + j, 
+                                   dwFields, ncolsIndex);
+                    break;
+                case 2: // ns_EVENT_BYTE
+                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT8*)pvData);
+                    break;
+                case 3: // ns_EVENT_WORD
+                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT16*)pvData);
+                    break;
+                case 4: // ns_EVENT_DWORD
+                    *(pdOutputData + (i * ncolsIndex) + j) = *((UINT32*)pvData);
+                    break;
+                }
+                *(pdOutputTimeStamp + (i * ncolsIndex) + j) = dTimeStamp;
+                *(pdOutputDataSize + (i * ncolsIndex) + j) = dwDataSize;
+
+                if (pdwOutputCode && (0 == pdwOutputCode[i * ncolsIndex + j]))
+                {
+                    mexPrintf("Not enough memory for the dictionary (ns_GetEventData).\n");
+                    *ppmxTimeStamp = mxCreateString("");
+                    *ppmxDataSize = mxCreateString("");
+                    *ppmxData = mxCreateString("");
+                    *ppmxFieldNames = mxCreateString("");
+                    *ppmxDictionary = mxCreateString("");
+                    free(pvData);
+                    free(pEventInfo);
+                    fFreeDictionary(&dictionary);
+                    return(ns_LIBERROR);
+                }
+            }
+            else if (-7 == nsresult)
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetEventData).\n");
+                bIndex = FALSE;
+                break;
+            }
+            else
+            {
+                mexPrintf("There was an error running ns_GetEventData!\n");
+                *ppmxTimeStamp = mxCreateString("");
+                *ppmxDataSize = mxCreateString("");
+                *ppmxData = mxCreateString("");
+                *ppmxFieldNames = mxCreateString("");
+                *ppmxDictionary = mxCreateString("");
+                free(pvData);
+                free(pEventInfo);
+                fFreeDictionary(&dictionary);
+                return(nsresult);
+            }
+        }
+    }
+
+    *ppmxDictionary = pdwOutputCode ? fDictionaryStrings(&dictionary) : mxCreateCellMatrix(0, 0);
+
+    free(pvData);
+    free(pEventInfo);
+    fFreeDictionary(&dictionary);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Event time stamps
+//
+//      The time stamps of an event entity are kept once they were looked
+//      up, so the events of a time window are found by a binary search that
+//      only asks the library for time stamps it was not asked for before.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// The time stamps of an event entity looked up so far
+typedef struct
+{
+    UINT32 hFile;
+    UINT32 dwEntityID;
+    UINT32 dwItemCount;       // number of events
+    double *pdTime;           // time stamp of every event (NaN if not looked up yet)
+} EVENTTIMES;
+
+EVENTTIMES **g_ppEventTimes = 0;
+size_t g_nEventTimes = 0;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Look up the kept time stamps of an event entity, creating them if there are none
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the event entity
+//          dwItemCount - number of events of the entity
+// Outputs: EVENTTIMES * - the time stamps, 0 if there is not enough memory
+EVENTTIMES *fFindEventTimes(UINT32 hFile, UINT32 dwEntityID, UINT32 dwItemCount)
+{
+    EVENTTIMES *pTimes;
+    EVENTTIMES **ppEventTimes;
+    UINT32 i;
+
+    for (i = 0; i < g_nEventTimes; ++i)
+    {
+        pTimes = g_ppEventTimes[i];
+        if ((pTimes->hFile == hFile) && (pTimes->dwEntityID == dwEntityID) && 
+            (pTimes->dwItemCount == dwItemCount))
+            return(pTimes);
+    }
+
+    pTimes = calloc(1, sizeof(EVENTTIMES));
+    ppEventTimes = realloc(g_ppEventTimes, (g_nEventTimes + 1) * sizeof(EVENTTIMES *));
+    if (ppEventTimes)
+        g_ppEventTimes = ppEventTimes;
+    if (pTimes)
+        pTimes->pdTime = malloc(((size_t) dwItemCount + 1) * sizeof(double));
+    if (!pTimes || !ppEventTimes || !pTimes->pdTime)
+    {
+        if (pTimes)
+            free(pTimes->pdTime);
+        free(pTimes);
+        return(0);
+    }
+
+    pTimes->hFile = hFile;
+    pTimes->dwEntityID = dwEntityID;
+    pTimes->dwItemCount = dwItemCount;
+    for (i = 0; i < dwItemCount; ++i)
+        pTimes->pdTime[i] = mxGetNaN();
+    g_ppEventTimes[g_nEventTimes++] = pTimes;
+    return(pTimes);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the first event after a time (or at or after it) by binary search
+//          Events are ordered by their time stamps.
+// Inputs:  pTimes - the time stamps of the entity
+//          dTime - the time
+//          bAfter - TRUE to skip events at dTime
+//          pdwIndex - receives the index of the event (dwItemCount if there is none)
+// Outputs: ns_RESULT - what error was returned by ns_GetTimeByIndex (should be 0)
+ns_RESULT fEventIndexByTime(EVENTTIMES *pTimes, double dTime, BOOL bAfter, UINT32 *pdwIndex)
+{
+    UINT32 dwLow = 0;
+    UINT32 dwHigh = pTimes->dwItemCount;
+    UINT32 dwMid;
+    ns_RESULT nsresult;
+
+    while (dwLow < dwHigh)
+    {
+        dwMid = dwLow + (dwHigh - dwLow) / 2;
+        if (mxIsNaN(pTimes->pdTime[dwMid]))
+        {
+            nsresult = ns_GetTimeByIndex(g_nsDllHandle, pTimes->hFile, pTimes->dwEntityID, dwMid, 
+                                         &pTimes->pdTime[dwMid]);
+            if (0 != nsresult)
+            {
+                pTimes->pdTime[dwMid] = mxGetNaN();
+                return(nsresult);
+            }
+        }
+
+        if (bAfter ? (pTimes->pdTime[dwMid] <= dTime) : (pTimes->pdTime[dwMid] < dTime))
+            dwLow = dwMid + 1;
+        else
+            dwHigh = dwMid;
+    }
+
+    *pdwIndex = dwLow;
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free the kept time stamps of a file, e.g. when it is closed, or of all files
+// Inputs:  hFile - handle/ID number of the file
+//          bAll - TRUE to free the time stamps of all files
+void fReleaseEventTimes(UINT32 hFile, BOOL bAll)
+{
+    size_t n;
+
+    for (n = 0; n < g_nEventTimes; )
+    {
+        if (bAll || (g_ppEventTimes[n]->hFile == hFile))
+        {
+            free(g_ppEventTimes[n]->pdTime);
+            free(g_ppEventTimes[n]);
+            g_ppEventTimes[n] = g_ppEventTimes[--g_nEventTimes];
+        }
+        else
+            ++n;
+    }
+
+    if (0 == g_nEventTimes)
+    {
+        free(g_ppEventTimes);
+        g_ppEventTimes = 0;
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the event data of several entities within a time window and convert it into
+//          Matlab format. Only the events in the window are read.
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for (all of one event type)
+//          dStartTime - start of the time window
+//          dEndTime - end of the time window
+//          pmxOptions - options structure passed from Matlab (may be empty), see fEventData
+//          ppmxTimeStamp - double pointer to the mex converted time stamps; one column per
+//                          entity, padded with NaN below the events of entities with fewer
+//                          events in the window
+//          ppmxData - double pointer to the mex converted data (padded with NaN, or with
+//                     empty cells for text events, or with code 0 for dictionary encoded
+//                     text events); the values of CSV events are an index by field by
+//                     entity array
+//          ppmxDataSize - double pointer to the mex converted size of every event (padded with 0)
+//          ppmxStartIndex - double pointer to the mex converted index of the first event of
+//                           every entity in the window (NaN if there is none)
+//          ppmxIndexCount - double pointer to the mex converted number of events of every
+//                           entity in the window
+//          ppmxFieldNames - double pointer to the names of the fields of CSV events (an
+//                           empty cell array for other events)
+//          ppmxDictionary - double pointer to the strings of the codes of text events (an
+//                           empty cell array if they are not dictionary encoded)
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxTimeStamp, ppmxData, ppmxDataSize, ppmxStartIndex, ppmxIndexCount,
+//          ppmxFieldNames and ppmxDictionary are filled.
+ns_RESULT fEventDataByTime(UINT32 hFile, size_t ncols, double *pdEntityID, double dStartTime,
+                           double dEndTime, const mxArray *pmxOptions, mxArray **ppmxTimeStamp, 
+                           mxArray **ppmxData, mxArray **ppmxDataSize, 
+                           mxArray **ppmxStartIndex, mxArray **ppmxIndexCount, 
+                           mxArray **ppmxFieldNames, mxArray **ppmxDictionary)
+{
+    ns_EVENTINFO *pEventInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    EVENTTIMES **ppTimes;
+    UINT32 *pdwIndex;
+    UINT32 *pdwIndexCount;
+    UINT32 dwEndIndex;
+    UINT32 dwType = 0;
+    UINT32 dwFields = 1;
+    UINT32 k;
+    UINT32 f;
+    mwSize adwDims[3];
+    size_t nRows = 0;
+    size_t nFields;
+    size_t i;
+    double *pdIndex = 0;
+    double *pdTimeStamp;
+    double *pdTime;
+    double *pdData = 0;
+    double *pdDataSize;
+    double *pdStartIndex;
+    double *pdIndexCount;
+    UINT32 *pdwCode = 0;
+    UINT32 *pdwEntityCode;
+    UINT32 *pdwCodeMap;
+    char *szString;
+    DICTIONARY dictionary;
+    mxArray *pmxTimeStamp;
+    mxArray *pmxData;
+    mxArray *pmxDataSize;
+    mxArray *pmxFieldNames;
+    mxArray *pmxDictionary;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bNumeric;
+    BOOL bDictionary = (0 != fGetOption(pmxOptions, "Dictionary", 0));
+    BOOL bTimeStampsOnly = (0 != fGetOption(pmxOptions, "TimeStampsOnly", 0));
+
+    *ppmxTimeStamp = 0;
+    *ppmxData = 0;
+    *ppmxDataSize = 0;
+    memset(&dictionary, 0, sizeof(dictionary));
+    pEventInfo = calloc(ncols + 1, sizeof(ns_EVENTINFO));
+    ppTimes = calloc(ncols + 1, sizeof(EVENTTIMES *));
+    pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+
+    // Find the events in the window; all entities must be of the same event type
+    for (i = 0; pEventInfo && ppTimes && pdwIndex && pdwIndexCount && (i < ncols); ++i)
+    {
+        nsresult = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &pEventInfo[i], 
+                                   sizeof(ns_EVENTINFO));
+        if ((0 != nsresult) || ((0 < i) && (dwType != pEventInfo[i].dwEventType) && !bTimeStampsOnly))
+        {
+            mexPrintf("All requested Entities have to be of the same event type\nor there was an error running ns_GetEventInfo!\n(Was required for ns_GetEventDataByTime)\n");
+            nsresult = ns_LIBERROR;
+            break;
+        }
+        dwType = pEventInfo[i].dwEventType;
+
+        nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo, 
+                                    (UINT32) sizeof(nsEntityInfo));
+        if (0 == nsresult)
+        {
+            ppTimes[i] = fFindEventTimes(hFile, (UINT32) pdEntityID[i], nsEntityInfo.dwItemCount);
+            nsresult = ppTimes[i] ? fEventIndexByTime(ppTimes[i], dStartTime, FALSE, &pdwIndex[i]) : ns_LIBERROR;
+            if (0 == nsresult)
+                nsresult = fEventIndexByTime(ppTimes[i], dEndTime, TRUE, &dwEndIndex);
+        }
+        if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetTimeByIndex!\n(Required for ns_GetEventDataByTime)\n");
+            break;
+        }
+
+        if (dwEndIndex > pdwIndex[i])
+            pdwIndexCount[i] = dwEndIndex - pdwIndex[i];
+        nRows = MAX(nRows, pdwIndexCount[i]);
+    }
+    if (!pEventInfo || !ppTimes || !pdwIndex || !pdwIndexCount)
+    {
+        mexPrintf("Not enough memory to find the events (ns_GetEventDataByTime).\n");
+        nsresult = ns_LIBERROR;
+    }
+
+    // CSV events have one column per field, the same fields as ns_GetEventData finds
+    if ((0 == nsresult) && (ns_EVENT_CSV == dwType) && !bTimeStampsOnly)
+    {
+        dwFields = 0;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (0 < pdwIndexCount[i])
+                dwFields = MAX(dwFields, fCSVFields(hFile, (UINT32) pdEntityID[i], &pEventInfo[i], pdwIndex[i]));
+        }
+    }
+
+    // The output is padded below the events of entities with fewer events
+    bDictionary = bDictionary && (ns_EVENT_TEXT == dwType) && !bTimeStampsOnly;
+    bNumeric = (ns_EVENT_TEXT != dwType) && !bTimeStampsOnly;
+    pdIndex = calloc(nRows + 1, sizeof(double));
+    if ((0 == nsresult) && !pdIndex)
+    {
+        mexPrintf("Not enough memory to find the events (ns_GetEventDataByTime).\n");
+        nsresult = ns_LIBERROR;
+    }
+    if (0 == nsresult)
+    {
+        adwDims[0] = nRows;
+        adwDims[1] = dwFields;
+        adwDims[2] = ncols;
+        *ppmxTimeStamp = mxCreateDoubleMatrix(nRows, ncols, mxREAL);
+        if (bTimeStampsOnly)
+            *ppmxData = mxCreateDoubleMatrix(0, 0, mxREAL);
+        else if (ns_EVENT_CSV == dwType)
+            *ppmxData = mxCreateNumericArray(3, adwDims, mxDOUBLE_CLASS, mxREAL);
+        else if (bDictionary)
+            *ppmxData = mxCreateNumericMatrix(nRows, ncols, mxUINT32_CLASS, mxREAL);
+        else
+            *ppmxData = bNumeric ? mxCreateDoubleMatrix(nRows, ncols, mxREAL) : mxCreateCellMatrix(nRows, ncols);
+        *ppmxDataSize = bTimeStampsOnly ? mxCreateDoubleMatrix(0, 0, mxREAL) : mxCreateDoubleMatrix(nRows, ncols, mxREAL);
+        pdTimeStamp = mxGetPr(*ppmxTimeStamp);
+        pdDataSize = mxGetPr(*ppmxDataSize);
+        if (bDictionary)
+            pdwCode = (UINT32 *) mxGetData(*ppmxData);
+        for (k = 0; k < nRows * ncols; ++k)
+            pdTimeStamp[k] = mxGetNaN();
+        if (bNumeric)
+        {
+            pdData = mxGetPr(*ppmxData);
+            for (k = 0; k < nRows * dwFields * ncols; ++k)
+                pdData[k] = mxGetNaN();
+        }
+    }
+
+    // Every entity is read on its own with the indeces of its events
+    for (i = 0; (0 == nsresult) && (i < ncols); ++i)
+    {
+        if (0 == pdwIndexCount[i])
+            continue;
+
+        // Time stamps only are taken from the kept ones where possible
+        if (bTimeStampsOnly)
+        {
+            for (k = 0; (0 == nsresult) && (k < pdwIndexCount[i]); ++k)
+            {
+                pdTime = &ppTimes[i]->pdTime[pdwIndex[i] + k];
+                if (mxIsNaN(*pdTime))
+                {
+                    nsresult = ns_GetTimeByIndex(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], 
+                                                 pdwIndex[i] + k, pdTime);
+                    if (0 != nsresult)
+                    {
+                        mexPrintf("There was an error running ns_GetTimeByIndex!\n(Required for ns_GetEventDataByTime)\n");
+                        *pdTime = mxGetNaN();
+                    }
+                }
+                pdTimeStamp[i * nRows + k] = *pdTime;
+            }
+            continue;
+        }
+
+        for (k = 0; k < pdwIndexCount[i]; ++k)
+            pdIndex[k] = (double) pdwIndex[i] + k;
+        nsresult = fEventData(hFile, 1, &pdEntityID[i], pdwIndexCount[i], pdIndex, pmxOptions, 
+                              &pmxTimeStamp, &pmxData, &pmxDataSize, &pmxFieldNames, 
+                              &pmxDictionary);
+        if (0 == nsresult)
+        {
+            memcpy(pdTimeStamp + i * nRows, mxGetPr(pmxTimeStamp), pdwIndexCount[i] * sizeof(double));
+            memcpy(pdDataSize + i * nRows, mxGetPr(pmxDataSize), pdwIndexCount[i] * sizeof(double));
+
+            // An entity may have fewer CSV fields than others
+            nFields = MIN(mxGetN(pmxData), dwFields);
+            for (f = 0; bNumeric && (f < nFields); ++f)
+            {
+                memcpy(pdData + (i * dwFields + f) * nRows, mxGetPr(pmxData) + f * pdwIndexCount[i], 
+                       pdwIndexCount[i] * sizeof(double));
+            }
+
+            // The codes of the entity are translated into codes of the dictionary of all entities
+            if (bDictionary)
+            {
+                pdwCodeMap = calloc(mxGetNumberOfElements(pmxDictionary) + 1, sizeof(UINT32));
+                for (k = 0; pdwCodeMap && (k < mxGetNumberOfElements(pmxDictionary)); ++k)
+                {
+                    szString = mxArrayToString(mxGetCell(pmxDictionary, k));
+                    pdwCodeMap[k + 1] = szString ? fDictionaryCode(&dictionary, szString) : 0;
+                    mxFree(szString);
+                    if (0 == pdwCodeMap[k + 1])
+                        break;
+                }
+                if (!pdwCodeMap || (k < mxGetNumberOfElements(pmxDictionary)))
+                {
+                    mexPrintf("Not enough memory for the dictionary (ns_GetEventDataByTime).\n");
+                    nsresult = ns_LIBERROR;
+                }
+
+                pdwEntityCode = (UINT32 *) mxGetData(pmxData);
+                for (k = 0; (0 == nsresult) && (k < pdwIndexCount[i]); ++k)
+                    pdwCode[i * nRows + k] = pdwCodeMap[pdwEntityCode[k]];
+                free(pdwCodeMap);
+            }
+
+            // The cells are moved, not copied
+            for (k = 0; !bNumeric && !bDictionary && (k < pdwIndexCount[i]); ++k)
+            {
+                mxSetCell(*ppmxData, i * nRows + k, mxGetCell(pmxData, k));
+                mxSetCell(pmxData, k, 0);
+            }
+
+            // The time stamps that were read are kept for later windows
+            for (k = 0; k < pdwIndexCount[i]; ++k)
+                ppTimes[i]->pdTime[pdwIndex[i] + k] = pdTimeStamp[i * nRows + k];
+        }
+        mxDestroyArray(pmxTimeStamp);
+        mxDestroyArray(pmxData);
+        mxDestroyArray(pmxDataSize);
+        mxDestroyArray(pmxFieldNames);
+        mxDestroyArray(pmxDictionary);
+    }
+
+    if (0 != nsresult)
+    {
+        if (*ppmxTimeStamp)
+        {
+            mxDestroyArray(*ppmxTimeStamp);
+            mxDestroyArray(*ppmxData);
+            mxDestroyArray(*ppmxDataSize);
+        }
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxDataSize = mxCreateString("");
+        *ppmxStartIndex = mxCreateString("");
+        *ppmxIndexCount = mxCreateString("");
+        *ppmxFieldNames = mxCreateString("");
+        *ppmxDictionary = mxCreateString("");
+    }
+    else
+    {
+        *ppmxStartIndex = mxCreateDoubleMatrix(1, ncols, mxREAL);
+        *ppmxIndexCount = mxCreateDoubleMatrix(1, ncols, mxREAL);
+        pdStartIndex = mxGetPr(*ppmxStartIndex);
+        pdIndexCount = mxGetPr(*ppmxIndexCount);
+        for (i = 0; i < ncols; ++i)
+        {
+            pdStartIndex[i] = (0 < pdwIndexCount[i]) ? (double) pdwIndex[i] : mxGetNaN();
+            pdIndexCount[i] = pdwIndexCount[i];
+        }
+        *ppmxFieldNames = ((ns_EVENT_CSV == dwType) && !bTimeStampsOnly) ? 
+                          fCSVFieldNames(pEventInfo, ncols, dwFields) : mxCreateCellMatrix(0, 0);
+        *ppmxDictionary = bDictionary ? fDictionaryStrings(&dictionary) : mxCreateCellMatrix(0, 0);
+    }
+
+    fFreeDictionary(&dictionary);
+    free(pdIndex);
+    free(pEventInfo);
+    free(ppTimes);
+    free(pdwIndex);
+    free(pdwIndexCount);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the event data of entities of any event types and convert it into Matlab
+//          format. All entities are read in one pass through one buffer that fits the
+//          longest event of all of them.
+// Inputs:  hFile - handle/ID number of the file
+//          ncolsEntity - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for
+//          ncolsIndex - number of elements in the array of indeces (pdIndex)
+//          pdIndex - pointer to the array of indeces to get data for (the same for all
+//                    entities)
+//          pmxOptions - options structure passed from Matlab (may be empty); Dictionary
+//                       encodes text events as codes into a dictionary of their strings
+//          ppmxEvents - double pointer to the mex converted structure array with one
+//                       element per entity: TimeStamp, Data (uint8, uint16 or uint32
+//                       values, a cell array of strings or uint32 codes for text events,
+//                       an index by field array for CSV events), DataSize, FieldNames and
+//                       Dictionary (see fEventData). The fields of entities that do not
+//                       exist are empty.
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxEvents is filled.
+ns_RESULT fEventDataBatch(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex,
+                          double *pdIndex, const mxArray *pmxOptions, mxArray **ppmxEvents)
+{
+    const char *aszEventNames[] = {"TimeStamp","Data","DataSize","FieldNames","Dictionary"};
+    ns_EVENTINFO *pEventInfo;
+    ns_RESULT *pnInfoResult;
+    DICTIONARY dictionary;
+    mxArray *pmxEvents;
+    mxArray *pmxData;
+    mxClassID classID;
+    double dTimeStamp;
+    double *pdTimeStamp;
+    double *pdDataSize;
+    double *pdData = 0;
+    UINT32 *pdwCode = 0;
+    void *pvOutput = 0;
+    void *pvData;
+    UINT32 dwMaxDataLength = 0;
+    UINT32 dwDataSize;
+    UINT32 dwFields = 0;
+    UINT32 dwType;
+    size_t i;
+    size_t j;
+    ns_RESULT nsresult = ns_OK;
+    ns_RESULT nsreturn = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bDictionary = (0 != fGetOption(pmxOptions, "Dictionary", 0));
+
+    memset(&dictionary, 0, sizeof(dictionary));
+    pEventInfo = calloc(ncolsEntity + 1, sizeof(ns_EVENTINFO));
+    pnInfoResult = calloc(ncolsEntity + 1, sizeof(ns_RESULT));
+    if (!pEventInfo || !pnInfoResult)
+    {
+        mexPrintf("Not enough memory to load the event information (ns_GetEventDataBatch).\n");
+        free(pEventInfo);
+        free(pnInfoResult);
+        *ppmxEvents = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    // The information of every entity is only loaded once
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        pnInfoResult[i] = ns_GetEventInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &pEventInfo[i], 
+                                          sizeof(ns_EVENTINFO));
+        if (0 == pnInfoResult[i])
+        {
+            dwMaxDataLength = MAX(dwMaxDataLength, pEventInfo[i].dwMaxDataLength);
+        }
+        else if (-5 == pnInfoResult[i])
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetEventDataBatch).\n");
+            bEntity = FALSE;
+            nsreturn = pnInfoResult[i];
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetEventInfo!\n(Required for ns_GetEventDataBatch)\n");
+            free(pEventInfo);
+            free(pnInfoResult);
+            *ppmxEvents = mxCreateString("");
+            return(ns_LIBERROR);
+        }
+    }
+
+    // One buffer large enough for every entity is used for all events
+    pvData = calloc(dwMaxDataLength + 1, 1);
+    if (!pvData)
+    {
+        mexPrintf("Not enough memory to load the event data (ns_GetEventDataBatch).\n");
+        free(pEventInfo);
+        free(pnInfoResult);
+        *ppmxEvents = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    pmxEvents = mxCreateStructMatrix(ncolsEntity, 1, 5, aszEventNames);
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        if (0 != pnInfoResult[i])
+            continue;
+
+        // Every entity gets data of the type of its events
+        dwType = pEventInfo[i].dwEventType;
+        switch (dwType)
+        {
+        case ns_EVENT_TEXT:
+            pmxData = bDictionary ? mxCreateNumericMatrix(ncolsIndex, 1, mxUINT32_CLASS, mxREAL) : 
+                                    mxCreateCellMatrix(ncolsIndex, 1);
+            pdwCode = bDictionary ? (UINT32 *) mxGetData(pmxData) : 0;
+            break;
+        case ns_EVENT_CSV:
+            dwFields = fCSVFields(hFile, (UINT32) pdEntityID[i], &pEventInfo[i], 
+                                  (0 < ncolsIndex) ? (UINT32) pdIndex[0] : 0);
+            pmxData = mxCreateDoubleMatrix(ncolsIndex, dwFields, mxREAL);
+            pdData = mxGetPr(pmxData);
+            break;
+        case ns_EVENT_BYTE:
+        case ns_EVENT_WORD:
+        case ns_EVENT_DWORD:
+            classID = (ns_EVENT_BYTE == dwType) ? mxUINT8_CLASS : 
+                      (ns_EVENT_WORD == dwType) ? mxUINT16_CLASS : mxUINT32_CLASS;
+            pmxData = mxCreateNumericMatrix(ncolsIndex, 1, classID, mxREAL);
+            pvOutput = mxGetData(pmxData);
+            break;
+        default:
+            pmxData = mxCreateDoubleMatrix(0, 0, mxREAL);
+            break;
+        }
+        mxSetField(pmxEvents, i, aszEventNames[0], mxCreateDoubleMatrix(ncolsIndex, 1, mxREAL));
+        mxSetField(pmxEvents, i, aszEventNames[1], pmxData);
+        mxSetField(pmxEvents, i, aszEventNames[2], mxCreateDoubleMatrix(ncolsIndex, 1, mxREAL));
+        pdTimeStamp = mxGetPr(mxGetField(pmxEvents, i, aszEventNames[0]));
+        pdDataSize = mxGetPr(mxGetField(pmxEvents, i, aszEventNames[2]));
+
+        for (j = 0; j < ncolsIndex; ++j)
+        {
+            nsresult = ns_GetEventData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdIndex[j], 
+                                       &dTimeStamp, pvData, pEventInfo[i].dwMaxDataLength, 
+                                       &dwDataSize);
+            if (0 == nsresult)
+            {
+                ((char *) pvData)[pEventInfo[i].dwMaxDataLength] = 0;
+                switch (dwType)
+                {
+                case ns_EVENT_TEXT:
+                    if (pdwCode)
+                        pdwCode[j] = fDictionaryCode(&dictionary, (char *) pvData);
+                    else
+                        mxSetCell(pmxData, j, mxCreateString((char *) pvData));
+                    break;
+                case ns_EVENT_CSV:
+                    fParseCSVEvent((char *) pvData, pdData + j, dwFields, ncolsIndex);
+                    break;
+                case ns_EVENT_BYTE:
+                    ((UINT8 *) pvOutput)[j] = *((UINT8 *) pvData);
+                    break;
+                case ns_EVENT_WORD:
+                    ((UINT16 *) pvOutput)[j] = *((UINT16 *) pvData);
+                    break;
+                case ns_EVENT_DWORD:
+                    ((UINT32 *) pvOutput)[j] = *((UINT32 *) pvData);
+                    break;
+                }
+                pdTimeStamp[j] = dTimeStamp;
+                pdDataSize[j] = dwDataSize;
+
+                if (pdwCode && (0 == pdwCode[j]))
+                {
+                    mexPrintf("Not enough memory for the dictionary (ns_GetEventDataBatch).\n");
+                    nsresult = ns_LIBERROR;
+                    break;
+                }
+            }
+            else if (-7 == nsresult)
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetEventDataBatch).\n");
+                bIndex = FALSE;
+                nsreturn = nsresult;
+                nsresult = ns_OK;
+                break;
+            }
+            else
+            {
+                mexPrintf("There was an error running ns_GetEventData!\n(Required for ns_GetEventDataBatch)\n");
+                break;
+            }
+        }
+        if (0 != nsresult)
+            break;
+
+        mxSetField(pmxEvents, i, aszEventNames[3], (ns_EVENT_CSV == dwType) ? 
+                   fCSVFieldNames(&pEventInfo[i], 1, dwFields) : mxCreateCellMatrix(0, 0));
+        mxSetField(pmxEvents, i, aszEventNames[4], pdwCode ? fDictionaryStrings(&dictionary) : 
+                                                            mxCreateCellMatrix(0, 0));
+        fFreeDictionary(&dictionary);
+        pdwCode = 0;
+    }
+
+    if (0 != nsresult)
+    {
+        mxDestroyArray(pmxEvents);
+        *ppmxEvents = mxCreateString("");
+        nsreturn = ns_LIBERROR;
+    }
+    else
+        *ppmxEvents = pmxEvents;
+
+    fFreeDictionary(&dictionary);
+    free(pvData);
+    free(pEventInfo);
+    free(pnInfoResult);
+    return(nsreturn);
+}
+
+// Longest stretch of indeces read past a chunk for the backward pass of a zero phase
+// filter; filters whose state decays more slowly are cut off there
+#define FILTER_MAX_OVERLAP (4 * ANALOG_CHUNK_SIZE)
+
+// An IIR filter applied to analog data while it is read, see fFilterColumn
+typedef struct
+{
+    double *pdSos;            // DSP_BIQUAD_SIZE coefficients of every section (0 = no filter)
+    size_t nSections;         // number of second order sections
+    BOOL bZeroPhase;          // filter forward and backward (like filtfilt)
+    size_t nOverlap;          // indeces read past a chunk for the backward pass
+    double *pdState;          // state of the forward pass of every entity
+    BOOL *pbStarted;          // the state of an entity holds the indeces read before
+} ANALOGFILTER;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Free a filter and its state
+// Inputs:  pFilter - the filter
+void fFreeFilter(ANALOGFILTER *pFilter)
+{
+    free(pFilter->pdSos);
+    free(pFilter->pdState);
+    free(pFilter->pbStarted);
+    memset(pFilter, 0, sizeof(ANALOGFILTER));
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the filter requested in the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          ncols - number of entities that are filtered
+//          pFilter - receives the filter (pdSos is 0 if the option is not given)
+// Outputs: BOOL - FALSE if the Filter option is not valid (a message is printed)
+BOOL fGetFilterOption(const mxArray *pmxOptions, size_t ncols, ANALOGFILTER *pFilter)
+{
+    const mxArray *pmxSos;
+    const double *pdSos;
+    double *pdSection;
+    double dRadius;
+    size_t nSections;
+    size_t i;
+    BOOL bFinite = TRUE;
+
+    memset(pFilter, 0, sizeof(ANALOGFILTER));
+    if (!fHasOption(pmxOptions, "Filter"))
+        return(TRUE);
+
+    pmxSos = mxGetField(pmxOptions, 0, "Filter");
+    if (!mxIsDouble(pmxSos) || mxIsComplex(pmxSos) || (2 != mxGetNumberOfDimensions(pmxSos)) ||
+        (6 != mxGetN(pmxSos)))
+    {
+        mexPrintf("Filter option must be a matrix with one row [b0 b1 b2 a0 a1 a2] per section.\n");
+        return(FALSE);
+    }
+
+    nSections = mxGetM(pmxSos);
+    pdSos = mxGetPr(pmxSos);
+    pFilter->nSections = nSections;
+    pFilter->pdSos = calloc(nSections * DSP_BIQUAD_SIZE, sizeof(double));
+    pFilter->pdState = calloc(ncols * 2 * nSections + 1, sizeof(double));
+    pFilter->pbStarted = calloc(ncols + 1, sizeof(BOOL));
+    if (!pFilter->pdSos || !pFilter->pdState || !pFilter->pbStarted)
+    {
+        mexPrintf("Not enough memory for the Filter option.\n");
+        fFreeFilter(pFilter);
+        return(FALSE);
+    }
+
+    // Matlab stores the matrix column by column, the sections are stored divided by a0
+    for (i = 0; i < nSections; ++i)
+    {
+        pdSection = pFilter->pdSos + i * DSP_BIQUAD_SIZE;
+        pdSection[0] = pdSos[i] / pdSos[3 * nSections + i];
+        pdSection[1] = pdSos[nSections + i] / pdSos[3 * nSections + i];
+        pdSection[2] = pdSos[2 * nSections + i] / pdSos[3 * nSections + i];
+        pdSection[3] = pdSos[4 * nSections + i] / pdSos[3 * nSections + i];
+        pdSection[4] = pdSos[5 * nSections + i] / pdSos[3 * nSections + i];
+        bFinite = bFinite && mxIsFinite(pdSection[0]) && mxIsFinite(pdSection[1]) && 
+                  mxIsFinite(pdSection[2]) && mxIsFinite(pdSection[3]) && mxIsFinite(pdSection[4]);
+    }
+
+    dRadius = dsp_BiquadRadius(pFilter->pdSos, nSections);
+    if (!bFinite || !(dRadius < 1))
+    {
+        mexPrintf("Filter option must be a stable filter with finite coefficients and a0 ~= 0.\n");
+        fFreeFilter(pFilter);
+        return(FALSE);
+    }
+
+    // The state of the filter decays by the pole radius per index. The backward pass
+    // starts far enough after a chunk for its starting state to have decayed by 1e-12.
+    pFilter->bZeroPhase = (0 != fGetOption(pmxOptions, "ZeroPhase", 0));
+    pFilter->nOverlap = FILTER_MAX_OVERLAP;
+    if (dRadius < pow(1e-12, 1.0 / FILTER_MAX_OVERLAP))
+        pFilter->nOverlap = MAX(16, (size_t) ceil(log(1e-12) / log(dRadius)));
+    return(TRUE);
+}
+
+// State of a multi-entity analog read shared by the worker threads
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    UINT32 dwIndex;
+    UINT32 dwIndexCount;
+    UINT32 *pdwIndex;         // first index of every entity (0 = dwIndex for all entities)
+    UINT32 *pdwIndexCount;    // index count of every entity (0 = dwIndexCount for all entities)
+    size_t nRows;             // rows of the output matrix, rows past the index count are padded
+    double dPad;              // value of padded rows
+    UINT32 dwDecimate;        // decimation factor, every dwDecimate-th filtered value is returned
+    double *pdTaps;           // anti-alias filter for decimation (set by fAnalogReadColumns)
+    size_t nTaps;             // number of filter coefficients (multiple of 4)
+    size_t nDelay;            // delay of the filter in samples
+    mxClassID classID;        // class of the output matrix
+    void *pvData;             // output matrix, one column per entity
+    double *pdScale;          // value of one raw count of every entity (int16 output)
+    UINT32 *pdwContCount;     // continuous count of every entity
+    ANALOGBLOCKS *pBlocks;    // continuous blocks of every entity (0 if not requested)
+    int nReference;           // kind of reference subtracted from the data (REFERENCE_*)
+    double *pdReference;      // reference entity of every entity (bipolar reference, NaN = none)
+    ANALOGFILTER *pFilter;    // filter applied to the data (0 = none)
+    UINT32 dwFilterEnd;       // a zero phase filter may read up to this index past the range
+    BOOL *pbServed;           // entities already served from windows read ahead or sidecars
+    ANALOGSIDECAR **ppSidecar;// sidecar of every entity to serve it from (set by fAnalogReadColumns)
+    ns_RESULT *pnResult;      // result of every entity
+} ANALOGREAD;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Prepare a read of the same index range of several analog entities
+// Inputs:  pRead - the read to prepare
+//          hFile - handle/ID number of the file
+//          pdEntityID - pointer to the array of entities to read
+//          dwIndex - index in the particular entity
+//          dwIndexCount - how many indeces are loaded
+//          classID - class of the data (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+//          pvData - receives the data, one column of dwIndexCount values per entity
+//          pdScale - value of one raw count of every entity (only used for mxINT16_CLASS)
+void fInitAnalogRead(ANALOGREAD *pRead, UINT32 hFile, double *pdEntityID, UINT32 dwIndex, 
+                     UINT32 dwIndexCount, mxClassID classID, void *pvData, double *pdScale)
+{
+    memset(pRead, 0, sizeof(ANALOGREAD));
+    pRead->hFile = hFile;
+    pRead->pdEntityID = pdEntityID;
+    pRead->dwIndex = dwIndex;
+    pRead->dwIndexCount = dwIndexCount;
+    pRead->nRows = dwIndexCount;
+    pRead->dwDecimate = 1;
+    pRead->classID = classID;
+    pRead->pvData = pvData;
+    pRead->pdScale = pdScale;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read one entity of a decimating analog read into its output column
+//          The data is read in chunks and low pass filtered; only every dwDecimate-th
+//          filtered value is computed. Values before the first and after the last index
+//          are taken to be equal to the first and last value. May be called from
+//          worker threads.
+// Inputs:  pRead - the ANALOGREAD describing the request
+//          nEntity - which entity (column) to read
+//          dwIndex - first index of the entity
+//          dwIndexCount - number of indeces of the entity
+//          pcColumn - receives ceil(dwIndexCount / dwDecimate) values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+//          pRead->pdwContCount[nEntity] is filled.
+ns_RESULT fDecimateColumn(ANALOGREAD *pRead, size_t nEntity, UINT32 dwIndex, UINT32 dwIndexCount, 
+                          char *pcColumn)
+{
+    size_t nFactor = pRead->dwDecimate;
+    size_t nSegment = nFactor * ((ANALOG_CHUNK_SIZE + nFactor - 1) / nFactor);
+    size_t nCapacity = nSegment + 2 * pRead->nDelay;
+    size_t cbValue = fClassSize(pRead->classID);
+    size_t nHave = pRead->nDelay;
+    size_t nRead = 0;
+    size_t nDone = 0;
+    size_t nLength;
+    size_t nOutputs;
+    size_t nRow = 0;
+    double *pdWork;
+    double *pdOutput;
+    ANALOGCHUNKS chunks;
+    ns_RESULT nsresult = ns_OK;
+    UINT32 i;
+
+    // pdWork[0] holds the value nDelay indeces before the next output. The filter
+    // reads up to nTaps values past the last output, which are kept at zero.
+    // fReadChunk may write one value past nCapacity (see there).
+    pdWork = calloc(nCapacity + pRead->nTaps + 1, sizeof(double));
+    pdOutput = calloc(nSegment / nFactor, sizeof(double));
+    if (!pdWork || !pdOutput || 
+        !fOpenChunks(&chunks, pRead->hFile, (UINT32) pRead->pdEntityID[nEntity], dwIndex, dwIndexCount, 0))
+    {
+        free(pdWork);
+        free(pdOutput);
+        return(ns_LIBERROR);
+    }
+    if (pRead->pBlocks)
+        fTrackBlocks(&chunks, &pRead->pBlocks[nEntity]);
+
+    while (nDone < dwIndexCount)
+    {
+        // Fill the work buffer with the next segment and the values around it
+        while ((nHave < nCapacity) && (nRead < dwIndexCount))
+        {
+            nsresult = fReadChunk(&chunks, pdWork + nHave, (UINT32) (nCapacity - nHave));
+            if (0 != nsresult)
+                break;
+            if (0 == nRead)
+            {
+                for (i = 0; i < pRead->nDelay; ++i)
+                    pdWork[i] = pdWork[pRead->nDelay];
+            }
+            nRead += chunks.dwCount;
+            nHave += chunks.dwCount;
+        }
+        if (0 != nsresult)
+            break;
+        for (; nHave < nCapacity; ++nHave)
+            pdWork[nHave] = pdWork[nHave - 1];
+        pdWork[nCapacity] = 0;
+
+        nLength = dwIndexCount - nDone;
+        if (nLength > nSegment)
+            nLength = nSegment;
+        nOutputs = (nLength + nFactor - 1) / nFactor;
+
+        dsp_FirDecimate(pdWork, nOutputs, nFactor, pRead->pdTaps, pRead->nTaps, pdOutput);
+        fConvertSamples(pdOutput, nOutputs, pRead->classID, pRead->pdScale[nEntity], 
+                        pcColumn + nRow * cbValue);
+        nRow += nOutputs;
+        nDone += nLength;
+
+        memmove(pdWork, pdWork + nLength, (nHave - nLength) * sizeof(double));
+        nHave -= nLength;
+    }
+
+    // Rows are continuous as long as the indeces they were computed from are
+    pRead->pdwContCount[nEntity] = (UINT32) ((chunks.dwContCount + nFactor - 1) / nFactor);
+
+    fCloseChunks(&chunks);
+    free(pdWork);
+    free(pdOutput);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read one entity of a filtering analog read into its output column
+//          The data is read in chunks and filtered with the state the entity was left
+//          in by the indeces before (pRead->pFilter->pdState), so the chunks of a stream
+//          join seamlessly. For a zero phase filter up to nOverlap indeces after every
+//          chunk are read as well; the backward pass starts there from the steady state
+//          of the last value. May be called from worker threads.
+// Inputs:  pRead - the ANALOGREAD describing the request
+//          nEntity - which entity (column) to read
+//          dwIndex - first index of the entity
+//          dwIndexCount - number of indeces of the entity
+//          pcColumn - receives dwIndexCount values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+//          pRead->pdwContCount[nEntity] is filled.
+ns_RESULT fFilterColumn(ANALOGREAD *pRead, size_t nEntity, UINT32 dwIndex, UINT32 dwIndexCount, 
+                        char *pcColumn)
+{
+    ANALOGFILTER *pFilter = pRead->pFilter;
+    UINT32 dwEntityID = (UINT32) pRead->pdEntityID[nEntity];
+    double *pdState = pFilter->pdState + nEntity * 2 * pFilter->nSections;
+    size_t nSegment = MAX(ANALOG_CHUNK_SIZE, pFilter->nOverlap);
+    size_t nCapacity = nSegment + (pFilter->bZeroPhase ? pFilter->nOverlap : 0);
+    size_t cbValue = fClassSize(pRead->classID);
+    UINT32 dwNext = dwIndex + dwIndexCount;
+    UINT32 dwLookEnd = dwNext;
+    UINT32 dwContCount;
+    UINT32 dwCount;
+    size_t nHave = 0;
+    size_t nDone = 0;
+    size_t nLength;
+    double *pdRaw;
+    double *pdWork;
+    double *pdBackward;
+    ANALOGCHUNKS chunks;
+    ns_RESULT nsresult = ns_OK;
+
+    // The backward pass may read past the range up to the end of the stream
+    if (pFilter->bZeroPhase && (pRead->dwFilterEnd > dwLookEnd))
+        dwLookEnd += (UINT32) MIN(pRead->dwFilterEnd - dwLookEnd, pFilter->nOverlap);
+
+    pdRaw = calloc(nCapacity + 1, sizeof(double));
+    pdWork = calloc(nCapacity, sizeof(double));
+    pdBackward = calloc(2 * pFilter->nSections, sizeof(double));
+    if (!pdRaw || !pdWork || !pdBackward || 
+        !fOpenChunks(&chunks, pRead->hFile, dwEntityID, dwIndex, dwIndexCount, 0))
+    {
+        free(pdRaw);
+        free(pdWork);
+        free(pdBackward);
+        return(ns_LIBERROR);
+    }
+    if (pRead->pBlocks)
+        fTrackBlocks(&chunks, &pRead->pBlocks[nEntity]);
+
+    while (nDone < dwIndexCount)
+    {
+        // Keep the raw values of the next segment and of the indeces after it
+        while (nHave < nCapacity)
+        {
+            if (chunks.dwIndex < chunks.dwEndIndex)
+            {
+                nsresult = fReadChunk(&chunks, pdRaw + nHave, (UINT32) (nCapacity - nHave));
+                if (0 != nsresult)
+                    break;
+                nHave += chunks.dwCount;
+            }
+            else if (dwNext < dwLookEnd)
+            {
+                // Indeces past the range only serve the backward pass. If they cannot be 
+                // read, the data is filtered as if it ended with the range.
+                dwCount = (UINT32) MIN(dwLookEnd - dwNext, nCapacity - nHave);
+                if (0 != fReadAnalog(pRead->hFile, dwEntityID, dwNext, dwCount, &dwContCount, 
+                                     pdRaw + nHave))
+                {
+                    dwLookEnd = dwNext;
+                    break;
+                }
+                nHave += dwCount;
+                dwNext += dwCount;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (0 != nsresult)
+            break;
+
+        nLength = dwIndexCount - nDone;
+        if (nLength > nSegment)
+            nLength = nSegment;
+
+        // A filter that has not seen any data starts as if the first value had always been there
+        memcpy(pdWork, pdRaw, nHave * sizeof(double));
+        if (!pFilter->pbStarted[nEntity])
+        {
+            dsp_BiquadSteadyState(pFilter->pdSos, pFilter->nSections, pdWork[0], pdState);
+            pFilter->pbStarted[nEntity] = TRUE;
+        }
+        dsp_Biquads(pFilter->pdSos, pFilter->nSections, pdState, pdWork, nLength, FALSE);
+
+        if (pFilter->bZeroPhase)
+        {
+            memcpy(pdBackward, pdState, 2 * pFilter->nSections * sizeof(double));
+            dsp_Biquads(pFilter->pdSos, pFilter->nSections, pdBackward, pdWork + nLength, 
+                        nHave - nLength, FALSE);
+            dsp_BiquadSteadyState(pFilter->pdSos, pFilter->nSections, pdWork[nHave - 1], pdBackward);
+            dsp_Biquads(pFilter->pdSos, pFilter->nSections, pdBackward, pdWork, nHave, TRUE);
+        }
+
+        fConvertSamples(pdWork, nLength, pRead->classID, pRead->pdScale[nEntity], 
+                        pcColumn + nDone * cbValue);
+        nDone += nLength;
+
+        memmove(pdRaw, pdRaw + nLength, (nHave - nLength) * sizeof(double));
+        nHave -= nLength;
+    }
+
+    pRead->pdwContCount[nEntity] = chunks.dwContCount;
+
+    fCloseChunks(&chunks);
+    free(pdRaw);
+    free(pdWork);
+    free(pdBackward);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read one entity of a multi-entity analog read into its output column
+// Inputs:  pvContext - the ANALOGREAD describing the request
+//          nEntity - which entity (column) to read
+// Outputs: pRead->pnResult[nEntity] and pRead->pdwContCount[nEntity] are filled
+void fAnalogDataTask(void *pvContext, size_t nEntity)
+{
+    ANALOGREAD *pRead = (ANALOGREAD *) pvContext;
+    size_t cbValue = fClassSize(pRead->classID);
+    UINT32 dwIndex = pRead->pdwIndex ? pRead->pdwIndex[nEntity] : pRead->dwIndex;
+    UINT32 dwIndexCount = pRead->pdwIndexCount ? pRead->pdwIndexCount[nEntity] : pRead->dwIndexCount;
+    size_t nRows = (dwIndexCount + pRead->dwDecimate - 1) / pRead->dwDecimate;
+    double dScratch = 0;
+    char *pcColumn;
+    ANALOGCHUNKS chunks;
+    size_t nOffset = 0;
+    size_t nRow;
+    ns_RESULT nsresult;
+
+    // The entity was served from a window read ahead
+    if (pRead->pbServed && pRead->pbServed[nEntity])
+        return;
+
+    pcColumn = (char *) pRead->pvData + nEntity * pRead->nRows * cbValue;
+
+    // The entity is served from its sidecar if the sidecar holds the range
+    if (pRead->ppSidecar && pRead->ppSidecar[nEntity] &&
+        fReadSidecar(pRead->ppSidecar[nEntity], dwIndex, dwIndexCount, pRead->classID, 
+                     pRead->pdScale[nEntity], pcColumn, &pRead->pdwContCount[nEntity]))
+    {
+        if (mxDOUBLE_CLASS == pRead->classID)
+            fEnvelopeFeed(pRead->hFile, (UINT32) pRead->pdEntityID[nEntity], dwIndex, dwIndexCount, 
+                          (double *) pcColumn);
+        pRead->pbServed[nEntity] = TRUE;
+        pRead->pnResult[nEntity] = ns_OK;
+        return;
+    }
+
+    if (pRead->pdwIndexCount && (0 == dwIndexCount))
+    {
+        // Nothing to read for this entity
+        pRead->pdwContCount[nEntity] = 0;
+        nsresult = ns_OK;
+    }
+    else if (1 < pRead->dwDecimate)
+    {
+        nsresult = fDecimateColumn(pRead, nEntity, dwIndex, dwIndexCount, pcColumn);
+    }
+    else if (pRead->pFilter)
+    {
+        nsresult = fFilterColumn(pRead, nEntity, dwIndex, dwIndexCount, pcColumn);
+    }
+    else if ((mxDOUBLE_CLASS == pRead->classID) && !pRead->pBlocks)
+    {
+        // An empty result has no column to write to, the library still gets a valid pointer
+        nsresult = fReadAnalog(pRead->hFile, (UINT32) pRead->pdEntityID[nEntity], dwIndex, 
+                               dwIndexCount, &pRead->pdwContCount[nEntity], 
+                               (0 < dwIndexCount) ? (double *) pcColumn : &dScratch);
+
+        // Whole tiles of an envelope of the entity are added on the way
+        if (0 == nsresult)
+            fEnvelopeFeed(pRead->hFile, (UINT32) pRead->pdEntityID[nEntity], dwIndex, dwIndexCount, 
+                          (double *) pcColumn);
+    }
+    else if (!fOpenChunks(&chunks, pRead->hFile, (UINT32) pRead->pdEntityID[nEntity], dwIndex, 
+                          dwIndexCount, ANALOG_CHUNK_SIZE))
+    {
+        fCloseChunks(&chunks);
+        nsresult = ns_LIBERROR;
+    }
+    else
+    {
+        // Other classes are read in chunks and converted, so only one chunk
+        // of double values is held in memory at a time. Blocks are found chunk by chunk.
+        if (pRead->pBlocks)
+            fTrackBlocks(&chunks, &pRead->pBlocks[nEntity]);
+
+        while ((0 == (nsresult = fNextChunk(&chunks))) && (0 < chunks.dwCount))
+        {
+            fConvertSamples(chunks.pdChunk, chunks.dwCount, pRead->classID, pRead->pdScale[nEntity], 
+                            pcColumn + nOffset * cbValue);
+            nOffset += chunks.dwCount;
+        }
+        pRead->pdwContCount[nEntity] = chunks.dwContCount;
+        fCloseChunks(&chunks);
+    }
+
+    // The library may have written part of the column before failing.
+    // Entities that could not be loaded are returned as zeros.
+    if ((0 != nsresult) && (0 < nRows))
+        memset(pcColumn, 0, nRows * cbValue);
+    if ((0 != nsresult) && pRead->pBlocks)
+        pRead->pBlocks[nEntity].nBlocks = 0;
+
+    // Rows past the index count of this entity are padded
+    for (nRow = nRows; nRow < pRead->nRows; ++nRow)
+        fConvertSamples(&pRead->dPad, 1, pRead->classID, 1, pcColumn + nRow * cbValue);
+
+    pRead->pnResult[nEntity] = nsresult;
+}
+
+// Analog entities can be re-referenced while they are read: to the mean or median of all
+// requested entities (common average or median reference) or each to another entity
+// (bipolar pairs). All entities are read side by side in spans, so only the referenced
+// data is ever held in full.
+
+// Kinds of reference (ANALOGREAD.nReference)
+#define REFERENCE_NONE    0
+#define REFERENCE_AVERAGE 1
+#define REFERENCE_MEDIAN  2
+#define REFERENCE_BIPOLAR 3
+
+// Number of indeces of every entity that one worker thread reads at once. The worker
+// threads are started twice per span, to read it and to write it referenced.
+#define REFERENCE_SPAN_SIZE 65536
+
+// Number of indeces of every entity that are re-referenced at once. The chunks of all
+// entities of a read together should stay in the cache while the reference is computed.
+#define REFERENCE_CHUNK_SIZE 4096
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the reference requested in the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          ncols - number of entities that are read
+//          pnReference - receives the kind of reference (REFERENCE_NONE if not given)
+//          ppdReference - receives the reference entity of every entity for bipolar
+//                         references (NaN for none), points into pmxOptions
+// Outputs: BOOL - FALSE if the Reference option is not 'average', 'median' or a vector
+//          of one entity or NaN per entity
+BOOL fGetReferenceOption(const mxArray *pmxOptions, size_t ncols, int *pnReference, 
+                         double **ppdReference)
+{
+    const mxArray *pmxReference;
+    char szReference[8];
+    size_t i;
+
+    *pnReference = REFERENCE_NONE;
+    *ppdReference = 0;
+    if (!fHasOption(pmxOptions, "Reference"))
+        return(TRUE);
+
+    pmxReference = mxGetField(pmxOptions, 0, "Reference");
+    if (mxIsChar(pmxReference))
+    {
+        if (!fGetOptionString(pmxOptions, "Reference", szReference, sizeof(szReference)))
+            return(FALSE);
+        if (0 == strcmp(szReference, "average"))
+            *pnReference = REFERENCE_AVERAGE;
+        else if (0 == strcmp(szReference, "median"))
+            *pnReference = REFERENCE_MEDIAN;
+        else
+            return(FALSE);
+        return(TRUE);
+    }
+
+    if (!mxIsDouble(pmxReference) || mxIsComplex(pmxReference) || 
+        (mxGetNumberOfElements(pmxReference) != ncols))
+        return(FALSE);
+
+    *ppdReference = mxGetPr(pmxReference);
+    for (i = 0; i < ncols; ++i)
+    {
+        if (!mxIsNaN((*ppdReference)[i]) && 
+            (!((*ppdReference)[i] >= 0) || ((*ppdReference)[i] >= MAX_INDEX_RANGE) || 
+             ((*ppdReference)[i] != floor((*ppdReference)[i]))))
+            return(FALSE);
+    }
+    *pnReference = REFERENCE_BIPOLAR;
+    return(TRUE);
+}
+
+// A read of the same index range of several entities that are re-referenced span by
+// span, see fReadReferenced
+typedef struct
+{
+    ANALOGREAD *pRead;
+    size_t nEntities;         // entities read: the requested ones, then bipolar references
+                              // that were not requested
+    UINT32 *pdwEntityID;      // entity of every reader
+    size_t *pnPartner;        // reader of the bipolar reference of every requested entity
+                              // ((size_t) -1 if it has none)
+    ANALOGCHUNKS *pChunks;    // reader of every entity
+    ns_RESULT *pnResult;      // result of every reader, a reader stops at its first error
+    double *pdReference;      // common reference of the current span
+    double *pdScratch;        // one referenced chunk per requested entity (other classes)
+    size_t nRow;              // row of the current span in the output
+} REFERENCEREAD;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the result of a requested entity of a re-referenced read
+// Inputs:  pRef - the read
+//          nEntity - which requested entity
+// Outputs: ns_RESULT - the result of its reader or, if that has none, of the reader of
+//          its bipolar reference
+ns_RESULT fReferenceResult(REFERENCEREAD *pRef, size_t nEntity)
+{
+    if ((0 == pRef->pnResult[nEntity]) && (pRef->pnPartner[nEntity] < pRef->nEntities))
+        return(pRef->pnResult[pRef->pnPartner[nEntity]]);
+    return(pRef->pnResult[nEntity]);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the next span of one entity of a re-referenced read
+//          May be called from worker threads.
+// Inputs:  pvContext - the REFERENCEREAD describing the request
+//          nEntity - which reader to advance
+void fReferenceReadTask(void *pvContext, size_t nEntity)
+{
+    REFERENCEREAD *pRef = (REFERENCEREAD *) pvContext;
+
+    if (0 == pRef->pnResult[nEntity])
+        pRef->pnResult[nEntity] = fNextChunk(&pRef->pChunks[nEntity]);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Compute the common reference of the current span of a re-referenced read:
+//          the mean or median of all requested entities that could be read so far
+//          The span is referenced chunk by chunk.
+// Inputs:  pRef - the read
+//          ncols - number of requested entities
+//          dwCount - number of values in the current span
+//          pdValues - buffer of ncols values
+// Outputs: pRef->pdReference holds dwCount values (0 if no entity could be read)
+void fCommonReference(REFERENCEREAD *pRef, size_t ncols, UINT32 dwCount, double *pdValues)
+{
+    double *pdReference;
+    size_t nValid;
+    size_t i;
+    UINT32 dwOffset;
+    UINT32 dwChunk;
+    UINT32 k;
+
+    for (dwOffset = 0; dwOffset < dwCount; dwOffset += dwChunk)
+    {
+        dwChunk = MIN(dwCount - dwOffset, REFERENCE_CHUNK_SIZE);
+        pdReference = pRef->pdReference + dwOffset;
+        memset(pdReference, 0, dwChunk * sizeof(double));
+        nValid = 0;
+
+        if (REFERENCE_AVERAGE == pRef->pRead->nReference)
+        {
+            // The chunks are added one after the other, every pass runs over contiguous
+            // memory and the sum stays in the cache
+            for (i = 0; i < ncols; ++i)
+            {
+                if (0 != pRef->pnResult[i])
+                    continue;
+                for (k = 0; k < dwChunk; ++k)
+                    pdReference[k] += pRef->pChunks[i].pdChunk[dwOffset + k];
+                ++nValid;
+            }
+            for (k = 0; (0 < nValid) && (k < dwChunk); ++k)
+                pdReference[k] /= nValid;
+        }
+        else if (REFERENCE_MEDIAN == pRef->pRead->nReference)
+        {
+            for (k = 0; k < dwChunk; ++k)
+            {
+                nValid = 0;
+                for (i = 0; i < ncols; ++i)
+                {
+                    if (0 == pRef->pnResult[i])
+                        pdValues[nValid++] = pRef->pChunks[i].pdChunk[dwOffset + k];
+                }
+                if (0 < nValid)
+                    pdReference[k] = dsp_Median(pdValues, nValid);
+            }
+        }
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Subtract the reference from the current span of one requested entity and
+//          write it into the output chunk by chunk. May be called from worker threads.
+// Inputs:  pvContext - the REFERENCEREAD describing the request
+//          nEntity - which requested entity to write
+void fReferenceWriteTask(void *pvContext, size_t nEntity)
+{
+    REFERENCEREAD *pRef = (REFERENCEREAD *) pvContext;
+    ANALOGREAD *pRead = pRef->pRead;
+    const double *pdChunk = pRef->pChunks[nEntity].pdChunk;
+    const double *pdReference = pRef->pdReference;
+    UINT32 dwCount = pRef->pChunks[nEntity].dwCount;
+    size_t nOffset = nEntity * pRead->nRows + pRef->nRow;
+    double *pdDst;
+    UINT32 dwOffset;
+    UINT32 dwChunk;
+    UINT32 i;
+
+    if (0 != fReferenceResult(pRef, nEntity))
+        return;
+
+    if (REFERENCE_BIPOLAR == pRead->nReference)
+    {
+        pdReference = 0;
+        if (pRef->pnPartner[nEntity] < pRef->nEntities)
+            pdReference = pRef->pChunks[pRef->pnPartner[nEntity]].pdChunk;
+    }
+
+    for (dwOffset = 0; dwOffset < dwCount; dwOffset += dwChunk)
+    {
+        dwChunk = MIN(dwCount - dwOffset, REFERENCE_CHUNK_SIZE);
+
+        // Double data is written straight into the output, other classes are converted
+        if (mxDOUBLE_CLASS == pRead->classID)
+            pdDst = (double *) pRead->pvData + nOffset + dwOffset;
+        else
+            pdDst = pRef->pdScratch + nEntity * REFERENCE_CHUNK_SIZE;
+
+        if (pdReference)
+        {
+            for (i = 0; i < dwChunk; ++i)
+                pdDst[i] = pdChunk[dwOffset + i] - pdReference[dwOffset + i];
+        }
+        else
+        {
+            memcpy(pdDst, pdChunk + dwOffset, dwChunk * sizeof(double));
+        }
+
+        if (mxDOUBLE_CLASS != pRead->classID)
+            fConvertSamples(pdDst, dwChunk, pRead->classID, pRead->pdScale[nEntity], 
+                            (char *) pRead->pvData + (nOffset + dwOffset) * fClassSize(pRead->classID));
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read several analog entities and re-reference them on the way
+//          The entities (and bipolar references that were not requested) are read 
+//          span by span in parallel, then the reference of the span is computed and
+//          subtracted. Only one span of double values per entity is held in memory.
+// Inputs:  pRead - the read prepared by fInitAnalogRead with nReference set
+//          ncols - number of elements in the array of entities (pRead->pdEntityID)
+//          nThreads - number of worker threads reading entities in parallel
+// Outputs: pRead->pvData, pRead->pdwContCount and pRead->pnResult are filled
+void fReadReferenced(ANALOGREAD *pRead, size_t ncols, int nThreads)
+{
+    REFERENCEREAD ref;
+    double *pdValues;
+    size_t cbValue = fClassSize(pRead->classID);
+    size_t i;
+    size_t k;
+    UINT32 dwCount;
+    BOOL bMemory;
+
+    memset(&ref, 0, sizeof(ref));
+    ref.pRead = pRead;
+    ref.nEntities = ncols;
+    ref.pdwEntityID = calloc(2 * ncols + 1, sizeof(UINT32));
+    ref.pnPartner = calloc(ncols + 1, sizeof(size_t));
+    ref.pChunks = calloc(2 * ncols + 1, sizeof(ANALOGCHUNKS));
+    ref.pnResult = calloc(2 * ncols + 1, sizeof(ns_RESULT));
+    ref.pdReference = malloc(REFERENCE_SPAN_SIZE * sizeof(double));
+    if (mxDOUBLE_CLASS != pRead->classID)
+        ref.pdScratch = malloc(ncols * REFERENCE_CHUNK_SIZE * sizeof(double));
+    pdValues = malloc((ncols + 1) * sizeof(double));
+
+    bMemory = ref.pdwEntityID && ref.pnPartner && ref.pChunks && ref.pnResult && ref.pdReference &&
+              pdValues && (ref.pdScratch || (mxDOUBLE_CLASS == pRead->classID));
+
+    // Bipolar references that were not requested are read after the requested entities
+    for (i = 0; bMemory && (i < ncols); ++i)
+        ref.pdwEntityID[i] = (UINT32) pRead->pdEntityID[i];
+    for (i = 0; bMemory && (i < ncols); ++i)
+    {
+        ref.pnPartner[i] = (size_t) -1;
+        if ((REFERENCE_BIPOLAR != pRead->nReference) || mxIsNaN(pRead->pdReference[i]))
+            continue;
+
+        for (k = 0; (k < ref.nEntities) && (ref.pdwEntityID[k] != (UINT32) pRead->pdReference[i]); ++k)
+            ;
+        if (k == ref.nEntities)
+            ref.pdwEntityID[ref.nEntities++] = (UINT32) pRead->pdReference[i];
+        ref.pnPartner[i] = k;
+    }
+
+    for (k = 0; bMemory && (k < ref.nEntities); ++k)
+    {
+        if (!fOpenChunks(&ref.pChunks[k], pRead->hFile, ref.pdwEntityID[k], pRead->dwIndex, 
+                                     pRead->dwIndexCount, REFERENCE_SPAN_SIZE))
+            ref.pnResult[k] = ns_LIBERROR;
+        else if ((k < ncols) && pRead->pBlocks)
+            fTrackBlocks(&ref.pChunks[k], &pRead->pBlocks[k]);
+    }
+
+    for (ref.nRow = 0; bMemory && (ref.nRow < pRead->dwIndexCount); ref.nRow += dwCount)
+    {
+        dwCount = pRead->dwIndexCount - (UINT32) ref.nRow;
+        if (dwCount > REFERENCE_SPAN_SIZE)
+            dwCount = REFERENCE_SPAN_SIZE;
+
+        th_ParallelFor(ref.nEntities, nThreads, fReferenceReadTask, &ref);
+        fCommonReference(&ref, ncols, dwCount, pdValues);
+        th_ParallelFor(ncols, nThreads, fReferenceWriteTask, &ref);
+    }
+
+    // Entities that could not be loaded (or whose reference could not be loaded) are 
+    // returned as zeros
+    for (i = 0; i < ncols; ++i)
+    {
+        pRead->pnResult[i] = bMemory ? fReferenceResult(&ref, i) : ns_LIBERROR;
+        pRead->pdwContCount[i] = ref.pChunks ? ref.pChunks[i].dwContCount : 0;
+        if (0 != pRead->pnResult[i])
+        {
+            memset((char *) pRead->pvData + i * pRead->nRows * cbValue, 0, pRead->nRows * cbValue);
+            if (pRead->pBlocks)
+                pRead->pBlocks[i].nBlocks = 0;
+        }
+    }
+
+    for (k = 0; ref.pChunks && (k < ref.nEntities); ++k)
+        fCloseChunks(&ref.pChunks[k]);
+    free(ref.pdwEntityID);
+    free(ref.pnPartner);
+    free(ref.pChunks);
+    free(ref.pnResult);
+    free(ref.pdReference);
+    free(ref.pdScratch);
+    free(pdValues);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read several analog entities into the columns of a matrix and report entities
+//          or indeces that do not exist
+// Inputs:  pRead - the read prepared by fInitAnalogRead
+//          ncols - number of elements in the array of entities (pRead->pdEntityID)
+//          nThreads - number of worker threads reading entities in parallel
+//          pdContCount - receives the number of continuous indeces of every entity
+//          pbFatal - set to TRUE if the library failed with an error other than a
+//                    non existing entity or index
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          pRead->pvData, pdContCount and pbFatal are filled.
+ns_RESULT fAnalogReadColumns(ANALOGREAD *pRead, size_t ncols, int nThreads, double *pdContCount, 
+                             BOOL *pbFatal)
+{
+    UINT32 i;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bPlain;
+    size_t cbColumn = pRead->nRows * fClassSize(pRead->classID);
+
+    *pbFatal = FALSE;
+
+    pRead->pdwContCount = calloc(ncols + 1, sizeof(UINT32));
+    pRead->pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+
+    // The anti-alias filter passes 80% of the band left after decimation and
+    // stops at its edge. It has 32 coefficients per decimation step, padded
+    // with zeros to a multiple of 4 for dsp_FirDecimate.
+    if (1 < pRead->dwDecimate)
+    {
+        pRead->nDelay = 16 * pRead->dwDecimate;
+        pRead->nTaps = (2 * pRead->nDelay + 1 + 3) & ~((size_t) 3);
+        pRead->pdTaps = calloc(pRead->nTaps, sizeof(double));
+        dsp_DesignLowpass(0.45 / pRead->dwDecimate, 2 * pRead->nDelay + 1, pRead->pdTaps);
+    }
+
+    // Probe the library before any worker thread calls into it
+    fLibraryIsThreadSafe();
+
+    // Plain reads of the same range of every entity are served from sidecars or the
+    // windows read ahead where possible
+    bPlain = (1 == pRead->dwDecimate) && !pRead->pFilter && (REFERENCE_NONE == pRead->nReference) &&
+             !pRead->pdwIndex && !pRead->pdwIndexCount && !pRead->pBlocks;
+    fWaitReadAhead();
+    if (bPlain)
+    {
+        pRead->pbServed = calloc(ncols + 1, sizeof(BOOL));
+        pRead->ppSidecar = fFindSidecars(pRead->hFile, pRead->pdEntityID, ncols);
+    }
+    for (i = 0; pRead->pbServed && (i < ncols); ++i)
+    {
+        if (pRead->ppSidecar && pRead->ppSidecar[i])
+            continue;
+        pRead->pbServed[i] = fServeReadAhead(pRead->hFile, (UINT32) pRead->pdEntityID[i], pRead->dwIndex,
+                                             pRead->dwIndexCount, pRead->classID, pRead->pdScale[i],
+                                             (char *) pRead->pvData + i * cbColumn, 
+                                             &pRead->pdwContCount[i]);
+        if (pRead->pbServed[i] && (mxDOUBLE_CLASS == pRead->classID))
+            fEnvelopeFeed(pRead->hFile, (UINT32) pRead->pdEntityID[i], pRead->dwIndex, 
+                          pRead->dwIndexCount, (double *) ((char *) pRead->pvData + i * cbColumn));
+    }
+
+    // The entities are read by the worker pool (or one after the other if only
+    // one thread is requested). Messages are only printed from this thread.
+    // Re-referenced entities depend on each other and are read side by side.
+    if (REFERENCE_NONE != pRead->nReference)
+        fReadReferenced(pRead, ncols, nThreads);
+    else
+        th_ParallelFor(ncols, nThreads, fAnalogDataTask, pRead);
+
+    // The windows after sequential reads are read in the background meanwhile;
+    // entities with a sidecar do not need them
+    for (i = 0; pRead->pbServed && (i < ncols); ++i)
+    {
+        if (pRead->ppSidecar && pRead->ppSidecar[i])
+            g_dSidecarHits += pRead->pbServed[i] ? 1 : 0;
+        else if (0 == pRead->pnResult[i])
+            fNoteRead(pRead->hFile, (UINT32) pRead->pdEntityID[i], pRead->dwIndex, pRead->dwIndexCount);
+    }
+    if (bPlain)
+        fWriteSidecars(pRead->hFile, pRead->pdEntityID, ncols, pRead->dwIndex, pRead->dwIndexCount, 
+                       pRead->classID, pRead->pvData, pRead->pdwContCount, pRead->pnResult, 
+                       pRead->ppSidecar, nThreads);
+    fStartReadAhead();
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = pRead->pnResult[i];
+
+        if (0 == nsresult)
+        {
+            *(pdContCount + i) = pRead->pdwContCount[i];
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogData).\n");
+            bEntity = FALSE;
+        }
+        else if (-7 == nsresult)
+        {
+            if (TRUE == bIndex)
+                mexPrintf("Some indeces do not exist (ns_GetAnalogData).\n");
+            bIndex = FALSE;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetAnalogData!\n");
+            *pbFatal = TRUE;
+            break;
+        }
+    }
+
+    free(pRead->pdwContCount);
+    free(pRead->pnResult);
+    free(pRead->pdTaps);
+    free(pRead->pbServed);
+    free(pRead->ppSidecar);
+    pRead->pdwContCount = 0;
+    pRead->pnResult = 0;
+    pRead->pdTaps = 0;
+    pRead->pbServed = 0;
+    pRead->ppSidecar = 0;
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the value of one raw count of several analog entities
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities
+//          classID - class of the data; only int16 data is scaled
+//          pdScale - receives the scale of every entity: the resolution of the entity for
+//                    int16 data, 1 otherwise or if the resolution is not known
+void fAnalogScale(UINT32 hFile, size_t ncols, double *pdEntityID, mxClassID classID, double *pdScale)
+{
+    ns_ANALOGINFO nsAnalogInfo;
+    UINT32 i;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        pdScale[i] = 1;
+        if ((mxINT16_CLASS == classID) &&
+            (0 == ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo,
+                                   (UINT32) sizeof(nsAnalogInfo))) &&
+            (0 < nsAnalogInfo.dResolution))
+        {
+            pdScale[i] = nsAnalogInfo.dResolution;
+        }
+    }
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Convert the continuous blocks found by an analog read into Matlab format
+//          Entities that could not be read have no blocks.
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities that were read
+//          dwEndIndex - one past the last index that was read
+//          pBlocks - the blocks of every entity
+// Outputs: mxArray * - cell array with a row [start index, index count, start time] per
+//          block for every entity
+mxArray *fBlockTable(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwEndIndex, 
+                     ANALOGBLOCKS *pBlocks)
+{
+    mxArray *pmxBlocks;
+    mxArray *pmxTable;
+    double *pdTable;
+    size_t nBlocks;
+    size_t i;
+    size_t k;
+    BOOL bOutOfMemory = FALSE;
+
+    pmxBlocks = mxCreateCellMatrix(1, ncols);
+    for (i = 0; i < ncols; ++i)
+    {
+        nBlocks = pBlocks[i].nBlocks;
+        if (pBlocks[i].bOutOfMemory)
+            bOutOfMemory = TRUE;
+
+        pmxTable = mxCreateDoubleMatrix(nBlocks, 3, mxREAL);
+        pdTable = mxGetPr(pmxTable);
+        for (k = 0; k < nBlocks; ++k)
+        {
+            pdTable[k] = pBlocks[i].pdwStart[k];
+            pdTable[nBlocks + k] = ((k + 1 < nBlocks) ? pBlocks[i].pdwStart[k + 1] : dwEndIndex) - 
+                                   pBlocks[i].pdwStart[k];
+            if (0 != ns_GetTimeByIndex(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], 
+                                       pBlocks[i].pdwStart[k], &pdTable[2 * nBlocks + k]))
+                pdTable[2 * nBlocks + k] = mxGetNaN();
+        }
+        mxSetCell(pmxBlocks, i, pmxTable);
+    }
+
+    if (bOutOfMemory)
+        mexPrintf("Not enough memory to store all blocks (ns_GetAnalogData).\n");
+    return(pmxBlocks);
+}
+
+// Author & Date: Almut Branner, 2/7/2003
+// Purpose: Get analog data and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          dwIndex - index in the particular entity
+//          dwIndexCount - How many indeces are loaded
+//          pmxOptions - options structure (may be empty)
+//                       Threads - number of worker threads reading entities in
+//                                 parallel (default 1, 0 = one per processor)
+//                       Class - class of the data: 'double' (default), 'single' or
+//                               'int16' (raw counts of the resolution of the entity)
+//                       Decimate - decimation factor; the data is low pass filtered and
+//                                  only every Decimate-th value is returned (default 1)
+//                       Blocks - find all continuous blocks of the index range (default false)
+//                       Reference - subtract the mean ('average') or median ('median')
+//                                   of all entities from every entity, or a vector with
+//                                   the entity to subtract from every entity (NaN = none)
+//                       Filter - IIR filter applied to the data, a row [b0 b1 b2 a0 a1 a2]
+//                                per second order section
+//                       ZeroPhase - filter forward and backward (default false)
+//          ppmxContCount - double pointer to the mex converted number of how
+//                          many continuous indeces (rows of decimated data) were loaded
+//          ppmxData - double pointer to the mex converted data structure
+//          ppmxScale - double pointer to the mex converted value of one count of the
+//                      data of every entity
+//          ppmxBlocks - double pointer to the mex converted blocks of every entity: a cell
+//                       per entity holding a row [start index, index count, start time]
+//                       per block (empty if the Blocks option is not set)
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxContCount is filled.
+//          ppmxData is filled.
+//          ppmxScale is filled.
+//          ppmxBlocks is filled.
+ns_RESULT fAnalogData(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                      UINT32 dwIndexCount, const mxArray *pmxOptions, mxArray **ppmxContCount, 
+                      mxArray **ppmxData, mxArray **ppmxScale, mxArray **ppmxBlocks)
+{
+    ANALOGREAD read;
+    ns_RESULT nsresult;
+    mxClassID classID;
+    UINT32 dwDecimate;
+    int nReference;
+    double *pdReference;
+    ANALOGFILTER filter;
+    size_t nRows;
+    size_t i;
+    BOOL bFatal;
+    BOOL bValid;
+
+    memset(&filter, 0, sizeof(filter));
+    bValid = fGetAnalogOptions(pmxOptions, &classID, &dwDecimate);
+    if (bValid && !fGetReferenceOption(pmxOptions, ncols, &nReference, &pdReference))
+    {
+        mexPrintf("Reference option must be 'average', 'median' or one EntityID or NaN per entity.\n");
+        bValid = FALSE;
+    }
+    if (bValid && (REFERENCE_NONE != nReference) && (1 < dwDecimate))
+    {
+        mexPrintf("Reference and Decimate options cannot be combined (ns_GetAnalogData).\n");
+        bValid = FALSE;
+    }
+    if (bValid && !fGetFilterOption(pmxOptions, ncols, &filter))
+        bValid = FALSE;
+    if (bValid && filter.pdSos && ((1 < dwDecimate) || (REFERENCE_NONE != nReference)))
+    {
+        mexPrintf("Filter option cannot be combined with Decimate or Reference (ns_GetAnalogData).\n");
+        bValid = FALSE;
+    }
+    if (!bValid)
+    {
+        fFreeFilter(&filter);
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        *ppmxBlocks = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    nRows = ((size_t) dwIndexCount + dwDecimate - 1) / dwDecimate;
+    
+    // Allocate the output up front so that the library can write each entity
+    // straight into its column of the result instead of into a temporary buffer.
+    // Decimated data is filtered on the way, only the decimated values are allocated.
+    *ppmxContCount = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+    *ppmxData = mxCreateNumericMatrix(nRows, ncols, classID, mxREAL);
+    *ppmxScale = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+
+    fAnalogScale(hFile, ncols, pdEntityID, classID, mxGetPr(*ppmxScale));
+
+    fInitAnalogRead(&read, hFile, pdEntityID, dwIndex, dwIndexCount, classID, mxGetData(*ppmxData),
+                    mxGetPr(*ppmxScale));
+    read.dwDecimate = dwDecimate;
+    read.nRows = nRows;
+    read.nReference = nReference;
+    read.pdReference = pdReference;
+    if (filter.pdSos)
+        read.pFilter = &filter;
+    if (0 != fGetOption(pmxOptions, "Blocks", 0))
+        read.pBlocks = calloc(ncols + 1, sizeof(ANALOGBLOCKS));
+
+    nsresult = fAnalogReadColumns(&read, ncols, fGetThreadOption(pmxOptions), mxGetPr(*ppmxContCount), 
+                                  &bFatal);
+    if (bFatal)
+    {
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        *ppmxBlocks = mxCreateString("");
+    }
+    else if (!read.pBlocks)
+    {
+        *ppmxBlocks = mxCreateDoubleMatrix(0, 0, mxREAL);
+    }
+    else
+    {
+        *ppmxBlocks = fBlockTable(hFile, ncols, pdEntityID, dwIndex + dwIndexCount, read.pBlocks);
+    }
+
+    if (read.pBlocks)
+    {
+        for (i = 0; i < ncols; ++i)
+            free(read.pBlocks[i].pdwStart);
+        free(read.pBlocks);
+    }
+    fFreeFilter(&filter);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find the indeces of an analog entity within a time window: from the first index
+//          at or after the start time to the last index at or before the end time
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - the analog entity
+//          dStartTime - start of the time window
+//          dEndTime - end of the time window
+//          pdwIndex - receives the first index in the window
+//          pdwIndexCount - receives the number of indeces in the window (0 if there are none)
+//          pdFirstTime - receives the time of the first index in the window
+//          pdSampleRate - receives the sample rate of the entity
+// Outputs: ns_RESULT - what error was returned by ns_GetAnalogInfo (should be 0)
+ns_RESULT fIndexRangeByTime(UINT32 hFile, UINT32 dwEntityID, double dStartTime, double dEndTime,
+                            UINT32 *pdwIndex, UINT32 *pdwIndexCount, double *pdFirstTime, 
+                            double *pdSampleRate)
+{
+    ns_ANALOGINFO nsAnalogInfo;
+    UINT32 dwLastIndex;
+    double dLastTime;
+    ns_RESULT nsresult;
+
+    *pdwIndex = 0;
+    *pdwIndexCount = 0;
+    *pdFirstTime = 0;
+    *pdSampleRate = 0;
+
+    nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, dwEntityID, &nsAnalogInfo, 
+                                (UINT32) sizeof(nsAnalogInfo));
+    if (0 != nsresult)
+        return(nsresult);
+    *pdSampleRate = nsAnalogInfo.dSampleRate;
+
+    // Libraries clamp the index to the first or last index of the entity, so the
+    // times of both ends are checked against the window
+    if ((0 == ns_GetIndexByTime(g_nsDllHandle, hFile, dwEntityID, dStartTime, ns_AFTER, pdwIndex)) &&
+        (0 == ns_GetIndexByTime(g_nsDllHandle, hFile, dwEntityID, dEndTime, ns_BEFORE, &dwLastIndex)) &&
+        (dwLastIndex >= *pdwIndex) &&
+        (0 == ns_GetTimeByIndex(g_nsDllHandle, hFile, dwEntityID, *pdwIndex, pdFirstTime)) &&
+        (0 == ns_GetTimeByIndex(g_nsDllHandle, hFile, dwEntityID, dwLastIndex, &dLastTime)) &&
+        (*pdFirstTime <= dEndTime) && (dLastTime >= dStartTime))
+    {
+        *pdwIndexCount = dwLastIndex - *pdwIndex + 1;
+    }
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the analog data of several entities within a time window and convert it into
+//          Matlab format. The index range is resolved for every entity, so entities with
+//          different sample rates are read correctly with one call.
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for
+//          dStartTime - start of the time window
+//          dEndTime - end of the time window
+//          pmxOptions - options structure (may be empty), see fAnalogData
+//          ppmxContCount - double pointer to the mex converted number of how
+//                          many continuous indeces were loaded
+//          ppmxData - double pointer to the mex converted data structure; one column
+//                     per entity, padded with NaN (0 for int16 data) below the data
+//                     of entities with fewer indeces in the window
+//          ppmxTime - double pointer to the mex converted time of every row of ppmxData;
+//                     a single column if all entities start at the same time with the
+//                     same sample rate, one column per entity otherwise
+//          ppmxStartIndex - double pointer to the mex converted first index of every
+//                           entity (NaN if the entity has no data in the window)
+//          ppmxIndexCount - double pointer to the mex converted number of indeces of
+//                           every entity in the window
+//          ppmxScale - double pointer to the mex converted value of one count of the
+//                      data of every entity
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxContCount, ppmxData, ppmxTime, ppmxStartIndex, ppmxIndexCount and
+//          ppmxScale are filled.
+ns_RESULT fAnalogDataByTime(UINT32 hFile, size_t ncols, double *pdEntityID, double dStartTime,
+                            double dEndTime, const mxArray *pmxOptions, mxArray **ppmxContCount,
+                            mxArray **ppmxData, mxArray **ppmxTime, mxArray **ppmxStartIndex,
+                            mxArray **ppmxIndexCount, mxArray **ppmxScale)
+{
+    ANALOGREAD read;
+    UINT32 *pdwIndex;
+    UINT32 *pdwIndexCount;
+    double *pdFirstTime;
+    double *pdSampleRate;
+    double *pdStartIndex;
+    double *pdIndexCount;
+    double *pdTime;
+    size_t nRows = 0;
+    size_t nTimeCols = 1;
+    size_t nReference = 0;
+    size_t nCount;
+    size_t i;
+    size_t k;
+    mxClassID classID;
+    UINT32 dwDecimate;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bFatal;
+
+    if (!fGetAnalogOptions(pmxOptions, &classID, &dwDecimate))
+    {
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxStartIndex = mxCreateString("");
+        *ppmxIndexCount = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    if (!(dStartTime <= dEndTime))
+    {
+        mexPrintf("StartTime must not be after EndTime (ns_GetAnalogDataByTime).\n");
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxStartIndex = mxCreateString("");
+        *ppmxIndexCount = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+    pdFirstTime = calloc(ncols + 1, sizeof(double));
+    pdSampleRate = calloc(ncols + 1, sizeof(double));
+
+    *ppmxStartIndex = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+    *ppmxIndexCount = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+    pdStartIndex = mxGetPr(*ppmxStartIndex);
+    pdIndexCount = mxGetPr(*ppmxIndexCount);
+
+    // Resolve the index range of every entity: from the first index at or after the
+    // start time to the last index at or before the end time
+    for (i = 0; i < ncols; ++i)
+    {
+        pdStartIndex[i] = mxGetNaN();
+
+        nsresult = fIndexRangeByTime(hFile, (UINT32) pdEntityID[i], dStartTime, dEndTime, &pdwIndex[i],
+                                     &pdwIndexCount[i], &pdFirstTime[i], &pdSampleRate[i]);
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogDataByTime).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_GetAnalogDataByTime)\n");
+            break;
+        }
+
+        if (0 < pdwIndexCount[i])
+            pdStartIndex[i] = pdwIndex[i];
+        pdIndexCount[i] = pdwIndexCount[i];
+
+        if (pdwIndexCount[i] > nRows)
+        {
+            nRows = pdwIndexCount[i];
+            nReference = i;
+        }
+    }
+
+    // Decimated data has one row per dwDecimate indeces
+    nRows = (nRows + dwDecimate - 1) / dwDecimate;
+
+    if ((0 != nsresult) && (-5 != nsresult))
+    {
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxStartIndex = mxCreateString("");
+        *ppmxIndexCount = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+    }
+    else
+    {
+        *ppmxContCount = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+        *ppmxData = mxCreateNumericMatrix(nRows, ncols, classID, mxREAL);
+        *ppmxScale = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+
+        fAnalogScale(hFile, ncols, pdEntityID, classID, mxGetPr(*ppmxScale));
+
+        fInitAnalogRead(&read, hFile, pdEntityID, 0, 0, classID, mxGetData(*ppmxData), 
+                        mxGetPr(*ppmxScale));
+        read.pdwIndex = pdwIndex;
+        read.pdwIndexCount = pdwIndexCount;
+        read.nRows = nRows;
+        read.dPad = mxGetNaN();
+        read.dwDecimate = dwDecimate;
+
+        nsresult = fAnalogReadColumns(&read, ncols, fGetThreadOption(pmxOptions), 
+                                      mxGetPr(*ppmxContCount), &bFatal);
+        if (bFatal)
+        {
+            *ppmxContCount = mxCreateString("");
+            *ppmxData = mxCreateString("");
+            *ppmxTime = mxCreateString("");
+            *ppmxStartIndex = mxCreateString("");
+            *ppmxIndexCount = mxCreateString("");
+            *ppmxScale = mxCreateString("");
+        }
+        else
+        {
+            // Entities that start at the same time with the same sample rate share one
+            // time column. Gaps in the data are not reflected in the time (see ContCount).
+            for (i = 0; i < ncols; ++i)
+            {
+                if ((0 < pdwIndexCount[i]) && ((pdFirstTime[i] != pdFirstTime[nReference]) || 
+                                               (pdSampleRate[i] != pdSampleRate[nReference])))
+                    nTimeCols = ncols;
+            }
+
+            *ppmxTime = mxCreateDoubleMatrix(nRows, nTimeCols, mxREAL);
+            pdTime = mxGetPr(*ppmxTime);
+            for (i = 0; i < nTimeCols; ++i)
+            {
+                size_t nEntity = (1 == nTimeCols) ? nReference : i;
+
+                nCount = ((size_t) pdwIndexCount[nEntity] + dwDecimate - 1) / dwDecimate;
+                for (k = 0; k < nRows; ++k)
+                {
+                    if (k >= nCount)
+                        pdTime[i * nRows + k] = mxGetNaN();
+                    else if (0 == k)
+                        pdTime[i * nRows + k] = pdFirstTime[nEntity];
+                    else if (0 < pdSampleRate[nEntity])
+                        pdTime[i * nRows + k] = pdFirstTime[nEntity] + k * dwDecimate / pdSampleRate[nEntity];
+                    else
+                        pdTime[i * nRows + k] = mxGetNaN();
+                }
+            }
+
+            if (FALSE == bEntity)
+                nsresult = ns_BADENTITY;
+        }
+    }
+
+    free(pdwIndex);
+    free(pdwIndexCount);
+    free(pdFirstTime);
+    free(pdSampleRate);
+    return(nsresult);
+}
+
+// A query of the envelopes of several entities, see fAnalogEnvelope
+typedef struct
+{
+    ENVELOPE **ppEnvelope;    // envelope of every entity (0 if it has no data in the window)
+    UINT32 *pdwIndex;         // first index of every entity in the window
+    UINT32 *pdwIndexCount;    // number of indeces of every entity in the window
+    double *pdFirstTime;      // time of the first index of every entity in the window
+    double *pdSampleRate;     // sample rate of every entity
+    double dStartTime;        // start of the window
+    double dColumnTime;       // time covered by one column
+    size_t nColumns;          // number of columns of the window
+    double dNaN;              // value of columns without data
+    double *pdMin;            // minimum of every column, one matrix column per entity
+    double *pdMax;            // maximum of every column, one matrix column per entity
+    ns_RESULT *pnResult;      // result of every entity
+} ENVELOPEQUERY;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the minimum and maximum of every column of one entity from its data, for
+//          columns narrower than a bin of the envelope. May be called from worker threads.
+// Inputs:  pQuery - the query
+//          nEntity - which entity to compute
+//          pdwEdge - first index of every column and one past the last index of the last
+//                    column, counted from the first index of the entity in the window
+//          pdMin - receives the minimum of every column with data
+//          pdMax - receives the maximum of every column with data
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+ns_RESULT fEnvelopeFromData(ENVELOPEQUERY *pQuery, size_t nEntity, const UINT32 *pdwEdge, 
+                            double *pdMin, double *pdMax)
+{
+    ENVELOPE *pEnv = pQuery->ppEnvelope[nEntity];
+    ANALOGCHUNKS chunks;
+    size_t nColumn = 0;
+    UINT32 dwOffset = 0;
+    UINT32 i;
+    double dValue;
+    ns_RESULT nsresult;
+
+    if (!fOpenChunks(&chunks, pEnv->hFile, pEnv->dwEntityID, pQuery->pdwIndex[nEntity], 
+                     pQuery->pdwIndexCount[nEntity], ANALOG_CHUNK_SIZE))
+    {
+        fCloseChunks(&chunks);
+        return(ns_LIBERROR);
+    }
+
+    // Columns without indeces are skipped
+    while ((0 == (nsresult = fNextChunk(&chunks))) && (0 < chunks.dwCount))
+    {
+        for (i = 0; i < chunks.dwCount; ++i, ++dwOffset)
+        {
+            while (dwOffset >= pdwEdge[nColumn + 1])
+                ++nColumn;
+
+            dValue = chunks.pdChunk[i];
+            if (dwOffset == pdwEdge[nColumn])
+            {
+                pdMin[nColumn] = dValue;
+                pdMax[nColumn] = dValue;
+            }
+            else if (dValue < pdMin[nColumn])
+                pdMin[nColumn] = dValue;
+            else if (dValue > pdMax[nColumn])
+                pdMax[nColumn] = dValue;
+        }
+    }
+
+    fCloseChunks(&chunks);
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the minimum and maximum of every column of one entity of an envelope query
+//          Columns of at least one bin are taken from the envelope, computing the bins that
+//          are still missing; narrower columns are computed from the data.
+// Inputs:  pvContext - the ENVELOPEQUERY describing the request
+//          nEntity - which entity to compute
+// Outputs: pQuery->pdMin, pQuery->pdMax and pQuery->pnResult[nEntity] are filled
+void fAnalogEnvelopeTask(void *pvContext, size_t nEntity)
+{
+    ENVELOPEQUERY *pQuery = (ENVELOPEQUERY *) pvContext;
+    ENVELOPE *pEnv = pQuery->ppEnvelope[nEntity];
+    size_t nColumns = pQuery->nColumns;
+    double *pdMin = pQuery->pdMin + nEntity * nColumns;
+    double *pdMax = pQuery->pdMax + nEntity * nColumns;
+    UINT32 dwIndex = pQuery->pdwIndex[nEntity];
+    UINT32 dwIndexCount = pQuery->pdwIndexCount[nEntity];
+    double dSampleRate = pQuery->pdSampleRate[nEntity];
+    double dPerColumn = pQuery->dColumnTime * dSampleRate;
+    double dOffset;
+    double *pdBuffer;
+    UINT32 *pdwEdge;
+    size_t nLevel = 0;
+    size_t nScale = 1;
+    size_t nFirst;
+    size_t nLast;
+    size_t i;
+    ns_RESULT nsresult;
+
+    for (i = 0; i < nColumns; ++i)
+        pdMin[i] = pdMax[i] = pQuery->dNaN;
+    pQuery->pnResult[nEntity] = ns_OK;
+    if (!pEnv)
+        return;
+
+    pdwEdge = malloc((nColumns + 1) * sizeof(UINT32));
+    if (!pdwEdge)
+    {
+        pQuery->pnResult[nEntity] = ns_LIBERROR;
+        return;
+    }
+
+    // Column i holds the indeces pdwEdge[i] ... pdwEdge[i + 1] - 1 (counted from dwIndex),
+    // i.e. those at or after the start time of the column
+    for (i = 0; i < nColumns; ++i)
+    {
+        dOffset = ceil((pQuery->dStartTime + i * pQuery->dColumnTime - pQuery->pdFirstTime[nEntity]) * 
+                       dSampleRate - 1e-6);
+        if (dOffset <= 0)
+            pdwEdge[i] = 0;
+        else if (dOffset >= dwIndexCount)
+            pdwEdge[i] = dwIndexCount;
+        else
+            pdwEdge[i] = (UINT32) dOffset;
+    }
+    pdwEdge[nColumns] = dwIndexCount;
+
+    if (dPerColumn < ENV_BASE_BIN)
+    {
+        nsresult = fEnvelopeFromData(pQuery, nEntity, pdwEdge, pdMin, pdMax);
+    }
+    else
+    {
+        // Use the coarsest level whose bins are not wider than a column. Columns are
+        // resolved to bins of level 0, i.e. they may include up to ENV_BASE_BIN - 1
+        // indeces of their neighbours.
+        while ((nLevel + 1 < pEnv->nLevels) && (ENV_BASE_BIN * (double) nScale * ENV_FACTOR <= dPerColumn))
+        {
+            ++nLevel;
+            nScale *= ENV_FACTOR;
+        }
+        nFirst = dwIndex / ENV_BASE_BIN;
+        nLast = (dwIndex + dwIndexCount - 1) / ENV_BASE_BIN + 1;
+
+        pdBuffer = malloc(ENV_TILE_SIZE * sizeof(double));
+
+        th_MutexLock(&pEnv->mutex);
+        nsresult = ns_LIBERROR;
+        if (pdBuffer)
+            nsresult = fEnvelopeLevel(pEnv, nLevel, nFirst / nScale, (nLast + nScale - 1) / nScale, pdBuffer);
+        for (i = 0; (0 == nsresult) && (i < nColumns); ++i)
+        {
+            if (pdwEdge[i] < pdwEdge[i + 1])
+                fEnvelopeRange(pEnv, nLevel, (dwIndex + pdwEdge[i]) / ENV_BASE_BIN, 
+                               (dwIndex + pdwEdge[i + 1] - 1) / ENV_BASE_BIN + 1, &pdMin[i], &pdMax[i]);
+        }
+        th_MutexUnlock(&pEnv->mutex);
+
+        free(pdBuffer);
+    }
+
+    // Entities that could not be computed are returned as NaN
+    if (0 != nsresult)
+    {
+        for (i = 0; i < nColumns; ++i)
+            pdMin[i] = pdMax[i] = pQuery->dNaN;
+    }
+
+    free(pdwEdge);
+    pQuery->pnResult[nEntity] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the minimum and maximum of the analog data of several entities for every
+//          column of a display of a time window, e.g. to draw the data at any zoom level.
+//          The values are taken from the envelopes of the entities, which are built
+//          as the data is queried.
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for
+//          dStartTime - start of the time window
+//          dEndTime - end of the time window
+//          nColumns - number of columns the window is divided into
+//          pmxOptions - options structure (may be empty)
+//                       Threads - number of worker threads computing entities in
+//                                 parallel (default 1, 0 = one per processor)
+//                       Sidecar - keep the envelopes in sidecar files next to the
+//                                 data file (default false)
+//          ppmxMin - double pointer to the mex converted minimum of every column; one
+//                    matrix column per entity, NaN for columns without data
+//          ppmxMax - double pointer to the mex converted maximum of every column
+//          ppmxTime - double pointer to the mex converted center time of every column
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxMin, ppmxMax and ppmxTime are filled.
+ns_RESULT fAnalogEnvelope(UINT32 hFile, size_t ncols, double *pdEntityID, double dStartTime,
+                          double dEndTime, size_t nColumns, const mxArray *pmxOptions, 
+                          mxArray **ppmxMin, mxArray **ppmxMax, mxArray **ppmxTime)
+{
+    ENVELOPEQUERY query;
+    ns_ENTITYINFO nsEntityInfo;
+    double *pdTime;
+    BOOL bSidecar = (0 != fGetOption(pmxOptions, "Sidecar", 0));
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bFatal = FALSE;
+    ns_RESULT nsresult = ns_OK;
+    size_t i;
+
+    if (!(dStartTime < dEndTime))
+    {
+        mexPrintf("StartTime must be before EndTime (ns_GetAnalogEnvelope).\n");
+        *ppmxMin = mxCreateString("");
+        *ppmxMax = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    memset(&query, 0, sizeof(query));
+    query.ppEnvelope = calloc(ncols + 1, sizeof(ENVELOPE *));
+    query.pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    query.pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+    query.pdFirstTime = calloc(ncols + 1, sizeof(double));
+    query.pdSampleRate = calloc(ncols + 1, sizeof(double));
+    query.pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+    query.dStartTime = dStartTime;
+    query.dColumnTime = (dEndTime - dStartTime) / nColumns;
+    query.nColumns = nColumns;
+    query.dNaN = mxGetNaN();
+
+    // Resolve the index range of every entity and look up its envelope. Envelopes
+    // are only created here, while no worker threads run.
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = fIndexRangeByTime(hFile, (UINT32) pdEntityID[i], dStartTime, dEndTime, 
+                                     &query.pdwIndex[i], &query.pdwIndexCount[i], 
+                                     &query.pdFirstTime[i], &query.pdSampleRate[i]);
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogEnvelope).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_GetAnalogEnvelope)\n");
+            break;
+        }
+        if (0 == query.pdwIndexCount[i])
+            continue;
+
+        query.ppEnvelope[i] = fFindEnvelope(hFile, (UINT32) pdEntityID[i]);
+        if (query.ppEnvelope[i])
+            continue;
+
+        nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo,
+                                    (UINT32) sizeof(nsEntityInfo));
+        if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetEntityInfo!\n(Required for ns_GetAnalogEnvelope)\n");
+            break;
+        }
+        query.ppEnvelope[i] = fCreateEnvelope(hFile, (UINT32) pdEntityID[i], nsEntityInfo.dwItemCount);
+        if (!query.ppEnvelope[i])
+        {
+            mexPrintf("Not enough memory for the envelope (ns_GetAnalogEnvelope).\n");
+            nsresult = ns_LIBERROR;
+            break;
+        }
+        if (bSidecar)
+            fLoadEnvelope(query.ppEnvelope[i]);
+    }
+
+    if ((0 == nsresult) || (-5 == nsresult))
+    {
+        *ppmxMin = mxCreateDoubleMatrix(nColumns, ncols, mxREAL);
+        *ppmxMax = mxCreateDoubleMatrix(nColumns, ncols, mxREAL);
+        query.pdMin = mxGetPr(*ppmxMin);
+        query.pdMax = mxGetPr(*ppmxMax);
+
+        // Probe the library before any worker thread calls into it
+        fLibraryIsThreadSafe();
+        th_ParallelFor(ncols, fGetThreadOption(pmxOptions), fAnalogEnvelopeTask, &query);
+
+        nsresult = (TRUE == bEntity) ? ns_OK : ns_BADENTITY;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (-7 == query.pnResult[i])
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetAnalogEnvelope).\n");
+                bIndex = FALSE;
+                nsresult = ns_BADINDEX;
+            }
+            else if (0 != query.pnResult[i])
+            {
+                mexPrintf("There was an error running ns_GetAnalogData!\n(Required for ns_GetAnalogEnvelope)\n");
+                nsresult = query.pnResult[i];
+                bFatal = TRUE;
+                break;
+            }
+        }
+
+        if (bSidecar)
+        {
+            for (i = 0; i < ncols; ++i)
+            {
+                if (query.ppEnvelope[i])
+                    fSaveEnvelope(query.ppEnvelope[i]);
+            }
+        }
+    }
+    else
+    {
+        bFatal = TRUE;
+    }
+
+    if (bFatal)
+    {
+        *ppmxMin = mxCreateString("");
+        *ppmxMax = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+    }
+    else
+    {
+        *ppmxTime = mxCreateDoubleMatrix(nColumns, 1, mxREAL);
+        pdTime = mxGetPr(*ppmxTime);
+        for (i = 0; i < nColumns; ++i)
+            pdTime[i] = dStartTime + (i + 0.5) * query.dColumnTime;
+    }
+
+    free(query.ppEnvelope);
+    free(query.pdwIndex);
+    free(query.pdwIndexCount);
+    free(query.pdFirstTime);
+    free(query.pdSampleRate);
+    free(query.pnResult);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Event-triggered epochs
+//
+//      An epoch is a window of analog data around a trigger time, e.g. the
+//      time of an event. The windows of all trials of an entity are sorted
+//      and windows that overlap or lie close together are read with one
+//      call of the library.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Largest number of indeces read at once when windows are merged. Single windows
+// that are longer are still read in one piece.
+#define EPOCH_MERGE_SIZE (16 * ANALOG_CHUNK_SIZE)
+
+// The indeces of one trial of an entity, see fAnalogEpochs
+typedef struct
+{
+    UINT32 dwIndex;           // first index of the window that exists
+    UINT32 dwIndexCount;      // number of indeces of the window that exist (0 = none)
+    size_t nRow;              // row of dwIndex within the epoch
+    size_t nTrial;            // trial of the window
+} EPOCHWINDOW;
+
+// A read of the epochs of several entities, see fAnalogEpochs
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    EPOCHWINDOW *pWindows;    // window of every trial, nTrials per entity
+    size_t nTrials;           // number of trials
+    size_t nRows;             // rows of every epoch
+    mxClassID classID;        // class of the output array
+    void *pvData;             // output array, nRows x nTrials per entity
+    double *pdScale;          // value of one raw count of every entity (int16 output)
+    double dPad;              // value of rows without data
+    ns_RESULT *pnResult;      // result of every entity
+} EPOCHREAD;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Fill samples of an output array with one value
+// Inputs:  dValue - the value
+//          nCount - number of samples
+//          classID - class of the output (mxDOUBLE_CLASS, mxSINGLE_CLASS or mxINT16_CLASS)
+//          pvDst - receives nCount values of the given class
+void fFillSamples(double dValue, size_t nCount, mxClassID classID, void *pvDst)
+{
+    size_t cbValue = fClassSize(classID);
+    size_t nDone;
+
+    if (0 == nCount)
+        return;
+
+    // The filled part is copied onto the rest, doubling it every time
+    fConvertSamples(&dValue, 1, classID, 1, pvDst);
+    for (nDone = 1; nDone < nCount; nDone *= 2)
+        memcpy((char *) pvDst + nDone * cbValue, pvDst, 
+               ((nDone < nCount - nDone) ? nDone : nCount - nDone) * cbValue);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Order the windows of an entity by their first index (qsort callback)
+int fCompareWindows(const void *pvA, const void *pvB)
+{
+    const EPOCHWINDOW *pA = (const EPOCHWINDOW *) pvA;
+    const EPOCHWINDOW *pB = (const EPOCHWINDOW *) pvB;
+
+    if (pA->dwIndex != pB->dwIndex)
+        return (pA->dwIndex < pB->dwIndex) ? -1 : 1;
+    return (pA->nTrial < pB->nTrial) ? -1 : (pA->nTrial > pB->nTrial);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the epochs of every trial of one entity. Windows are merged into reads of
+//          up to EPOCH_MERGE_SIZE indeces as long as the indeces between them are fewer
+//          than the rows of an epoch. May be called from worker threads.
+// Inputs:  pvContext - the EPOCHREAD describing the request
+//          nEntity - which entity to read
+// Outputs: the epochs of the entity in pRead->pvData and pRead->pnResult[nEntity] are filled
+void fAnalogEpochsTask(void *pvContext, size_t nEntity)
+{
+    EPOCHREAD *pRead = (EPOCHREAD *) pvContext;
+    EPOCHWINDOW *pWindows = pRead->pWindows + nEntity * pRead->nTrials;
+    UINT32 dwEntityID = (UINT32) pRead->pdEntityID[nEntity];
+    size_t cbValue = fClassSize(pRead->classID);
+    size_t nRows = pRead->nRows;
+    char *pcEntity = (char *) pRead->pvData + nEntity * pRead->nTrials * nRows * cbValue;
+    double *pdBuffer = 0;
+    size_t nBuffer = 0;
+    size_t nFirst;
+    size_t nLast;
+    size_t k;
+    UINT32 dwIndex;
+    UINT32 dwEnd;
+    UINT32 dwContCount;
+    ns_RESULT nsresult = ns_OK;
+
+    // Rows without data keep the pad value
+    fFillSamples(pRead->dPad, pRead->nTrials * nRows, pRead->classID, pcEntity);
+
+    qsort(pWindows, pRead->nTrials, sizeof(EPOCHWINDOW), fCompareWindows);
+
+    // Trials without data have no indeces and are skipped
+    for (nFirst = 0; (0 == nsresult) && (nFirst < pRead->nTrials); nFirst = nLast)
+    {
+        nLast = nFirst + 1;
+        if (0 == pWindows[nFirst].dwIndexCount)
+            continue;
+
+        dwIndex = pWindows[nFirst].dwIndex;
+        dwEnd = dwIndex + pWindows[nFirst].dwIndexCount;
+        while ((nLast < pRead->nTrials) && ((size_t) pWindows[nLast].dwIndex < (size_t) dwEnd + nRows) &&
+               (MAX(dwEnd, pWindows[nLast].dwIndex + pWindows[nLast].dwIndexCount) - dwIndex <= 
+                EPOCH_MERGE_SIZE))
+        {
+            dwEnd = MAX(dwEnd, pWindows[nLast].dwIndex + pWindows[nLast].dwIndexCount);
+            ++nLast;
+        }
+
+        if (dwEnd - dwIndex > nBuffer)
+        {
+            free(pdBuffer);
+            nBuffer = dwEnd - dwIndex;
+            pdBuffer = malloc(nBuffer * sizeof(double));
+            if (!pdBuffer)
+            {
+                nBuffer = 0;
+                nsresult = ns_LIBERROR;
+                break;
+            }
+        }
+
+        nsresult = fReadAnalog(pRead->hFile, dwEntityID, dwIndex, dwEnd - dwIndex, &dwContCount, 
+                               pdBuffer);
+        for (k = nFirst; (0 == nsresult) && (k < nLast); ++k)
+        {
+            fConvertSamples(pdBuffer + (pWindows[k].dwIndex - dwIndex), pWindows[k].dwIndexCount, 
+                            pRead->classID, pRead->pdScale[nEntity], 
+                            pcEntity + (pWindows[k].nTrial * nRows + pWindows[k].nRow) * cbValue);
+        }
+    }
+
+    // Entities that could not be read are returned as pad values only
+    if (0 != nsresult)
+        fFillSamples(pRead->dPad, pRead->nTrials * nRows, pRead->classID, pcEntity);
+
+    free(pdBuffer);
+    pRead->pnResult[nEntity] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get windows of analog data around trigger times from several entities and convert
+//          them into Matlab format. The index of every trigger is resolved for every entity,
+//          so entities with different sample rates are read correctly with one call.
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for
+//          nTrials - number of trigger times
+//          pdTrigger - pointer to the array of trigger times
+//          dPreTime - time of the window before every trigger
+//          dPostTime - time of the window after every trigger
+//          pmxOptions - options structure (may be empty)
+//                       Threads - number of worker threads reading entities in
+//                                 parallel (default 1, 0 = one per processor)
+//                       Class - class of the data: 'double' (default), 'single' or 'int16'
+//          ppmxData - double pointer to the mex converted data structure; the samples of
+//                     every trial and entity (samples x trials x entities), padded with NaN
+//                     (0 for int16 data) where the window has no data
+//          ppmxTime - double pointer to the mex converted time of every sample relative to
+//                     the trigger; a single column if all entities have the same sample
+//                     rate, one column per entity otherwise
+//          ppmxScale - double pointer to the mex converted value of one count of the
+//                      data of every entity
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxData, ppmxTime and ppmxScale are filled.
+ns_RESULT fAnalogEpochs(UINT32 hFile, size_t ncols, double *pdEntityID, size_t nTrials, 
+                        double *pdTrigger, double dPreTime, double dPostTime, 
+                        const mxArray *pmxOptions, mxArray **ppmxData, mxArray **ppmxTime, 
+                        mxArray **ppmxScale)
+{
+    EPOCHREAD read;
+    EPOCHWINDOW *pWindow;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    mxClassID classID;
+    double *pdSampleRate;
+    double *pdOffset;
+    double *pdTime;
+    double dRows;
+    double dFirst;
+    double dLast;
+    double dTime;
+    size_t nRows = 0;
+    size_t nTimeCols = 1;
+    size_t nReference = 0;
+    size_t i;
+    size_t k;
+    UINT32 dwIndex;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bTrigger = TRUE;
+    BOOL bFatal = FALSE;
+
+    if (!fGetClassOption(pmxOptions, &classID))
+    {
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    if (!(-dPreTime < dPostTime))
+    {
+        mexPrintf("The window must end after it starts (ns_GetAnalogEpochs).\n");
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    memset(&read, 0, sizeof(read));
+    read.pWindows = calloc(ncols * nTrials + 1, sizeof(EPOCHWINDOW));
+    read.pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+    pdSampleRate = calloc(ncols + 1, sizeof(double));
+    pdOffset = calloc(ncols + 1, sizeof(double));
+
+    // The window of every entity holds the indeces from PreTime before to PostTime after
+    // the index closest to the trigger, i.e. the rows of the entity with the highest
+    // sample rate. Triggers that do not lie within the data of an entity have no window.
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if (0 == nsresult)
+            nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo,
+                                        (UINT32) sizeof(nsEntityInfo));
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogEpochs).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_GetAnalogEpochs)\n");
+            break;
+        }
+        if (!(0 < nsAnalogInfo.dSampleRate))
+            continue;
+
+        pdSampleRate[i] = nsAnalogInfo.dSampleRate;
+        pdOffset[i] = floor(-dPreTime * pdSampleRate[i] + 0.5);
+        dRows = floor(dPostTime * pdSampleRate[i] + 0.5) - pdOffset[i];
+        if (dRows >= MAX_INDEX_RANGE)
+        {
+            mexPrintf("The window must not exceed 2^32 - 1 indeces (ns_GetAnalogEpochs).\n");
+            nsresult = ns_LIBERROR;
+            break;
+        }
+        if (dRows > nRows)
+            nRows = (size_t) dRows;
+
+        for (k = 0; k < nTrials; ++k)
+        {
+            pWindow = &read.pWindows[i * nTrials + k];
+            pWindow->nTrial = k;
+            if ((0 != ns_GetIndexByTime(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], pdTrigger[k], 
+                                        ns_CLOSEST, &dwIndex)) ||
+                (0 != ns_GetTimeByIndex(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, &dTime)) ||
+                !(fabs(dTime - pdTrigger[k]) * pdSampleRate[i] <= 1))
+            {
+                if (TRUE == bTrigger)
+                    mexPrintf("Some triggers lie outside of the data (ns_GetAnalogEpochs).\n");
+                bTrigger = FALSE;
+                continue;
+            }
+
+            dFirst = MAX((double) dwIndex + pdOffset[i], 0);
+            dLast = (double) dwIndex + pdOffset[i] + dRows;
+            if (dLast > nsEntityInfo.dwItemCount)
+                dLast = nsEntityInfo.dwItemCount;
+            if (dFirst < dLast)
+            {
+                pWindow->dwIndex = (UINT32) dFirst;
+                pWindow->dwIndexCount = (UINT32) (dLast - dFirst);
+                pWindow->nRow = (size_t) (dFirst - ((double) dwIndex + pdOffset[i]));
+            }
+        }
+    }
+
+    if ((0 == nsresult) || (-5 == nsresult))
+    {
+        const mwSize dims[] = {nRows, nTrials, ncols};
+
+        *ppmxData = mxCreateNumericArray(3, dims, classID, mxREAL);
+        *ppmxScale = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+
+        fAnalogScale(hFile, ncols, pdEntityID, classID, mxGetPr(*ppmxScale));
+
+        read.hFile = hFile;
+        read.pdEntityID = pdEntityID;
+        read.nTrials = nTrials;
+        read.nRows = nRows;
+        read.classID = classID;
+        read.pvData = mxGetData(*ppmxData);
+        read.pdScale = mxGetPr(*ppmxScale);
+        read.dPad = mxGetNaN();
+
+        // Probe the library before any worker thread calls into it
+        fLibraryIsThreadSafe();
+        th_ParallelFor(ncols, fGetThreadOption(pmxOptions), fAnalogEpochsTask, &read);
+
+        nsresult = (TRUE == bEntity) ? ns_OK : ns_BADENTITY;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (-7 == read.pnResult[i])
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetAnalogEpochs).\n");
+                bIndex = FALSE;
+                nsresult = ns_BADINDEX;
+            }
+            else if (0 != read.pnResult[i])
+            {
+                mexPrintf("There was an error running ns_GetAnalogData!\n(Required for ns_GetAnalogEpochs)\n");
+                nsresult = read.pnResult[i];
+                bFatal = TRUE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        bFatal = TRUE;
+    }
+
+    if (bFatal)
+    {
+        *ppmxData = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+    }
+    else
+    {
+        // Entities with the same sample rate share one time column
+        for (i = 0; i < ncols; ++i)
+        {
+            if ((0 < pdSampleRate[i]) && !(0 < pdSampleRate[nReference]))
+                nReference = i;
+            if ((0 < pdSampleRate[i]) && (pdSampleRate[i] != pdSampleRate[nReference]))
+                nTimeCols = ncols;
+        }
+
+        *ppmxTime = mxCreateDoubleMatrix(nRows, nTimeCols, mxREAL);
+        pdTime = mxGetPr(*ppmxTime);
+        for (i = 0; i < nTimeCols; ++i)
+        {
+            size_t nEntity = (1 == nTimeCols) ? nReference : i;
+
+            dRows = floor(dPostTime * pdSampleRate[nEntity] + 0.5) - pdOffset[nEntity];
+            for (k = 0; k < nRows; ++k)
+            {
+                if ((0 < pdSampleRate[nEntity]) && (k < dRows))
+                    pdTime[i * nRows + k] = (k + pdOffset[nEntity]) / pdSampleRate[nEntity];
+                else
+                    pdTime[i * nRows + k] = mxGetNaN();
+            }
+        }
+    }
+
+    free(read.pWindows);
+    free(read.pnResult);
+    free(pdSampleRate);
+    free(pdOffset);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Analog statistics
+//
+//      The statistics of an entity are accumulated chunk by chunk while
+//      it is read, so only the summary is returned to Matlab.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// A reduction of several entities to their statistics, see fAnalogStats
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    UINT32 *pdwIndex;         // first index of every entity
+    UINT32 *pdwIndexCount;    // number of indeces of every entity
+    double *pdLow;            // samples at or below are clipped, for every entity
+    double *pdHigh;           // samples at or above are clipped, for every entity
+    DSP_STATS *pStats;        // statistics of every entity
+    ns_RESULT *pnResult;      // result of every entity
+} ANALOGSTATS;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Accumulate the statistics of one entity. May be called from worker threads.
+// Inputs:  pvContext - the ANALOGSTATS describing the request
+//          nEntity - which entity to compute
+// Outputs: pQuery->pStats[nEntity] and pQuery->pnResult[nEntity] are filled
+void fAnalogStatsTask(void *pvContext, size_t nEntity)
+{
+    ANALOGSTATS *pQuery = (ANALOGSTATS *) pvContext;
+    DSP_STATS *pStats = &pQuery->pStats[nEntity];
+    ANALOGCHUNKS chunks;
+    ns_RESULT nsresult;
+
+    dsp_InitStats(pStats);
+    pQuery->pnResult[nEntity] = ns_OK;
+    if (0 == pQuery->pdwIndexCount[nEntity])
+        return;
+
+    if (!fOpenChunks(&chunks, pQuery->hFile, (UINT32) pQuery->pdEntityID[nEntity], 
+                     pQuery->pdwIndex[nEntity], pQuery->pdwIndexCount[nEntity], ANALOG_CHUNK_SIZE))
+    {
+        fCloseChunks(&chunks);
+        pQuery->pnResult[nEntity] = ns_LIBERROR;
+        return;
+    }
+
+    // The continuous count is not needed, so chunk boundaries are not checked for gaps
+    chunks.bGap = TRUE;
+
+    while ((0 == (nsresult = fNextChunk(&chunks))) && (0 < chunks.dwCount))
+        dsp_Accumulate(chunks.pdChunk, chunks.dwCount, pQuery->pdLow[nEntity], pQuery->pdHigh[nEntity], 
+                       pStats);
+
+    // Entities that could not be read have no statistics
+    if (0 != nsresult)
+        dsp_InitStats(pStats);
+
+    fCloseChunks(&chunks);
+    pQuery->pnResult[nEntity] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the statistics of the analog data of several entities without returning
+//          the data itself, e.g. to check the signals of a whole recording
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get statistics for
+//          dwIndex - first index of every entity
+//          dIndexCount - how many indeces are used; Inf uses all indeces of every
+//                        entity from dwIndex on
+//          pmxOptions - options structure (may be empty)
+//                       Threads - number of worker threads reading entities in
+//                                 parallel (default 1, 0 = one per processor)
+//          ppmxStats - double pointer to the mex converted statistics; a structure per
+//                      entity with the fields IndexCount, Mean, RMS, Min, Max and
+//                      PercentClipped (percentage of samples at or beyond MinVal and
+//                      MaxVal of ns_ANALOGINFO, NaN if they do not give a range)
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxStats is filled.
+ns_RESULT fAnalogStats(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                       double dIndexCount, const mxArray *pmxOptions, mxArray **ppmxStats)
+{
+    const char *aszStatsNames[] = {"IndexCount","Mean","RMS","Min","Max","PercentClipped"};
+    ANALOGSTATS query;
+    DSP_STATS *pStats;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    double adValue[6];
+    double dNaN = mxGetNaN();
+    size_t i;
+    size_t k;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bFatal = FALSE;
+
+    memset(&query, 0, sizeof(query));
+    query.hFile = hFile;
+    query.pdEntityID = pdEntityID;
+    query.pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    query.pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+    query.pdLow = calloc(ncols + 1, sizeof(double));
+    query.pdHigh = calloc(ncols + 1, sizeof(double));
+    query.pStats = calloc(ncols + 1, sizeof(DSP_STATS));
+    query.pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+
+    // Clipping is judged against the range of values the entity can hold
+    for (i = 0; i < ncols; ++i)
+    {
+        query.pnResult[i] = ns_BADENTITY;
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if ((0 == nsresult) && (dIndexCount == mxGetInf()))
+            nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo,
+                                        (UINT32) sizeof(nsEntityInfo));
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogStats).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_GetAnalogStats)\n");
+            break;
+        }
+
+        query.pnResult[i] = ns_OK;
+        query.pdwIndex[i] = dwIndex;
+        if (dIndexCount != mxGetInf())
+            query.pdwIndexCount[i] = (UINT32) dIndexCount;
+        else if (dwIndex < nsEntityInfo.dwItemCount)
+            query.pdwIndexCount[i] = nsEntityInfo.dwItemCount - dwIndex;
+
+        query.pdLow[i] = -HUGE_VAL;
+        query.pdHigh[i] = HUGE_VAL;
+        if (nsAnalogInfo.dMinVal < nsAnalogInfo.dMaxVal)
+        {
+            query.pdLow[i] = nsAnalogInfo.dMinVal;
+            query.pdHigh[i] = nsAnalogInfo.dMaxVal;
+        }
+    }
+
+    if ((0 == nsresult) || (-5 == nsresult))
+    {
+        // Entities that do not exist are skipped by the workers
+        for (i = 0; i < ncols; ++i)
+        {
+            if (0 != query.pnResult[i])
+                query.pdwIndexCount[i] = 0;
+        }
+
+        // Probe the library before any worker thread calls into it
+        fLibraryIsThreadSafe();
+        th_ParallelFor(ncols, fGetThreadOption(pmxOptions), fAnalogStatsTask, &query);
+
+        nsresult = (TRUE == bEntity) ? ns_OK : ns_BADENTITY;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (-7 == query.pnResult[i])
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetAnalogStats).\n");
+                bIndex = FALSE;
+                nsresult = ns_BADINDEX;
+            }
+            else if (0 != query.pnResult[i])
+            {
+                mexPrintf("There was an error running ns_GetAnalogData!\n(Required for ns_GetAnalogStats)\n");
+                nsresult = query.pnResult[i];
+                bFatal = TRUE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        bFatal = TRUE;
+    }
+
+    if (bFatal)
+    {
+        *ppmxStats = mxCreateString("");
+    }
+    else
+    {
+        // Entities without data (or that could not be read) have NaN statistics
+        *ppmxStats = mxCreateStructMatrix(ncols, 1, 6, aszStatsNames);
+        for (i = 0; i < ncols; ++i)
+        {
+            pStats = &query.pStats[i];
+            adValue[0] = pStats->dCount;
+            for (k = 1; k < 6; ++k)
+                adValue[k] = dNaN;
+            if (0 < pStats->dCount)
+            {
+                adValue[1] = pStats->dSum / pStats->dCount;
+                adValue[2] = sqrt(pStats->dSumSquares / pStats->dCount);
+                adValue[3] = pStats->dMin;
+                adValue[4] = pStats->dMax;
+                if (-HUGE_VAL != query.pdLow[i])
+                    adValue[5] = 100 * pStats->dClipped / pStats->dCount;
+            }
+
+            for (k = 0; k < 6; ++k)
+                mxSetField(*ppmxStats, i, aszStatsNames[k], mxCreateScalarDouble(adValue[k]));
+        }
+    }
+
+    free(query.pdwIndex);
+    free(query.pdwIndexCount);
+    free(query.pdLow);
+    free(query.pdHigh);
+    free(query.pStats);
+    free(query.pnResult);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Power spectra
+//
+//      The power spectral density of an entity is estimated with Welch's
+//      method: the data is cut into overlapping windowed segments whose
+//      periodograms are averaged. Segments are taken from the chunks while
+//      the entity is read, so only the spectrum is returned to Matlab.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Longest window and transform accepted by ns_GetAnalogPSD
+#define MAX_PSD_LENGTH 0x1000000
+
+// Length of the default window of ns_GetAnalogPSD
+#define PSD_WINDOW 1024
+
+// An estimate of the power spectral density of several entities, see fAnalogPSD
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    UINT32 *pdwIndex;         // first index of every entity
+    UINT32 *pdwIndexCount;    // number of indeces of every entity
+    const double *pdWindow;   // window applied to every segment
+    size_t nWindow;           // length of the window (indeces per segment)
+    size_t nStep;             // indeces from the start of a segment to the next
+    size_t nFft;              // length of the transform (power of 2, at least nWindow)
+    double *pdTable;          // twiddle factors of the transform
+    double *pdPower;          // summed power of every entity, nFft / 2 + 1 values each
+    size_t *pnSegments;       // number of segments of every entity
+    ns_RESULT *pnResult;      // result of every entity
+} ANALOGPSD;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Sum the power of the windowed segments of one entity
+//          Two segments at a time are transformed as real and imaginary part of one
+//          complex transform. May be called from worker threads.
+// Inputs:  pvContext - the ANALOGPSD describing the request
+//          nEntity - which entity to compute
+// Outputs: pQuery->pdPower, pQuery->pnSegments and pQuery->pnResult of the entity are filled
+void fAnalogPSDTask(void *pvContext, size_t nEntity)
+{
+    ANALOGPSD *pQuery = (ANALOGPSD *) pvContext;
+    double *pdPower = pQuery->pdPower + nEntity * (pQuery->nFft / 2 + 1);
+    size_t nCapacity = MAX(ANALOG_CHUNK_SIZE, 2 * pQuery->nWindow);
+    size_t nHave = 0;
+    size_t nStart;
+    size_t k;
+    double *pdBuffer;
+    double *pdReal;
+    double *pdImag;
+    double *pdSegment;
+    ANALOGCHUNKS chunks;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bPending = FALSE;
+
+    pQuery->pnSegments[nEntity] = 0;
+    pQuery->pnResult[nEntity] = ns_OK;
+    if (pQuery->pdwIndexCount[nEntity] < pQuery->nWindow)
+        return;
+
+    pdBuffer = malloc((nCapacity + 1) * sizeof(double));
+    pdReal = calloc(pQuery->nFft, sizeof(double));
+    pdImag = calloc(pQuery->nFft, sizeof(double));
+    if (!pdBuffer || !pdReal || !pdImag || 
+        !fOpenChunks(&chunks, pQuery->hFile, (UINT32) pQuery->pdEntityID[nEntity], 
+                     pQuery->pdwIndex[nEntity], pQuery->pdwIndexCount[nEntity], 0))
+    {
+        free(pdBuffer);
+        free(pdReal);
+        free(pdImag);
+        pQuery->pnResult[nEntity] = ns_LIBERROR;
+        return;
+    }
+
+    // The continuous count is not needed, so chunk boundaries are not checked for gaps
+    chunks.bGap = TRUE;
+
+    while (chunks.dwIndex < chunks.dwEndIndex)
+    {
+        nsresult = fReadChunk(&chunks, pdBuffer + nHave, (UINT32) (nCapacity - nHave));
+        if (0 != nsresult)
+            break;
+        nHave += chunks.dwCount;
+
+        // Every segment that lies completely in the buffer is windowed into the real or
+        // imaginary part of the next transform, the rest is kept for the next chunk
+        for (nStart = 0; nStart + pQuery->nWindow <= nHave; nStart += pQuery->nStep)
+        {
+            pdSegment = bPending ? pdImag : pdReal;
+            for (k = 0; k < pQuery->nWindow; ++k)
+                pdSegment[k] = pdBuffer[nStart + k] * pQuery->pdWindow[k];
+            ++pQuery->pnSegments[nEntity];
+
+            if (bPending)
+            {
+                dsp_Fft(pdReal, pdImag, pQuery->nFft, pQuery->pdTable);
+                dsp_AddPower(pdReal, pdImag, pQuery->nFft, pdPower);
+                memset(pdReal, 0, pQuery->nFft * sizeof(double));
+                memset(pdImag, 0, pQuery->nFft * sizeof(double));
+            }
+            bPending = !bPending;
+        }
+
+        memmove(pdBuffer, pdBuffer + nStart, (nHave - nStart) * sizeof(double));
+        nHave -= nStart;
+    }
+
+    // An odd segment is transformed alone
+    if ((0 == nsresult) && bPending)
+    {
+        dsp_Fft(pdReal, pdImag, pQuery->nFft, pQuery->pdTable);
+        dsp_AddPower(pdReal, pdImag, pQuery->nFft, pdPower);
+    }
+
+    // Entities that could not be read have no spectrum
+    if (0 != nsresult)
+        pQuery->pnSegments[nEntity] = 0;
+
+    fCloseChunks(&chunks);
+    free(pdBuffer);
+    free(pdReal);
+    free(pdImag);
+    pQuery->pnResult[nEntity] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the window of a power spectrum from the options
+// Inputs:  pmxOptions - options structure passed from Matlab (may be empty)
+//          pnWindow - receives the length of the window
+//          ppdWindow - receives the window (allocated, must be freed)
+// Outputs: BOOL - FALSE if the Window option is neither a length nor a vector (a message
+//          is printed)
+BOOL fGetWindowOption(const mxArray *pmxOptions, size_t *pnWindow, double **ppdWindow)
+{
+    const mxArray *pmxWindow = 0;
+    double dLength = PSD_WINDOW;
+
+    *pnWindow = 0;
+    *ppdWindow = 0;
+    if (fHasOption(pmxOptions, "Window"))
+    {
+        pmxWindow = mxGetField(pmxOptions, 0, "Window");
+        if (!mxIsDouble(pmxWindow) || mxIsComplex(pmxWindow) || 
+            !((mxGetM(pmxWindow) == 1) || (mxGetN(pmxWindow) == 1)))
+            dLength = 0;
+        else if (1 == mxGetNumberOfElements(pmxWindow))
+            dLength = mxGetScalar(pmxWindow);
+        else
+            dLength = (double) mxGetNumberOfElements(pmxWindow);
+    }
+    if (!(dLength >= 1) || (dLength > MAX_PSD_LENGTH) || (dLength != floor(dLength)))
+    {
+        mexPrintf("Window option must be a window length or a vector (at most 2^24 values).\n");
+        return(FALSE);
+    }
+
+    *pnWindow = (size_t) dLength;
+    *ppdWindow = calloc(*pnWindow, sizeof(double));
+    if (!*ppdWindow)
+    {
+        mexPrintf("Not enough memory for the Window option.\n");
+        return(FALSE);
+    }
+
+    // A length gives a Hamming window, a vector is the window itself
+    if (pmxWindow && (1 < mxGetNumberOfElements(pmxWindow)))
+        memcpy(*ppdWindow, mxGetPr(pmxWindow), *pnWindow * sizeof(double));
+    else
+        dsp_HammingWindow(*pnWindow, *ppdWindow);
+    return(TRUE);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Estimate the power spectral density of several analog entities (Welch's method
+//          like pwelch) without returning the data itself
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities
+//          dwIndex - first index of every entity
+//          dIndexCount - how many indeces are used; Inf uses all indeces of every
+//                        entity from dwIndex on
+//          pmxOptions - options structure (may be empty)
+//                       Window - length of the segments (a Hamming window is used) or
+//                                the window itself (default 1024)
+//                       Overlap - indeces shared by neighbouring segments (default half
+//                                 the window)
+//                       NFFT - length of the transform; a power of 2, at least the
+//                              window length (default the next power of 2, at least 256)
+//                       Threads - number of worker threads reading entities in
+//                                 parallel (default 1, 0 = one per processor)
+//          ppmxPSD - double pointer to the mex converted one-sided power spectral density,
+//                    NFFT / 2 + 1 rows per entity (NaN for entities shorter than a window)
+//          ppmxFrequency - double pointer to the mex converted frequencies of the rows in
+//                          Hz; one column per entity if the sample rates differ
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxPSD and ppmxFrequency are filled.
+ns_RESULT fAnalogPSD(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                     double dIndexCount, const mxArray *pmxOptions, mxArray **ppmxPSD, 
+                     mxArray **ppmxFrequency)
+{
+    ANALOGPSD query;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    double *pdWindow;
+    double *pdSampleRate;
+    double *pdPSD;
+    double *pdFrequency;
+    double dOverlap;
+    double dNfft;
+    double dPower = 0;
+    double dScale;
+    double dRate;
+    double dNaN = mxGetNaN();
+    size_t nWindow;
+    size_t nRows;
+    size_t nFreqCols = 1;
+    size_t nReference = 0;
+    size_t nEntity;
+    size_t i;
+    size_t k;
+    int nExponent;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bFatal = FALSE;
+
+    if (!fGetWindowOption(pmxOptions, &nWindow, &pdWindow))
+    {
+        *ppmxPSD = mxCreateString("");
+        *ppmxFrequency = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    // Like pwelch the transform has at least 256 points
+    dOverlap = fGetOption(pmxOptions, "Overlap", (double) (nWindow / 2));
+    for (dNfft = 256; dNfft < nWindow; dNfft *= 2)
+        ;
+    dNfft = fGetOption(pmxOptions, "NFFT", dNfft);
+    if (!(dOverlap >= 0) || !(dOverlap < nWindow) || (dOverlap != floor(dOverlap)) ||
+        !(dNfft >= nWindow) || (dNfft > MAX_PSD_LENGTH) || (frexp(dNfft, &nExponent) != 0.5))
+    {
+        mexPrintf("Overlap must be less than the window length and NFFT a power of 2 not less than it.\n");
+        free(pdWindow);
+        *ppmxPSD = mxCreateString("");
+        *ppmxFrequency = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    memset(&query, 0, sizeof(query));
+    query.hFile = hFile;
+    query.pdEntityID = pdEntityID;
+    query.pdWindow = pdWindow;
+    query.nWindow = nWindow;
+    query.nStep = nWindow - (size_t) dOverlap;
+    query.nFft = (size_t) dNfft;
+    nRows = query.nFft / 2 + 1;
+    query.pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    query.pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+    query.pdTable = calloc(query.nFft, sizeof(double));
+    query.pdPower = calloc(ncols * nRows + 1, sizeof(double));
+    query.pnSegments = calloc(ncols + 1, sizeof(size_t));
+    query.pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+    pdSampleRate = calloc(ncols + 1, sizeof(double));
+
+    dsp_FftTable(query.nFft, query.pdTable);
+
+    for (i = 0; i < ncols; ++i)
+    {
+        query.pnResult[i] = ns_BADENTITY;
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if ((0 == nsresult) && (dIndexCount == mxGetInf()))
+            nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo,
+                                        (UINT32) sizeof(nsEntityInfo));
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetAnalogPSD).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_GetAnalogPSD)\n");
+            break;
+        }
+
+        query.pnResult[i] = ns_OK;
+        query.pdwIndex[i] = dwIndex;
+        if (dIndexCount != mxGetInf())
+            query.pdwIndexCount[i] = (UINT32) dIndexCount;
+        else if (dwIndex < nsEntityInfo.dwItemCount)
+            query.pdwIndexCount[i] = nsEntityInfo.dwItemCount - dwIndex;
+        pdSampleRate[i] = nsAnalogInfo.dSampleRate;
+    }
+
+    if ((0 == nsresult) || (-5 == nsresult))
+    {
+        // Entities that do not exist are skipped by the workers
+        for (i = 0; i < ncols; ++i)
+        {
+            if (0 != query.pnResult[i])
+                query.pdwIndexCount[i] = 0;
+        }
+
+        // Probe the library before any worker thread calls into it
+        fLibraryIsThreadSafe();
+        th_ParallelFor(ncols, fGetThreadOption(pmxOptions), fAnalogPSDTask, &query);
+
+        nsresult = (TRUE == bEntity) ? ns_OK : ns_BADENTITY;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (-7 == query.pnResult[i])
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetAnalogPSD).\n");
+                bIndex = FALSE;
+                nsresult = ns_BADINDEX;
+            }
+            else if (0 != query.pnResult[i])
+            {
+                mexPrintf("There was an error running ns_GetAnalogData!\n(Required for ns_GetAnalogPSD)\n");
+                nsresult = query.pnResult[i];
+                bFatal = TRUE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        bFatal = TRUE;
+    }
+
+    if (bFatal)
+    {
+        *ppmxPSD = mxCreateString("");
+        *ppmxFrequency = mxCreateString("");
+    }
+    else
+    {
+        // The power is scaled to a density per Hz of the window's power. All frequencies
+        // but 0 and the Nyquist frequency also hold the power of the negative ones.
+        for (k = 0; k < nWindow; ++k)
+            dPower += pdWindow[k] * pdWindow[k];
+
+        *ppmxPSD = mxCreateDoubleMatrix(nRows, ncols, mxREAL);
+        pdPSD = mxGetPr(*ppmxPSD);
+        for (i = 0; i < ncols; ++i)
+        {
+            dScale = dPower * query.pnSegments[i] * pdSampleRate[i];
+
+            for (k = 0; k < nRows; ++k)
+            {
+                pdPSD[i * nRows + k] = dNaN;
+                if ((0 < query.pnSegments[i]) && (0 < dScale))
+                    pdPSD[i * nRows + k] = query.pdPower[i * nRows + k] / dScale * 
+                                           (((0 == k) || (2 * k == query.nFft)) ? 1 : 2);
+            }
+        }
+
+        // Entities with the same sample rate share one frequency column
+        for (i = 0; i < ncols; ++i)
+        {
+            if (0 == query.pnResult[i])
+                nReference = i;
+        }
+        for (i = 0; i < ncols; ++i)
+        {
+            if ((0 == query.pnResult[i]) && (pdSampleRate[i] != pdSampleRate[nReference]))
+                nFreqCols = ncols;
+        }
+
+        *ppmxFrequency = mxCreateDoubleMatrix(nRows, nFreqCols, mxREAL);
+        pdFrequency = mxGetPr(*ppmxFrequency);
+        for (i = 0; i < nFreqCols; ++i)
+        {
+            nEntity = (1 == nFreqCols) ? nReference : i;
+            dRate = (0 == query.pnResult[nEntity]) ? pdSampleRate[nEntity] : dNaN;
+            for (k = 0; k < nRows; ++k)
+                pdFrequency[i * nRows + k] = k * dRate / query.nFft;
+        }
+    }
+
+    free(pdWindow);
+    free(pdSampleRate);
+    free(query.pdwIndex);
+    free(query.pdwIndexCount);
+    free(query.pdTable);
+    free(query.pdPower);
+    free(query.pnSegments);
+    free(query.pnResult);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Spike detection
+//
+//      Spikes are detected where the data of an entity crosses a threshold
+//      relative to its noise level. The noise level is estimated from the
+//      median absolute deviation of windows spread over the range, then the
+//      entity is read chunk by chunk and only the spikes are returned.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// The noise level is estimated from at most this many windows of ANALOG_CHUNK_SIZE indeces
+#define SPIKE_NOISE_WINDOWS 16
+
+// Longest snippet accepted by ns_DetectSpikes
+#define MAX_SNIPPET_LENGTH 65536
+
+// The spikes detected in one entity
+typedef struct
+{
+    UINT32 *pdwIndex;         // index of every spike (first index beyond the threshold)
+    double *pdSnippet;        // snippet of every spike (0 if no snippets are cut out)
+    size_t nSpikes;           // number of spikes
+    size_t nCapacity;         // capacity of pdwIndex and pdSnippet
+    BOOL bOutOfMemory;        // not all spikes could be stored
+    double dNoise;            // noise level (median absolute deviation / 0.6745)
+    double dThreshold;        // value the data crossed
+    ANALOGBLOCKS blocks;      // continuous blocks of the range
+} SPIKETRAIN;
+
+// A detection of spikes in several entities, see fDetectSpikes
+typedef struct
+{
+    UINT32 hFile;
+    double *pdEntityID;
+    UINT32 *pdwIndex;         // first index of every entity
+    UINT32 *pdwIndexCount;    // number of indeces of every entity
+    UINT32 *pdwRefractory;    // indeces after a spike in which no other spike is detected
+    double dFactor;           // threshold in multiples of the noise level (< 0 for crossings downwards)
+    size_t nPre;              // values of a snippet before the crossing
+    size_t nPost;             // values of a snippet from the crossing on
+    ANALOGFILTER *pFilter;    // filter applied to the data before detection (0 = none)
+    SPIKETRAIN *pTrains;      // spikes of every entity
+    ns_RESULT *pnResult;      // result of every entity
+} SPIKEDETECTION;
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Store a spike, the caller fills its snippet. May be called from worker threads.
+// Inputs:  pTrain - the spikes of the entity
+//          dwIndex - index of the spike
+//          nLength - length of a snippet (0 = no snippets)
+// Outputs: BOOL - FALSE if there is not enough memory (pTrain->bOutOfMemory is set)
+BOOL fAddSpike(SPIKETRAIN *pTrain, UINT32 dwIndex, size_t nLength)
+{
+    size_t nCapacity = 2 * pTrain->nCapacity + 64;
+    UINT32 *pdwIndex;
+    double *pdSnippet;
+
+    if (pTrain->bOutOfMemory)
+        return(FALSE);
+
+    if (pTrain->nSpikes == pTrain->nCapacity)
+    {
+        pdwIndex = realloc(pTrain->pdwIndex, nCapacity * sizeof(UINT32));
+        if (pdwIndex)
+            pTrain->pdwIndex = pdwIndex;
+        pdSnippet = (0 < nLength) ? realloc(pTrain->pdSnippet, nCapacity * nLength * sizeof(double)) : 0;
+        if (pdSnippet)
+            pTrain->pdSnippet = pdSnippet;
+        if (!pdwIndex || ((0 < nLength) && !pdSnippet))
+        {
+            pTrain->bOutOfMemory = TRUE;
+            return(FALSE);
+        }
+        pTrain->nCapacity = nCapacity;
+    }
+
+    pTrain->pdwIndex[pTrain->nSpikes++] = dwIndex;
+    return(TRUE);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Estimate the median and the noise level of an entity from windows spread
+//          evenly over its range (the whole range if it is short enough)
+//          May be called from worker threads.
+// Inputs:  pQuery - the SPIKEDETECTION describing the request
+//          nEntity - which entity to estimate
+//          pdBuffer - room for SPIKE_NOISE_WINDOWS * ANALOG_CHUNK_SIZE values
+// Outputs: ns_RESULT - what error was returned by the library (should be 0)
+//          pdMedian and the noise level of the entity are filled
+ns_RESULT fSpikeNoise(SPIKEDETECTION *pQuery, size_t nEntity, double *pdBuffer, double *pdMedian)
+{
+    ANALOGFILTER *pFilter = pQuery->pFilter;
+    UINT32 dwEntityID = (UINT32) pQuery->pdEntityID[nEntity];
+    UINT32 dwIndexCount = pQuery->pdwIndexCount[nEntity];
+    size_t nValues = MIN(dwIndexCount, SPIKE_NOISE_WINDOWS * ANALOG_CHUNK_SIZE);
+    size_t nWindows = (nValues + ANALOG_CHUNK_SIZE - 1) / ANALOG_CHUNK_SIZE;
+    size_t nLength;
+    size_t i;
+    size_t k;
+    double *pdState = 0;
+    double *pdWindow;
+    UINT32 dwStart;
+    UINT32 dwContCount;
+    ns_RESULT nsresult;
+
+    if (pFilter && !(pdState = calloc(2 * pFilter->nSections, sizeof(double))))
+        return(ns_LIBERROR);
+
+    for (i = 0; i < nWindows; ++i)
+    {
+        pdWindow = pdBuffer + i * ANALOG_CHUNK_SIZE;
+        nLength = MIN(ANALOG_CHUNK_SIZE, nValues - i * ANALOG_CHUNK_SIZE);
+        dwStart = pQuery->pdwIndex[nEntity] + (UINT32) (i * ANALOG_CHUNK_SIZE);
+        if (nValues < dwIndexCount)
+            dwStart = pQuery->pdwIndex[nEntity] + 
+                      (UINT32) ((double) (dwIndexCount - ANALOG_CHUNK_SIZE) * i / (nWindows - 1));
+
+        nsresult = fReadAnalog(pQuery->hFile, dwEntityID, dwStart, (UINT32) nLength, &dwContCount, 
+                               pdWindow);
+        if (0 != nsresult)
+        {
+            free(pdState);
+            return(nsresult);
+        }
+
+        // Every window is filtered as if its first value had always been there
+        if (pFilter)
+        {
+            dsp_BiquadSteadyState(pFilter->pdSos, pFilter->nSections, pdWindow[0], pdState);
+            dsp_Biquads(pFilter->pdSos, pFilter->nSections, pdState, pdWindow, nLength, FALSE);
+        }
+    }
+
+    // The noise level of a Gaussian signal is its median absolute deviation / 0.6745
+    *pdMedian = dsp_Median(pdBuffer, nValues);
+    for (k = 0; k < nValues; ++k)
+        pdBuffer[k] = fabs(pdBuffer[k] - *pdMedian);
+    pQuery->pTrains[nEntity].dNoise = dsp_Median(pdBuffer, nValues) / 0.6745;
+
+    free(pdState);
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Detect the spikes of one entity. The values a snippet needs before a crossing
+//          are kept from one chunk to the next, and crossings whose snippet reaches past
+//          a chunk are looked at after the next chunk. May be called from worker threads.
+// Inputs:  pvContext - the SPIKEDETECTION describing the request
+//          nEntity - which entity to detect spikes in
+// Outputs: pQuery->pTrains[nEntity] and pQuery->pnResult[nEntity] are filled
+void fDetectSpikesTask(void *pvContext, size_t nEntity)
+{
+    SPIKEDETECTION *pQuery = (SPIKEDETECTION *) pvContext;
+    SPIKETRAIN *pTrain = &pQuery->pTrains[nEntity];
+    ANALOGFILTER *pFilter = pQuery->pFilter;
+    size_t nLength = pQuery->nPre + pQuery->nPost;
+    size_t nHistory = MAX(pQuery->nPre, 1);
+    size_t nCapacity = MAX(SPIKE_NOISE_WINDOWS * ANALOG_CHUNK_SIZE, 
+                           nHistory + ANALOG_CHUNK_SIZE + pQuery->nPost);
+    size_t nHave = 0;
+    size_t nScan = 0;
+    size_t nLimit;
+    size_t nDrop;
+    size_t nBlock = 0;
+    size_t k;
+    ptrdiff_t nSource;
+    double *pdBuffer;
+    double *pdState = 0;
+    double *pdSnippet;
+    double dMedian = 0;
+    double dPrevious = 0;
+    double dValue;
+    UINT32 dwBase = pQuery->pdwIndex[nEntity];
+    UINT32 dwLast = 0;
+    UINT32 dwIndex;
+    ANALOGCHUNKS chunks;
+    ns_RESULT nsresult;
+    BOOL bPrevious = FALSE;
+    BOOL bSpike = FALSE;
+
+    pTrain->dNoise = mxGetNaN();
+    pTrain->dThreshold = mxGetNaN();
+    pQuery->pnResult[nEntity] = ns_OK;
+    if (0 == pQuery->pdwIndexCount[nEntity])
+        return;
+
+    pdBuffer = malloc((nCapacity + 1) * sizeof(double));
+    if (!pdBuffer || 
+        !fOpenChunks(&chunks, pQuery->hFile, (UINT32) pQuery->pdEntityID[nEntity], 
+                     pQuery->pdwIndex[nEntity], pQuery->pdwIndexCount[nEntity], 0))
+    {
+        free(pdBuffer);
+        pQuery->pnResult[nEntity] = ns_LIBERROR;
+        return;
+    }
+
+    nsresult = fSpikeNoise(pQuery, nEntity, pdBuffer, &dMedian);
+    if (0 != nsresult)
+    {
+        fCloseChunks(&chunks);
+        free(pdBuffer);
+        pQuery->pnResult[nEntity] = nsresult;
+        return;
+    }
+    pTrain->dThreshold = dMedian + pQuery->dFactor * pTrain->dNoise;
+
+    // The blocks tell where there is no index before a crossing and give the time of the spikes
+    fTrackBlocks(&chunks, &pTrain->blocks);
+    if (pFilter)
+        pdState = pFilter->pdState + nEntity * 2 * pFilter->nSections;
+
+    while (chunks.dwIndex < chunks.dwEndIndex)
+    {
+        nsresult = fReadChunk(&chunks, pdBuffer + nHave, (UINT32) (nCapacity - nHave));
+        if (0 != nsresult)
+            break;
+        if (pFilter)
+        {
+            if (!pFilter->pbStarted[nEntity])
+                dsp_BiquadSteadyState(pFilter->pdSos, pFilter->nSections, pdBuffer[nHave], pdState);
+            pFilter->pbStarted[nEntity] = TRUE;
+            dsp_Biquads(pFilter->pdSos, pFilter->nSections, pdState, pdBuffer + nHave, chunks.dwCount, 
+                        FALSE);
+        }
+        nHave += chunks.dwCount;
+
+        // Only crossings whose snippet has been read completely are looked at
+        nLimit = nHave;
+        if (chunks.dwIndex < chunks.dwEndIndex)
+            nLimit = (nHave > pQuery->nPost) ? nHave - pQuery->nPost : 0;
+
+        for (; nScan < nLimit; ++nScan)
+        {
+            dwIndex = dwBase + (UINT32) nScan;
+            dValue = pdBuffer[nScan];
+
+            // The data crosses the threshold if the index before it is in the same block
+            // and not beyond the threshold
+            while ((nBlock < pTrain->blocks.nBlocks) && (pTrain->blocks.pdwStart[nBlock] < dwIndex))
+                ++nBlock;
+            if ((nBlock < pTrain->blocks.nBlocks) && (pTrain->blocks.pdwStart[nBlock] == dwIndex))
+                bPrevious = FALSE;
+            bSpike = bPrevious && 
+                     ((pQuery->dFactor < 0) ? ((dValue < pTrain->dThreshold) && !(dPrevious < pTrain->dThreshold)) :
+                                              ((dValue > pTrain->dThreshold) && !(dPrevious > pTrain->dThreshold)));
+            dPrevious = dValue;
+            bPrevious = TRUE;
+
+            if (!bSpike || ((0 < pTrain->nSpikes) && (dwIndex - dwLast < pQuery->pdwRefractory[nEntity])) ||
+                !fAddSpike(pTrain, dwIndex, nLength))
+                continue;
+            dwLast = dwIndex;
+
+            // Snippets reaching past the range are padded with NaN
+            pdSnippet = pTrain->pdSnippet + (pTrain->nSpikes - 1) * nLength;
+            for (k = 0; k < nLength; ++k)
+            {
+                nSource = (ptrdiff_t) (nScan + k) - (ptrdiff_t) pQuery->nPre;
+                pdSnippet[k] = ((0 <= nSource) && ((size_t) nSource < nHave)) ? pdBuffer[nSource] : mxGetNaN();
+            }
+        }
+
+        // Keep the values before the next index to look at
+        nDrop = (nScan > nHistory) ? nScan - nHistory : 0;
+        memmove(pdBuffer, pdBuffer + nDrop, (nHave - nDrop) * sizeof(double));
+        dwBase += (UINT32) nDrop;
+        nHave -= nDrop;
+        nScan -= nDrop;
+    }
+
+    fCloseChunks(&chunks);
+    free(pdBuffer);
+    pQuery->pnResult[nEntity] = nsresult;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Detect spikes in several analog entities as crossings of a threshold relative
+//          to the noise level (median absolute deviation / 0.6745) without returning the
+//          data itself
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities
+//          dwIndex - first index of every entity
+//          dIndexCount - how many indeces are used; Inf uses all indeces of every
+//                        entity from dwIndex on
+//          pmxOptions - options structure (may be empty)
+//                       Threshold - threshold in multiples of the noise level relative to
+//                                   the median; negative for crossings downwards (default -4)
+//                       Refractory - time in s after a spike in which no other spike is
+//                                    detected (default 0.001)
+//                       Snippet - [Pre Post]: values cut out before the crossing and from
+//                                 the crossing on (default none)
+//                       Filter - filter applied to the data before detection (forward only)
+//                       Threads - number of worker threads reading entities in
+//                                 parallel (default 1, 0 = one per processor)
+//          ppmxSpikes - double pointer to the mex converted spikes; a structure per entity
+//                       with the fields Index, Time, Threshold, Noise and Snippets
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxSpikes is filled.
+ns_RESULT fDetectSpikes(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                        double dIndexCount, const mxArray *pmxOptions, mxArray **ppmxSpikes)
+{
+    const char *aszSpikeNames[] = {"Index","Time","Threshold","Noise","Snippets"};
+    SPIKEDETECTION query;
+    SPIKETRAIN *pTrain;
+    ANALOGFILTER filter;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_ENTITYINFO nsEntityInfo;
+    const mxArray *pmxSnippet;
+    mxArray *pmxValue;
+    double *pdSampleRate;
+    double *pdIndex;
+    double *pdTime;
+    double *pdBlockTime = 0;
+    double dRefractory = fGetOption(pmxOptions, "Refractory", 0.001);
+    double dPre = 0;
+    double dPost = 0;
+    size_t nLength;
+    size_t nBlock;
+    size_t i;
+    size_t k;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+    BOOL bFatal = FALSE;
+    BOOL bOutOfMemory = FALSE;
+
+    memset(&query, 0, sizeof(query));
+    query.dFactor = fGetOption(pmxOptions, "Threshold", -4);
+    if (fHasOption(pmxOptions, "Snippet"))
+    {
+        pmxSnippet = mxGetField(pmxOptions, 0, "Snippet");
+        dPre = -1;
+        if (mxIsDouble(pmxSnippet) && !mxIsComplex(pmxSnippet) && (2 == mxGetNumberOfElements(pmxSnippet)))
+        {
+            dPre = mxGetPr(pmxSnippet)[0];
+            dPost = mxGetPr(pmxSnippet)[1];
+        }
+    }
+    if (!mxIsFinite(query.dFactor) || (0 == query.dFactor) || !(dRefractory >= 0) || !mxIsFinite(dRefractory) ||
+        !(dPre >= 0) || !(dPost >= 0) || (dPre != floor(dPre)) || (dPost != floor(dPost)) || 
+        (dPre + dPost > MAX_SNIPPET_LENGTH))
+    {
+        mexPrintf("Threshold must be a non-zero number, Refractory not negative and Snippet [Pre Post] counts of values.\n");
+        *ppmxSpikes = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    query.nPre = (size_t) dPre;
+    query.nPost = (size_t) dPost;
+    nLength = query.nPre + query.nPost;
+
+    if (!fGetFilterOption(pmxOptions, ncols, &filter))
+    {
+        *ppmxSpikes = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    if (filter.bZeroPhase)
+    {
+        mexPrintf("ZeroPhase option is not supported (ns_DetectSpikes).\n");
+        fFreeFilter(&filter);
+        *ppmxSpikes = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    query.hFile = hFile;
+    query.pdEntityID = pdEntityID;
+    query.pFilter = filter.pdSos ? &filter : 0;
+    query.pdwIndex = calloc(ncols + 1, sizeof(UINT32));
+    query.pdwIndexCount = calloc(ncols + 1, sizeof(UINT32));
+    query.pdwRefractory = calloc(ncols + 1, sizeof(UINT32));
+    query.pTrains = calloc(ncols + 1, sizeof(SPIKETRAIN));
+    query.pnResult = calloc(ncols + 1, sizeof(ns_RESULT));
+    pdSampleRate = calloc(ncols + 1, sizeof(double));
+
+    for (i = 0; i < ncols; ++i)
+    {
+        query.pnResult[i] = ns_BADENTITY;
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo, 
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if ((0 == nsresult) && (dIndexCount == mxGetInf()))
+            nsresult = ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo,
+                                        (UINT32) sizeof(nsEntityInfo));
+        if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_DetectSpikes).\n");
+            bEntity = FALSE;
+            continue;
+        }
+        else if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_DetectSpikes)\n");
+            break;
+        }
+
+        query.pnResult[i] = ns_OK;
+        query.pdwIndex[i] = dwIndex;
+        if (dIndexCount != mxGetInf())
+            query.pdwIndexCount[i] = (UINT32) dIndexCount;
+        else if (dwIndex < nsEntityInfo.dwItemCount)
+            query.pdwIndexCount[i] = nsEntityInfo.dwItemCount - dwIndex;
+        pdSampleRate[i] = nsAnalogInfo.dSampleRate;
+        if (0 < nsAnalogInfo.dSampleRate)
+            query.pdwRefractory[i] = (UINT32) MIN(ceil(dRefractory * nsAnalogInfo.dSampleRate), 4294967295.0);
+    }
+
+    if ((0 == nsresult) || (-5 == nsresult))
+    {
+        // Entities that do not exist are skipped by the workers
+        for (i = 0; i < ncols; ++i)
+        {
+            if (0 != query.pnResult[i])
+                query.pdwIndexCount[i] = 0;
+        }
+
+        // Probe the library before any worker thread calls into it
+        fLibraryIsThreadSafe();
+        th_ParallelFor(ncols, fGetThreadOption(pmxOptions), fDetectSpikesTask, &query);
+
+        nsresult = (TRUE == bEntity) ? ns_OK : ns_BADENTITY;
+        for (i = 0; i < ncols; ++i)
+        {
+            if (-7 == query.pnResult[i])
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_DetectSpikes).\n");
+                bIndex = FALSE;
+                nsresult = ns_BADINDEX;
+            }
+            else if (0 != query.pnResult[i])
+            {
+                mexPrintf("There was an error running ns_GetAnalogData!\n(Required for ns_DetectSpikes)\n");
+                nsresult = query.pnResult[i];
+                bFatal = TRUE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        bFatal = TRUE;
+    }
+
+    if (bFatal)
+    {
+        *ppmxSpikes = mxCreateString("");
+    }
+    else
+    {
+        // Entities that could not be read have no spikes
+        *ppmxSpikes = mxCreateStructMatrix(ncols, 1, 5, aszSpikeNames);
+        for (i = 0; i < ncols; ++i)
+        {
+            pTrain = &query.pTrains[i];
+            if (0 != query.pnResult[i])
+                pTrain->nSpikes = 0;
+            if (pTrain->bOutOfMemory || pTrain->blocks.bOutOfMemory)
+                bOutOfMemory = TRUE;
+
+            // The time of a spike is counted from the start of its block
+            free(pdBlockTime);
+            pdBlockTime = calloc(pTrain->blocks.nBlocks + 1, sizeof(double));
+            for (nBlock = 0; pdBlockTime && (nBlock < pTrain->blocks.nBlocks); ++nBlock)
+            {
+                if (0 != ns_GetTimeByIndex(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], 
+                                           pTrain->blocks.pdwStart[nBlock], &pdBlockTime[nBlock]))
+                    pdBlockTime[nBlock] = mxGetNaN();
+            }
+
+            pmxValue = mxCreateDoubleMatrix(pTrain->nSpikes, 1, mxREAL);
+            pdIndex = mxGetPr(pmxValue);
+            mxSetField(*ppmxSpikes, i, aszSpikeNames[0], pmxValue);
+            pmxValue = mxCreateDoubleMatrix(pTrain->nSpikes, 1, mxREAL);
+            pdTime = mxGetPr(pmxValue);
+            mxSetField(*ppmxSpikes, i, aszSpikeNames[1], pmxValue);
+
+            for (k = 0, nBlock = 0; k < pTrain->nSpikes; ++k)
+            {
+                pdIndex[k] = pTrain->pdwIndex[k];
+                while ((nBlock + 1 < pTrain->blocks.nBlocks) && 
+                       (pTrain->blocks.pdwStart[nBlock + 1] <= pTrain->pdwIndex[k]))
+                    ++nBlock;
+                if (pdBlockTime && (0 < pdSampleRate[i]) && (nBlock < pTrain->blocks.nBlocks))
+                    pdTime[k] = pdBlockTime[nBlock] + 
+                                (pTrain->pdwIndex[k] - pTrain->blocks.pdwStart[nBlock]) / pdSampleRate[i];
+                else if (0 != ns_GetTimeByIndex(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], 
+                                                pTrain->pdwIndex[k], &pdTime[k]))
+                    pdTime[k] = mxGetNaN();
+            }
+
+            mxSetField(*ppmxSpikes, i, aszSpikeNames[2], mxCreateScalarDouble(pTrain->dThreshold));
+            mxSetField(*ppmxSpikes, i, aszSpikeNames[3], mxCreateScalarDouble(pTrain->dNoise));
+
+            pmxValue = mxCreateDoubleMatrix(nLength, (0 < nLength) ? pTrain->nSpikes : 0, mxREAL);
+            if ((0 < nLength) && (0 < pTrain->nSpikes))
+                memcpy(mxGetPr(pmxValue), pTrain->pdSnippet, pTrain->nSpikes * nLength * sizeof(double));
+            mxSetField(*ppmxSpikes, i, aszSpikeNames[4], pmxValue);
+        }
+
+        if (bOutOfMemory)
+            mexPrintf("Not enough memory to store all spikes (ns_DetectSpikes).\n");
+    }
+
+    for (i = 0; i < ncols; ++i)
+    {
+        free(query.pTrains[i].pdwIndex);
+        free(query.pTrains[i].pdSnippet);
+        free(query.pTrains[i].blocks.pdwStart);
+    }
+    free(pdBlockTime);
+    free(pdSampleRate);
+    free(query.pdwIndex);
+    free(query.pdwIndexCount);
+    free(query.pdwRefractory);
+    free(query.pTrains);
+    free(query.pnResult);
+    fFreeFilter(&filter);
+    return(nsresult);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Streaming analog data
+//
+//      A stream reads a fixed index range of several analog entities in
+//      chunks, so recordings larger than the available memory can be
+//      processed piece by piece. The read position is kept here between
+//      calls; Matlab only holds the stream handle. The handle encodes the
+//      slot in the stream table and how often the slot was opened, so the
+//      handle of a closed stream is not taken for a later stream of the
+//      same slot.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define MAX_STREAMS 64
+
+typedef struct
+{
+    BOOL bValid;
+    UINT32 hFile;
+    size_t ncols;             // number of entities
+    double *pdEntityID;       // the entities (copied from the open request)
+    double *pdSampleRate;     // sample rate of every entity (from ns_ANALOGINFO)
+    double *pdScale;          // value of one raw count of every entity (int16 data)
+    UINT32 dwIndex;           // next index to read
+    UINT32 dwEndIndex;        // one past the last index of the stream
+    UINT32 dwChunkSize;       // maximum number of indeces returned per read
+    int nThreads;             // worker threads used for every chunk
+    mxClassID classID;        // class of the returned data
+    ANALOGFILTER filter;      // filter applied to the data, its state is kept between chunks
+} ANALOGSTREAM;
+
+// This is initialized to zero as per ANSI C specifications
+ANALOGSTREAM g_aStreams[MAX_STREAMS];
+UINT32 g_adwStreamGenerations[MAX_STREAMS];   // number of times every slot was opened
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Close a stream and free its memory
+// Inputs:  pStream - the stream to close
+void fFreeStream(ANALOGSTREAM *pStream)
+{
+    free(pStream->pdEntityID);
+    free(pStream->pdSampleRate);
+    free(pStream->pdScale);
+    fFreeFilter(&pStream->filter);
+    memset(pStream, 0, sizeof(ANALOGSTREAM));
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Look up a stream by the handle that was returned to Matlab
+// Inputs:  dStream - the stream handle
+// Outputs: ANALOGSTREAM * - the stream, 0 if the handle is not valid
+ANALOGSTREAM *fGetStream(double dStream)
+{
+    int nStream;
+    UINT32 dwGeneration;
+
+    // Handles are (generation * MAX_STREAMS + slot + 1) with 32 bit generations,
+    // see fOpenAnalogStream
+    if (!(dStream >= 1) || (dStream > MAX_STREAMS * 4294967296.0) || (dStream != floor(dStream)))
+        return(0);
+    nStream = (int) fmod(dStream - 1, MAX_STREAMS);
+    dwGeneration = (UINT32) floor((dStream - 1) / MAX_STREAMS);
+
+    if (!g_aStreams[nStream].bValid || (g_adwStreamGenerations[nStream] != dwGeneration))
+        return(0);
+    return(&g_aStreams[nStream]);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Open a stream over an index range of several analog entities
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to stream
+//          dwIndex - first index of the stream
+//          dwIndexCount - number of indeces in the stream
+//          dwChunkSize - maximum number of indeces returned by one read
+//          pmxOptions - options structure (may be empty)
+//                       Threads - number of worker threads used for every chunk
+//                       Class - class of the data: 'double' (default), 'single' or
+//                               'int16' (raw counts of the resolution of the entity)
+//                       Filter - IIR filter applied to the data, a row [b0 b1 b2 a0 a1 a2]
+//                                per second order section
+//                       ZeroPhase - filter forward and backward (default false)
+//          ppmxStream - double pointer to the mex converted stream handle
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxStream is filled.
+ns_RESULT fOpenAnalogStream(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                            UINT32 dwIndexCount, UINT32 dwChunkSize, const mxArray *pmxOptions, 
+                            mxArray **ppmxStream)
+{
+    ANALOGSTREAM *pStream = 0;
+    ns_ANALOGINFO nsAnalogInfo;
+    ns_RESULT nsresult;
+    mxClassID classID;
+    UINT32 dwDecimate;
+    BOOL bSampleRate = TRUE;
+    int nStream;
+    UINT32 i;
+
+    *ppmxStream = mxCreateString("");
+
+    if (!fGetAnalogOptions(pmxOptions, &classID, &dwDecimate))
+        return(ns_LIBERROR);
+
+    // The filter state is not kept between the chunks of a stream
+    if (1 < dwDecimate)
+    {
+        mexPrintf("Decimate option is not supported for streams (ns_OpenAnalogStream).\n");
+        return(ns_LIBERROR);
+    }
+
+    for (nStream = 0; nStream < MAX_STREAMS; ++nStream)
+    {
+        if (!g_aStreams[nStream].bValid)
+        {
+            pStream = &g_aStreams[nStream];
+            break;
+        }
+    }
+    if (!pStream)
+    {
+        mexPrintf("Too many open streams, close a stream first (ns_OpenAnalogStream).\n");
+        return(ns_LIBERROR);
+    }
+    if ((0 == ncols) || (0 == dwChunkSize) || (dwIndex > dwIndex + dwIndexCount))
+    {
+        mexPrintf("Invalid entity list, index range or chunk size (ns_OpenAnalogStream).\n");
+        return(ns_LIBERROR);
+    }
+    if (!fGetFilterOption(pmxOptions, ncols, &pStream->filter))
+        return(ns_LIBERROR);
+
+    pStream->pdEntityID = calloc(ncols, sizeof(double));
+    pStream->pdSampleRate = calloc(ncols, sizeof(double));
+    pStream->pdScale = calloc(ncols, sizeof(double));
+
+    // All entities must be analog entities. Rows of a chunk share the same
+    // indeces, so the entities should share the same sample rate.
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetAnalogInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsAnalogInfo,
+                                    (UINT32) sizeof(nsAnalogInfo));
+        if (0 != nsresult)
+        {
+            mexPrintf("There was an error running ns_GetAnalogInfo!\n(Required for ns_OpenAnalogStream)\n");
+            fFreeStream(pStream);
+            return(nsresult);
+        }
+        pStream->pdEntityID[i] = pdEntityID[i];
+        pStream->pdSampleRate[i] = nsAnalogInfo.dSampleRate;
+        pStream->pdScale[i] = 1;
+        if ((mxINT16_CLASS == classID) && (0 < nsAnalogInfo.dResolution))
+            pStream->pdScale[i] = nsAnalogInfo.dResolution;
+
+        if ((pStream->pdSampleRate[i] != pStream->pdSampleRate[0]) && (TRUE == bSampleRate))
+        {
+            mexPrintf("Entities of the stream have different sample rates (ns_OpenAnalogStream).\n");
+            bSampleRate = FALSE;
+        }
+    }
+
+    pStream->bValid = TRUE;
+    pStream->hFile = hFile;
+    pStream->ncols = ncols;
+    pStream->dwIndex = dwIndex;
+    pStream->dwEndIndex = dwIndex + dwIndexCount;
+    pStream->dwChunkSize = dwChunkSize;
+    pStream->nThreads = fGetThreadOption(pmxOptions);
+    pStream->classID = classID;
+
+    // A new generation of the slot invalidates the handles of its earlier streams
+    ++g_adwStreamGenerations[nStream];
+    *ppmxStream = mxCreateScalarDouble((double) g_adwStreamGenerations[nStream] * MAX_STREAMS + nStream + 1);
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Read the next chunk of a stream and convert it into Matlab format
+// Inputs:  pStream - the stream to read from
+//          ppmxContCount - double pointer to the mex converted number of how
+//                          many continuous indeces were loaded
+//          ppmxData - double pointer to the mex converted data (empty at the end of the stream)
+//          ppmxIndex - double pointer to the mex converted index of the first row of ppmxData
+//          ppmxTime - double pointer to the mex converted time of the first row of ppmxData
+//                     for every entity
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxContCount, ppmxData, ppmxIndex and ppmxTime are filled.
+ns_RESULT fReadAnalogStream(ANALOGSTREAM *pStream, mxArray **ppmxContCount, mxArray **ppmxData,
+                            mxArray **ppmxIndex, mxArray **ppmxTime)
+{
+    UINT32 dwCount;
+    UINT32 i;
+    double *pdTime;
+    ANALOGREAD read;
+    ns_RESULT nsresult = ns_OK;
+    BOOL bFatal = FALSE;
+
+    dwCount = pStream->dwEndIndex - pStream->dwIndex;
+    if (dwCount > pStream->dwChunkSize)
+        dwCount = pStream->dwChunkSize;
+
+    *ppmxContCount = mxCreateDoubleMatrix(pStream->ncols, 1, mxREAL);
+    *ppmxData = mxCreateNumericMatrix(dwCount, pStream->ncols, pStream->classID, mxREAL);
+    *ppmxIndex = mxCreateScalarDouble(pStream->dwIndex);
+    *ppmxTime = mxCreateDoubleMatrix(pStream->ncols, 1, mxREAL);
+
+    if (0 == dwCount)
+        return(ns_OK);
+
+    pdTime = mxGetPr(*ppmxTime);
+    for (i = 0; i < pStream->ncols; ++i)
+    {
+        if (0 != ns_GetTimeByIndex(g_nsDllHandle, pStream->hFile, (UINT32) pStream->pdEntityID[i],
+                                   pStream->dwIndex, &pdTime[i]))
+            pdTime[i] = mxGetNaN();
+    }
+
+    fInitAnalogRead(&read, pStream->hFile, pStream->pdEntityID, pStream->dwIndex, dwCount, 
+                    pStream->classID, mxGetData(*ppmxData), pStream->pdScale);
+    if (pStream->filter.pdSos)
+    {
+        read.pFilter = &pStream->filter;
+        read.dwFilterEnd = pStream->dwEndIndex;
+    }
+    nsresult = fAnalogReadColumns(&read, pStream->ncols, pStream->nThreads, mxGetPr(*ppmxContCount), 
+                                  &bFatal);
+    if (bFatal)
+    {
+        *ppmxContCount = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxIndex = mxCreateString("");
+        *ppmxTime = mxCreateString("");
+        return(nsresult);
+    }
+
+    pStream->dwIndex += dwCount;
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Release everything that is kept between calls for a file, e.g. when it is closed
+// Inputs:  hFile - handle/ID number of the file
+void fReleaseFile(UINT32 hFile)
+{
+    size_t n;
+    int i;
+
+    fReleaseReadAhead(hFile, FALSE);
+    fCacheFlush(hFile, FALSE);
+    fReleaseSidecars(hFile, FALSE);
+    fReleaseEventTimes(hFile, FALSE);
+
+    for (i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (g_aStreams[i].bValid && (g_aStreams[i].hFile == hFile))
+            fFreeStream(&g_aStreams[i]);
+    }
+
+    for (n = 0; n < g_nEnvelopes; )
+    {
+        if (g_ppEnvelopes[n]->hFile == hFile)
+        {
+            fFreeEnvelope(g_ppEnvelopes[n]);
+            g_ppEnvelopes[n] = g_ppEnvelopes[--g_nEnvelopes];
+        }
+        else
+            ++n;
+    }
+
+    fForgetFile(hFile);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Release everything that is kept between calls, e.g. when the library is changed
+//          or this mex DLL is unloaded
+void fReleaseAll(void)
+{
+    size_t n;
+    int i;
+
+    fReleaseReadAhead(0, TRUE);
+    fCacheFlush(0, TRUE);
+    fReleaseSidecars(0, TRUE);
+    fReleaseEventTimes(0, TRUE);
+
+    for (i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (g_aStreams[i].bValid)
+            fFreeStream(&g_aStreams[i]);
+    }
+
+    for (n = 0; n < g_nEnvelopes; ++n)
+        fFreeEnvelope(g_ppEnvelopes[n]);
+    free(g_ppEnvelopes);
+    g_ppEnvelopes = 0;
+    g_nEnvelopes = 0;
+
+    for (n = 0; n < g_nOpenFiles; ++n)
+        free(g_pOpenFiles[n].szPath);
+    free(g_pOpenFiles);
+    g_pOpenFiles = 0;
+    g_nOpenFiles = 0;
+}
+
+// Author & Date: Almut Branner, 2/21/2003
+// Purpose: Get segment data and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncolsEntity - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get data for
+//          ncolsIndex - number of elements in the array of entities (pdEntityID)
+//          pdIndex - pointer to the array of indeces to get data for
+//          pmxOptions - options structure (may be empty)
+//                       Class - class of the data: 'double' (default), 'single' or
+//                               'int16' (raw counts of the resolution of the first source)
+//                       TimeStampsOnly - read only the time stamps (see fTimeStampsOnly)
+//                                        and leave all other outputs empty
+//          ppmxTimeStamp - double pointer to the mex converted time stamp
+//          ppmxData - double pointer to the mex converted data structure
+//          ppmxSampleCount - double pointer to the mex converted count of the
+//                            samples loaded
+//          ppmxUnitID - double pointer to the mex converted unit classification
+//                       code
+//          ppmxScale - double pointer to the mex converted value of one count of the
+//                      data of every entity
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxTimeStamp is filled.
+//          ppmxData is filled.
+//          ppmxSampleCount is filled.
+//          ppmxUnitID is filled.
+//          ppmxScale is filled.
+ns_RESULT fSegmentData(UINT32 hFile, size_t ncolsEntity, double *pdEntityID, size_t ncolsIndex, 
+                       double *pdIndex, const mxArray *pmxOptions, mxArray **ppmxTimeStamp, 
+                       mxArray **ppmxData, mxArray **ppmxSampleCount, mxArray **ppmxUnitID,
+                       mxArray **ppmxScale)
+{
+    UINT32 i;
+    UINT32 j;
+    double dTimeStamp;
+    double *pdData;
+    char *pcTempData;
+    double *pdTempTimeStamp;
+    double *pdTempSampleCount;
+    double *pdTempUnitID;
+    double *pdScale;
+    UINT32 dwSampleCount;
+    UINT32 dwUnitID;
+    size_t dwMaxSampleCount = 0;
+    size_t cbValue;
+    mxClassID classID;
+    ns_SEGMENTINFO nsSegmentInfo;
+    ns_SEGSOURCEINFO nsSegSourceInfo;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+
+    if (!fGetClassOption(pmxOptions, &classID))
+    {
+        mexPrintf("Class option must be 'double', 'single' or 'int16'.\n");
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxSampleCount = mxCreateString("");
+        *ppmxUnitID = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+    cbValue = fClassSize(classID);
+
+    // The waveforms are not loaded at all if only the time stamps are needed
+    if (0 != fGetOption(pmxOptions, "TimeStampsOnly", 0))
+    {
+        nsresult = fTimeStampsOnly(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, pmxOptions, 
+                                   "ns_GetSegmentData", ppmxTimeStamp);
+        if (ns_LIBERROR == nsresult)
+        {
+            *ppmxSampleCount = mxCreateString("");
+            *ppmxUnitID = mxCreateString("");
+            *ppmxData = mxCreateString("");
+            *ppmxScale = mxCreateString("");
+            return(ns_LIBERROR);
+        }
+        *ppmxSampleCount = mxCreateDoubleMatrix(0, 0, mxREAL);
+        *ppmxUnitID = mxCreateDoubleMatrix(0, 0, mxREAL);
+        *ppmxData = mxCreateDoubleMatrix(0, 0, mxREAL);
+        *ppmxScale = mxCreateDoubleMatrix(0, 0, mxREAL);
+        return(nsresult);
+    }
+
+    *ppmxScale = mxCreateDoubleMatrix(ncolsEntity, 1, mxREAL);
+    pdScale = mxGetPr(*ppmxScale);
+
+    // Determine the maximum data buffer necessary in case segment have different length
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        pdScale[i] = 1;
+        nsresult = ns_GetSegmentInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsSegmentInfo, 
+                                     sizeof(nsSegmentInfo));
+        if (0 == nsresult)
+        {
+            if (nsSegmentInfo.dwMaxSampleCount > dwMaxSampleCount)
+                dwMaxSampleCount = nsSegmentInfo.dwMaxSampleCount;
+
+            // Raw counts are given in the resolution of the first source
+            if ((mxINT16_CLASS == classID) &&
+                (0 == ns_GetSegmentSourceInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], 0, 
+                                              &nsSegSourceInfo, sizeof(nsSegSourceInfo))) &&
+                (0 < nsSegSourceInfo.dResolution))
+            {
+                pdScale[i] = nsSegSourceInfo.dResolution;
+            }
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetSegmentInfo).\n");
+            bEntity = FALSE;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetSegmentInfo!\n(Required for ns_GetSegmentData)\n");
+            *ppmxTimeStamp = mxCreateString("");
+            *ppmxSampleCount = mxCreateString("");
+            *ppmxUnitID = mxCreateString("");
+            *ppmxData = mxCreateString("");
+            *ppmxScale = mxCreateString("");
+            return(ns_LIBERROR);
+        }
+    }
+
+    // Check whether there actually is data or whether the size of it is defined
+    if (0 < dwMaxSampleCount)
+    {
+        const mwSize dims[] = {dwMaxSampleCount, ncolsIndex, ncolsEntity};
+        pdData = calloc(dwMaxSampleCount, 8);
+        *ppmxData = mxCreateNumericArray(3, dims, classID, mxREAL);
+        *ppmxTimeStamp = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+        *ppmxSampleCount = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+        *ppmxUnitID = mxCreateDoubleMatrix(ncolsIndex, ncolsEntity, mxREAL);
+        pcTempData = mxGetData(*ppmxData);
+        pdTempTimeStamp = mxGetPr(*ppmxTimeStamp);
+        pdTempSampleCount = mxGetPr(*ppmxSampleCount);
+        pdTempUnitID = mxGetPr(*ppmxUnitID);
+    }
+    else
+    {
+        mexPrintf("ns_GetSegmentInfo returned a ZERO sample count for the data!\n(Required for ns_GetSegmentData)\n");
+        *ppmxTimeStamp = mxCreateString("");
+        *ppmxSampleCount = mxCreateString("");
+        *ppmxUnitID = mxCreateString("");
+        *ppmxData = mxCreateString("");
+        *ppmxScale = mxCreateString("");
+        return(ns_LIBERROR);
+    }
+
+    // Load the data and fill the matrix
+    for (i = 0; i < ncolsEntity; ++i)
+    {
+        for (j = 0; j < ncolsIndex; ++j)
+        {
+            nsresult = ns_GetSegmentData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], (UINT32) pdIndex[j], 
+                                         &dTimeStamp, pdData, 8 * (UINT32) dwMaxSampleCount, &dwSampleCount, 
+                                         &dwUnitID);
+            if (0 == nsresult)
+            {
+                // totalrow * totalcol * 3rd + col * totalrow + row
+                if (dwSampleCount > dwMaxSampleCount)
+                    dwSampleCount = (UINT32) dwMaxSampleCount;
+                fConvertSamples(pdData, dwSampleCount, classID, pdScale[i], 
+                                pcTempData + (dwMaxSampleCount * ncolsIndex * i + dwMaxSampleCount * j) * cbValue);
+
+                *(pdTempTimeStamp + i * ncolsIndex + j) = dTimeStamp;
+                *(pdTempSampleCount + i * ncolsIndex + j) = dwSampleCount;
+                *(pdTempUnitID + i * ncolsIndex + j) = dwUnitID;
+            }
+            else if (-5 == nsresult)
+            {
+                break;
+            }
+            else if (-7 == nsresult)
+            {
+                if (TRUE == bIndex)
+                    mexPrintf("Some indeces do not exist (ns_GetSegmentData).\n");
+                bIndex = FALSE;
+                break;
+            }
+            else
+            {
+                mexPrintf("There was an error running ns_GetSegmentData!\n");
+                *ppmxTimeStamp = mxCreateString("");
+                *ppmxSampleCount = mxCreateString("");
+                *ppmxUnitID = mxCreateString("");
+                *ppmxData = mxCreateString("");
+                *ppmxScale = mxCreateString("");
+                free(pdData);
+                return(nsresult);
+            }
+        }
+    }
+
+    free(pdData);
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/7/2003
+// Purpose: Get neural data and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          dwIndex - index in the particular entity
+//          dwIndexCount - how many indeces are loaded
+//          ppmxData - double pointer to the mex converted data structure
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxData is filled.
+ns_RESULT fNeuralData(UINT32 hFile, size_t ncols, double *pdEntityID, UINT32 dwIndex, 
+                      UINT32 dwIndexCount, mxArray **ppmxData)
+{
+    UINT32 i;
+    UINT32 j;
+    double *pdData = 0;
+    double *pdTempData = 0;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+    BOOL bIndex = TRUE;
+
+    pdData = calloc(dwIndexCount, 8);
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetNeuralData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, dwIndexCount, pdData);
+
+        if (0 == i)
+        {
+            *ppmxData = mxCreateDoubleMatrix(dwIndexCount, ncols, mxREAL);
+            pdTempData = mxGetPr(*ppmxData);
+        }
+
+        if (nsresult == 0)
+        {
+            for (j = 0; j < dwIndexCount; ++j)
+            {
+                *(pdTempData + (i * dwIndexCount) + j) = *(pdData + j);
+            }
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetNeuralData).\n");
+            bEntity = FALSE;
+        }
+        else if (-7 == nsresult)
+        {
+            ns_ENTITYINFO nsEntityInfo;
+
+            if (TRUE == bIndex)
+                mexPrintf("Some indeces do not exist (ns_GetNeuralData).\n");
+
+            // Load the indeces up to the last one (pdData only holds dwIndexCount values)
+            if ((ns_GetEntityInfo(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], &nsEntityInfo, 
+                sizeof(ns_ENTITYINFO)) == 0) && (dwIndex < nsEntityInfo.dwItemCount) &&
+                (nsEntityInfo.dwItemCount - dwIndex < dwIndexCount))
+            {
+                if (ns_GetNeuralData(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dwIndex, 
+                    nsEntityInfo.dwItemCount - dwIndex, pdData) == 0)
+                {
+                    for (j = 0; j < nsEntityInfo.dwItemCount - dwIndex; ++j)
+                    {
+                        *(pdTempData + (i * dwIndexCount) + j) = *(pdData + j);
+                    }
+                }
+            }
+
+            bIndex = FALSE;
+        }
+        else
+        {
+            mexPrintf("There was an error running ns_GetNeuralData!\n");
+            *ppmxData = mxCreateString("");
+            break;
+        }
+    }
+
+    free(pdData);
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/7/2003
+// Purpose: Find index and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          ncols - number of elements in the array of entities (pdEntityID)
+//          pdEntityID - pointer to the array of entities to get info for
+//          dTime - time of the data to search for
+//          nFlag - flag specifying whether index to be retrieved belongs to data item
+//                 occuring before (-1), closest (0) or after (1) specified time
+//          ppmxIndex - double pointer to the mex converted index
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxIndex is filled.
+ns_RESULT fIndexByTime(UINT32 hFile, size_t ncols, double *pdEntityID, double dTime, INT32 nFlag, 
+                       mxArray **ppmxIndex)
+{
+    UINT32 i;
+    UINT32 dwIndex;
+    double *pdIndex = 0;
+    ns_RESULT nsresult = 0;
+    BOOL bEntity = TRUE;
+
+    for (i = 0; i < ncols; ++i)
+    {
+        nsresult = ns_GetIndexByTime(g_nsDllHandle, hFile, (UINT32) pdEntityID[i], dTime, nFlag, &dwIndex);
+
+        if (0 == i)
+        {
+            *ppmxIndex = mxCreateDoubleMatrix(ncols, 1, mxREAL);
+            pdIndex = mxGetPr(*ppmxIndex);
+        }
+
+        if (0 == nsresult)
+        {
+            *(pdIndex + i) = dwIndex;
+        }
+        else if (-5 == nsresult)
+        {
+            if (TRUE == bEntity)
+                mexPrintf("Some entities do not exist (ns_GetIndexByTime).\n");
+            bEntity = FALSE;
+        }
+        else 
+        {
+            mexPrintf("There was an error running ns_GetIndexByTime!\n");
+            *ppmxIndex = mxCreateString("");
+            break;
+        }
+    }
+
+    return(nsresult);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Find time and convert it into Matlab format
+// Inputs:  hFile - handle/ID number of the file
+//          dwEntityID - get info for this entity
+//          dwIndexCount - the number of indices we care about
+//          pdIndex - array of indices we want to know about
+//          ppmxTime - double pointer to the mex converted time
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxTime is filled.
+ns_RESULT fTimeByIndex(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndexCount, double * pdIndex, mxArray **ppmxTime)
+{
+    double * adTime = 0;
+    ns_RESULT nsresult = ns_BADINDEX;
+    UINT32 i;
+
+    // Let's get our space
+    *ppmxTime = mxCreateDoubleMatrix(dwIndexCount, 1, mxREAL);
+    adTime = mxGetPr(*ppmxTime);
+
+    // Now do them all
+    for (i = 0; i < dwIndexCount; ++i)
+    {
+        UINT32 dwIndex = (UINT32)pdIndex[i];
+        
+        nsresult = ns_GetTimeByIndex(g_nsDllHandle, hFile, dwEntityID, dwIndex, &adTime[i]);
+        if (nsresult != ns_OK)
+        {
+            mexPrintf("There was an error running ns_GetTimeByIndex!\n");
+            *ppmxTime = mxCreateString("");
+            return nsresult;
+        }
+    }
+    return nsresult;
+}
+
+
+// Author & Date: Almut Branner, 2/21/2003
+// Purpose: Get the extended error message to last error
+// Inputs:  ppmxErrorMsg - double pointer to the mex converted error message
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxErrorMsg is filled.
+ns_RESULT fLastErrorMsg(mxArray **ppmxErrorMsg)
+{
+    char szMsgBuffer[256];
+    ns_RESULT nsresult;
+
+    nsresult = ns_GetLastErrorMsg(g_nsDllHandle, szMsgBuffer, sizeof(szMsgBuffer));
+
+    if (nsresult == 0) 
+        *ppmxErrorMsg = mxCreateString(szMsgBuffer);
+    else 
+    {
+        mexPrintf("There was an error running ns_GetTimeByIndex!\n");
+        *ppmxErrorMsg = mxCreateString("");
+    }
+
+    return(nsresult);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Set the memory used to read analog data ahead and get the read-ahead counters
+// Inputs:  pmxMaxBytes - maximum number of bytes of all windows read ahead (0 = no read-ahead);
+//                        if it is not empty, all windows are dropped and the counters reset
+//          ppmxInfo - double pointer to the mex converted counters
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fReadAhead(const mxArray *pmxMaxBytes, mxArray **ppmxInfo)
+{
+    const char *aszInfoNames[] = {"MaxBytes","Bytes","Requests","Hits","HitRate","ReadAhead",
+                                  "Wasted","WastedBytes"};
+    double adValue[8];
+    int k;
+
+    fWaitReadAhead();
+
+    if (!mxIsEmpty(pmxMaxBytes))
+    {
+        fReleaseReadAhead(0, TRUE);
+        g_nReadAheadLimit = (size_t) MIN(mxGetScalar(pmxMaxBytes), (double) ((size_t) -1 / 2));
+        memset(&g_readAheadStats, 0, sizeof(g_readAheadStats));
+    }
+
+    adValue[0] = (double) g_nReadAheadLimit;
+    adValue[1] = (double) g_nReadAheadBytes;
+    adValue[2] = g_readAheadStats.dRequests;
+    adValue[3] = g_readAheadStats.dHits;
+    adValue[4] = (0 < g_readAheadStats.dRequests) ? 
+                 g_readAheadStats.dHits / g_readAheadStats.dRequests : mxGetNaN();
+    adValue[5] = g_readAheadStats.dWindows;
+    adValue[6] = g_readAheadStats.dWasted;
+    adValue[7] = g_readAheadStats.dWastedBytes;
+
+    *ppmxInfo = mxCreateStructMatrix(1, 1, 8, aszInfoNames);
+    for (k = 0; k < 8; ++k)
+        mxSetField(*ppmxInfo, 0, aszInfoNames[k], mxCreateScalarDouble(adValue[k]));
+
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Set the memory of the analog block cache, empty it and get its counters
+// Inputs:  pmxArgument - empty to only get the counters, the maximum number of bytes of all
+//                        blocks (0 = no cache) or 'flush' to drop all blocks and reset the
+//                        counters
+//          ppmxInfo - double pointer to the mex converted counters
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fAnalogCache(const mxArray *pmxArgument, mxArray **ppmxInfo)
+{
+    const char *aszInfoNames[] = {"MaxBytes","Bytes","Blocks","BlockSize","Hits","Misses","HitRate",
+                                  "Evictions"};
+    double adValue[8];
+    int k;
+
+    // Blocks are only added while data is read
+    fWaitReadAhead();
+
+    if (mxIsChar(pmxArgument))
+    {
+        fCacheFlush(0, TRUE);
+        memset(&g_cacheStats, 0, sizeof(g_cacheStats));
+    }
+    else if (!mxIsEmpty(pmxArgument))
+    {
+        g_nCacheLimit = (size_t) MIN(mxGetScalar(pmxArgument), (double) ((size_t) -1 / 2));
+        fCacheTrim(g_nCacheLimit);
+    }
+
+    adValue[0] = (double) g_nCacheLimit;
+    adValue[1] = (double) g_nCacheBytes;
+    adValue[2] = (double) g_nCacheBlocks;
+    adValue[3] = CACHE_BLOCK_SIZE;
+    adValue[4] = g_cacheStats.dHits;
+    adValue[5] = g_cacheStats.dMisses;
+    adValue[6] = (0 < g_cacheStats.dHits + g_cacheStats.dMisses) ? 
+                 g_cacheStats.dHits / (g_cacheStats.dHits + g_cacheStats.dMisses) : mxGetNaN();
+    adValue[7] = g_cacheStats.dEvictions;
+
+    *ppmxInfo = mxCreateStructMatrix(1, 1, 8, aszInfoNames);
+    for (k = 0; k < 8; ++k)
+        mxSetField(*ppmxInfo, 0, aszInfoNames[k], mxCreateScalarDouble(adValue[k]));
+
+    return(ns_OK);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Set the class of the sidecar files analog data is kept in and get their counters
+// Inputs:  szClass - 'off' (no sidecars), 'single' or 'int16'; empty to only get the counters
+//          ppmxInfo - double pointer to the mex converted counters
+// Outputs: ns_RESULT - what error was returned by the function (should be 0)
+//          ppmxInfo is filled.
+ns_RESULT fAnalogSidecar(const char *szClass, mxArray **ppmxInfo)
+{
+    const char *aszInfoNames[] = {"Class","Sidecars","Hits","Written"};
+    double dSidecars = 0;
+    int i;
+
+    fWaitReadAhead();
+
+    // Sidecars of the previous class are unmapped, those of the new class are
+    // mapped when their entities are read next
+    if (0 != strlen(szClass))
+    {
+        fReleaseSidecars(0, TRUE);
+        g_sidecarClass = mxUNKNOWN_CLASS;
+        if (0 == strcmp(szClass, "single"))
+            g_sidecarClass = mxSINGLE_CLASS;
+        if (0 == strcmp(szClass, "int16"))
+            g_sidecarClass = mxINT16_CLASS;
+    }
+
+    for (i = 0; i < MAX_SIDECARS; ++i)
+    {
+        if (g_aSidecars[i].bValid && g_aSidecars[i].map.pvData)
+            dSidecars += 1;
+    }
+
+    *ppmxInfo = mxCreateStructMatrix(1, 1, 4, aszInfoNames);
+    mxSetField(*ppmxInfo, 0, aszInfoNames[0], mxCreateString((mxSINGLE_CLASS == g_sidecarClass) ? "single" :
+                                                             (mxINT16_CLASS == g_sidecarClass) ? "int16" : "off"));
+    mxSetField(*ppmxInfo, 0, aszInfoNames[1], mxCreateScalarDouble(dSidecars));
+    mxSetField(*ppmxInfo, 0, aszInfoNames[2], mxCreateScalarDouble(g_dSidecarHits));
+    mxSetField(*ppmxInfo, 0, aszInfoNames[3], mxCreateScalarDouble(g_dSidecarsWritten));
+
+    return(ns_OK);
+}
+
+// Author & Date:       Kirk Korver     17 Dec 2003
+// Purpose: Unload the previous library if it was loaded, then load this DLL
+// Inputs:
+//  szName - the name of the library to load
+// Outputs:
+//  ns_OK if life is good; ns_LIBERROR, if the DLL couldn't be loaded
+ns_RESULT fSetLibrary(const char * szName)
+{
+    fReleaseAll();
+
+    if (g_nsDllHandle)
+        ns_CloseLibrary(g_nsDllHandle);
+
+    g_nsDllHandle = ns_LoadLibrary(szName);
+    g_nThreadSafe = -1;
+
+    return g_nsDllHandle ? ns_OK : ns_LIBERROR;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Error handling functions
+//
+//      If an error occurs, the output arguments are filled with an empty
+//      string, a MATLAB error message is created and the program returns
+//      back to MATLAB with a general library error.
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Check whether the right amount of arguments were given by Matlab
+// Inputs:  pplhs - double pointer to the return arguments of the function
+//          nRight - number of right hand arguments
+//          nLeft - number of left hand arguments
+//          nExpRight - number of expected right hand arguments
+//          nExpLeft - number of expected left hand arguments
+// Outputs: BOOL - is expected number of arguments the same as actual
+//          If there is an error the left hand arguments are filled in with blanks
+BOOL fCheckNumArguments(mxArray **pplhs, int nRight, int nLeft, int nExpRight, int nExpLeft)
+{
+    int i;
+
+    // Check for proper number of input and output arguments.
+    if ((nRight != nExpRight) || (nLeft != nExpLeft))
+    {
+        mexPrintf("Check number of input arguments.\n");
+        
+        *pplhs = mxCreateScalarDouble(ns_LIBERROR);
+        for (i = 1; i < nExpLeft; ++i)
+        {
+            *(pplhs + i) = mxCreateString("");
+        }
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Check whether the library is loaded already
+// Inputs:  pplhs - double pointer to the return of the function
+//          nLeft - number of left hand arguments
+// Outputs: BOOL - FALSE if no file or library were loaded yet
+//          If there is an error the left hand arguments are filled in with blanks
+BOOL fCheckLoad(mxArray **pplhs, int nLeft)
+{
+    int i;
+
+    // Check whether the DLL was loaded.
+    if (!g_nsDllHandle)
+    {
+        mexPrintf("Call ns_SetLibrary first! Process interrupted!\n");
+        
+        *pplhs = mxCreateScalarDouble(ns_LIBERROR);
+        for (i = 1; i < nLeft; ++i)
+        {
+            *(pplhs + i) = mxCreateString("");
+        }
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+// Author & Date: Almut Branner, 2/6/2003
+// Purpose: Main/entry function for the mex DLL
+//      The main function receives input and output arguments from the
+//      the MATLAB m-files for each Neuroshare function. An additional
+//      number identifies which Neuroshare function is called.
+//
+//      The number of input and output arguments and the format of the
+//      input arguments are checked based on which function was called.
+//      This function then calls a separate function for each Neuroshare
+//      function. Input arguments and mxArray output pointers are passed
+//      to these functions and filled there.
+//
+//      After returning from the specific functions, the main function then
+//      converts the result (ns_RESULT) into an mxArray and returns with all
+//      output arguments back to MATLAB.
+// Inputs:  nlhs - number of left hand side arguments
+//          plhs - pointer to array of left hand side arguments
+//          nrhs - number of right hand side arguments
+//          prhs - pointer to array of right hand side arguments
+// Outputs: plhs is filled.
+void mexFunction(
+    int nlhs,              // Number of left hand side (output) arguments
+    mxArray *plhs[],       // Array of left hand side arguments
+    int nrhs,              // Number of right hand side (input) arguments
+    const mxArray *prhs[]  // Array of right hand side arguments
+)
+{
+    double dFunc;
+    size_t mrows, ncols;
+
+    // Check for proper number of input arguments.
+    if (nrhs < 1)
+    {
+        mexErrMsgTxt("At least one input required.");
+    }
+    
+    // The first input must be a noncomplex scalar double.
+    mrows = mxGetM(prhs[0]);
+    ncols = mxGetN(prhs[0]);
+    if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || !(mrows == 1 && ncols == 1))
+    {
+        mexErrMsgTxt("Input must be a noncomplex scalar double.");
+    }
+
+    // Assign pointers to each input and output.
+    dFunc = mxGetScalar(prhs[0]);
+
+    // A library that is not multithread safe must not be called while data is read ahead
+    if (1 != g_nThreadSafe)
+        fWaitReadAhead();
+
+    switch ((int) dFunc)
+    {
+    case 1:     // function ns_OpenFile
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2)) 
+                return;
+
+            // Input must be a string and a row vector.
+            if ((mxIsChar(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1))
+            {
+                mexPrintf("Input must be a string and a vector.\n");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+    
+            // Get the length of the input string and allocate memory for it.
+            {
+                char *szFile;
+                size_t cbBuffer;
+                int status;
+                ns_RESULT fresult;
+
+                cbBuffer = (mxGetM(prhs[1]) * mxGetN(prhs[1])) + 1;
+                szFile = mxCalloc(cbBuffer, sizeof(char));
+
+                // Copy the string data from prhs[0] into a C string szFile.
+                status = mxGetString(prhs[1], szFile, cbBuffer);
+                if (status != 0) 
+                    mexWarnMsgTxt("Not enough space. String is truncated.\n");
+
+                // Check whether a DLL and a data file were loaded.
+                if (!fCheckLoad(&plhs[0], nlhs)) 
+                    return;
+                
+                fresult = fOpenFile(szFile, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 2:     // function ns_GetLibraryInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 1, 2)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            {
+                ns_RESULT fresult;
+
+                fresult = fLibInfo(&plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 3:     // function ns_GetFileInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            // Input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("Input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+
+                fresult = fFileInfo(hFile, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 4:     // function ns_GetEntityInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            // hFile input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                ns_RESULT fresult;
+                
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = (UINT32)mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = (UINT32)mxGetM(prhs[2]);
+
+                fresult = fEntityInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 5:     // function ns_GetEventInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or row vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+
+                fresult = fEventInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 6:     // function ns_GetEventData
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 6)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            // Input arguments must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input arguments must be a double scalar.\n");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID and Index input must be a scalar or a row vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
+                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            {
+                mexPrintf("EntityID and Index input arguments must be a double scalar or vector.\n");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[4]))
+            {
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                double *pdIndex;
+                size_t ncolsEntity = 0;
+                size_t ncolsIndex = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncolsEntity = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncolsEntity = mxGetM(prhs[2]);
+                pdIndex = mxGetPr(prhs[3]);
+                if (mxGetM(prhs[3]) == 1)
+                    ncolsIndex = mxGetN(prhs[3]);
+                if (mxGetN(prhs[3]) == 1)
+                    ncolsIndex = mxGetM(prhs[3]);
+
+                fresult = fEventData(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, prhs[4], 
+                                     &plhs[1], &plhs[2], &plhs[3], &plhs[4], &plhs[5]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 7:     // function ns_GetAnalogInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            // hFile input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+
+                fresult = fAnalogInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 8:     // function ns_GetAnalogData
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 5)) 
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs)) 
+                return;
+
+            // Input arguments except EntityID must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
+            {
+                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Index and IndexCount must lie within the indexes of the library.
+            if (!fIsIndexRange(prhs[3], prhs[4]))
+            {
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
+            {
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                UINT32 dwIndex;
+                UINT32 dwIndexCount;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+                dwIndex = (UINT32) mxGetScalar(prhs[3]);
+                dwIndexCount = (UINT32) mxGetScalar(prhs[4]);
+
+                fresult = fAnalogData(hFile, ncols, pdEntityID, dwIndex, dwIndexCount, prhs[5], 
+                                      &plhs[1], &plhs[2], &plhs[3], &plhs[4]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 9:     // function ns_GetSegmentInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2))
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile input arguments must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+
+                fresult = fSegmentInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 10:    // function ns_GetSegmentSourceInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 2))
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile nput arguments must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input arguments must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID and SourceID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
+                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            {
+                mexPrintf("EntityID and Source ID inputs must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncolsEntity = 0;
+                double *pdSourceID;
+                size_t ncolsSource = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncolsEntity = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncolsEntity = mxGetM(prhs[2]);
+                pdSourceID = mxGetPr(prhs[3]);
+                if (mxGetM(prhs[3]) == 1)
+                    ncolsSource = mxGetN(prhs[3]);
+                if (mxGetN(prhs[3]) == 1)
+                    ncolsSource = mxGetM(prhs[3]);
+
+                fresult = fSegmentSourceInfo(hFile, ncolsEntity, pdEntityID, ncolsSource,
+                                             pdSourceID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 11:    // function ns_GetSegmentData
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 6))
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID and Index input must be a scalar or a row vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
+                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            {
+                mexPrintf("EntityID and Index inputs must be a double scalar or vector.\n");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[4]))
+            {
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncolsEntity = 0;
+                double *pdIndex;
+                size_t ncolsIndex = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncolsEntity = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncolsEntity = mxGetM(prhs[2]);
+                pdIndex = mxGetPr(prhs[3]);
+                if (mxGetM(prhs[3]) == 1)
+                    ncolsIndex = mxGetN(prhs[3]);
+                if (mxGetN(prhs[3]) == 1)
+                    ncolsIndex = mxGetM(prhs[3]);
+
+                fresult = fSegmentData(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, prhs[4], 
+                                       &plhs[1], &plhs[2], &plhs[3], &plhs[4], &plhs[5]);
+
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 12:    // function ns_GetNeuralInfo
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2))
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile input arguments must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input arguments must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                ns_RESULT fresult;
+
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+
+                fresult = fNeuralInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 13:    // function ns_GetNeuralData
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 2))
+                return;
+
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // Input arguments except EntityID must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
+            {
+                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Index and IndexCount must lie within the indexes of the library.
+            if (!fIsIndexRange(prhs[3], prhs[4]))
+            {
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
+                return;
+            }
+
+            // EntityID input arguments must be a scalar.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            {
+                mexPrintf("EntityID input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
 
-    // Check for proper number of input and output arguments.
-    if ((nRight != nExpRight) || (nLeft != nExpLeft))
-    {
-        mexPrintf("Check number of input arguments.\n");
-        
-        *pplhs = mxCreateScalarDouble(ns_LIBERROR);
-        for (i = 1; i < nExpLeft; ++i)
-        {
-            *(pplhs + i) = mxCreateString("");
-        }
-        return(FALSE);
-    }
-    return(TRUE);
-}
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                UINT32 dwIndex;
+                UINT32 dwIndexCount;
+                ns_RESULT fresult;
 
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+                dwIndex = (UINT32) mxGetScalar(prhs[3]);
+                dwIndexCount = (UINT32) mxGetScalar(prhs[4]);
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Check whether the library is loaded already
-// Inputs:  pplhs - double pointer to the return of the function
-//          nLeft - number of left hand arguments
-// Outputs: BOOL - FALSE if no file or library were loaded yet
-//          If there is an error the left hand arguments are filled in with blanks
-BOOL fCheckLoad(mxArray **pplhs, int nLeft)
-{
-    int i;
+                fresult = fNeuralData(hFile, ncols, pdEntityID, dwIndex, dwIndexCount, &plhs[1]);
 
-    // Check whether the DLL was loaded.
-    if (!g_nsDllHandle)
-    {
-        mexPrintf("Call ns_SetLibrary first! Process interrupted!\n");
-        
-        *pplhs = mxCreateScalarDouble(ns_LIBERROR);
-        for (i = 1; i < nLeft; ++i)
-        {
-            *(pplhs + i) = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
         }
-        return(FALSE);
-    }
-    return(TRUE);
-}
+        break;
+    case 14:    // function ns_CloseFile
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 1))
+                return;
 
-// Author & Date: Almut Branner, 2/6/2003
-// Purpose: Main/entry function for the mex DLL
-//      The main function receives input and output arguments from the
-//      the MATLAB m-files for each Neuroshare function. An additional
-//      number identifies which Neuroshare function is called.
-//
-//      The number of input and output arguments and the format of the
-//      input arguments are checked based on which function was called.
-//      This function then calls a separate function for each Neuroshare
-//      function. Input arguments and mxArray output pointers are passed
-//      to these functions and filled there.
-//
-//      After returning from the specific functions, the main function then
-//      converts the result (ns_RESULT) into an mxArray and returns with all
-//      output arguments back to MATLAB.
-// Inputs:  nlhs - number of left hand side arguments
-//          plhs - pointer to array of left hand side arguments
-//          nrhs - number of right hand side arguments
-//          prhs - pointer to array of right hand side arguments
-// Outputs: plhs is filled.
-void mexFunction(
-    int nlhs,              // Number of left hand side (output) arguments
-    mxArray *plhs[],       // Array of left hand side arguments
-    int nrhs,              // Number of right hand side (input) arguments
-    const mxArray *prhs[]  // Array of right hand side arguments
-)
-{
-    double dFunc;
-    size_t mrows, ncols;
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
 
-    // Check for proper number of input arguments.
-    if (nrhs < 1)
-    {
-        mexErrMsgTxt("At least one input required.");
-    }
-    
-    // The first input must be a noncomplex scalar double.
-    mrows = mxGetM(prhs[0]);
-    ncols = mxGetN(prhs[0]);
-    if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || !(mrows == 1 && ncols == 1))
-    {
-        mexErrMsgTxt("Input must be a noncomplex scalar double.");
-    }
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("Input arguments must be a double scalar.\n");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
 
-    // Assign pointers to each input and output.
-    dFunc = mxGetScalar(prhs[0]);
+            {
+                UINT32 hFile;
+                ns_RESULT fresult;
 
-    switch ((int) dFunc)
-    {
-    case 1:     // function ns_OpenFile
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                fReleaseFile(hFile);
+                fresult = ns_CloseFile(g_nsDllHandle, hFile);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 15:    // function ns_GetIndexByTime
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 2))
                 return;
 
-            // Input must be a string and a row vector.
-            if ((mxIsChar(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1))
+            // Check whether a DLL and a data file were loaded.
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // Input arguments except Entity ID must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("Input must be a string and a vector.\n");
+                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
-    
-            // Get the length of the input string and allocate memory for it.
+
+            // EntityID input arguments must be a scalar or vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
-                char *szFile;
-                size_t cbBuffer;
-                int status;
-                ns_RESULT fresult;
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
 
-                cbBuffer = (mxGetM(prhs[1]) * mxGetN(prhs[1])) + 1;
-                szFile = mxCalloc(cbBuffer, sizeof(char));
+            {
+                UINT32 hFile;
+                double *pdEntityID;
+                size_t ncols = 0;
+                double dTime;
+                INT32 nFlag;
+                ns_RESULT fresult;
 
-                // Copy the string data from prhs[0] into a C string szFile.
-                status = mxGetString(prhs[1], szFile, cbBuffer);
-                if (status != 0) 
-                    mexWarnMsgTxt("Not enough space. String is truncated.\n");
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+                dTime = (double) mxGetScalar(prhs[3]);
+                nFlag = (INT32) mxGetScalar(prhs[4]);
 
-                // Check whether a DLL and a data file were loaded.
-                if (!fCheckLoad(&plhs[0], nlhs)) 
-                    return;
-                
-                fresult = fOpenFile(szFile, &plhs[1]);
+                fresult = fIndexByTime(hFile, ncols, pdEntityID, dTime, nFlag, &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 2:     // function ns_GetLibraryInfo
+    case 16:    // function ns_GetTimeByIndex
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 1, 2)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckLoad(&plhs[0], nlhs))
+                return;
+
+            // hFile input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("hFile input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // EntityID input must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            {
+                mexPrintf("EntityID input must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Index can be a vector or a scalar
+            if ((mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            {
+                mexPrintf("Index must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
+            }
 
             {
+                UINT32 hFile;
+                UINT32 dwEntityID;
+                double * pdIndex = 0;
+                size_t dwIndexCount;
                 ns_RESULT fresult;
 
-                fresult = fLibInfo(&plhs[1]);
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                dwEntityID = (UINT32) mxGetScalar(prhs[2]);
+
+                dwIndexCount = MAX(mxGetM(prhs[3]), mxGetN(prhs[3]));
+                pdIndex = mxGetPr(prhs[3]);
+
+
+                fresult = fTimeByIndex(hFile, dwEntityID, (UINT32) dwIndexCount, pdIndex, &plhs[1]);
+
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 3:     // function ns_GetFileInfo
+    case 17:    // function ns_GetLastErrorMsg
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 1, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // Input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
             {
-                mexPrintf("Input must be a double scalar.\n");
-                plhs[1] = mxCreateString("");
-                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                ns_RESULT fresult;
+
+                fresult = fLastErrorMsg(&plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 18:    // function ns_SetLibrary
+        {
+            // Check for proper number of input and output arguments.
+            // RHS args:
+            //  18 - code to mean ns_SetLibrary
+            //  szName - the name of the DLL to load
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 1))
                 return;
-            }
 
             {
-                UINT32 hFile;
+                char * szFile;
+                size_t cbBuffer;
+                int status;
                 ns_RESULT fresult;
 
-                hFile = (UINT32) mxGetScalar(prhs[1]);
+                cbBuffer = (mxGetM(prhs[1]) * mxGetN(prhs[1])) + 1;
+                szFile = mxCalloc(cbBuffer, sizeof(char));
 
-                fresult = fFileInfo(hFile, &plhs[1]);
+                // Copy the string data from rhs into a C string.
+                status = mxGetString(prhs[1], szFile, cbBuffer);
+                if (status != 0) 
+                    mexWarnMsgTxt("Not enough space. String is truncated.\n");
+
+                // Ok...now we've got the name, let's rock'n roll
+                fresult = fSetLibrary(szFile);
                 plhs[0] = mxCreateScalarDouble(fresult);
+                mxFree(szFile);
+
+                if (fresult == ns_LIBERROR)
+                {
+                    mexWarnMsgTxt("Unable to load this DLL");
+                }
             }
         }
         break;
-    case 4:     // function ns_GetEntityInfo
+    case 19:    // function ns_OpenAnalogStream
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 7, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // hFile input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // Input arguments except EntityID and Options must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1) ||
+                (mxIsDouble(prhs[5]) != 1) || (mxGetM(prhs[5]) != 1) || (mxGetN(prhs[5]) != 1))
             {
-                mexPrintf("hFile input must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // EntityID input must be a scalar or a vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            // Index and IndexCount must lie within the indexes of the library.
+            if (!fIsIndexRange(prhs[3], prhs[4]))
             {
-                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
                 plhs[1] = mxCreateString("");
-                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
                 return;
             }
 
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
-                UINT32 hFile;
-                double *pdEntityID;
-                size_t ncols = 0;
-                ns_RESULT fresult;
-                
-                hFile = (UINT32) mxGetScalar(prhs[1]);
-                pdEntityID = mxGetPr(prhs[2]);
-                if (mxGetM(prhs[2]) == 1)
-                    ncols = (UINT32)mxGetN(prhs[2]);
-                if (mxGetN(prhs[2]) == 1)
-                    ncols = (UINT32)mxGetM(prhs[2]);
-
-                fresult = fEntityInfo(hFile, ncols, pdEntityID, &plhs[1]);
-                plhs[0] = mxCreateScalarDouble(fresult);
-            }
-        }
-        break;
-    case 5:     // function ns_GetEventInfo
-        {
-            // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
-                return;
-
-            // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs))
-                return;
-
-            // hFile input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
-            {
-                mexPrintf("hFile input must be a double scalar.\n");
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // EntityID input must be a scalar or a vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[6]))
             {
-                mexPrintf("EntityID input must be a double scalar or row vector.\n");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
@@ -1887,6 +9724,9 @@ void mexFunction(
                 UINT32 hFile;
                 double *pdEntityID;
                 size_t ncols = 0;
+                UINT32 dwIndex;
+                UINT32 dwIndexCount;
+                UINT32 dwChunkSize;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
@@ -1895,38 +9735,31 @@ void mexFunction(
                     ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
+                dwIndex = (UINT32) mxGetScalar(prhs[3]);
+                dwIndexCount = (UINT32) mxGetScalar(prhs[4]);
+                dwChunkSize = (UINT32) mxGetScalar(prhs[5]);
 
-                fresult = fEventInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                fresult = fOpenAnalogStream(hFile, ncols, pdEntityID, dwIndex, dwIndexCount, 
+                                            dwChunkSize, prhs[6], &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 6:     // function ns_GetEventData
+    case 20:    // function ns_ReadAnalogStream
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 4)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 5))
                 return;
 
             // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // Input arguments must be a scalar.
+            // hStream input must be a scalar.
             if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
             {
-                mexPrintf("hFile input arguments must be a double scalar.\n");
-                plhs[3] = mxCreateString("");
-                plhs[2] = mxCreateString("");
-                plhs[1] = mxCreateString("");
-                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
-                return;
-            }
-
-            // EntityID and Index input must be a scalar or a row vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
-                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
-            {
-                mexPrintf("EntityID and Index input arguments must be a double scalar or vector.\n");
+                mexPrintf("hStream input must be a double scalar.\n");
+                plhs[4] = mxCreateString("");
                 plhs[3] = mxCreateString("");
                 plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
@@ -1935,93 +9768,75 @@ void mexFunction(
             }
 
             {
-                UINT32 hFile;
-                double *pdEntityID;
-                double *pdIndex;
-                size_t ncolsEntity = 0;
-                size_t ncolsIndex = 0;
+                ANALOGSTREAM *pStream;
                 ns_RESULT fresult;
 
-                hFile = (UINT32) mxGetScalar(prhs[1]);
-                pdEntityID = mxGetPr(prhs[2]);
-                if (mxGetM(prhs[2]) == 1)
-                    ncolsEntity = mxGetN(prhs[2]);
-                if (mxGetN(prhs[2]) == 1)
-                    ncolsEntity = mxGetM(prhs[2]);
-                pdIndex = mxGetPr(prhs[3]);
-                if (mxGetM(prhs[3]) == 1)
-                    ncolsIndex = mxGetN(prhs[3]);
-                if (mxGetN(prhs[3]) == 1)
-                    ncolsIndex = mxGetM(prhs[3]);
+                pStream = fGetStream(mxGetScalar(prhs[1]));
+                if (!pStream)
+                {
+                    mexPrintf("Invalid stream handle (ns_ReadAnalogStream).\n");
+                    plhs[4] = mxCreateString("");
+                    plhs[3] = mxCreateString("");
+                    plhs[2] = mxCreateString("");
+                    plhs[1] = mxCreateString("");
+                    plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                    return;
+                }
 
-                fresult = fEventData(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, &plhs[1], 
-                                     &plhs[2], &plhs[3]);
+                fresult = fReadAnalogStream(pStream, &plhs[1], &plhs[2], &plhs[3], &plhs[4]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 7:     // function ns_GetAnalogInfo
+    case 21:    // function ns_CloseAnalogStream
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2)) 
-                return;
-
-            // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 1))
                 return;
 
-            // hFile input must be a scalar.
             if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
             {
-                mexPrintf("hFile input must be a double scalar.\n");
-                plhs[1] = mxCreateString("");
-                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
-                return;
-            }
-
-            // EntityID input must be a scalar or a vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
-            {
-                mexPrintf("EntityID input must be a double scalar or vector.\n");
-                plhs[1] = mxCreateString("");
+                mexPrintf("hStream input must be a double scalar.\n");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
             {
-                UINT32 hFile;
-                double *pdEntityID;
-                size_t ncols = 0;
-                ns_RESULT fresult;
+                ANALOGSTREAM *pStream;
 
-                hFile = (UINT32) mxGetScalar(prhs[1]);
-                pdEntityID = mxGetPr(prhs[2]);
-                if (mxGetM(prhs[2]) == 1)
-                    ncols = mxGetN(prhs[2]);
-                if (mxGetN(prhs[2]) == 1)
-                    ncols = mxGetM(prhs[2]);
+                pStream = fGetStream(mxGetScalar(prhs[1]));
+                if (!pStream)
+                {
+                    mexPrintf("Invalid stream handle (ns_CloseAnalogStream).\n");
+                    plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                    return;
+                }
 
-                fresult = fAnalogInfo(hFile, ncols, pdEntityID, &plhs[1]);
-                plhs[0] = mxCreateScalarDouble(fresult);
+                fFreeStream(pStream);
+                plhs[0] = mxCreateScalarDouble(ns_OK);
             }
         }
         break;
-    case 8:     // function ns_GetAnalogData
+    case 22:    // function ns_GetAnalogDataByTime
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 3)) 
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 7))
                 return;
 
             // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs)) 
+            if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // Input arguments except EntityID must be a scalar.
+            // Input arguments except EntityID and Options must be a scalar.
             if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
                 (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
                 (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
                 plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
@@ -2032,6 +9847,23 @@ void mexFunction(
             if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
                 mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
+            {
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
                 plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
@@ -2042,8 +9874,8 @@ void mexFunction(
                 UINT32 hFile;
                 double *pdEntityID;
                 size_t ncols = 0;
-                UINT32 dwIndex;
-                UINT32 dwIndexCount;
+                double dStartTime;
+                double dEndTime;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
@@ -2052,29 +9884,45 @@ void mexFunction(
                     ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
-                dwIndex = (UINT32) mxGetScalar(prhs[3]);
-                dwIndexCount = (UINT32) mxGetScalar(prhs[4]);
+                dStartTime = mxGetScalar(prhs[3]);
+                dEndTime = mxGetScalar(prhs[4]);
 
-                fresult = fAnalogData(hFile, ncols, pdEntityID, dwIndex, dwIndexCount, &plhs[1], 
-                                      &plhs[2]);
+                fresult = fAnalogDataByTime(hFile, ncols, pdEntityID, dStartTime, dEndTime, prhs[5], 
+                                            &plhs[1], &plhs[2], &plhs[3], &plhs[4], &plhs[5], &plhs[6]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 9:     // function ns_GetSegmentInfo
+    case 23:    // function ns_GetAnalogEnvelope
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 7, 4))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // hFile input arguments must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // Input arguments except EntityID and Options must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1) ||
+                (mxIsDouble(prhs[5]) != 1) || (mxGetM(prhs[5]) != 1) || (mxGetN(prhs[5]) != 1))
             {
-                mexPrintf("hFile input must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Columns input must be a positive integer.
+            if (!(mxGetScalar(prhs[5]) >= 1) || (mxGetScalar(prhs[5]) != floor(mxGetScalar(prhs[5]))))
+            {
+                mexPrintf("Columns input must be a positive integer.\n");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
@@ -2084,6 +9932,18 @@ void mexFunction(
             if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
                 mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[6]))
+            {
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
@@ -2093,91 +9953,66 @@ void mexFunction(
                 UINT32 hFile;
                 double *pdEntityID;
                 size_t ncols = 0;
+                double dStartTime;
+                double dEndTime;
+                size_t nColumns;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
                 pdEntityID = mxGetPr(prhs[2]);
-                pdEntityID = mxGetPr(prhs[2]);
                 if (mxGetM(prhs[2]) == 1)
                     ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
+                dStartTime = mxGetScalar(prhs[3]);
+                dEndTime = mxGetScalar(prhs[4]);
+                nColumns = (size_t) mxGetScalar(prhs[5]);
 
-                fresult = fSegmentInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                fresult = fAnalogEnvelope(hFile, ncols, pdEntityID, dStartTime, dEndTime, nColumns, 
+                                          prhs[6], &plhs[1], &plhs[2], &plhs[3]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 10:    // function ns_GetSegmentSourceInfo
+    case 24:    // function ns_GetAnalogEpochs
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 7, 4))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // hFile nput arguments must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
-            {
-                mexPrintf("hFile input arguments must be a double scalar.\n");
-                plhs[1] = mxCreateString("");
-                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
-                return;
-            }
-
-            // EntityID and SourceID input must be a scalar or a vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
-                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            // Input arguments except EntityID, TriggerTime and Options must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1) ||
+                (mxIsDouble(prhs[5]) != 1) || (mxGetM(prhs[5]) != 1) || (mxGetN(prhs[5]) != 1))
             {
-                mexPrintf("EntityID and Source ID inputs must be a double scalar or vector.\n");
+                mexPrintf("Input arguments except EntityID, TriggerTime and Options must be a double scalar.\n");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
-                UINT32 hFile;
-                double *pdEntityID;
-                size_t ncolsEntity = 0;
-                double *pdSourceID;
-                size_t ncolsSource = 0;
-                ns_RESULT fresult;
-
-                hFile = (UINT32) mxGetScalar(prhs[1]);
-                pdEntityID = mxGetPr(prhs[2]);
-                if (mxGetM(prhs[2]) == 1)
-                    ncolsEntity = mxGetN(prhs[2]);
-                if (mxGetN(prhs[2]) == 1)
-                    ncolsEntity = mxGetM(prhs[2]);
-                pdSourceID = mxGetPr(prhs[3]);
-                if (mxGetM(prhs[3]) == 1)
-                    ncolsSource = mxGetN(prhs[3]);
-                if (mxGetN(prhs[3]) == 1)
-                    ncolsSource = mxGetM(prhs[3]);
-
-                fresult = fSegmentSourceInfo(hFile, ncolsEntity, pdEntityID, ncolsSource,
-                                             pdSourceID, &plhs[1]);
-                plhs[0] = mxCreateScalarDouble(fresult);
-            }
-        }
-        break;
-    case 11:    // function ns_GetSegmentData
-        {
-            // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 5))
-                return;
-
-            // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs))
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
+            }
 
-            // hFile input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // TriggerTime input must be a vector or empty.
+            if ((mxIsDouble(prhs[3]) != 1) || 
+                !((mxGetM(prhs[3]) <= 1) || (mxGetN(prhs[3]) <= 1)))
             {
-                mexPrintf("hFile input must be a double scalar.\n");
-                plhs[4] = mxCreateString("");
+                mexPrintf("TriggerTime input must be a double vector or empty.\n");
                 plhs[3] = mxCreateString("");
                 plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
@@ -2185,12 +10020,9 @@ void mexFunction(
                 return;
             }
 
-            // EntityID and Index input must be a scalar or a row vector.
-            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
-                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[6]))
             {
-                mexPrintf("EntityID and Index inputs must be a double scalar or vector.\n");
-                plhs[4] = mxCreateString("");
                 plhs[3] = mxCreateString("");
                 plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
@@ -2201,49 +10033,61 @@ void mexFunction(
             {
                 UINT32 hFile;
                 double *pdEntityID;
-                size_t ncolsEntity = 0;
-                double *pdIndex;
-                size_t ncolsIndex = 0;
+                size_t ncols = 0;
+                double *pdTrigger;
+                size_t nTrials;
+                double dPreTime;
+                double dPostTime;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
                 pdEntityID = mxGetPr(prhs[2]);
                 if (mxGetM(prhs[2]) == 1)
-                    ncolsEntity = mxGetN(prhs[2]);
+                    ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
-                    ncolsEntity = mxGetM(prhs[2]);
-                pdIndex = mxGetPr(prhs[3]);
-                if (mxGetM(prhs[3]) == 1)
-                    ncolsIndex = mxGetN(prhs[3]);
-                if (mxGetN(prhs[3]) == 1)
-                    ncolsIndex = mxGetM(prhs[3]);
-
-                fresult = fSegmentData(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, &plhs[1],
-                                       &plhs[2], &plhs[3], &plhs[4]);
+                    ncols = mxGetM(prhs[2]);
+                pdTrigger = mxGetPr(prhs[3]);
+                nTrials = mxGetNumberOfElements(prhs[3]);
+                dPreTime = mxGetScalar(prhs[4]);
+                dPostTime = mxGetScalar(prhs[5]);
 
+                fresult = fAnalogEpochs(hFile, ncols, pdEntityID, nTrials, pdTrigger, dPreTime, 
+                                        dPostTime, prhs[6], &plhs[1], &plhs[2], &plhs[3]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 12:    // function ns_GetNeuralInfo
+    case 25:    // function ns_GetAnalogStats
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 3, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // hFile input arguments must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // Input arguments except EntityID and Options must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("hFile input arguments must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
+            // Index and IndexCount must lie within the indexes of the library. An infinite
+            // IndexCount selects all indexes from Index on.
+            if ((mxGetScalar(prhs[4]) == mxGetInf()) ? !fIsIndex(prhs[3]) : !fIsIndexRange(prhs[3], prhs[4]))
+            {
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
+                return;
+            }
+
             // EntityID input must be a scalar or a vector.
             if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
@@ -2253,10 +10097,20 @@ void mexFunction(
                 return;
             }
 
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
+            {
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
             {
                 UINT32 hFile;
                 double *pdEntityID;
                 size_t ncols = 0;
+                UINT32 dwIndex;
+                double dIndexCount;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
@@ -2265,37 +10119,63 @@ void mexFunction(
                     ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
+                dwIndex = (UINT32) mxGetScalar(prhs[3]);
+                dIndexCount = mxGetScalar(prhs[4]);
 
-                fresult = fNeuralInfo(hFile, ncols, pdEntityID, &plhs[1]);
+                fresult = fAnalogStats(hFile, ncols, pdEntityID, dwIndex, dIndexCount, prhs[5], 
+                                       &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 13:    // function ns_GetNeuralData
+
+    case 26:    // function ns_GetAnalogPSD
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 3))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // Input arguments except EntityID must be a scalar.
+            // Input arguments except EntityID and Options must be a scalar.
             if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
                 (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
                 (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // EntityID input arguments must be a scalar.
+            // Index and IndexCount must lie within the indexes of the library. An infinite
+            // IndexCount selects all indexes from Index on.
+            if ((mxGetScalar(prhs[4]) == mxGetInf()) ? !fIsIndex(prhs[3]) : !fIsIndexRange(prhs[3], prhs[4]))
+            {
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
             if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
-                mexPrintf("EntityID input must be a double scalar.\n");
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[2] = mxCreateString("");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
+            {
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
@@ -2306,7 +10186,7 @@ void mexFunction(
                 double *pdEntityID;
                 size_t ncols = 0;
                 UINT32 dwIndex;
-                UINT32 dwIndexCount;
+                double dIndexCount;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
@@ -2316,63 +10196,128 @@ void mexFunction(
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
                 dwIndex = (UINT32) mxGetScalar(prhs[3]);
-                dwIndexCount = (UINT32) mxGetScalar(prhs[4]);
+                dIndexCount = mxGetScalar(prhs[4]);
 
-                fresult = fNeuralData(hFile, ncols, pdEntityID, dwIndex, dwIndexCount, &plhs[1]);
+                fresult = fAnalogPSD(hFile, ncols, pdEntityID, dwIndex, dIndexCount, prhs[5], 
+                                     &plhs[1], &plhs[2]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 27:    // function ns_ReadAhead
+        {
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2))
+                return;
+
+            // MaxBytes input must be empty or a non-negative scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || 
+                (!mxIsEmpty(prhs[1]) && ((mxGetNumberOfElements(prhs[1]) != 1) || 
+                                         !(mxGetScalar(prhs[1]) >= 0))))
+            {
+                mexPrintf("MaxBytes input must be empty or a non-negative double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
+            {
+                ns_RESULT fresult;
 
+                fresult = fReadAhead(prhs[1], &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 14:    // function ns_CloseFile
+    case 28:    // function ns_AnalogCache
         {
+            char szCommand[8] = "";
+
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 1))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2))
                 return;
 
-            // Check whether a DLL and a data file were loaded.
-            if (!fCheckLoad(&plhs[0], nlhs))
+            // The input must be empty, a non-negative scalar or 'flush'.
+            if (mxIsChar(prhs[1]))
+                mxGetString(prhs[1], szCommand, sizeof(szCommand));
+            if (mxIsChar(prhs[1]) ? (0 != strcmp(szCommand, "flush")) :
+                ((mxIsDouble(prhs[1]) != 1) || 
+                 (!mxIsEmpty(prhs[1]) && ((mxGetNumberOfElements(prhs[1]) != 1) || 
+                                          !(mxGetScalar(prhs[1]) >= 0)))))
+            {
+                mexPrintf("MaxBytes input must be empty, a non-negative double scalar or 'flush'.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
+            }
 
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
             {
-                mexPrintf("Input arguments must be a double scalar.\n");
+                ns_RESULT fresult;
+
+                fresult = fAnalogCache(prhs[1], &plhs[1]);
+                plhs[0] = mxCreateScalarDouble(fresult);
+            }
+        }
+        break;
+    case 29:    // function ns_AnalogSidecar
+        {
+            char szClass[8] = "";
+
+            // Check for proper number of input and output arguments.
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 2))
+                return;
+
+            // Class input must be 'off', 'single', 'int16' or empty.
+            if (!mxIsChar(prhs[1]) || (0 != mxGetString(prhs[1], szClass, sizeof(szClass))) ||
+                ((0 != strlen(szClass)) && (0 != strcmp(szClass, "off")) && 
+                 (0 != strcmp(szClass, "single")) && (0 != strcmp(szClass, "int16"))))
+            {
+                mexPrintf("Class input must be 'off', 'single' or 'int16'.\n");
+                plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
             {
-                UINT32 hFile;
                 ns_RESULT fresult;
 
-                hFile = (UINT32) mxGetScalar(prhs[1]);
-                fresult = ns_CloseFile(g_nsDllHandle, hFile);
+                fresult = fAnalogSidecar(szClass, &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 15:    // function ns_GetIndexByTime
+    case 30:    // function ns_DetectSpikes
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // Input arguments except Entity ID must be a scalar.
+            // Input arguments except EntityID and Options must be a scalar.
             if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
                 (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
                 (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("Input arguments except EntityID must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // EntityID input arguments must be a scalar or vector.
+            // Index and IndexCount must lie within the indexes of the library. An infinite
+            // IndexCount selects all indexes from Index on.
+            if ((mxGetScalar(prhs[4]) == mxGetInf()) ? !fIsIndex(prhs[3]) : !fIsIndexRange(prhs[3], prhs[4]))
+            {
+                mexPrintf("Index range must be integers that are not negative or exceed the last index (2^32 - 1).\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_BADINDEX);
+                return;
+            }
+
+            // EntityID input must be a scalar or a vector.
             if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
                 mexPrintf("EntityID input must be a double scalar or vector.\n");
@@ -2381,12 +10326,20 @@ void mexFunction(
                 return;
             }
 
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
+            {
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
+
             {
                 UINT32 hFile;
                 double *pdEntityID;
                 size_t ncols = 0;
-                double dTime;
-                INT32 nFlag;
+                UINT32 dwIndex;
+                double dIndexCount;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
@@ -2395,46 +10348,66 @@ void mexFunction(
                     ncols = mxGetN(prhs[2]);
                 if (mxGetN(prhs[2]) == 1)
                     ncols = mxGetM(prhs[2]);
-                dTime = (double) mxGetScalar(prhs[3]);
-                nFlag = (INT32) mxGetScalar(prhs[4]);
+                dwIndex = (UINT32) mxGetScalar(prhs[3]);
+                dIndexCount = mxGetScalar(prhs[4]);
 
-                fresult = fIndexByTime(hFile, ncols, pdEntityID, dTime, nFlag, &plhs[1]);
+                fresult = fDetectSpikes(hFile, ncols, pdEntityID, dwIndex, dIndexCount, prhs[5], 
+                                        &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 16:    // function ns_GetTimeByIndex
+    case 31:    // function ns_GetEventDataByTime
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 4, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 6, 8))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
-            // hFile input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // Input arguments except EntityID and Options must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1) ||
+                (mxIsDouble(prhs[3]) != 1) || (mxGetM(prhs[3]) != 1) || (mxGetN(prhs[3]) != 1) ||
+                (mxIsDouble(prhs[4]) != 1) || (mxGetM(prhs[4]) != 1) || (mxGetN(prhs[4]) != 1))
             {
-                mexPrintf("hFile input must be a double scalar.\n");
+                mexPrintf("Input arguments except EntityID and Options must be a double scalar.\n");
+                plhs[7] = mxCreateString("");
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // EntityID input must be a scalar.
-            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
+            // EntityID input must be a scalar or a vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)))
             {
-                mexPrintf("EntityID input must be a double scalar.\n");
+                mexPrintf("EntityID input must be a double scalar or vector.\n");
+                plhs[7] = mxCreateString("");
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
             }
 
-            // Index can be a vector or a scalar
-            if ((mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[5]))
             {
-                mexPrintf("Index must be a double scalar or vector.\n");
+                plhs[7] = mxCreateString("");
+                plhs[6] = mxCreateString("");
+                plhs[5] = mxCreateString("");
+                plhs[4] = mxCreateString("");
+                plhs[3] = mxCreateString("");
+                plhs[2] = mxCreateString("");
                 plhs[1] = mxCreateString("");
                 plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
@@ -2442,74 +10415,88 @@ void mexFunction(
 
             {
                 UINT32 hFile;
-                UINT32 dwEntityID;
-                double * pdIndex = 0;
-                size_t dwIndexCount;
+                double *pdEntityID;
+                size_t ncols = 0;
+                double dStartTime;
+                double dEndTime;
                 ns_RESULT fresult;
 
                 hFile = (UINT32) mxGetScalar(prhs[1]);
-                dwEntityID = (UINT32) mxGetScalar(prhs[2]);
-
-                dwIndexCount = MAX(mxGetM(prhs[3]), mxGetN(prhs[3]));
-                pdIndex = mxGetPr(prhs[3]);
-
-
-                fresult = fTimeByIndex(hFile, dwEntityID, (UINT32) dwIndexCount, pdIndex, &plhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncols = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncols = mxGetM(prhs[2]);
+                dStartTime = mxGetScalar(prhs[3]);
+                dEndTime = mxGetScalar(prhs[4]);
 
+                fresult = fEventDataByTime(hFile, ncols, pdEntityID, dStartTime, dEndTime, prhs[5], 
+                                           &plhs[1], &plhs[2], &plhs[3], &plhs[4], &plhs[5], 
+                                           &plhs[6], &plhs[7]);
                 plhs[0] = mxCreateScalarDouble(fresult);
             }
         }
         break;
-    case 17:    // function ns_GetLastErrorMsg
+    case 32:    // function ns_GetEventDataBatch
         {
             // Check for proper number of input and output arguments.
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 1, 2))
+            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 5, 2))
                 return;
 
             // Check whether a DLL and a data file were loaded.
             if (!fCheckLoad(&plhs[0], nlhs))
                 return;
 
+            // Input arguments must be a scalar.
+            if ((mxIsDouble(prhs[1]) != 1) || (mxGetM(prhs[1]) != 1) || (mxGetN(prhs[1]) != 1))
             {
-                ns_RESULT fresult;
+                mexPrintf("hFile input arguments must be a double scalar.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
+            }
 
-                fresult = fLastErrorMsg(&plhs[1]);
-                plhs[0] = mxCreateScalarDouble(fresult);
+            // EntityID and Index input must be a scalar or a row vector.
+            if ((mxIsDouble(prhs[2]) != 1) || !((mxGetM(prhs[2]) == 1) || (mxGetN(prhs[2]) == 1)) ||
+                (mxIsDouble(prhs[3]) != 1) || !((mxGetM(prhs[3]) == 1) || (mxGetN(prhs[3]) == 1)))
+            {
+                mexPrintf("EntityID and Index input arguments must be a double scalar or vector.\n");
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
+                return;
             }
-        }
-        break;
-    case 18:    // function ns_SetLibrary
-        {
-            // Check for proper number of input and output arguments.
-            // RHS args:
-            //  18 - code to mean ns_SetLibrary
-            //  szName - the name of the DLL to load
-            if (!fCheckNumArguments(&plhs[0], nrhs, nlhs, 2, 1))
+
+            // Options input must be a structure or empty.
+            if (!fCheckOptions(prhs[4]))
+            {
+                plhs[1] = mxCreateString("");
+                plhs[0] = mxCreateScalarDouble(ns_LIBERROR);
                 return;
+            }
 
             {
-                char * szFile;
-                size_t cbBuffer;
-                int status;
+                UINT32 hFile;
+                double *pdEntityID;
+                double *pdIndex;
+                size_t ncolsEntity = 0;
+                size_t ncolsIndex = 0;
                 ns_RESULT fresult;
 
-                cbBuffer = (mxGetM(prhs[1]) * mxGetN(prhs[1])) + 1;
-                szFile = mxCalloc(cbBuffer, sizeof(char));
-
-                // Copy the string data from rhs into a C string.
-                status = mxGetString(prhs[1], szFile, cbBuffer);
-                if (status != 0) 
-                    mexWarnMsgTxt("Not enough space. String is truncated.\n");
+                hFile = (UINT32) mxGetScalar(prhs[1]);
+                pdEntityID = mxGetPr(prhs[2]);
+                if (mxGetM(prhs[2]) == 1)
+                    ncolsEntity = mxGetN(prhs[2]);
+                if (mxGetN(prhs[2]) == 1)
+                    ncolsEntity = mxGetM(prhs[2]);
+                pdIndex = mxGetPr(prhs[3]);
+                if (mxGetM(prhs[3]) == 1)
+                    ncolsIndex = mxGetN(prhs[3]);
+                if (mxGetN(prhs[3]) == 1)
+                    ncolsIndex = mxGetM(prhs[3]);
 
-                // Ok...now we've got the name, let's rock'n roll
-                fresult = fSetLibrary(szFile);
+                fresult = fEventDataBatch(hFile, ncolsEntity, pdEntityID, ncolsIndex, pdIndex, prhs[4], 
+                                          &plhs[1]);
                 plhs[0] = mxCreateScalarDouble(fresult);
-                mxFree(szFile);
-
-                if (fresult == ns_LIBERROR)
-                {
-                    mexWarnMsgTxt("Unable to load this DLL");
-                }
             }
         }
         break;
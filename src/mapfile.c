@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: mapfile.c $
+//
+// Description   : Minimal portable support for mapping whole files into memory.
+//                 mmap is used on Linux and MacOS X, file mappings on Windows.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "mapfile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(WIN32) && !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Map a whole file into memory for reading
+//          The file may be closed or removed while it is mapped.
+// Inputs:  pMap - receives the mapping
+//          szName - name of the file
+// Outputs: int - 1 if the file was mapped, 0 if it does not exist, is empty or
+//          could not be mapped
+int mf_Open(MF_MAP *pMap, const char *szName)
+{
+#if defined(WIN32) || defined(_WIN32)
+    HANDLE hFile;
+    LARGE_INTEGER size;
+
+    memset(pMap, 0, sizeof(MF_MAP));
+    hFile = CreateFileA(szName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, 0, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, 0);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return 0;
+
+    if (GetFileSizeEx(hFile, &size) && (0 < size.QuadPart) && ((size_t) size.QuadPart == size.QuadPart))
+    {
+        pMap->hMapping = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+        if (pMap->hMapping)
+        {
+            pMap->pvData = MapViewOfFile(pMap->hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (!pMap->pvData)
+            {
+                CloseHandle(pMap->hMapping);
+                pMap->hMapping = 0;
+            }
+        }
+        pMap->nSize = (size_t) size.QuadPart;
+    }
+    CloseHandle(hFile);
+#else
+    struct stat fileStat;
+    void *pvData;
+    int nFile;
+
+    memset(pMap, 0, sizeof(MF_MAP));
+    nFile = open(szName, O_RDONLY);
+    if (nFile < 0)
+        return 0;
+
+    if ((0 == fstat(nFile, &fileStat)) && (0 < fileStat.st_size) && 
+        ((size_t) fileStat.st_size == fileStat.st_size))
+    {
+        pvData = mmap(0, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, nFile, 0);
+        if (MAP_FAILED != pvData)
+        {
+            pMap->pvData = pvData;
+            pMap->nSize = (size_t) fileStat.st_size;
+        }
+    }
+    close(nFile);
+#endif
+
+    if (!pMap->pvData)
+        pMap->nSize = 0;
+    return (0 != pMap->pvData);
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Unmap a file mapped by mf_Open (nothing happens if it is not mapped)
+// Inputs:  pMap - the mapping
+void mf_Close(MF_MAP *pMap)
+{
+    if (!pMap->pvData)
+        return;
+
+#if defined(WIN32) || defined(_WIN32)
+    UnmapViewOfFile(pMap->pvData);
+    CloseHandle(pMap->hMapping);
+#else
+    munmap((void *) pMap->pvData, pMap->nSize);
+#endif
+    memset(pMap, 0, sizeof(MF_MAP));
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Move a completely written file over another one in one step, so readers
+//          either see the old or the new file. Mappings of the old file stay valid.
+// Inputs:  szFrom - name of the new file
+//          szTo - name of the file to replace (need not exist)
+// Outputs: int - 1 if the file was replaced, 0 otherwise (szFrom is left as it is)
+int mf_Replace(const char *szFrom, const char *szTo)
+{
+#if defined(WIN32) || defined(_WIN32)
+    return (0 != MoveFileExA(szFrom, szTo, MOVEFILE_REPLACE_EXISTING));
+#else
+    return (0 == rename(szFrom, szTo));
+#endif
+}
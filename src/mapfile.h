@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: mapfile.h $
+//
+// Description   : Minimal portable support for mapping whole files into memory
+//                 for reading, and for replacing files that may be mapped. A mapped
+//                 file may be read from any thread.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MAPFILE_H_INCLUDED   // Include guards
+#define MAPFILE_H_INCLUDED
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(WIN32) || defined(_WIN32)
+    #include <windows.h>
+#endif
+
+// A file mapped into memory, see mf_Open
+typedef struct
+{
+    const void *pvData;       // contents of the file
+    size_t nSize;             // size of the file in bytes
+#if defined(WIN32) || defined(_WIN32)
+    HANDLE hMapping;
+#endif
+} MF_MAP;
+
+int  mf_Open(MF_MAP *pMap, const char *szName);
+void mf_Close(MF_MAP *pMap);
+int  mf_Replace(const char *szFrom, const char *szTo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // include guards
@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: threads.c $
+//
+// Description   : Minimal portable threading support for the MATLAB wrapper.
+//                 POSIX threads are used on Linux and MacOS X, the native thread
+//                 API on Windows.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "threads.h"
+
+#if defined(WIN32) || defined(_WIN32)
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+// State shared by all threads of one th_ParallelFor call
+typedef struct
+{
+    TH_MUTEX mutex;
+    size_t nNext;
+    size_t nItems;
+    TH_TASK pfTask;
+    void *pvContext;
+} TH_POOL;
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Mutex
+//
+////////////////////////////////////////////////////////////////////////////
+
+#if defined(WIN32) || defined(_WIN32)
+
+    void th_MutexInit(TH_MUTEX *pMutex)    { InitializeSRWLock(pMutex); }
+    void th_MutexDestroy(TH_MUTEX *pMutex) { (void) pMutex; }
+    void th_MutexLock(TH_MUTEX *pMutex)    { AcquireSRWLockExclusive(pMutex); }
+    void th_MutexUnlock(TH_MUTEX *pMutex)  { ReleaseSRWLockExclusive(pMutex); }
+
+#else
+
+    void th_MutexInit(TH_MUTEX *pMutex)    { pthread_mutex_init(pMutex, 0); }
+    void th_MutexDestroy(TH_MUTEX *pMutex) { pthread_mutex_destroy(pMutex); }
+    void th_MutexLock(TH_MUTEX *pMutex)    { pthread_mutex_lock(pMutex); }
+    void th_MutexUnlock(TH_MUTEX *pMutex)  { pthread_mutex_unlock(pMutex); }
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Worker pool
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the number of processors available to this process
+// Outputs: int - number of online processors (at least 1)
+int th_GetProcessorCount(void)
+{
+    long nCount;
+
+#if defined(WIN32) || defined(_WIN32)
+    SYSTEM_INFO sysInfo;
+
+    GetSystemInfo(&sysInfo);
+    nCount = (long) sysInfo.dwNumberOfProcessors;
+#else
+    nCount = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (nCount < 1) ? 1 : (int) nCount;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Take work items from the pool and process them until none are left
+// Inputs:  pPool - the pool shared by all threads
+static void th_RunPool(TH_POOL *pPool)
+{
+    size_t nItem;
+
+    for (;;)
+    {
+        th_MutexLock(&pPool->mutex);
+        nItem = pPool->nNext++;
+        th_MutexUnlock(&pPool->mutex);
+
+        if (nItem >= pPool->nItems)
+            break;
+
+        pPool->pfTask(pPool->pvContext, nItem);
+    }
+}
+
+#if defined(WIN32) || defined(_WIN32)
+
+    static unsigned __stdcall th_WorkerMain(void *pvPool)
+    {
+        th_RunPool((TH_POOL *) pvPool);
+        return 0;
+    }
+
+    static unsigned __stdcall th_JobMain(void *pvJob)
+    {
+        ((TH_JOB *) pvJob)->pfTask(((TH_JOB *) pvJob)->pvContext, 0);
+        return 0;
+    }
+
+    static int th_StartThread(TH_JOB *pJob)
+    {
+        pJob->thread = (HANDLE) _beginthreadex(0, 0, th_JobMain, pJob, 0, 0);
+        return (pJob->thread != 0);
+    }
+
+    static int th_Start(TH_THREAD *pThread, TH_POOL *pPool)
+    {
+        *pThread = (HANDLE) _beginthreadex(0, 0, th_WorkerMain, pPool, 0, 0);
+        return (*pThread != 0);
+    }
+
+    static void th_Join(TH_THREAD thread)
+    {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+
+#else
+
+    static void *th_WorkerMain(void *pvPool)
+    {
+        th_RunPool((TH_POOL *) pvPool);
+        return 0;
+    }
+
+    static void *th_JobMain(void *pvJob)
+    {
+        ((TH_JOB *) pvJob)->pfTask(((TH_JOB *) pvJob)->pvContext, 0);
+        return 0;
+    }
+
+    static int th_StartThread(TH_JOB *pJob)
+    {
+        return (pthread_create(&pJob->thread, 0, th_JobMain, pJob) == 0);
+    }
+
+    static int th_Start(TH_THREAD *pThread, TH_POOL *pPool)
+    {
+        return (pthread_create(pThread, 0, th_WorkerMain, pPool) == 0);
+    }
+
+    static void th_Join(TH_THREAD thread)
+    {
+        pthread_join(thread, 0);
+    }
+
+#endif
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Call a task for every work item, distributing the items over several threads
+//          The calling thread takes part in the work. If fewer threads could be started
+//          than requested, the remaining ones simply process more items.
+// Inputs:  nItems - number of work items
+//          nThreads - number of threads to use (<= 1 runs everything in the calling thread)
+//          pfTask - task that is called once for every item
+//          pvContext - passed to every call of pfTask
+// Outputs: int - number of threads that actually did the work
+int th_ParallelFor(size_t nItems, int nThreads, TH_TASK pfTask, void *pvContext)
+{
+    TH_THREAD aThreads[TH_MAX_THREADS];
+    TH_POOL pool;
+    int nStarted = 0;
+    int i;
+
+    if (nThreads > TH_MAX_THREADS)
+        nThreads = TH_MAX_THREADS;
+    if ((size_t) nThreads > nItems)
+        nThreads = (int) nItems;
+
+    if (nThreads <= 1)
+    {
+        size_t nItem;
+
+        for (nItem = 0; nItem < nItems; ++nItem)
+            pfTask(pvContext, nItem);
+        return 1;
+    }
+
+    th_MutexInit(&pool.mutex);
+    pool.nNext = 0;
+    pool.nItems = nItems;
+    pool.pfTask = pfTask;
+    pool.pvContext = pvContext;
+
+    for (i = 0; i < nThreads - 1; ++i)
+    {
+        if (!th_Start(&aThreads[nStarted], &pool))
+            break;
+        ++nStarted;
+    }
+
+    th_RunPool(&pool);
+
+    for (i = 0; i < nStarted; ++i)
+        th_Join(aThreads[i]);
+
+    th_MutexDestroy(&pool.mutex);
+    return nStarted + 1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Background jobs
+//
+////////////////////////////////////////////////////////////////////////////
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Run a task on a thread of its own while the calling thread goes on
+//          If no thread can be started, the task is run in the calling thread.
+// Inputs:  pJob - the job; must not be running and must stay valid until th_WaitJob
+//          pfTask - task that is called once with item 0
+//          pvContext - passed to pfTask
+// Outputs: int - 1 if the task runs in the background, 0 if it has already been run
+int th_StartJob(TH_JOB *pJob, TH_TASK pfTask, void *pvContext)
+{
+    pJob->pfTask = pfTask;
+    pJob->pvContext = pvContext;
+    pJob->bRunning = th_StartThread(pJob);
+    if (!pJob->bRunning)
+        pfTask(pvContext, 0);
+    return pJob->bRunning;
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Wait until the task of a job has finished (returns at once if none is running)
+// Inputs:  pJob - the job
+void th_WaitJob(TH_JOB *pJob)
+{
+    if (pJob->bRunning)
+        th_Join(pJob->thread);
+    pJob->bRunning = 0;
+}
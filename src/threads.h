@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: threads.h $
+//
+// Description   : Minimal portable threading support for the MATLAB wrapper.
+//                 Provides a mutex, a simple worker pool that distributes
+//                 independent work items (e.g. entities) over several threads
+//                 and jobs that run a single task in the background.
+//
+//                 None of the MATLAB API functions (mx*, mex*) may be called from
+//                 a task that runs on a worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef THREADS_H_INCLUDED   // Include guards
+#define THREADS_H_INCLUDED
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(WIN32) || defined(_WIN32)
+    #include <windows.h>
+
+    typedef SRWLOCK TH_MUTEX;
+    #define TH_MUTEX_INITIALIZER SRWLOCK_INIT
+    typedef HANDLE TH_THREAD;
+#else
+    #include <pthread.h>
+
+    typedef pthread_mutex_t TH_MUTEX;
+    #define TH_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+    typedef pthread_t TH_THREAD;
+#endif
+
+// Maximum number of threads a single th_ParallelFor call will use
+#define TH_MAX_THREADS 64
+
+// A task processes a single work item (0 ... nItems - 1) of th_ParallelFor
+typedef void (*TH_TASK)(void *pvContext, size_t nItem);
+
+// A task running on a thread of its own, see th_StartJob
+typedef struct
+{
+    TH_THREAD thread;
+    TH_TASK pfTask;
+    void *pvContext;
+    int bRunning;             // the thread was started and not yet waited for
+} TH_JOB;
+
+void th_MutexInit(TH_MUTEX *pMutex);
+void th_MutexDestroy(TH_MUTEX *pMutex);
+void th_MutexLock(TH_MUTEX *pMutex);
+void th_MutexUnlock(TH_MUTEX *pMutex);
+
+int  th_GetProcessorCount(void);
+int  th_ParallelFor(size_t nItems, int nThreads, TH_TASK pfTask, void *pvContext);
+
+int  th_StartJob(TH_JOB *pJob, TH_TASK pfTask, void *pvContext);
+void th_WaitJob(TH_JOB *pJob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // include guards
@@ -0,0 +1,90 @@
+function Result = bench_GetAnalogData(hFile, EntityID, IndexCount, Repeats, Baseline);
+
+%bench_GetAnalogData   Measures the time and memory of analog data reads
+%
+%   Usage:
+%      Result = bench_GetAnalogData(hFile, EntityID, IndexCount)
+%      Result = bench_GetAnalogData(hFile, EntityID, IndexCount, Repeats)
+%      Result = bench_GetAnalogData(hFile, EntityID, IndexCount, Repeats, 
+%                                   Baseline)
+%
+%   Description:
+%       Reads IndexCount values of the Analog Entities EntityID from the
+%       start of the file referenced by hFile Repeats times with
+%       ns_GetAnalogData and reports the time of one read and, on Linux,
+%       how much the peak memory of Matlab grew while reading.
+%       To compare two builds of mexprog (e.g. before and after a change
+%       of the read path), run the benchmark with the first build in a
+%       fresh Matlab session, save Result, and pass it as Baseline to the
+%       run with the second build in another fresh session.  The peak
+%       memory only grows with the first read that is larger than any
+%       before, so every build needs its own session.
+%       The m-files and mexprog must be on the path.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number(s) of the Analog Entities in
+%                       the data file.
+%       IndexCount	    Number of analog values to read of every entity.
+%       Repeats         Number of reads that are timed (default 5).
+%       Baseline        Result of an earlier run to compare with (optional).
+%
+%   Return Values:
+%       Result          Structure with the fields:
+%                         Time        Median time of one read in seconds
+%                         MBPerSecond Megabytes of Data read per second
+%                         PeakMB      Growth of the peak resident memory of
+%                                     Matlab in megabytes (NaN if it is
+%                                     not known)
+%                         DataMB      Size of Data in megabytes
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 4)
+    Repeats = 5;
+end;
+if (nargin < 5)
+    Baseline = [];
+end;
+
+PeakBefore = PeakMemory();
+Times = zeros(Repeats, 1);
+for i = 1:Repeats
+    tic;
+    [ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, EntityID, 1, IndexCount);
+    Times(i) = toc;
+    if (ns_RESULT ~= 0)
+        error('ns_GetAnalogData failed with %d.', ns_RESULT);
+    end;
+    clear Data;
+end;
+
+Result.DataMB = 8 * IndexCount * numel(EntityID) / 2^20;
+Result.Time = median(Times);
+Result.MBPerSecond = Result.DataMB / Result.Time;
+Result.PeakMB = PeakMemory() - PeakBefore;
+
+fprintf('%d entities x %d values (%.1f MB)\n', numel(EntityID), IndexCount, Result.DataMB);
+if isempty(Baseline)
+    fprintf('  %10.4f s per read  %10.1f MB/s  peak memory +%.1f MB\n', ...
+            Result.Time, Result.MBPerSecond, Result.PeakMB);
+else
+    fprintf('           %12s %12s\n', 'Baseline', 'This build');
+    fprintf('  Time     %10.4f s %10.4f s  (%.2fx)\n', Baseline.Time, Result.Time, ...
+            Baseline.Time / Result.Time);
+    fprintf('  Peak     %9.1f MB %9.1f MB\n', Baseline.PeakMB, Result.PeakMB);
+end;
+
+
+function PeakMB = PeakMemory()
+
+% Peak resident memory of the Matlab process in megabytes (NaN if unknown)
+PeakMB = NaN;
+if exist('/proc/self/status', 'file')
+    Tokens = regexp(fileread('/proc/self/status'), 'VmHWM:\s*(\d+)\s*kB', 'tokens', 'once');
+    if ~isempty(Tokens)
+        PeakMB = str2double(Tokens{1}) / 1024;
+    end;
+end;
@@ -0,0 +1,96 @@
+function Result = bench_GetEventData(hFile, EntityID, Repeats, Baseline);
+
+%bench_GetEventData   Measures the time and memory of event data reads
+%
+%   Usage:
+%      Result = bench_GetEventData(hFile, EntityID)
+%      Result = bench_GetEventData(hFile, EntityID, Repeats)
+%      Result = bench_GetEventData(hFile, EntityID, Repeats, Baseline)
+%
+%   Description:
+%       Reads all indexes of the Event Entity EntityID of the file
+%       referenced by hFile Repeats times with one call of
+%       ns_GetEventData and reports the time of one read and, on Linux,
+%       how much the peak memory of Matlab grew while reading.  The event
+%       entity of the synthetic library built from nssynth.c next to this
+%       file (make synth, EntityID 2) has 1000000 events; open any file
+%       with it loaded.
+%       Builds of mexprog are compared as with bench_GetAnalogData, which
+%       is next to this file as well: run the benchmark with each build
+%       in a fresh Matlab session and pass the Result of the first run as
+%       Baseline to the second.
+%       The m-files and mexprog must be on the path.
+%
+%   Parameters:
+%       hFile	        Handle/Indentification number to an open file.
+%       EntityID	    Identification number of the Event Entity in the
+%                       data file.
+%       Repeats         Number of reads that are timed (default 5).
+%       Baseline        Result of an earlier run to compare with (optional).
+%
+%   Return Values:
+%       Result          Structure with the fields:
+%                         Time            Median time of one read in
+%                                         seconds
+%                         EventsPerSecond Events read per second
+%                         PeakMB          Growth of the peak resident
+%                                         memory of Matlab in megabytes
+%                                         (NaN if it is not known)
+%                         EventCount      Number of events of the entity
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+if (nargin < 3)
+    Repeats = 5;
+end;
+if (nargin < 4)
+    Baseline = [];
+end;
+
+[ns_RESULT, EntityInfo] = ns_GetEntityInfo(hFile, EntityID);
+if (ns_RESULT ~= 0)
+    error('ns_GetEntityInfo failed with %d.', ns_RESULT);
+end;
+Index = 1:EntityInfo.ItemCount;
+
+PeakBefore = PeakMemory();
+Times = zeros(Repeats, 1);
+for i = 1:Repeats
+    tic;
+    [ns_RESULT, TimeStamp, Data] = ns_GetEventData(hFile, EntityID, Index);
+    Times(i) = toc;
+    if (ns_RESULT ~= 0)
+        error('ns_GetEventData failed with %d.', ns_RESULT);
+    end;
+    clear TimeStamp Data;
+end;
+
+Result.EventCount = numel(Index);
+Result.Time = median(Times);
+Result.EventsPerSecond = Result.EventCount / Result.Time;
+Result.PeakMB = PeakMemory() - PeakBefore;
+
+fprintf('%d events of entity %d\n', Result.EventCount, EntityID);
+if isempty(Baseline)
+    fprintf('  %10.4f s per read  %12.0f events/s  peak memory +%.1f MB\n', ...
+            Result.Time, Result.EventsPerSecond, Result.PeakMB);
+else
+    fprintf('           %12s %12s\n', 'Baseline', 'This build');
+    fprintf('  Time     %10.4f s %10.4f s  (%.2fx)\n', Baseline.Time, Result.Time, ...
+            Baseline.Time / Result.Time);
+    fprintf('  Peak     %9.1f MB %9.1f MB\n', Baseline.PeakMB, Result.PeakMB);
+end;
+
+
+function PeakMB = PeakMemory()
+
+% Peak resident memory of the Matlab process in megabytes (NaN if unknown)
+PeakMB = NaN;
+if exist('/proc/self/status', 'file')
+    Tokens = regexp(fileread('/proc/self/status'), 'VmHWM:\s*(\d+)\s*kB', 'tokens', 'once');
+    if ~isempty(Tokens)
+        PeakMB = str2double(Tokens{1}) / 1024;
+    end;
+end;
@@ -0,0 +1,406 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026  German Neuroinformatics Node (G-Node)
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// $Workfile: nssynth.c $
+//
+// Description   : Synthetic Neuroshare library for testing the MATLAB wrapper with
+//                 entities larger than any real recording at hand.
+//
+//                 Every file opened has two entities. Entity 0 is an analog entity
+//                 with the largest number of indeces the API can address (2^32 - 1).
+//                 The value of every index is the index itself, so stitched reads
+//                 can be checked value by value. There is one gap in time before
+//                 SYNTH_GAP_INDEX, which lies on a split of the reads of the wrapper
+//                 (see ANALOG_READ_WINDOW in main.c), so a gap that is only visible
+//                 between two library calls can be tested. Entity 1 is an event
+//                 entity with SYNTH_EVENT_COUNT 32-bit events, one per millisecond,
+//                 whose value is their index, e.g. to measure event reads. Nothing
+//                 is read from disk; the file name is ignored.
+//
+//                 Environment variables, read when the library is called, select
+//                 how the library behaves:
+//                   NSSYNTH_SINGLETHREADED=1  the library does not report itself as
+//                                             multithread safe, and calls that overlap
+//                                             other calls fail with ns_LIBERROR
+//                   NSSYNTH_NOCONTCOUNT=1     ns_GetAnalogData reports no continuous
+//                                             indeces (0), as some libraries do
+//
+//                 Build (Linux): cc -shared -fPIC -O2 -I../src -o nssynth.so nssynth.c
+//                 or 'make synth' in the top directory.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(WIN32) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200112L   // nanosleep
+#endif
+
+#define NS_COMPILING_LIB
+#include "ns.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(WIN32) || defined(_WIN32)
+    #include <windows.h>
+    #define SYNTH_INCREMENT(x) InterlockedIncrement(x)
+    #define SYNTH_DECREMENT(x) InterlockedDecrement(x)
+    #define SYNTH_PAUSE() Sleep(1)
+#else
+    #include <time.h>
+    #define SYNTH_INCREMENT(x) __sync_add_and_fetch(x, 1)
+    #define SYNTH_DECREMENT(x) __sync_sub_and_fetch(x, 1)
+    #define SYNTH_PAUSE() { struct timespec pause = {0, 100000}; nanosleep(&pause, 0); }
+#endif
+
+#define SYNTH_HANDLE        1
+#define SYNTH_ITEM_COUNT    0xFFFFFFFFu
+#define SYNTH_GAP_INDEX     0xFF000000u   // 2^32 - 2^24, a multiple of the read window
+#define SYNTH_GAP_LENGTH    1.0           // seconds
+#define SYNTH_SAMPLE_RATE   30000.0
+#define SYNTH_EVENT_COUNT   1000000u
+#define SYNTH_EVENT_RATE    1000.0
+
+static volatile long g_nCalls = 0;      // calls running right now
+static volatile long g_nOverlaps = 0;   // calls that overlapped others in single thread mode
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Find out whether an environment variable selects a mode of the library
+// Inputs:  szName - name of the variable
+// Outputs: int - 1 if the variable is set and not "0"
+static int synth_Mode(const char *szName)
+{
+    const char *szValue = getenv(szName);
+
+    return((0 != szValue) && (0 != strcmp(szValue, "")) && (0 != strcmp(szValue, "0")));
+}
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Note that a call starts. In single thread mode a call that overlaps another
+//          one is an error of the caller; every call lasts a little longer then, so that
+//          overlapping calls are found reliably.
+// Outputs: int - 0 if the call must fail
+static int synth_Enter(void)
+{
+    int bSingleThreaded = synth_Mode("NSSYNTH_SINGLETHREADED");
+
+    if ((1 < SYNTH_INCREMENT(&g_nCalls)) && bSingleThreaded)
+    {
+        SYNTH_INCREMENT(&g_nOverlaps);
+        return(0);
+    }
+    if (bSingleThreaded)
+        SYNTH_PAUSE();
+    return(1);
+}
+
+// Calls a function of the library between synth_Enter and the end of the call
+#define SYNTH_CALL(call)                                                   \
+    ns_RESULT nsresult = synth_Enter() ? (call) : ns_LIBERROR;             \
+    SYNTH_DECREMENT(&g_nCalls);                                            \
+    return(nsresult)
+
+// Author & Date: G-Node, 10/17/2026
+// Purpose: Get the time of an index of the analog entity
+// Inputs:  dwIndex - the index
+// Outputs: double - time in seconds
+static double synth_Time(UINT32 dwIndex)
+{
+    return(dwIndex / SYNTH_SAMPLE_RATE + ((dwIndex >= SYNTH_GAP_INDEX) ? SYNTH_GAP_LENGTH : 0));
+}
+
+ns_RESULT ns_stdcall ns_GetLibraryInfo(ns_LIBRARYINFO *pLibraryInfo, UINT32 dwLibraryInfoSize)
+{
+    if (dwLibraryInfoSize < sizeof(ns_LIBRARYINFO))
+        return(ns_LIBERROR);
+
+    memset(pLibraryInfo, 0, dwLibraryInfoSize);
+    pLibraryInfo->dwLibVersionMaj = 1;
+    pLibraryInfo->dwAPIVersionMaj = 1;
+    pLibraryInfo->dwAPIVersionMin = 3;
+    pLibraryInfo->dwFlags = synth_Mode("NSSYNTH_SINGLETHREADED") ? 0 : ns_LIBRARY_MULTITHREADED;
+    pLibraryInfo->dwMaxFiles = 1;
+    strcpy(pLibraryInfo->szDescription, "Synthetic test data");
+    strcpy(pLibraryInfo->szCreator, "G-Node");
+    return(ns_OK);
+}
+
+ns_RESULT ns_stdcall ns_OpenFile(const char *pszFilename, UINT32 *hFile)
+{
+    (void) pszFilename;
+    *hFile = SYNTH_HANDLE;
+    return(ns_OK);
+}
+
+ns_RESULT ns_stdcall ns_GetFileInfo(UINT32 hFile, ns_FILEINFO *pFileInfo, UINT32 dwFileInfoSize)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (dwFileInfoSize < sizeof(ns_FILEINFO))
+        return(ns_LIBERROR);
+
+    memset(pFileInfo, 0, dwFileInfoSize);
+    strcpy(pFileInfo->szFileType, "Synthetic");
+    pFileInfo->dwEntityCount = 2;
+    pFileInfo->dTimeStampResolution = 1 / SYNTH_SAMPLE_RATE;
+    pFileInfo->dTimeSpan = synth_Time(SYNTH_ITEM_COUNT - 1);
+    return(ns_OK);
+}
+
+ns_RESULT ns_stdcall ns_CloseFile(UINT32 hFile)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_OK : ns_BADFILE);
+}
+
+static ns_RESULT synth_GetEntityInfo(UINT32 hFile, UINT32 dwEntityID, ns_ENTITYINFO *pEntityInfo,
+                                     UINT32 dwEntityInfoSize)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (1 < dwEntityID)
+        return(ns_BADENTITY);
+    if (dwEntityInfoSize < sizeof(ns_ENTITYINFO))
+        return(ns_LIBERROR);
+
+    memset(pEntityInfo, 0, dwEntityInfoSize);
+    if (0 == dwEntityID)
+    {
+        strcpy(pEntityInfo->szEntityLabel, "synth");
+        pEntityInfo->dwEntityType = ns_ENTITY_ANALOG;
+        pEntityInfo->dwItemCount = SYNTH_ITEM_COUNT;
+    }
+    else
+    {
+        strcpy(pEntityInfo->szEntityLabel, "synth events");
+        pEntityInfo->dwEntityType = ns_ENTITY_EVENT;
+        pEntityInfo->dwItemCount = SYNTH_EVENT_COUNT;
+    }
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetAnalogInfo(UINT32 hFile, UINT32 dwEntityID, ns_ANALOGINFO *pAnalogInfo,
+                                     UINT32 dwAnalogInfoSize)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (0 != dwEntityID)
+        return(ns_BADENTITY);
+    if (dwAnalogInfoSize < sizeof(ns_ANALOGINFO))
+        return(ns_LIBERROR);
+
+    memset(pAnalogInfo, 0, dwAnalogInfoSize);
+    pAnalogInfo->dSampleRate = SYNTH_SAMPLE_RATE;
+    pAnalogInfo->dMinVal = 0;
+    pAnalogInfo->dMaxVal = SYNTH_ITEM_COUNT;
+    pAnalogInfo->dResolution = 1;
+    strcpy(pAnalogInfo->szUnits, "index");
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetAnalogData(UINT32 hFile, UINT32 dwEntityID, UINT32 dwStartIndex,
+                                     UINT32 dwIndexCount, UINT32 *pdwContCount, double *pData)
+{
+    UINT32 i;
+
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (0 != dwEntityID)
+        return(ns_BADENTITY);
+    if ((dwStartIndex >= SYNTH_ITEM_COUNT) || (dwIndexCount > SYNTH_ITEM_COUNT - dwStartIndex))
+        return(ns_BADINDEX);
+
+    for (i = 0; i < dwIndexCount; ++i)
+        pData[i] = (double) dwStartIndex + i;
+
+    // Like real libraries, only the gaps within the requested range are reported
+    if (pdwContCount)
+    {
+        *pdwContCount = dwIndexCount;
+        if ((dwStartIndex < SYNTH_GAP_INDEX) && (SYNTH_GAP_INDEX - dwStartIndex < dwIndexCount))
+            *pdwContCount = SYNTH_GAP_INDEX - dwStartIndex;
+        if (synth_Mode("NSSYNTH_NOCONTCOUNT"))
+            *pdwContCount = 0;
+    }
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetIndexByTime(UINT32 hFile, UINT32 dwEntityID, double dTime, INT32 nFlag,
+                                      UINT32 *pdwIndex)
+{
+    double dIndex;
+
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (1 < dwEntityID)
+        return(ns_BADENTITY);
+
+    // Times within the gap belong to the index before or after it
+    dIndex = dTime * SYNTH_SAMPLE_RATE;
+    if (1 == dwEntityID)
+        dIndex = dTime * SYNTH_EVENT_RATE;
+    else if (dTime >= synth_Time(SYNTH_GAP_INDEX))
+        dIndex -= SYNTH_GAP_LENGTH * SYNTH_SAMPLE_RATE;
+    else if (dIndex > SYNTH_GAP_INDEX - 1)
+        dIndex = (nFlag > 0) ? SYNTH_GAP_INDEX : SYNTH_GAP_INDEX - 1;
+
+    if (nFlag < 0)
+        dIndex = floor(dIndex);
+    else if (nFlag > 0)
+        dIndex = ceil(dIndex);
+    else
+        dIndex = floor(dIndex + 0.5);
+
+    if (dIndex < 0)
+        dIndex = 0;
+    if (dIndex > ((1 == dwEntityID) ? SYNTH_EVENT_COUNT : SYNTH_ITEM_COUNT) - 1)
+        dIndex = ((1 == dwEntityID) ? SYNTH_EVENT_COUNT : SYNTH_ITEM_COUNT) - 1;
+    *pdwIndex = (UINT32) dIndex;
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetTimeByIndex(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, double *pdTime)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (1 < dwEntityID)
+        return(ns_BADENTITY);
+    if (dwIndex >= ((1 == dwEntityID) ? SYNTH_EVENT_COUNT : SYNTH_ITEM_COUNT))
+        return(ns_BADINDEX);
+
+    *pdTime = (1 == dwEntityID) ? dwIndex / SYNTH_EVENT_RATE : synth_Time(dwIndex);
+    return(ns_OK);
+}
+
+ns_RESULT ns_stdcall ns_GetLastErrorMsg(char *pszMsgBuffer, UINT32 dwMsgBufferSize)
+{
+    if ((0 < dwMsgBufferSize) && (0 < g_nOverlaps))
+        snprintf(pszMsgBuffer, dwMsgBufferSize, "%ld calls overlapped other calls", (long) g_nOverlaps);
+    else if (0 < dwMsgBufferSize)
+        snprintf(pszMsgBuffer, dwMsgBufferSize, "Synthetic library has no errors to report");
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetEventInfo(UINT32 hFile, UINT32 dwEntityID, ns_EVENTINFO *pEventInfo,
+                                    UINT32 dwEventInfoSize)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (1 != dwEntityID)
+        return(ns_BADENTITY);
+    if (dwEventInfoSize < sizeof(ns_EVENTINFO))
+        return(ns_LIBERROR);
+
+    memset(pEventInfo, 0, dwEventInfoSize);
+    pEventInfo->dwEventType = ns_EVENT_DWORD;
+    pEventInfo->dwMinDataLength = sizeof(UINT32);
+    pEventInfo->dwMaxDataLength = sizeof(UINT32);
+    return(ns_OK);
+}
+
+static ns_RESULT synth_GetEventData(UINT32 hFile, UINT32 dwEntityID, UINT32 nIndex, double *pdTimeStamp,
+                                    void *pData, UINT32 dwDataSize, UINT32 *pdwDataRetSize)
+{
+    if (SYNTH_HANDLE != hFile)
+        return(ns_BADFILE);
+    if (1 != dwEntityID)
+        return(ns_BADENTITY);
+    if (nIndex >= SYNTH_EVENT_COUNT)
+        return(ns_BADINDEX);
+    if (dwDataSize < sizeof(UINT32))
+        return(ns_LIBERROR);
+
+    *pdTimeStamp = nIndex / SYNTH_EVENT_RATE;
+    memcpy(pData, &nIndex, sizeof(UINT32));
+    *pdwDataRetSize = sizeof(UINT32);
+    return(ns_OK);
+}
+
+// The synthetic file has no segment or neural entities
+
+ns_RESULT ns_stdcall ns_GetSegmentInfo(UINT32 hFile, UINT32 dwEntityID, ns_SEGMENTINFO *pSegmentInfo,
+                                       UINT32 dwSegmentInfoSize)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_BADENTITY : ns_BADFILE);
+}
+
+ns_RESULT ns_stdcall ns_GetSegmentSourceInfo(UINT32 hFile, UINT32 dwEntityID, UINT32 dwSourceID,
+                                             ns_SEGSOURCEINFO *pSourceInfo, UINT32 dwSourceInfoSize)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_BADENTITY : ns_BADFILE);
+}
+
+ns_RESULT ns_stdcall ns_GetSegmentData(UINT32 hFile, UINT32 dwEntityID, UINT32 nIndex, double *pdTimeStamp,
+                                       double *pdData, UINT32 dwDataBufferSize, UINT32 *pdwSampleCount,
+                                       UINT32 *pdwUnitID)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_BADENTITY : ns_BADFILE);
+}
+
+ns_RESULT ns_stdcall ns_GetNeuralInfo(UINT32 hFile, UINT32 dwEntityID, ns_NEURALINFO *pNeuralInfo,
+                                      UINT32 dwNeuralInfoSize)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_BADENTITY : ns_BADFILE);
+}
+
+ns_RESULT ns_stdcall ns_GetNeuralData(UINT32 hFile, UINT32 dwEntityID, UINT32 dwStartIndex,
+                                      UINT32 dwIndexCount, double *pdData)
+{
+    return((SYNTH_HANDLE == hFile) ? ns_BADENTITY : ns_BADFILE);
+}
+
+// The functions that may be called from worker threads go through SYNTH_CALL
+
+ns_RESULT ns_stdcall ns_GetEntityInfo(UINT32 hFile, UINT32 dwEntityID, ns_ENTITYINFO *pEntityInfo,
+                                      UINT32 dwEntityInfoSize)
+{
+    SYNTH_CALL(synth_GetEntityInfo(hFile, dwEntityID, pEntityInfo, dwEntityInfoSize));
+}
+
+ns_RESULT ns_stdcall ns_GetAnalogInfo(UINT32 hFile, UINT32 dwEntityID, ns_ANALOGINFO *pAnalogInfo,
+                                      UINT32 dwAnalogInfoSize)
+{
+    SYNTH_CALL(synth_GetAnalogInfo(hFile, dwEntityID, pAnalogInfo, dwAnalogInfoSize));
+}
+
+ns_RESULT ns_stdcall ns_GetAnalogData(UINT32 hFile, UINT32 dwEntityID, UINT32 dwStartIndex,
+                                      UINT32 dwIndexCount, UINT32 *pdwContCount, double *pData)
+{
+    SYNTH_CALL(synth_GetAnalogData(hFile, dwEntityID, dwStartIndex, dwIndexCount, pdwContCount, pData));
+}
+
+ns_RESULT ns_stdcall ns_GetIndexByTime(UINT32 hFile, UINT32 dwEntityID, double dTime, INT32 nFlag,
+                                       UINT32 *pdwIndex)
+{
+    SYNTH_CALL(synth_GetIndexByTime(hFile, dwEntityID, dTime, nFlag, pdwIndex));
+}
+
+ns_RESULT ns_stdcall ns_GetTimeByIndex(UINT32 hFile, UINT32 dwEntityID, UINT32 dwIndex, double *pdTime)
+{
+    SYNTH_CALL(synth_GetTimeByIndex(hFile, dwEntityID, dwIndex, pdTime));
+}
+
+ns_RESULT ns_stdcall ns_GetEventInfo(UINT32 hFile, UINT32 dwEntityID, ns_EVENTINFO *pEventInfo,
+                                     UINT32 dwEventInfoSize)
+{
+    SYNTH_CALL(synth_GetEventInfo(hFile, dwEntityID, pEventInfo, dwEventInfoSize));
+}
+
+ns_RESULT ns_stdcall ns_GetEventData(UINT32 hFile, UINT32 dwEntityID, UINT32 nIndex, double *pdTimeStamp,
+                                     void *pData, UINT32 dwDataSize, UINT32 *pdwDataRetSize)
+{
+    SYNTH_CALL(synth_GetEventData(hFile, dwEntityID, nIndex, pdTimeStamp, pData, dwDataSize, pdwDataRetSize));
+}
@@ -0,0 +1,89 @@
+function Passed = test_LargeIndex(LibraryPath);
+
+%test_LargeIndex   Tests analog reads of entities with more than 2^24 indeces
+%
+%   Usage:
+%      Passed = test_LargeIndex(LibraryPath)
+%
+%   Description:
+%       Loads the synthetic Neuroshare library built from tests/nssynth.c
+%       (make synth) and reads its analog entity, which has 2^32 - 1
+%       indeces whose values are the indeces themselves.  Long reads are
+%       split by mexprog into several library calls; the test reads across
+%       such a split just before the gap of the entity and checks the
+%       values and the continuous count, reads the last indeces of the
+%       entity, and checks that index ranges outside of the entity or
+%       that are not integers are rejected.
+%       The m-files and mexprog must be on the path.  The test needs about
+%       300 MB of memory.
+%
+%   Parameters:
+%       LibraryPath     Path of nssynth.so (or the library built for the
+%                       platform).
+%
+%   Return Values:
+%       Passed          1 if all checks passed, otherwise 0.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+ns_OK = 0;
+ns_BADINDEX = -7;
+Window = 2^24;
+GapIndex = 2^32 - 2^24 + 1;     % first index (1-based) after the gap
+LastIndex = 2^32 - 1;
+
+Passed = 1;
+if (ns_SetLibrary(LibraryPath) ~= ns_OK)
+    error('Could not load %s.', LibraryPath);
+end;
+[ns_RESULT, hFile] = ns_OpenFile('synthetic');
+if (ns_RESULT ~= ns_OK)
+    error('Could not open the synthetic file.');
+end;
+
+% A read across a split whose second part starts right after the gap
+StartIndex = GapIndex - Window;
+[ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, 1, StartIndex, Window + 100);
+Passed = Check(Passed, ns_RESULT == ns_OK, 'read across the gap');
+Passed = Check(Passed, ContCount == Window, 'continuous count before the gap');
+Passed = Check(Passed, isequal(Data, (StartIndex - 1:StartIndex + Window + 98)'), ...
+               'values across the split');
+clear Data;
+
+% The same read one index later, so the gap is inside the first library call
+[ns_RESULT, ContCount] = ns_GetAnalogData(hFile, 1, StartIndex + 1, Window + 100);
+Passed = Check(Passed, ns_RESULT == ns_OK, 'read across the gap (shifted)');
+Passed = Check(Passed, ContCount == Window - 1, 'continuous count before the gap (shifted)');
+
+% The last indeces of the entity
+[ns_RESULT, ContCount, Data] = ns_GetAnalogData(hFile, 1, LastIndex - 9, 10);
+Passed = Check(Passed, ns_RESULT == ns_OK && ContCount == 10, 'read of the last indeces');
+Passed = Check(Passed, isequal(Data, (LastIndex - 10:LastIndex - 1)'), 'values of the last indeces');
+ns_RESULT = ns_GetAnalogData(hFile, 1, LastIndex - 9, 11);
+Passed = Check(Passed, ns_RESULT == ns_BADINDEX, 'read past the last index');
+% The end of this range, one past its last index, does not fit into 32 bits
+ns_RESULT = ns_GetAnalogData(hFile, 1, 2^32 - 10, 11, struct('Filter', [0.2 0.4 0.2 1 -0.3 0.1]));
+Passed = Check(Passed, ns_RESULT == ns_BADINDEX, 'filtered read past the last index');
+
+% Index ranges the API cannot address
+ns_RESULT = ns_GetAnalogData(hFile, 1, 1, 2^32);
+Passed = Check(Passed, ns_RESULT == ns_BADINDEX, 'index count of 2^32');
+ns_RESULT = ns_GetAnalogData(hFile, 1, 1.5, 10);
+Passed = Check(Passed, ns_RESULT == ns_BADINDEX, 'fractional start index');
+ns_RESULT = ns_GetAnalogData(hFile, 1, 1, 2.5);
+Passed = Check(Passed, ns_RESULT == ns_BADINDEX, 'fractional index count');
+
+ns_CloseFile(hFile);
+if (Passed)
+    fprintf('test_LargeIndex passed\n');
+else
+    fprintf('test_LargeIndex FAILED\n');
+end;
+
+function Passed = Check(Passed, Condition, Name);
+if (~Condition)
+    fprintf('  failed: %s\n', Name);
+    Passed = 0;
+end;
@@ -0,0 +1,78 @@
+function Passed = test_SingleThreaded(LibraryPath);
+
+%test_SingleThreaded   Tests reads with a library that is not multithread safe
+%
+%   Usage:
+%      Passed = test_SingleThreaded(LibraryPath)
+%
+%   Description:
+%       Loads the synthetic Neuroshare library built from tests/nssynth.c
+%       (make synth) in the modes NSSYNTH_SINGLETHREADED, in which calls
+%       that overlap other calls fail, and NSSYNTH_NOCONTCOUNT, in which
+%       the library reports no continuous indeces, so that the blocks of
+%       the data are found by the time stamps.  Its analog entity is read
+%       four times at once by several threads, with the Blocks option and
+%       with the Decimate and Filter options, across its gap.  Every read
+%       must succeed and find both blocks: the calls of all threads into
+%       the library must be serialized.
+%       The m-files and mexprog must be on the path.  The environment
+%       variables are cleared again at the end.
+%
+%   Parameters:
+%       LibraryPath     Path of nssynth.so (or the library built for the
+%                       platform).
+%
+%   Return Values:
+%       Passed          1 if all checks passed, otherwise 0.
+%
+%   Copyright (C) 2026 German Neuroinformatics Node (G-Node)
+%   Author: G-Node
+%   Last modification: 10/17/2026
+
+ns_OK = 0;
+GapIndex = 2^32 - 2^24 + 1;     % first index (1-based) after the gap
+Half = 300000;
+StartIndex = GapIndex - Half;
+Expected = [StartIndex, Half; GapIndex, Half];
+
+setenv('NSSYNTH_SINGLETHREADED', '1');
+setenv('NSSYNTH_NOCONTCOUNT', '1');
+Passed = 1;
+if (ns_SetLibrary(LibraryPath) ~= ns_OK)
+    error('Could not load %s.', LibraryPath);
+end;
+[ns_RESULT, hFile] = ns_OpenFile('synthetic');
+if (ns_RESULT ~= ns_OK)
+    error('Could not open the synthetic file.');
+end;
+
+Names = {'Blocks', 'Decimate', 'Filter'};
+Options = {struct('Blocks', 1, 'Threads', 4), ...
+           struct('Blocks', 1, 'Threads', 4, 'Decimate', 4), ...
+           struct('Blocks', 1, 'Threads', 4, 'Filter', [0.2 0.4 0.2 1 -0.3 0.1])};
+for i = 1:numel(Options)
+    [ns_RESULT, ContCount, Data, Scale, Blocks] = ns_GetAnalogData(hFile, [1 1 1 1], StartIndex, ...
+                                                                   2 * Half, Options{i});
+    Passed = Check(Passed, ns_RESULT == ns_OK, [Names{i} ' read']);
+    for k = 1:4
+        Passed = Check(Passed, (ns_RESULT == ns_OK) && isequal(Blocks{k}(:, 1:2), Expected), ...
+                       sprintf('%s blocks of column %d', Names{i}, k));
+    end;
+    clear Data;
+end;
+
+[ns_RESULT, Message] = ns_GetLastErrorMsg;
+ns_CloseFile(hFile);
+setenv('NSSYNTH_SINGLETHREADED', '');
+setenv('NSSYNTH_NOCONTCOUNT', '');
+if (Passed)
+    fprintf('test_SingleThreaded passed\n');
+else
+    fprintf('test_SingleThreaded FAILED (%s)\n', Message);
+end;
+
+function Passed = Check(Passed, Condition, Name);
+if (~Condition)
+    fprintf('  failed: %s\n', Name);
+    Passed = 0;
+end;